@@ -2,16 +2,27 @@
 #define LINNE_H_INCLUDED
 
 #include "linne_stdint.h"
+#include <stddef.h>
 
 /* フォーマットバージョン */
-#define LINNE_FORMAT_VERSION        1
+#define LINNE_FORMAT_VERSION        2
 
 /* コーデックバージョン */
 #define LINNE_CODEC_VERSION         1
 
-/* ヘッダサイズ */
+/* ヘッダサイズ（ヘッダ拡張を含まない） */
 #define LINNE_HEADER_SIZE           30
 
+/* ヘッダ拡張に記録できる独自レイヤー構造の最大レイヤー数 */
+#define LINNE_MAX_NUM_CUSTOM_LAYERS 8
+
+/* ヘッダ拡張を含む最大のヘッダサイズ */
+#define LINNE_MAX_HEADER_SIZE       (LINNE_HEADER_SIZE + 1 + LINNE_MAX_NUM_CUSTOM_LAYERS)
+
+/* ヘッダ拡張を含むヘッダサイズの計算: 独自レイヤー構造があればレイヤー数(1byte)と各レイヤーのパラメータ数(1byte)が続く */
+#define LINNE_CALCULATE_HEADER_SIZE(header)\
+    (LINNE_HEADER_SIZE + (((header)->num_custom_layers > 0) ? (1U + (header)->num_custom_layers) : 0U))
+
 /* 処理可能な最大チャンネル数 */
 #define LINNE_MAX_NUM_CHANNELS      8
 
@@ -46,8 +57,43 @@ struct LINNEHeader {
     uint32_t sampling_rate;                         /* サンプリングレート             */
     uint16_t bits_per_sample;                       /* サンプルあたりビット数         */
     uint32_t num_samples_per_block;                 /* ブロックあたりサンプル数   */
-    uint8_t preset;                                 /* パラメータプリセット         */
+    uint8_t preset;                                 /* パラメータプリセット（ブロック毎に切り替える場合は上限） */
+    uint8_t enable_block_preset;                    /* ブロック毎にプリセットを切り替えるか？ 1:切り替える */
+    uint8_t num_custom_layers;                      /* 独自レイヤー構造のレイヤー数 0以外ではpresetの代わりに使う */
+    uint32_t custom_num_params_list[LINNE_MAX_NUM_CUSTOM_LAYERS]; /* 独自レイヤー構造の各レイヤーのパラメータ数 */
     LINNEChannelProcessMethod ch_process_method;    /* マルチチャンネル処理法         */
 };
 
+/* メモリ確保関数: alignmentバイト境界に揃えたsizeバイトの領域を返す（失敗時はNULL） */
+typedef void *(*LINNEAllocateFunction)(size_t size, size_t alignment, void *context);
+
+/* メモリ解放関数: LINNEAllocateFunctionで確保した領域を解放する */
+typedef void (*LINNEDeallocateFunction)(void *ptr, void *context);
+
+/* メモリアロケータ */
+struct LINNEAllocator {
+    LINNEAllocateFunction allocate;     /* 確保関数                 */
+    LINNEDeallocateFunction deallocate; /* 解放関数                 */
+    void *context;                      /* 各関数に渡すユーザデータ */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ワーク領域を指定せずに作成したハンドルが使うアロケータの設定
+ * エンコーダ・デコーダ・ハンドルプールに加え、LPC係数計算とWAVファイルのハンドルもこのアロケータを使う
+ * NULLを指定すると標準のアロケータ（malloc/free）に戻す
+ * 設定はプロセス全体で共有する静的変数で排他制御はしないため、スレッドセーフではない
+ * 他のスレッドがハンドルを作成・破棄していないとき（起動直後など）に設定すること
+ * 自前確保したハンドルは作成時と同じアロケータで解放するため、そのようなハンドルが残っている間は変更しないこと */
+LINNEApiResult LINNE_SetAllocator(const struct LINNEAllocator *allocator);
+
+/* 現在のアロケータの取得 */
+void LINNE_GetAllocator(struct LINNEAllocator *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* LINNE_H_INCLUDED */
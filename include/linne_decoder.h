@@ -12,9 +12,40 @@ struct LINNEDecoderConfig {
     uint8_t check_crc; /* CRCによるデータ破損検査を行うか？ 1:ON それ意外:OFF */
 };
 
+/* ブロック情報 */
+struct LINNEBlockInfo {
+    uint32_t data_offset; /* データ先頭からのブロック位置[byte] */
+    uint32_t data_size; /* ブロックヘッダを含むブロックサイズ[byte] */
+    uint32_t sample_offset; /* ブロック先頭のサンプル位置 */
+    uint32_t num_samples; /* ブロックのチャンネルあたりサンプル数 */
+    uint8_t corrupted; /* CRC16検査でデータ破損を検知したか？ 1:破損 それ以外:正常 */
+};
+
+/* 一括デコードのブロック毎の入出力 */
+struct LINNEDecodeBlockRequest {
+    const struct LINNEHeader *header; /* ブロックが属するストリームのヘッダ */
+    const uint8_t *data; /* ブロックデータ先頭 */
+    uint32_t data_size; /* ブロックデータサイズ */
+    int32_t **buffer; /* 出力バッファ */
+    uint32_t buffer_num_channels; /* 出力バッファのチャンネル数 */
+    uint32_t buffer_num_samples; /* 出力バッファのチャンネルあたりサンプル数 */
+    uint32_t decode_size; /* [出力] デコードしたデータサイズ */
+    uint32_t num_decode_samples; /* [出力] デコードしたチャンネルあたりサンプル数 */
+    LINNEApiResult result; /* [出力] このブロックのデコード結果 */
+};
+
 /* デコーダハンドル */
 struct LINNEDecoder;
 
+/* タスク関数: task_index番目のタスクを実行する */
+typedef void (*LINNEDecoderTaskFunction)(void *task_context, uint32_t task_index);
+
+/* タスク実行コールバック
+* task(task_context, i)をi = 0,...,num_tasks-1について実行し、全てのタスクが完了してから戻ること
+* 各タスクは互いに独立なので、任意の順序・任意のスレッドで並列に実行してよい */
+typedef void (*LINNEDecoderRunTasksCallback)(
+        LINNEDecoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data);
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -26,29 +57,94 @@ LINNEApiResult LINNEDecoder_DecodeHeader(
 /* デコーダハンドルの作成に必要なワークサイズの計算 */
 int32_t LINNEDecoder_CalculateWorkSize(const struct LINNEDecoderConfig *condig);
 
-/* デコーダハンドルの作成 */
+/* ヘッダのデコードに必要な最小のコンフィグを取得
+* check_crcは1（検査する）に設定される */
+LINNEApiResult LINNEDecoder_CalculateMinimumConfig(
+        const struct LINNEHeader *header, struct LINNEDecoderConfig *config);
+
+/* ヘッダのデコードに必要な最小のワークサイズの計算 */
+int32_t LINNEDecoder_CalculateWorkSizeFromHeader(const struct LINNEHeader *header);
+
+/* デコーダハンドルの作成 workにNULL, work_sizeに0を指定するとLINNE_SetAllocatorのアロケータで自前確保する */
 struct LINNEDecoder* LINNEDecoder_Create(const struct LINNEDecoderConfig *condig, void *work, int32_t work_size);
 
 /* デコーダハンドルの破棄 */
 void LINNEDecoder_Destroy(struct LINNEDecoder *decoder);
 
-/* デコーダにヘッダをセット */
+/* デコーダハンドルを作成直後の状態に戻す
+* ヘッダは未設定に戻り、タスク実行コールバックも解除される（CRC検査の有無はコンフィグの設定を保つ）
+* 領域の確保は行わないため、ハンドルを作り直さずに別のストリームへ再利用できる */
+LINNEApiResult LINNEDecoder_Reset(struct LINNEDecoder *decoder);
+
+/* デコーダにヘッダをセット
+* ハンドルの容量内であればストリームが変わってもハンドルを作り直す必要はない
+* 容量を超える場合はLINNE_APIRESULT_INSUFFICIENT_BUFFERを返す
+* デエンファシスフィルタはブロック毎に初期化されるため、前のストリームの状態は残らない */
 LINNEApiResult LINNEDecoder_SetHeader(
         struct LINNEDecoder *decoder, const struct LINNEHeader *header);
 
-/* 単一データブロックデコード */
+/* チャンネル毎の合成処理を実行するタスク実行コールバックの設定
+* 設定するとブロック内の各チャンネルのLPC合成とデエンファシスをチャンネル毎のタスクとして実行する
+* callbackにNULLを指定すると逐次処理に戻る */
+LINNEApiResult LINNEDecoder_SetTaskCallback(
+        struct LINNEDecoder *decoder, LINNEDecoderRunTasksCallback callback, void *user_data);
+
+/* 単一データブロックデコード
+* パラメータを再利用するブロックは直前にデコードした圧縮データブロックのパラメータを使う
+* パラメータを差分で記録したブロックは直前にデコードしたブロックの末尾サンプルとパラメータを基準にする
+* 途中のブロックからデコードを始める場合はLINNEDecoder_SetHeaderでヘッダを設定し直すこと
+* （次にパラメータを持つ圧縮データブロック（キーフレーム）が来るまで、
+* 再利用・差分記録したブロックはLINNE_APIRESULT_INSUFFICIENT_DATAになる）
+* デコードに失敗したときも直前のブロックへの依存は破棄し、次のキーフレームまで同様にINSUFFICIENT_DATAになる */
 LINNEApiResult LINNEDecoder_DecodeBlock(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
         uint32_t *decode_size, uint32_t *num_decode_samples);
 
+/* 異なるストリームの複数ブロックを一括デコード
+* 同じプリセット・同じブロックサイズのブロックが続くとき、LPC合成をストリーム間でインターリーブする
+* ブロック毎の結果はrequests[i].resultに記録し、失敗したブロックがあれば最初の失敗結果を返す
+* ハンドルにセットされたヘッダは変更しない
+* 直前のブロックに依存するブロック（パラメータの再利用・差分記録）はデコードできない（LINNE_APIRESULT_INSUFFICIENT_DATAになる） */
+LINNEApiResult LINNEDecoder_DecodeBlocks(
+        struct LINNEDecoder *decoder,
+        struct LINNEDecodeBlockRequest *requests, uint32_t num_requests);
+
 /* ヘッダを含めて全ブロックデコード */
 LINNEApiResult LINNEDecoder_DecodeWhole(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
 
+/* dataの先頭から走査し、同期コード・サイズ・CRC16が正常な最初のブロック位置を取得
+* 破損ブロックからの復帰に使用する。見つからない場合はLINNE_APIRESULT_INSUFFICIENT_DATAを返す
+* 直前のブロックへの依存は破棄するため、見つかったブロックが再利用・差分記録したブロックならば
+* LINNEDecoder_DecodeBlockはLINNE_APIRESULT_INSUFFICIENT_DATAを返す（次のキーフレームまで読み飛ばすこと） */
+LINNEApiResult LINNEDecoder_FindNextBlock(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size, uint32_t *block_offset);
+
+/* dataの先頭にあるブロックの情報（サイズ・サンプル数・CRC16検査結果）を取得
+* 再同期で読み飛ばしたブロックのサンプル数を数えるのに使用する。data_offset, sample_offsetは0になる
+* 同期コード・ブロックタイプ・サンプル数が不正ならばLINNE_APIRESULT_INVALID_FORMAT、
+* ブロックがdata_sizeに収まらなければLINNE_APIRESULT_INSUFFICIENT_DATAを返す */
+LINNEApiResult LINNEDecoder_PeekBlockInfo(
+        const struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size, struct LINNEBlockInfo *block_info);
+
+/* ヘッダを含むデータから各ブロックの情報を取得
+* block_infoがNULLのときはブロック数のみ取得する */
+LINNEApiResult LINNEDecoder_GetBlockInfo(
+        const uint8_t *data, uint32_t data_size,
+        struct LINNEBlockInfo *block_info, uint32_t max_num_blocks, uint32_t *num_blocks);
+
+/* デコードせずにブロックのCRC16のみを検査し、結果をblock_info[i].corruptedに記録
+* ハンドルを使わないため、ブロック範囲を分けて複数スレッドから同時に呼び出せる */
+LINNEApiResult LINNEDecoder_CheckBlocks(
+        const uint8_t *data, uint32_t data_size,
+        struct LINNEBlockInfo *block_info, uint32_t num_blocks);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -4,6 +4,18 @@
 #include "linne.h"
 #include "linne_stdint.h"
 
+/* 適応ブロックサイズ選択でのブロックの最大分割段数 */
+#define LINNEENCODER_MAX_BLOCK_SPLIT_DEPTH 3
+/* 適応ブロックサイズ選択で1区間を分割して得られる最大ブロック数 */
+#define LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS (1 << LINNEENCODER_MAX_BLOCK_SPLIT_DEPTH)
+
+/* プリセット競争エンコードで同時に試せる最大エンコーダ数: 全プリセット x 学習の有無 */
+#define LINNEENCODER_MAX_NUM_RACE_ENCODERS (2 * LINNE_NUM_PARAMETER_PRESETS)
+
+/* 単一データブロックの最大サイズ: ブロックヘッダ(11byte) + 生データのサイズを超えない */
+#define LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(num_channels, bits_per_sample, num_samples)\
+    (11U + ((uint32_t)(num_channels) * (uint32_t)(bits_per_sample) * (uint32_t)(num_samples)) / 8U)
+
 /* エンコードパラメータ */
 struct LINNEEncodeParameter {
     uint16_t num_channels; /* 入力波形のチャンネル数 */
@@ -13,6 +25,16 @@ struct LINNEEncodeParameter {
     uint8_t preset; /* エンコードパラメータプリセット */
     LINNEChannelProcessMethod ch_process_method;  /* マルチチャンネル処理法 */
     uint8_t enable_learning; /* ネットワークの学習を行うか？ */
+    uint16_t min_num_samples_per_block; /* 適応ブロックサイズ選択での最小ブロックあたりサンプル数 0で適応選択を行わない */
+    uint8_t block_size_search_budget; /* ブロックサイズ探索の計算量上限（ブロックあたりサンプル数分の符号長推定を1とした回数） */
+    uint16_t target_realtime_factor; /* 目標の実時間倍率 0以外ではpresetを上限に、ブロック毎の処理時間を見てプリセットと学習の有無を切り替える */
+    uint8_t num_custom_layers; /* 独自レイヤー構造のレイヤー数 0以外ではpresetの代わりにcustom_num_params_listの構造を使う */
+    uint32_t custom_num_params_list[LINNE_MAX_NUM_CUSTOM_LAYERS]; /* 独自レイヤー構造の各レイヤーのパラメータ数（入力側から順に） */
+    uint8_t enable_block_preset; /* ブロック毎にプリセット番号を記録するか？ プリセット競争エンコードでは1にする（target_realtime_factorが0以外のときは常に記録） */
+    uint8_t enable_parameter_reuse; /* 直前のブロックのパラメータで十分に予測できるとき、分析とパラメータの記録を省くか？ 再利用したブロックは直前の圧縮ブロックなしにデコードできない */
+    uint16_t num_lookback_samples; /* 分析に含める直前のブロックのサンプル数 0で無効 出力を遅らせずに短いブロックの分析を安定させる */
+    uint8_t enable_delta_parameters; /* パラメータを直前のブロックとの差分で記録するか？ 差分で記録したブロックは直前のブロックなしにデコードできない */
+    uint16_t keyframe_interval; /* 直前のブロックに依存しない圧縮ブロック（キーフレーム）を置く最大間隔[ブロック] 0で制限しない */
 };
 
 /* エンコーダコンフィグ */
@@ -21,11 +43,32 @@ struct LINNEEncoderConfig {
     uint32_t max_num_samples_per_block; /* 最大のブロックあたりサンプル数 */
     uint32_t max_num_layers; /* LPCNetの最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* LPCNetのレイヤーあたり最大パラメータ数 */
+    uint32_t max_num_lookback_samples; /* 分析に含める直前のブロックの最大サンプル数 0では分析窓バッファを確保しない */
+    uint8_t enable_delta_parameters; /* パラメータの差分記録を行うか？ 0では差分の基準を保持する領域を確保しない */
+};
+
+/* 圧縮サイズ・エンコード時間の推定結果 */
+struct LINNEEncodeEstimate {
+    uint32_t num_blocks; /* 全ブロック数 */
+    uint32_t num_analyzed_blocks; /* 分析したブロック数 */
+    double estimated_size; /* 推定圧縮サイズ[byte]（ヘッダ含む） */
+    double estimated_size_lower; /* 推定圧縮サイズの95%信頼区間の下限[byte] */
+    double estimated_size_upper; /* 推定圧縮サイズの95%信頼区間の上限[byte] */
+    double estimated_encode_time; /* 推定エンコード時間[sec] */
 };
 
 /* エンコーダハンドル */
 struct LINNEEncoder;
 
+/* タスク関数: task_index番目のタスクを実行する */
+typedef void (*LINNEEncoderTaskFunction)(void *task_context, uint32_t task_index);
+
+/* タスク実行コールバック
+* task(task_context, i)をi = 0,...,num_tasks-1について実行し、全てのタスクが完了してから戻ること
+* 各タスクは互いに独立なので、任意の順序・任意のスレッドで並列に実行してよい */
+typedef void (*LINNEEncoderRunTasksCallback)(
+        LINNEEncoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data);
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -37,28 +80,92 @@ LINNEApiResult LINNEEncoder_EncodeHeader(
 /* エンコーダハンドル作成に必要なワークサイズ計算 */
 int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config);
 
-/* エンコーダハンドル作成 */
+/* エンコードパラメータでのエンコードに必要な最小のコンフィグを取得 */
+LINNEApiResult LINNEEncoder_CalculateMinimumConfig(
+    const struct LINNEEncodeParameter *parameter, struct LINNEEncoderConfig *config);
+
+/* エンコードパラメータでのエンコードに必要な最小のワークサイズ計算 */
+int32_t LINNEEncoder_CalculateWorkSizeFromParameter(const struct LINNEEncodeParameter *parameter);
+
+/* エンコーダハンドル作成 workにNULL, work_sizeに0を指定するとLINNE_SetAllocatorのアロケータで自前確保する */
 struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config, void *work, int32_t work_size);
 
 /* エンコーダハンドルの破棄 */
 void LINNEEncoder_Destroy(struct LINNEEncoder *encoder);
 
-/* エンコードパラメータの設定 */
+/* エンコーダハンドルを作成直後の状態に戻す
+* パラメータは未設定に戻り、速度目標の計測結果・プリエンファシスフィルタ・ネットワークの状態も破棄する
+* 領域の確保は行わないため、ハンドルを作り直さずに別のストリームへ再利用できる */
+LINNEApiResult LINNEEncoder_Reset(struct LINNEEncoder *encoder);
+
+/* エンコードパラメータの設定
+* ハンドルの容量内であればパラメータが変わってもハンドルを作り直す必要はない
+* 容量を超える場合はLINNE_APIRESULT_INSUFFICIENT_BUFFERを返す
+* ブロック間で引き継ぐ状態（速度目標の計測結果）はここで初期化され、前のストリームの状態は残らない */
 LINNEApiResult LINNEEncoder_SetEncodeParameter(
     struct LINNEEncoder *encoder, const struct LINNEEncodeParameter *parameter);
 
-/* 単一データブロックエンコード */
+/* プリセット競争の分析を実行するタスク実行コールバックの設定
+* LINNEEncoder_EncodeBlockRaceの先頭のエンコーダに設定すると、各エンコーダの分析をエンコーダ毎のタスクとして実行する
+* callbackにNULLを指定すると逐次処理に戻る */
+LINNEApiResult LINNEEncoder_SetTaskCallback(
+        struct LINNEEncoder *encoder, LINNEEncoderRunTasksCallback callback, void *user_data);
+
+/* 入力先頭の最大ブロックあたりサンプル数までの区間をブロックに分割
+* block_num_samplesには先頭から順に各ブロックのサンプル数が入り、その総和はnum_samples_per_blockとnum_samplesの小さい方になる
+* block_num_samplesにはLINNEENCODER_MAX_NUM_BLOCK_PARTITIONS以上の要素数の領域を渡すこと
+* 適応ブロックサイズ選択が無効な場合は1ブロックのみを返す */
+LINNEApiResult LINNEEncoder_DecideBlockPartition(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples,
+        uint32_t *block_num_samples, uint32_t max_num_blocks, uint32_t *num_blocks);
+
+/* 単一データブロックエンコード
+* 出力サイズはLINNEENCODER_CALCULATE_MAX_BLOCK_SIZEを超えない */
 LINNEApiResult LINNEEncoder_EncodeBlock(
         struct LINNEEncoder *encoder,
         const int32_t *const *input, uint32_t num_samples,
         uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
+/* プリセット競争による単一データブロックエンコード
+* 同じブロックをnum_encoders個のエンコーダ（それぞれ異なるプリセット・学習の有無を設定）で分析し、最も小さいものを出力する
+* チャンネル処理・プリエンファシスなどのプリセットに依存しない前処理はencoders[0]で1度だけ行い、他のエンコーダはその結果を共有する
+* 全てのエンコーダにはチャンネル数・ビット幅・ブロックあたりサンプル数・チャンネル処理法が同じで
+* enable_block_presetを1にしたパラメータを設定し、num_lookback_samplesは0にすること（独自レイヤー構造は使えない）
+* 速度目標による速度レベルの更新、パラメータの再利用・差分記録は行わない */
+LINNEApiResult LINNEEncoder_EncodeBlockRace(
+        struct LINNEEncoder *const *encoders, uint32_t num_encoders,
+        const int32_t *const *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
 /* ヘッダ含めファイル全体をエンコード */
 LINNEApiResult LINNEEncoder_EncodeWhole(
     struct LINNEEncoder *encoder,
     const int32_t *const *input, uint32_t num_samples,
     uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
+/* ファイル全体の圧縮サイズとエンコード時間の推定
+* 全体に等間隔に散らばるnum_analyze_blocks個のブロックを、設定済みのパラメータで実際のエンコードと同じ手順で分析する
+* （ブロック分割は固定ブロックサイズ、ブロック毎のプリセット切り替えは現在の速度レベルのみで見積もる）
+* 出力データは書き出さない。ブロックを跨ぐ状態は変わりうるため、推定後にエンコードする場合はパラメータを設定し直すこと */
+LINNEApiResult LINNEEncoder_EstimateWhole(
+    struct LINNEEncoder *encoder,
+    const int32_t *const *input, uint32_t num_samples, uint32_t num_analyze_blocks,
+    struct LINNEEncodeEstimate *estimate);
+
+/* ファイル全体の事前分析によるエンコードパラメータの決定
+* 全体に等間隔に散らばるnum_analyze_blocks個の区間を分析し、
+* parameterのチャンネル処理法・ブロックあたりサンプル数・プリセットを内容に合わせて決め直す
+* - チャンネル処理法: 2chではMS処理の有無のうちLPCの推定符号長による推定サイズが小さい方
+* - ブロックあたりサンプル数: num_samples_per_blockから半分ずつ短くした中でLPCの推定符号長による推定サイズが最小のもの（適応ブロックサイズ選択時は変えない）
+* - プリセット: preset以下で、下位のプリセットよりLINNEEncoder_EstimateWholeの推定サイズが十分に縮むもの（独自レイヤー構造は変えない）
+* 決め直した設定は、LINNEEncoder_EstimateWholeの推定サイズが決め直す前のparameterより小さい場合のみ採用する
+* 分析のためencoderには決め直す前のparameterを設定する。決め直したparameterでエンコードする場合は設定し直すこと */
+LINNEApiResult LINNEEncoder_PreAnalyzeWhole(
+    struct LINNEEncoder *encoder,
+    const int32_t *const *input, uint32_t num_samples, uint32_t num_analyze_blocks,
+    struct LINNEEncodeParameter *parameter);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
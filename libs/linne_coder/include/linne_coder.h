@@ -23,6 +23,10 @@ void LINNECoder_Destroy(struct LINNECoder *coder);
 /* 符号付き整数配列の符号化 */
 void LINNECoder_Encode(struct LINNECoder *coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples);
 
+/* 符号付き整数配列の符号長[bit]の計算
+* LINNECoder_Encodeで出力されるビット数と一致する */
+uint32_t LINNECoder_CalculateCodeLength(struct LINNECoder *coder, const int32_t *data, uint32_t num_samples);
+
 /* 符号付き整数配列の復号 */
 void LINNECoder_Decode(struct BitStream *stream, int32_t *data, uint32_t num_samples);
 
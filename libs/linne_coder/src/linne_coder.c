@@ -46,7 +46,7 @@ struct LINNECoder* LINNECoder_Create(void *work, int32_t work_size)
         if ((work_size = LINNECoder_CalculateWorkSize()) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        work = LINNE_AllocateMemory((size_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -76,7 +76,7 @@ void LINNECoder_Destroy(struct LINNECoder *coder)
     if (coder != NULL) {
         /* 自前確保していたら領域開放 */
         if (coder->alloced_by_own == 1) {
-            free(coder->work);
+            LINNE_FreeMemory(coder->work);
         }
     }
 }
@@ -199,8 +199,23 @@ static void LINNECoder_CalculateOptimalRecursiveRiceParameter(
 #undef OPTX
 }
 
-/* 符号付き整数配列の符号化 */
-static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder* coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples)
+/* 再帰的Rice符号の符号長[bit] */
+static uint32_t RecursiveRice_GetCodeLength(uint32_t k1, uint32_t k2, uint32_t uval)
+{
+    const uint32_t k1pow = 1U << k1;
+
+    if (uval < k1pow) {
+        /* 1段目: 1bitのフラグ + k1bit */
+        return 1 + k1;
+    }
+
+    /* 2段目: 0のラン(1 + 商) + 終端の1 + k2bit */
+    return 2 + ((uval - k1pow) >> k2) + k2;
+}
+
+/* 最適な分割数の探索
+* 探索時に計算した各分割での平均はcoder->part_meanに残る */
+static uint32_t LINNECoder_SearchBestPartitionOrder(struct LINNECoder* coder, const int32_t *data, uint32_t num_samples)
 {
     uint32_t max_porder, max_num_partitions;
     uint32_t porder, part, best_porder;
@@ -264,6 +279,15 @@ static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder* coder,
         }
     }
 
+    return best_porder;
+}
+
+/* 符号付き整数配列の符号化 */
+static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder* coder, struct BitStream *stream, const int32_t *data, uint32_t num_samples)
+{
+    uint32_t part;
+    const uint32_t best_porder = LINNECoder_SearchBestPartitionOrder(coder, data, num_samples);
+
     /* 最適な分割を用いて符号化 */
     {
         uint32_t smpl, k1, k2, prevk2;
@@ -271,7 +295,7 @@ static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder* coder,
 
         BitWriter_PutBits(stream, best_porder, LINNECODER_LOG2_MAX_NUM_PARTITIONS);
 
-        for (part = 0; part < (1 << best_porder); part++) {
+        for (part = 0; part < (1U << best_porder); part++) {
             LINNECoder_CalculateOptimalRecursiveRiceParameter(coder->part_mean[best_porder][part], &k1, &k2, NULL);
             if (part == 0) {
                 BitWriter_PutBits(stream, k2, LINNECODER_RICE_PARAMETER_BITS);
@@ -288,6 +312,32 @@ static void LINNECoder_EncodePartitionedRecursiveRice(struct LINNECoder* coder,
     }
 }
 
+/* 符号付き整数配列の符号長[bit]の計算 */
+static uint32_t LINNECoder_CalculatePartitionedRecursiveRiceCodeLength(struct LINNECoder* coder, const int32_t *data, uint32_t num_samples)
+{
+    uint32_t part, smpl, k1, k2, prevk2, bits;
+    const uint32_t best_porder = LINNECoder_SearchBestPartitionOrder(coder, data, num_samples);
+    const uint32_t nsmpl = num_samples >> best_porder;
+
+    /* 符号化と同じ手順で符号長を積算 */
+    bits = LINNECODER_LOG2_MAX_NUM_PARTITIONS;
+    for (part = 0; part < (1U << best_porder); part++) {
+        LINNECoder_CalculateOptimalRecursiveRiceParameter(coder->part_mean[best_porder][part], &k1, &k2, NULL);
+        if (part == 0) {
+            bits += LINNECODER_RICE_PARAMETER_BITS;
+        } else {
+            const int32_t diff = (int32_t)k2 - (int32_t)prevk2;
+            bits += LINNECODER_GAMMA_BITS(LINNEUTILITY_SINT32_TO_UINT32(diff));
+        }
+        prevk2 = k2;
+        for (smpl = 0; smpl < nsmpl; smpl++) {
+            bits += RecursiveRice_GetCodeLength(k1, k2, LINNEUTILITY_SINT32_TO_UINT32(data[part * nsmpl + smpl]));
+        }
+    }
+
+    return bits;
+}
+
 /* 符号付き整数配列の復号 */
 static void LINNECoder_DecodePartitionedRecursiveRice(struct BitStream *stream, int32_t *data, uint32_t num_samples)
 {
@@ -297,7 +347,7 @@ static void LINNECoder_DecodePartitionedRecursiveRice(struct BitStream *stream,
     BitReader_GetBits(stream, &best_porder, LINNECODER_LOG2_MAX_NUM_PARTITIONS);
 
     nsmpl = num_samples >> best_porder;
-    for (part = 0; part < (1 << best_porder); part++) {
+    for (part = 0; part < (1U << best_porder); part++) {
         if (part == 0) {
             BitReader_GetBits(stream, &k2, LINNECODER_RICE_PARAMETER_BITS);
         } else {
@@ -321,6 +371,15 @@ void LINNECoder_Encode(struct LINNECoder *coder, struct BitStream *stream, const
     LINNECoder_EncodePartitionedRecursiveRice(coder, stream, data, num_samples);
 }
 
+/* 符号付き整数配列の符号長[bit]の計算 */
+uint32_t LINNECoder_CalculateCodeLength(struct LINNECoder *coder, const int32_t *data, uint32_t num_samples)
+{
+    LINNE_ASSERT((data != NULL) && (coder != NULL));
+    LINNE_ASSERT(num_samples != 0);
+
+    return LINNECoder_CalculatePartitionedRecursiveRiceCodeLength(coder, data, num_samples);
+}
+
 /* 符号付き整数配列の復号 */
 void LINNECoder_Decode(struct BitStream *stream, int32_t *data, uint32_t num_samples)
 {
@@ -17,9 +17,18 @@
 
 /* 内部状態フラグ操作マクロ */
 #define LINNEDECODER_SET_STATUS_FLAG(decoder, flag)    ((decoder->status_flags) |= (flag))
-#define LINNEDECODER_CLEAR_STATUS_FLAG(decoder, flag)  ((decoder->status_flags) &= ~(flag))
+#define LINNEDECODER_CLEAR_STATUS_FLAG(decoder, flag)  ((decoder->status_flags) &= (uint8_t)~(flag))
 #define LINNEDECODER_GET_STATUS_FLAG(decoder, flag)    ((decoder->status_flags) & (flag))
 
+/* ユニット数が4以上のレイヤーで、ユニット並列合成より16bit積和の合成を優先する最小次数 */
+#define LINNEDECODER_INT16_UNITS_MIN_ORDER 24
+
+/* チャンネルchの第l層のLPC係数の先頭 */
+#define LINNEDECODER_PARAMS_INT(decoder, ch, l)\
+    (&(decoder)->params_int[((ch) * (decoder)->max_num_layers + (uint32_t)(l)) * (decoder)->max_num_parameters_per_layer])
+/* チャンネルchの第l層の情報（ユニット数・右シフト量） */
+#define LINNEDECODER_LAYER_INFO(decoder, info, ch, l) ((decoder)->info[(ch) * (decoder)->max_num_layers + (uint32_t)(l)])
+
 /* デコーダハンドル */
 struct LINNEDecoder {
     struct LINNEHeader header; /* ヘッダ */
@@ -27,10 +36,16 @@ struct LINNEDecoder {
     uint32_t max_num_layers; /* 最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* 最大レイヤーあたりパラメータ数 */
     struct LINNEPreemphasisFilter **de_emphasis; /* デエンファシスフィルタ */
-    int32_t ***params_int; /* LPC係数(int) */
-    uint32_t **num_units; /* 各層のユニット数 */
-    uint32_t **rshifts; /* 各層のLPC係数右シフト量 */
+    uint32_t wasted_bits[LINNE_MAX_NUM_CHANNELS]; /* チャンネル毎の下位の無効ビット数 */
+    int32_t *params_int; /* LPC係数(int) [チャンネル][層][パラメータ]の順に並ぶ */
+    uint32_t *num_units; /* 各層のユニット数 [チャンネル][層]の順に並ぶ */
+    uint32_t *rshifts; /* 各層のLPC係数右シフト量 [チャンネル][層]の順に並ぶ */
     const struct LINNEParameterPreset *parameter_preset; /* パラメータプリセット */
+    struct LINNEParameterPreset custom_preset; /* 独自レイヤー構造（ヘッダの配列を参照） */
+    const struct LINNEParameterPreset *reusable_preset; /* 保持しているパラメータのレイヤー構造 NULLならば再利用できない */
+    int32_t last_samples[LINNE_MAX_NUM_CHANNELS]; /* 直前にデコードしたブロックのチャンネル毎の末尾サンプル（出力） */
+    LINNEDecoderRunTasksCallback run_tasks; /* タスク実行コールバック */
+    void *run_tasks_user_data; /* タスク実行コールバックに渡すユーザデータ */
     uint8_t status_flags; /* 内部状態フラグ */
     void *work; /* ワーク領域先頭ポインタ */
 };
@@ -46,13 +61,19 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
-        uint32_t *decode_size);
+        uint8_t has_wasted_bits, uint8_t parameter_flags, uint32_t *decode_size);
 /* 無音データブロックデコード */
 static LINNEApiResult LINNEDecoder_DecodeSilentData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
         uint32_t *decode_size);
+/* 定数データブロックデコード */
+static LINNEApiResult LINNEDecoder_DecodeConstantData(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
+        uint32_t *decode_size);
 
 /* ヘッダデコード */
 LINNEApiResult LINNEDecoder_DecodeHeader(
@@ -113,15 +134,38 @@ LINNEApiResult LINNEDecoder_DecodeHeader(
     /* 最大ブロックあたりサンプル数 */
     ByteArray_GetUint32BE(data_pos, &u32buf);
     tmp_header.num_samples_per_block = u32buf;
-    /* パラメータプリセット */
+    /* パラメータプリセット: ブロック毎に切り替えるか・独自レイヤー構造があるかのフラグを含む */
     ByteArray_GetUint8(data_pos, &u8buf);
-    tmp_header.preset = u8buf;
+    tmp_header.preset = (uint8_t)(u8buf & ~(LINNE_HEADER_BLOCK_PRESET_FLAG | LINNE_HEADER_CUSTOM_LAYERS_FLAG));
+    tmp_header.enable_block_preset = (u8buf & LINNE_HEADER_BLOCK_PRESET_FLAG) ? 1 : 0;
+    tmp_header.num_custom_layers = (u8buf & LINNE_HEADER_CUSTOM_LAYERS_FLAG) ? 1 : 0;
     /* マルチチャンネル処理法 */
     ByteArray_GetUint8(data_pos, &u8buf);
     tmp_header.ch_process_method = (LINNEChannelProcessMethod)u8buf;
 
+    /* ヘッダ拡張: 独自レイヤー構造 */
+    if (tmp_header.num_custom_layers > 0) {
+        uint32_t l;
+        if (data_size < (LINNE_HEADER_SIZE + 1)) {
+            return LINNE_APIRESULT_INSUFFICIENT_DATA;
+        }
+        ByteArray_GetUint8(data_pos, &u8buf);
+        /* 0層の拡張は不正 */
+        if ((u8buf == 0) || (u8buf > LINNE_MAX_NUM_CUSTOM_LAYERS)) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+        tmp_header.num_custom_layers = u8buf;
+        if (data_size < LINNE_CALCULATE_HEADER_SIZE(&tmp_header)) {
+            return LINNE_APIRESULT_INSUFFICIENT_DATA;
+        }
+        for (l = 0; l < tmp_header.num_custom_layers; l++) {
+            ByteArray_GetUint8(data_pos, &u8buf);
+            tmp_header.custom_num_params_list[l] = u8buf;
+        }
+    }
+
     /* ヘッダサイズチェック */
-    LINNE_ASSERT((data_pos - data) == LINNE_HEADER_SIZE);
+    LINNE_ASSERT((data_pos - data) == LINNE_CALCULATE_HEADER_SIZE(&tmp_header));
 
     /* 成功終了 */
     (*header) = tmp_header;
@@ -135,8 +179,9 @@ static LINNEError LINNEDecoder_CheckHeaderFormat(const struct LINNEHeader *heade
     LINNE_ASSERT(header != NULL);
 
     /* フォーマットバージョン */
-    /* 補足）今のところは不一致なら無条件でエラー */
-    if (header->format_version != LINNE_FORMAT_VERSION) {
+    /* 補足）32bit積和で合成していた旧フォーマットまでは読める それより新しければエラー */
+    if ((header->format_version < LINNE_LAST_32BIT_ACCUMULATOR_FORMAT_VERSION)
+            || (header->format_version > LINNE_FORMAT_VERSION)) {
         return LINNE_ERROR_INVALID_FORMAT;
     }
     /* コーデックバージョン */
@@ -168,6 +213,15 @@ static LINNEError LINNEDecoder_CheckHeaderFormat(const struct LINNEHeader *heade
     if (header->preset >= LINNE_NUM_PARAMETER_PRESETS) {
         return LINNE_ERROR_INVALID_FORMAT;
     }
+    /* 独自レイヤー構造: ブロック毎のプリセット切り替えとは併用できない */
+    if (header->num_custom_layers > 0) {
+        if (LINNE_CheckCustomLayerStructure(header->num_custom_layers, header->custom_num_params_list) != LINNE_ERROR_OK) {
+            return LINNE_ERROR_INVALID_FORMAT;
+        }
+        if (header->enable_block_preset == 1) {
+            return LINNE_ERROR_INVALID_FORMAT;
+        }
+    }
     /* マルチチャンネル処理法 */
     if (header->ch_process_method >= LINNE_CH_PROCESS_METHOD_INVALID) {
         return LINNE_ERROR_INVALID_FORMAT;
@@ -211,19 +265,62 @@ int32_t LINNEDecoder_CalculateWorkSize(const struct LINNEDecoderConfig *config)
     work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(struct LINNEPreemphasisFilter, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
     /* パラメータ領域 */
     /* LPC係数(int) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* 各層のユニット数 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(uint32_t, config->max_num_channels * config->max_num_layers);
     /* 各層のLPC係数右シフト量 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(uint32_t, config->max_num_channels * config->max_num_layers);
 
     return work_size;
 }
 
+/* ヘッダのデコードに必要な最小のコンフィグを取得 */
+LINNEApiResult LINNEDecoder_CalculateMinimumConfig(
+        const struct LINNEHeader *header, struct LINNEDecoderConfig *config)
+{
+    uint32_t l;
+    struct LINNEParameterPreset custom;
+    const struct LINNEParameterPreset *preset;
+
+    /* 引数チェック */
+    if ((header == NULL) || (config == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダの有効性チェック */
+    if (LINNEDecoder_CheckHeaderFormat(header) != LINNE_ERROR_OK) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* プリセット（独自レイヤー構造があればその構造）から決定 */
+    preset = LINNE_GetLayerStructure(header, &custom);
+    config->max_num_channels = header->num_channels;
+    config->max_num_layers = preset->num_layers;
+    config->max_num_parameters_per_layer = 0;
+    for (l = 0; l < preset->num_layers; l++) {
+        config->max_num_parameters_per_layer
+            = LINNEUTILITY_MAX(config->max_num_parameters_per_layer, preset->num_params_list[l]);
+    }
+    config->check_crc = 1;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* ヘッダのデコードに必要な最小のワークサイズの計算 */
+int32_t LINNEDecoder_CalculateWorkSizeFromHeader(const struct LINNEHeader *header)
+{
+    struct LINNEDecoderConfig config;
+
+    if (LINNEDecoder_CalculateMinimumConfig(header, &config) != LINNE_APIRESULT_OK) {
+        return -1;
+    }
+
+    return LINNEDecoder_CalculateWorkSize(&config);
+}
+
 /* デコーダハンドル作成 */
 struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config, void *work, int32_t work_size)
 {
-    uint32_t ch, l;
     struct LINNEDecoder *decoder;
     uint8_t *work_ptr;
     uint8_t tmp_alloc_by_own = 0;
@@ -233,7 +330,7 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
         if ((work_size = LINNEDecoder_CalculateWorkSize(config)) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        work = LINNE_AllocateMemory((size_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -263,6 +360,8 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
     decoder->max_num_channels = config->max_num_channels;
     decoder->max_num_layers = config->max_num_layers;
     decoder->max_num_parameters_per_layer = config->max_num_parameters_per_layer;
+    decoder->run_tasks = NULL;
+    decoder->run_tasks_user_data = NULL;
     decoder->status_flags = 0;  /* 状態クリア */
     if (tmp_alloc_by_own == 1) {
         LINNEDECODER_SET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN);
@@ -275,27 +374,23 @@ struct LINNEDecoder *LINNEDecoder_Create(const struct LINNEDecoderConfig *config
     LINNE_ALLOCATE_2DIMARRAY(decoder->de_emphasis,
             work_ptr, struct LINNEPreemphasisFilter, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
 
-    /* バッファ領域の確保 全てのポインタをアラインメント */
+    /* バッファ領域の確保 各配列は連続領域に詰めて置き、先頭をキャッシュラインに揃える */
     /* LPC係数(int) */
-    LINNE_ALLOCATE_3DIMARRAY(decoder->params_int,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    LINNE_ALLOCATE_FLATARRAY(decoder->params_int,
+            work_ptr, int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* 各層のユニット数 */
-    LINNE_ALLOCATE_2DIMARRAY(decoder->num_units,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
+    LINNE_ALLOCATE_FLATARRAY(decoder->num_units,
+            work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
     /* 各層のLPC係数右シフト量 */
-    LINNE_ALLOCATE_2DIMARRAY(decoder->rshifts,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
+    LINNE_ALLOCATE_FLATARRAY(decoder->rshifts,
+            work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
 
     /* バッファオーバーランチェック */
     /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
     LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
 
-    /* プリエンファシスフィルタ初期化 */
-    for (ch = 0; ch < config->max_num_channels; ch++) {
-        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
-            LINNEPreemphasisFilter_Initialize(&decoder->de_emphasis[ch][l]);
-        }
-    }
+    /* 内部状態の初期化 */
+    (void)LINNEDecoder_Reset(decoder);
 
     return decoder;
 }
@@ -305,9 +400,52 @@ void LINNEDecoder_Destroy(struct LINNEDecoder *decoder)
 {
     if (decoder != NULL) {
         if (LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN)) {
-            free(decoder->work);
+            LINNE_FreeMemory(decoder->work);
+        }
+    }
+}
+
+/* 直前のブロックに依存するデコードの基準を破棄
+* 以降はパラメータを持つ圧縮データブロックをデコードするまで、再利用・差分記録したブロックをデコードしない */
+static void LINNEDecoder_InvalidateReference(struct LINNEDecoder *decoder)
+{
+    uint32_t ch;
+
+    LINNE_ASSERT(decoder != NULL);
+
+    decoder->reusable_preset = NULL;
+    for (ch = 0; ch < LINNE_MAX_NUM_CHANNELS; ch++) {
+        decoder->last_samples[ch] = 0;
+    }
+}
+
+/* デコーダハンドルを作成直後の状態に戻す */
+LINNEApiResult LINNEDecoder_Reset(struct LINNEDecoder *decoder)
+{
+    uint32_t ch, l;
+
+    /* 引数チェック */
+    if (decoder == NULL) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダ未設定に戻す（領域確保・CRC検査のフラグはコンフィグ由来のため残す） */
+    LINNEDECODER_CLEAR_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER);
+    decoder->parameter_preset = NULL;
+    LINNEDecoder_InvalidateReference(decoder);
+
+    /* タスク実行コールバックを外して逐次処理に戻す */
+    decoder->run_tasks = NULL;
+    decoder->run_tasks_user_data = NULL;
+
+    /* デエンファシスフィルタ初期化 */
+    for (ch = 0; ch < decoder->max_num_channels; ch++) {
+        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+            LINNEPreemphasisFilter_Initialize(&decoder->de_emphasis[ch][l]);
         }
     }
+
+    return LINNE_APIRESULT_OK;
 }
 
 /* デコーダにヘッダをセット */
@@ -332,7 +470,8 @@ LINNEApiResult LINNEDecoder_SetHeader(
     /* 最大レイヤー数/パラメータ数のチェック */
     {
         uint32_t i;
-        const struct LINNEParameterPreset* preset = &g_linne_parameter_preset[header->preset];
+        struct LINNEParameterPreset custom;
+        const struct LINNEParameterPreset* preset = LINNE_GetLayerStructure(header, &custom);
         if (decoder->max_num_layers < preset->num_layers) {
             return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
         }
@@ -343,14 +482,32 @@ LINNEApiResult LINNEDecoder_SetHeader(
         }
     }
 
-    /* エンコードプリセットを取得 */
-    LINNE_ASSERT(header->preset < LINNE_NUM_PARAMETER_PRESETS);
-    decoder->parameter_preset = &g_linne_parameter_preset[header->preset];
-
     /* ヘッダセット */
     decoder->header = (*header);
+
+    /* エンコードプリセットを取得（独自レイヤー構造はセットしたヘッダを参照） */
+    LINNE_ASSERT(header->preset < LINNE_NUM_PARAMETER_PRESETS);
+    decoder->parameter_preset = LINNE_GetLayerStructure(&decoder->header, &decoder->custom_preset);
     LINNEDECODER_SET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER);
 
+    /* 以前のストリームのパラメータ・末尾サンプルは参照させない */
+    LINNEDecoder_InvalidateReference(decoder);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* タスク実行コールバックの設定 */
+LINNEApiResult LINNEDecoder_SetTaskCallback(
+        struct LINNEDecoder *decoder, LINNEDecoderRunTasksCallback callback, void *user_data)
+{
+    /* 引数チェック */
+    if (decoder == NULL) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    decoder->run_tasks = callback;
+    decoder->run_tasks_user_data = (callback != NULL) ? user_data : NULL;
+
     return LINNE_APIRESULT_OK;
 }
 
@@ -427,17 +584,100 @@ static LINNEApiResult LINNEDecoder_DecodeRawData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 圧縮データブロックデコード */
-static LINNEApiResult LINNEDecoder_DecodeCompressData(
+/* Rice符号の読み出し */
+static uint32_t LINNEDecoder_GetRiceCode(struct BitStream *reader, uint32_t k)
+{
+    uint32_t quot, rem;
+
+    LINNE_ASSERT(reader != NULL);
+
+    BitReader_GetZeroRunLength(reader, &quot);
+    BitReader_GetBits(reader, &rem, k);
+
+    return (quot << k) | rem;
+}
+
+/* 直前のブロックとの差分で記録されたパラメータの復号 */
+static void LINNEDecoder_GetDeltaParameters(
+        struct LINNEDecoder *decoder, struct BitStream *reader, uint32_t num_channels, uint8_t reuse_parameters)
+{
+    uint32_t ch, l, i, k, uval;
+    int32_t basis[LINNE_MAX_NUM_CHANNELS];
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(reader != NULL);
+    LINNE_ASSERT(num_channels <= LINNE_MAX_NUM_CHANNELS);
+
+    header = &(decoder->header);
+
+    /* プリエンファシス */
+    /* 初段の初期値: 直前のブロックの末尾サンプルをこのブロックと同じように前処理した値との差分 */
+    LINNEUtility_CalculatePreemphasisBasis(decoder->last_samples, decoder->wasted_bits, num_channels,
+            (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) ? 1 : 0, basis);
+    BitReader_GetBits(reader, &k, LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH);
+    for (ch = 0; ch < num_channels; ch++) {
+        uval = LINNEDecoder_GetRiceCode(reader, k);
+        decoder->de_emphasis[ch][0].prev = basis[ch] + LINNEUTILITY_UINT32_TO_SINT32(uval);
+    }
+    /* 各段の係数 2段目以降の初期値は前段の初期値を前段でプリエンファシスした値 */
+    for (ch = 0; ch < num_channels; ch++) {
+        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+            struct LINNEPreemphasisFilter *filters = decoder->de_emphasis[ch];
+            if (l > 0) {
+                filters[l].prev = filters[l - 1].prev
+                    - ((filters[l - 1].prev * filters[l - 1].coef) >> LINNE_PREEMPHASIS_COEF_SHIFT);
+            }
+            BitReader_GetBits(reader, &uval, LINNE_PREEMPHASIS_COEF_SHIFT - 1);
+            filters[l].coef = (int32_t)uval;
+        }
+    }
+
+    /* ユニット数/LPC係数右シフト量/LPC係数の差分 再利用する場合は記録されていない */
+    for (ch = 0; (reuse_parameters != 1) && (ch < num_channels); ch++) {
+        for (l = 0; l < decoder->parameter_preset->num_layers; l++) {
+            uint32_t num_units, rshift;
+            uint8_t same_shape;
+            int32_t *params_int = LINNEDECODER_PARAMS_INT(decoder, ch, l);
+            /* log2(ユニット数) */
+            BitReader_GetBits(reader, &uval, LINNE_LOG2_NUM_UNITS_BITWIDTH);
+            num_units = (1U << uval);
+            /* LPC係数右シフト量 */
+            BitReader_GetBits(reader, &uval, LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH);
+            rshift = (uint32_t)(LINNE_LPC_COEFFICIENT_BITWIDTH - LINNEUTILITY_UINT32_TO_SINT32(uval));
+            /* ユニット数と右シフト量が同じときのみ保持している係数との差分 */
+            same_shape = ((num_units == LINNEDECODER_LAYER_INFO(decoder, num_units, ch, l))
+                    && (rshift == LINNEDECODER_LAYER_INFO(decoder, rshifts, ch, l))) ? 1 : 0;
+            LINNEDECODER_LAYER_INFO(decoder, num_units, ch, l) = num_units;
+            LINNEDECODER_LAYER_INFO(decoder, rshifts, ch, l) = rshift;
+            /* LPC係数 */
+            BitReader_GetBits(reader, &k, LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH);
+            for (i = 0; i < decoder->parameter_preset->num_params_list[l]; i++) {
+                uval = LINNEDecoder_GetRiceCode(reader, k);
+                params_int[i] = ((same_shape == 1) ? params_int[i] : 0) + LINNEUTILITY_UINT32_TO_SINT32(uval);
+            }
+        }
+    }
+}
+
+/* 圧縮データブロックのパラメータと残差の復号
+* パラメータはch_offsetから始まるチャンネル領域に格納する
+* has_wasted_bitsが1のときは先頭のチャンネル毎の下位の無効ビット数も読む
+* parameter_flagsに再利用フラグが立っているときはLPCパラメータを読まず、直前の圧縮データブロックのものを使う
+* parameter_flagsに差分記録フラグが立っているときはパラメータを直前のブロックとの差分として読む */
+static LINNEApiResult LINNEDecoder_DecodeCompressDataParameters(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
         int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
-        uint32_t *decode_size)
+        uint32_t ch_offset, uint8_t has_wasted_bits, uint8_t parameter_flags, uint32_t *decode_size)
 {
     uint32_t ch;
     int32_t l;
     struct BitStream reader;
     const struct LINNEHeader *header;
+    const uint8_t reuse_parameters = (parameter_flags & LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG) ? 1 : 0;
+    const uint8_t delta_parameters = (parameter_flags & LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG) ? 1 : 0;
 
     /* 内部関数なので不正な引数はアサートで落とす */
     LINNE_ASSERT(decoder != NULL);
@@ -453,36 +693,71 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
 
     /* チャンネル数不足もアサートで落とす */
     LINNE_ASSERT(num_channels >= header->num_channels);
+    LINNE_ASSERT((ch_offset + num_channels) <= decoder->max_num_channels);
+
+    /* パラメータの再利用・差分記録の可否 */
+    if ((reuse_parameters == 1) || (delta_parameters == 1)) {
+        /* 直前の圧縮データブロックをデコードしていない */
+        if ((decoder->reusable_preset == NULL) || (ch_offset != 0)) {
+            return LINNE_APIRESULT_INSUFFICIENT_DATA;
+        }
+        /* 直前とレイヤー構造が異なる */
+        if (decoder->reusable_preset != decoder->parameter_preset) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+    }
+    if (reuse_parameters != 1) {
+        /* パラメータを上書きするので、復号し終えるまで再利用不可 */
+        decoder->reusable_preset = NULL;
+    }
 
     /* ビットリーダ作成 */
     BitReader_Open(&reader, (uint8_t *)data, data_size);
 
     /* パラメータ復号 */
-    /* プリエンファシス */
+    /* 下位の無効ビット数 */
     for (ch = 0; ch < num_channels; ch++) {
+        uint32_t uval = 0;
+        if (has_wasted_bits == 1) {
+            BitReader_GetBits(&reader, &uval, LINNE_WASTED_BITS_BITWIDTH);
+            /* サンプルのビット幅以上は落とせない */
+            if (uval >= header->bits_per_sample) {
+                BitStream_Close(&reader);
+                return LINNE_APIRESULT_INVALID_FORMAT;
+            }
+        }
+        decoder->wasted_bits[ch_offset + ch] = uval;
+    }
+    /* 直前のブロックとの差分 */
+    if (delta_parameters == 1) {
+        LINNEDecoder_GetDeltaParameters(decoder, &reader, num_channels, reuse_parameters);
+    }
+    /* プリエンファシス */
+    for (ch = 0; (delta_parameters != 1) && (ch < num_channels); ch++) {
         uint32_t uval;
         for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
             BitReader_GetBits(&reader, &uval, header->bits_per_sample + 1);
-            decoder->de_emphasis[ch][l].prev = LINNEUTILITY_UINT32_TO_SINT32(uval);
+            decoder->de_emphasis[ch_offset + ch][l].prev = LINNEUTILITY_UINT32_TO_SINT32(uval);
             /* プリエンファシス係数は正値に制限しているため1bitケチれる */
             BitReader_GetBits(&reader, &uval, LINNE_PREEMPHASIS_COEF_SHIFT - 1);
-            decoder->de_emphasis[ch][l].coef = (int32_t)uval;
+            decoder->de_emphasis[ch_offset + ch][l].coef = (int32_t)uval;
         }
     }
-    /* ユニット数/LPC係数右シフト量/LPC係数 */
-    for (ch = 0; ch < num_channels; ch++) {
+    /* ユニット数/LPC係数右シフト量/LPC係数 再利用・差分記録する場合は記録されていない */
+    for (ch = 0; (reuse_parameters != 1) && (delta_parameters != 1) && (ch < num_channels); ch++) {
         for (l = 0; l < (int32_t)decoder->parameter_preset->num_layers; l++) {
             uint32_t i, uval;
+            int32_t *params_int = LINNEDECODER_PARAMS_INT(decoder, ch_offset + ch, l);
             /* log2(ユニット数) */
             BitReader_GetBits(&reader, &uval, LINNE_LOG2_NUM_UNITS_BITWIDTH);
-            decoder->num_units[ch][l] = (1 << uval);
+            LINNEDECODER_LAYER_INFO(decoder, num_units, ch_offset + ch, l) = (1 << uval);
             /* 各レイヤーでのLPC係数右シフト量: 基準のLINNE_LPC_COEFFICIENT_BITWIDTHと差分をとる */
             BitReader_GetBits(&reader, &uval, LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH);
-            decoder->rshifts[ch][l] = (uint32_t)(LINNE_LPC_COEFFICIENT_BITWIDTH - LINNEUTILITY_UINT32_TO_SINT32(uval));
+            LINNEDECODER_LAYER_INFO(decoder, rshifts, ch_offset + ch, l) = (uint32_t)(LINNE_LPC_COEFFICIENT_BITWIDTH - LINNEUTILITY_UINT32_TO_SINT32(uval));
             /* LPC係数 */
             for (i = 0; i < decoder->parameter_preset->num_params_list[l]; i++) {
                 BitReader_GetBits(&reader, &uval, LINNE_LPC_COEFFICIENT_BITWIDTH);
-                decoder->params_int[ch][l][i] = LINNEUTILITY_UINT32_TO_SINT32(uval);
+                params_int[i] = LINNEUTILITY_UINT32_TO_SINT32(uval);
             }
         }
     }
@@ -501,27 +776,143 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
     /* ビットライタ破棄 */
     BitStream_Close(&reader);
 
-    /* チャンネル毎に合成処理 */
-    for (ch = 0; ch < header->num_channels; ch++) {
-        /* LPC合成 */
-        for (l = (int32_t)decoder->parameter_preset->num_layers - 1; l >= 0; l--) {
-            uint32_t u;
-            const uint32_t nunits = decoder->num_units[ch][l];
-            const uint32_t nparams_per_unit = decoder->parameter_preset->num_params_list[l] / nunits;
-            const uint32_t nsmpls_per_unit = num_decode_samples / nunits;
-            const uint32_t rshift = decoder->rshifts[ch][l];
-            for (u = 0; u < nunits; u++) {
-                int32_t *poutput = &buffer[ch][u * nsmpls_per_unit];
-                const int32_t *pcoef = &decoder->params_int[ch][l][u * nparams_per_unit];
-                /* 合成 */
-                LINNELPC_Synthesize(poutput, nsmpls_per_unit, pcoef, nparams_per_unit, rshift);
+    /* 先頭のチャンネル領域のパラメータのみ次のブロックで再利用できる */
+    if (ch_offset == 0) {
+        decoder->reusable_preset = decoder->parameter_preset;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 複数チャンネル（レーン）のLPC合成
+* レーンiのパラメータはlane_offset+iのチャンネル領域にあるものを使う
+* bits_per_sampleとformat_versionは全レーンに共通の音源のビット深度とフォーマットバージョン（演算精度の選択に使う）
+* 32bitの積和が桁あふれしうるユニットは64bitで積和して合成する
+* ただし旧フォーマットはエンコーダが32bit積和（桁あふれは巡回）で予測しているので、常に32bit以下の積和で合成する
+* 16bit以下の音源では出力が16bitに収まると見込んで16bit積和で合成する（収まらなければ32bit演算に切り替わる）
+* ユニット数が4未満で同じ形状（ユニット数とサンプル数）のレーンは4つまとめてインターリーブ合成し、
+* それ以外はレーン毎にユニット間で並列に合成する */
+static void LINNEDecoder_SynthesizeLanes(
+        struct LINNEDecoder *decoder, uint32_t lane_offset,
+        int32_t *const *lane_buffer, const uint32_t *lane_num_samples, uint32_t num_lanes,
+        uint32_t bits_per_sample, uint32_t format_version)
+{
+    int32_t l;
+    uint32_t i, j, n, u;
+    uint8_t int16_source, int64_accumulator, need_int64;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(lane_buffer != NULL);
+    LINNE_ASSERT(lane_num_samples != NULL);
+    LINNE_ASSERT((lane_offset + num_lanes) <= decoder->max_num_channels);
+
+    int16_source = (bits_per_sample <= 16) ? 1 : 0;
+    int64_accumulator = (format_version > LINNE_LAST_32BIT_ACCUMULATOR_FORMAT_VERSION) ? 1 : 0;
+
+    for (l = (int32_t)decoder->parameter_preset->num_layers - 1; l >= 0; l--) {
+        const uint32_t nparams = decoder->parameter_preset->num_params_list[l];
+        for (i = 0; i < num_lanes; i += n) {
+            const uint32_t nunits = LINNEDECODER_LAYER_INFO(decoder, num_units, lane_offset + i, l);
+            const uint32_t nparams_per_unit = nparams / nunits;
+            const uint32_t nsmpls_per_unit = lane_num_samples[i] / nunits;
+
+            /* 同じ形状のレーンを最大4つ集める */
+            for (n = 1; (n < 4) && ((i + n) < num_lanes); n++) {
+                if ((LINNEDECODER_LAYER_INFO(decoder, num_units, lane_offset + i + n, l) != nunits)
+                        || (lane_num_samples[i + n] != lane_num_samples[i])) {
+                    break;
+                }
+            }
+
+            /* 32bitの積和が桁あふれしうるユニットを含むか */
+            need_int64 = 0;
+            for (j = 0; (j < n) && int64_accumulator && !need_int64; j++) {
+                for (u = 0; (u < nunits) && !need_int64; u++) {
+                    need_int64 = LINNEUtility_IsLPCAccumulatorOverflowable(
+                            &LINNEDECODER_PARAMS_INT(decoder, lane_offset + i + j, l)[u * nparams_per_unit], nparams_per_unit,
+                            LINNEDECODER_LAYER_INFO(decoder, rshifts, lane_offset + i + j, l), bits_per_sample);
+                }
+            }
+
+            if (need_int64) {
+                /* ユニット毎にエンコーダと同じ判定で積和の精度を選んで合成 */
+                for (j = 0; j < n; j++) {
+                    for (u = 0; u < nunits; u++) {
+                        int32_t *pdata = &lane_buffer[i + j][u * nsmpls_per_unit];
+                        const int32_t *pcoef = &LINNEDECODER_PARAMS_INT(decoder, lane_offset + i + j, l)[u * nparams_per_unit];
+                        const uint32_t rshift = LINNEDECODER_LAYER_INFO(decoder, rshifts, lane_offset + i + j, l);
+                        if (LINNEUtility_IsLPCAccumulatorOverflowable(pcoef, nparams_per_unit, rshift, bits_per_sample)) {
+                            LINNELPC_SynthesizeInt64(pdata, nsmpls_per_unit, pcoef, nparams_per_unit, rshift);
+                        } else if (int16_source) {
+                            LINNELPC_SynthesizeInt16(pdata, nsmpls_per_unit, pcoef, nparams_per_unit, rshift);
+                        } else {
+                            LINNELPC_Synthesize(pdata, nsmpls_per_unit, pcoef, nparams_per_unit, rshift);
+                        }
+                    }
+                }
+            } else if (int16_source
+                    && ((nunits < 4) || (nparams_per_unit >= LINNEDECODER_INT16_UNITS_MIN_ORDER))) {
+                /* ユニット毎に16bit積和で合成 */
+                for (j = 0; j < n; j++) {
+                    for (u = 0; u < nunits; u++) {
+                        LINNELPC_SynthesizeInt16(&lane_buffer[i + j][u * nsmpls_per_unit], nsmpls_per_unit,
+                                &LINNEDECODER_PARAMS_INT(decoder, lane_offset + i + j, l)[u * nparams_per_unit], nparams_per_unit,
+                                LINNEDECODER_LAYER_INFO(decoder, rshifts, lane_offset + i + j, l));
+                    }
+                }
+            } else if ((n == 4) && (nunits < 4)) {
+                int32_t *pdata[4];
+                const int32_t *pcoef[4];
+                uint32_t rshift[4];
+                for (j = 0; j < 4; j++) {
+                    rshift[j] = LINNEDECODER_LAYER_INFO(decoder, rshifts, lane_offset + i + j, l);
+                }
+                for (u = 0; u < nunits; u++) {
+                    for (j = 0; j < 4; j++) {
+                        pdata[j] = &lane_buffer[i + j][u * nsmpls_per_unit];
+                        pcoef[j] = &LINNEDECODER_PARAMS_INT(decoder, lane_offset + i + j, l)[u * nparams_per_unit];
+                    }
+                    /* 合成 */
+                    LINNELPC_SynthesizeInterleaved4(pdata, nsmpls_per_unit, pcoef, nparams_per_unit, rshift);
+                }
+            } else {
+                /* ユニットが複数あればレーン内のユニット間で並列に合成 */
+                for (j = 0; j < n; j++) {
+                    LINNELPC_SynthesizeUnits(lane_buffer[i + j], nunits, nsmpls_per_unit,
+                            LINNEDECODER_PARAMS_INT(decoder, lane_offset + i + j, l), nparams_per_unit,
+                            LINNEDECODER_LAYER_INFO(decoder, rshifts, lane_offset + i + j, l));
+                }
             }
-        }
-        /* デエンファシス */
-        for (l = LINNE_NUM_PREEMPHASIS_FILTERS - 1; l >= 0; l--) {
-            LINNEPreemphasisFilter_Deemphasis(&decoder->de_emphasis[ch][l], buffer[ch], num_decode_samples);
         }
     }
+}
+
+/* 1チャンネルのデエンファシス
+* デエンファシスフィルタはchのチャンネル領域にあるものを使う */
+static void LINNEDecoder_DeemphasisChannel(
+        struct LINNEDecoder *decoder, uint32_t ch, int32_t *buffer, uint32_t num_decode_samples)
+{
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(buffer != NULL);
+    LINNE_ASSERT(ch < decoder->max_num_channels);
+
+    LINNEPreemphasisFilter_MultiStageDeemphasis(decoder->de_emphasis[ch], buffer, num_decode_samples);
+}
+
+/* チャンネル処理（MS -> LR） */
+static LINNEApiResult LINNEDecoder_ConvertChannels(
+        struct LINNEDecoder *decoder, int32_t **buffer, uint32_t num_decode_samples)
+{
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(buffer != NULL);
+
+    /* ヘッダ取得 */
+    header = &(decoder->header);
 
     /* MS -> LR */
     if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
@@ -536,6 +927,179 @@ static LINNEApiResult LINNEDecoder_DecodeCompressData(
     return LINNE_APIRESULT_OK;
 }
 
+/* 下位の無効ビットを戻す
+* 無効ビット数はch_offsetから始まるチャンネル領域にあるものを使う */
+static void LINNEDecoder_RestoreWastedBits(
+        struct LINNEDecoder *decoder, uint32_t ch_offset,
+        int32_t **buffer, uint32_t num_decode_samples)
+{
+    uint32_t ch, smpl;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(buffer != NULL);
+
+    for (ch = 0; ch < decoder->header.num_channels; ch++) {
+        const uint32_t shift = decoder->wasted_bits[ch_offset + ch];
+        int32_t *pbuffer = buffer[ch];
+        if (shift == 0) {
+            continue;
+        }
+        /* 補足）負値の左シフトを避けるため符号なしでシフト */
+        for (smpl = 0; smpl < num_decode_samples; smpl++) {
+            pbuffer[smpl] = (int32_t)((uint32_t)pbuffer[smpl] << shift);
+        }
+    }
+}
+
+/* デエンファシス・チャンネル処理と無効ビットの復元
+* デエンファシスフィルタと無効ビット数はch_offsetから始まるチャンネル領域にあるものを使う */
+static LINNEApiResult LINNEDecoder_PostProcess(
+        struct LINNEDecoder *decoder, uint32_t ch_offset,
+        int32_t **buffer, uint32_t num_decode_samples)
+{
+    uint32_t ch;
+    LINNEApiResult ret;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(buffer != NULL);
+
+    if ((decoder->header.ch_process_method == LINNE_CH_PROCESS_METHOD_MS)
+            && (decoder->header.num_channels == 2)) {
+        /* MSのステレオはデエンファシスとMS -> LRを1パスで処理 */
+        LINNEPreemphasisFilter_MultiStageDeemphasisLRConversion(
+                &decoder->de_emphasis[ch_offset], buffer, num_decode_samples);
+    } else {
+        /* デエンファシス */
+        for (ch = 0; ch < decoder->header.num_channels; ch++) {
+            LINNEDecoder_DeemphasisChannel(decoder, ch_offset + ch, buffer[ch], num_decode_samples);
+        }
+        /* MS -> LR */
+        if ((ret = LINNEDecoder_ConvertChannels(decoder, buffer, num_decode_samples)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+    }
+
+    /* 無効ビットの復元 */
+    LINNEDecoder_RestoreWastedBits(decoder, ch_offset, buffer, num_decode_samples);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* チャンネル毎合成タスクのコンテキスト */
+struct LINNEDecoderChannelTaskContext {
+    struct LINNEDecoder *decoder; /* デコーダ */
+    int32_t **buffer; /* 出力バッファ */
+    uint32_t num_decode_samples; /* チャンネルあたりサンプル数 */
+};
+
+/* チャンネル毎合成タスク: 1チャンネルのLPC合成とデエンファシス */
+static void LINNEDecoder_ChannelTask(void *task_context, uint32_t task_index)
+{
+    struct LINNEDecoderChannelTaskContext *context = (struct LINNEDecoderChannelTaskContext *)task_context;
+
+    LINNE_ASSERT(context != NULL);
+    LINNE_ASSERT(task_index < context->decoder->header.num_channels);
+
+    LINNEDecoder_SynthesizeLanes(context->decoder, task_index,
+            &context->buffer[task_index], &context->num_decode_samples, 1,
+            context->decoder->header.bits_per_sample, context->decoder->header.format_version);
+    LINNEDecoder_DeemphasisChannel(context->decoder, task_index,
+            context->buffer[task_index], context->num_decode_samples);
+}
+
+/* 圧縮データブロックのプリセットをデコーダにセット
+* ブロック毎にプリセットを切り替えるストリームでは、圧縮データ先頭にプリセット番号がある */
+static LINNEApiResult LINNEDecoder_SetBlockPreset(
+        struct LINNEDecoder *decoder, const uint8_t *data, uint32_t data_size, uint32_t *preset_size)
+{
+    uint8_t preset;
+    const uint8_t *read_ptr;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(preset_size != NULL);
+
+    /* ヘッダのプリセット（独自レイヤー構造）を使う */
+    if (decoder->header.enable_block_preset != 1) {
+        decoder->parameter_preset = LINNE_GetLayerStructure(&decoder->header, &decoder->custom_preset);
+        (*preset_size) = 0;
+        return LINNE_APIRESULT_OK;
+    }
+
+    if (data_size < 1) {
+        return LINNE_APIRESULT_INSUFFICIENT_DATA;
+    }
+    read_ptr = data;
+    ByteArray_GetUint8(read_ptr, &preset);
+
+    /* ヘッダのプリセットが上限（デコーダの容量はヘッダのプリセットで確認済み） */
+    if (preset > decoder->header.preset) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    decoder->parameter_preset = &g_linne_parameter_preset[preset];
+    (*preset_size) = (uint32_t)(read_ptr - data);
+    return LINNE_APIRESULT_OK;
+}
+
+/* 圧縮データブロックデコード */
+static LINNEApiResult LINNEDecoder_DecodeCompressData(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
+        uint8_t has_wasted_bits, uint8_t parameter_flags, uint32_t *decode_size)
+{
+    uint32_t ch, preset_size;
+    uint32_t lane_num_samples[LINNE_MAX_NUM_CHANNELS];
+    LINNEApiResult ret;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(num_channels <= LINNE_MAX_NUM_CHANNELS);
+
+    /* ブロックのプリセット取得 */
+    if ((ret = LINNEDecoder_SetBlockPreset(decoder, data, data_size, &preset_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* パラメータと残差の復号 */
+    if ((ret = LINNEDecoder_DecodeCompressDataParameters(decoder,
+                    data + preset_size, data_size - preset_size, buffer, num_channels, num_decode_samples,
+                    0, has_wasted_bits, parameter_flags, decode_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    (*decode_size) += preset_size;
+
+    /* タスク実行コールバックがあればチャンネル毎に並列に合成処理 */
+    /* 補足）チャンネル間の依存はMS -> LRのみ */
+    if ((decoder->run_tasks != NULL) && (decoder->header.num_channels > 1)) {
+        struct LINNEDecoderChannelTaskContext context;
+        context.decoder = decoder;
+        context.buffer = buffer;
+        context.num_decode_samples = num_decode_samples;
+        decoder->run_tasks(LINNEDecoder_ChannelTask, &context,
+                decoder->header.num_channels, decoder->run_tasks_user_data);
+        if ((ret = LINNEDecoder_ConvertChannels(decoder, buffer, num_decode_samples)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        LINNEDecoder_RestoreWastedBits(decoder, 0, buffer, num_decode_samples);
+        return LINNE_APIRESULT_OK;
+    }
+
+    /* チャンネル毎に合成処理 */
+    for (ch = 0; ch < decoder->header.num_channels; ch++) {
+        lane_num_samples[ch] = num_decode_samples;
+    }
+    LINNEDecoder_SynthesizeLanes(decoder, 0, buffer, lane_num_samples, decoder->header.num_channels,
+            decoder->header.bits_per_sample, decoder->header.format_version);
+
+    /* デエンファシスとチャンネル処理 */
+    return LINNEDecoder_PostProcess(decoder, 0, buffer, num_decode_samples);
+}
+
 /* 無音データブロックデコード */
 static LINNEApiResult LINNEDecoder_DecodeSilentData(
         struct LINNEDecoder *decoder,
@@ -571,57 +1135,95 @@ static LINNEApiResult LINNEDecoder_DecodeSilentData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 単一データブロックデコード */
-LINNEApiResult LINNEDecoder_DecodeBlock(
+/* 定数データブロックデコード */
+static LINNEApiResult LINNEDecoder_DecodeConstantData(
         struct LINNEDecoder *decoder,
         const uint8_t *data, uint32_t data_size,
-        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
-        uint32_t *decode_size, uint32_t *num_decode_samples)
-{
-    uint8_t buf8;
-    uint16_t buf16;
-    uint32_t buf32;
-    uint16_t num_block_samples;
-    uint32_t block_header_size, block_data_size;
-    LINNEApiResult ret;
-    LINNEBlockDataType block_type;
+        int32_t **buffer, uint32_t num_channels, uint32_t num_decode_samples,
+        uint32_t *decode_size)
+{
+    uint32_t ch, smpl;
+    struct BitStream reader;
     const struct LINNEHeader *header;
-    const uint8_t *read_ptr;
 
-    /* 引数チェック */
-    if ((decoder == NULL) || (data == NULL)
-            || (buffer == NULL) || (decode_size == NULL)
-            || (num_decode_samples == NULL)) {
-        return LINNE_APIRESULT_INVALID_ARGUMENT;
-    }
-
-    /* ヘッダがまだセットされていない */
-    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
-        return LINNE_APIRESULT_PARAMETER_NOT_SET;
-    }
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(buffer != NULL);
+    LINNE_ASSERT(buffer[0] != NULL);
+    LINNE_ASSERT(num_decode_samples > 0);
+    LINNE_ASSERT(decode_size != NULL);
 
     /* ヘッダ取得 */
     header = &(decoder->header);
 
-    /* バッファチャンネル数チェック */
-    if (buffer_num_channels < header->num_channels) {
-        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    /* チャンネル数不足もアサートで落とす */
+    LINNE_ASSERT(num_channels >= header->num_channels);
+
+    /* データサイズチェック */
+    if (data_size < (uint32_t)((header->bits_per_sample * header->num_channels + 7) / 8)) {
+        return LINNE_APIRESULT_INSUFFICIENT_DATA;
     }
 
-    /* ブロックヘッダデコード */
+    /* チャンネル毎の定数値で埋める */
+    BitReader_Open(&reader, (uint8_t *)data, data_size);
+    for (ch = 0; ch < header->num_channels; ch++) {
+        uint32_t uval;
+        int32_t value;
+        BitReader_GetBits(&reader, &uval, header->bits_per_sample);
+        value = LINNEUTILITY_UINT32_TO_SINT32(uval);
+        for (smpl = 0; smpl < num_decode_samples; smpl++) {
+            buffer[ch][smpl] = value;
+        }
+    }
+    BitStream_Flush(&reader);
+    BitStream_Tell(&reader, (int32_t *)decode_size);
+    BitStream_Close(&reader);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* ブロックヘッダのデコード */
+static LINNEApiResult LINNEDecoder_DecodeBlockHeader(
+        const struct LINNEDecoder *decoder, const uint8_t *data, uint32_t data_size,
+        LINNEBlockDataType *block_type, uint8_t *has_wasted_bits, uint8_t *parameter_flags,
+        uint16_t *num_block_samples, uint32_t *block_header_size, uint32_t *block_size)
+{
+    uint8_t buf8;
+    uint16_t buf16;
+    uint32_t buf32;
+    const uint8_t *read_ptr;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(block_type != NULL);
+    LINNE_ASSERT(has_wasted_bits != NULL);
+    LINNE_ASSERT(parameter_flags != NULL);
+    LINNE_ASSERT(num_block_samples != NULL);
+    LINNE_ASSERT(block_header_size != NULL);
+    LINNE_ASSERT(block_size != NULL);
+
     read_ptr = data;
 
+    /* ブロックヘッダが読めるか */
+    if (data_size < LINNE_BLOCK_HEADER_SIZE) {
+        return LINNE_APIRESULT_INSUFFICIENT_DATA;
+    }
+
     /* 同期コード */
     ByteArray_GetUint16BE(read_ptr, &buf16);
     /* 同期コード不一致 */
     if (buf16 != LINNE_BLOCK_SYNC_CODE) {
         return LINNE_APIRESULT_INVALID_FORMAT;
     }
-    /* ブロックサイズ */
+    /* ブロックサイズ: CRC計算前に範囲を確認する（不正な値で範囲外を読まないように） */
     ByteArray_GetUint32BE(read_ptr, &buf32);
-    LINNE_ASSERT(buf32 > 0);
-    /* データサイズ不足 */
-    if ((buf32 + 6) > data_size) {
+    if (buf32 < (LINNE_BLOCK_HEADER_SIZE - 6)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    /* データサイズ不足 補足）data_sizeはブロックヘッダサイズ以上なので引き算は負にならない */
+    if (buf32 > (data_size - 6)) {
         return LINNE_APIRESULT_INSUFFICIENT_DATA;
     }
     /* ブロックCRC16 */
@@ -634,30 +1236,90 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
             return LINNE_APIRESULT_DETECT_DATA_CORRUPTION;
         }
     }
-    /* ブロックデータタイプ */
+    /* ブロックデータタイプ: 無効ビット・パラメータ再利用・差分記録のフラグは圧縮データにのみ立つ */
     ByteArray_GetUint8(read_ptr, &buf8);
-    block_type = (LINNEBlockDataType)buf8;
+    (*has_wasted_bits) = (buf8 & LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG) ? 1 : 0;
+    (*parameter_flags) = (uint8_t)(buf8
+            & (LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG | LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG));
+    (*block_type) = (LINNEBlockDataType)(buf8 & ~LINNE_BLOCK_DATA_TYPE_FLAGS);
+    if (((buf8 & LINNE_BLOCK_DATA_TYPE_FLAGS) != 0) && ((*block_type) != LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
     /* ブロックチャンネルあたりサンプル数 */
-    ByteArray_GetUint16BE(read_ptr, &num_block_samples);
+    ByteArray_GetUint16BE(read_ptr, num_block_samples);
+    if (((*num_block_samples) == 0) || ((*num_block_samples) > decoder->header.num_samples_per_block)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    /* ブロックヘッダサイズ */
+    (*block_header_size) = (uint32_t)(read_ptr - data);
+    /* ブロックサイズ（同期コードとブロックサイズ自体の6byteを含む） */
+    (*block_size) = buf32 + 6;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 単一データブロックデコード（引数チェック済み） */
+static LINNEApiResult LINNEDecoder_DecodeBlockCore(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+        uint32_t *decode_size, uint32_t *num_decode_samples)
+{
+    uint16_t num_block_samples;
+    uint32_t block_header_size, block_size, block_data_size;
+    LINNEApiResult ret;
+    LINNEBlockDataType block_type;
+    uint8_t has_wasted_bits, parameter_flags;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(buffer != NULL);
+    LINNE_ASSERT(decode_size != NULL);
+    LINNE_ASSERT(num_decode_samples != NULL);
+
+    /* ヘッダがまだセットされていない */
+    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* ヘッダ取得 */
+    header = &(decoder->header);
+
+    /* バッファチャンネル数チェック */
+    if (buffer_num_channels < header->num_channels) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* ブロックヘッダデコード */
+    if ((ret = LINNEDecoder_DecodeBlockHeader(decoder, data, data_size,
+                    &block_type, &has_wasted_bits, &parameter_flags, &num_block_samples,
+                    &block_header_size, &block_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
     if (num_block_samples > buffer_num_samples) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
-    /* ブロックヘッダサイズ */
-    block_header_size = (uint32_t)(read_ptr - data);
 
     /* データ部のデコード */
     switch (block_type) {
     case LINNE_BLOCK_DATA_TYPE_RAWDATA:
         ret = LINNEDecoder_DecodeRawData(decoder,
-                read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+                data + block_header_size, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
         ret = LINNEDecoder_DecodeCompressData(decoder,
-                read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+                data + block_header_size, data_size - block_header_size, buffer, header->num_channels, num_block_samples,
+                has_wasted_bits, parameter_flags, &block_data_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_SILENT:
         ret = LINNEDecoder_DecodeSilentData(decoder,
-                read_ptr, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+                data + block_header_size, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
+        break;
+    case LINNE_BLOCK_DATA_TYPE_CONSTANT:
+        ret = LINNEDecoder_DecodeConstantData(decoder,
+                data + block_header_size, data_size - block_header_size, buffer, header->num_channels, num_block_samples, &block_data_size);
         break;
     default:
         return LINNE_APIRESULT_INVALID_FORMAT;
@@ -668,16 +1330,334 @@ LINNEApiResult LINNEDecoder_DecodeBlock(
         return ret;
     }
 
+    /* ブロックサイズとデータ部の内容が食い違っている */
+    if ((block_header_size + block_data_size) != block_size) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
     /* デコードサイズ */
     (*decode_size) = block_header_size + block_data_size;
 
     /* デコードサンプル数 */
     (*num_decode_samples) = num_block_samples;
 
+    /* 次のブロックの差分の基準として末尾サンプルを記録 */
+    if (num_block_samples > 0) {
+        uint32_t ch;
+        for (ch = 0; ch < header->num_channels; ch++) {
+            decoder->last_samples[ch] = buffer[ch][num_block_samples - 1];
+        }
+    }
+
     /* デコード成功 */
     return LINNE_APIRESULT_OK;
 }
 
+/* 単一データブロックデコード */
+LINNEApiResult LINNEDecoder_DecodeBlock(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size,
+        int32_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+        uint32_t *decode_size, uint32_t *num_decode_samples)
+{
+    LINNEApiResult ret;
+
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL)
+            || (buffer == NULL) || (decode_size == NULL)
+            || (num_decode_samples == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* 失敗したブロックの次のブロックが、失敗より前のブロックを基準にデコードされないよう破棄 */
+    if ((ret = LINNEDecoder_DecodeBlockCore(decoder, data, data_size,
+                    buffer, buffer_num_channels, buffer_num_samples,
+                    decode_size, num_decode_samples)) != LINNE_APIRESULT_OK) {
+        LINNEDecoder_InvalidateReference(decoder);
+        return ret;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 一括デコード用: ブロックをLPC合成の直前までデコード
+* 圧縮ブロックのパラメータはch_offsetから始まるチャンネル領域に格納し、is_compressedを1にする */
+static LINNEApiResult LINNEDecoder_DecodeRequestBeforeSynthesis(
+        struct LINNEDecoder *decoder, struct LINNEDecodeBlockRequest *request,
+        uint32_t ch_offset, uint8_t *is_compressed)
+{
+    uint16_t num_block_samples;
+    uint32_t block_header_size, block_size, block_data_size;
+    LINNEApiResult ret;
+    LINNEBlockDataType block_type;
+    uint8_t has_wasted_bits, parameter_flags;
+    const uint8_t *read_ptr;
+    uint32_t read_size;
+
+    LINNE_ASSERT(decoder != NULL);
+    LINNE_ASSERT(request != NULL);
+    LINNE_ASSERT(is_compressed != NULL);
+
+    (*is_compressed) = 0;
+
+    /* 引数チェック */
+    if ((request->header == NULL) || (request->data == NULL) || (request->buffer == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダセット（有効性と容量のチェックを含む） */
+    if ((ret = LINNEDecoder_SetHeader(decoder, request->header)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* バッファチャンネル数チェック */
+    if (request->buffer_num_channels < request->header->num_channels) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* ブロックヘッダデコード */
+    if ((ret = LINNEDecoder_DecodeBlockHeader(decoder, request->data, request->data_size,
+                    &block_type, &has_wasted_bits, &parameter_flags, &num_block_samples,
+                    &block_header_size, &block_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    if (num_block_samples > request->buffer_num_samples) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+    read_ptr = request->data + block_header_size;
+    read_size = request->data_size - block_header_size;
+
+    /* データ部のデコード */
+    switch (block_type) {
+    case LINNE_BLOCK_DATA_TYPE_RAWDATA:
+        ret = LINNEDecoder_DecodeRawData(decoder,
+                read_ptr, read_size, request->buffer, request->header->num_channels, num_block_samples, &block_data_size);
+        break;
+    case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
+        {
+            uint32_t preset_size;
+            if ((ret = LINNEDecoder_SetBlockPreset(decoder, read_ptr, read_size, &preset_size)) != LINNE_APIRESULT_OK) {
+                return ret;
+            }
+            /* 合成は後でまとめて行う */
+            if ((ret = LINNEDecoder_DecodeCompressDataParameters(decoder,
+                            read_ptr + preset_size, read_size - preset_size,
+                            request->buffer, request->header->num_channels, num_block_samples,
+                            ch_offset, has_wasted_bits, parameter_flags, &block_data_size)) != LINNE_APIRESULT_OK) {
+                return ret;
+            }
+            block_data_size += preset_size;
+            (*is_compressed) = 1;
+        }
+        break;
+    case LINNE_BLOCK_DATA_TYPE_SILENT:
+        ret = LINNEDecoder_DecodeSilentData(decoder,
+                read_ptr, read_size, request->buffer, request->header->num_channels, num_block_samples, &block_data_size);
+        break;
+    case LINNE_BLOCK_DATA_TYPE_CONSTANT:
+        ret = LINNEDecoder_DecodeConstantData(decoder,
+                read_ptr, read_size, request->buffer, request->header->num_channels, num_block_samples, &block_data_size);
+        break;
+    default:
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* ブロックサイズとデータ部の内容が食い違っている */
+    if ((ret == LINNE_APIRESULT_OK) && ((block_header_size + block_data_size) != block_size)) {
+        ret = LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 結果記録 */
+    request->decode_size = block_header_size + block_data_size;
+    request->num_decode_samples = num_block_samples;
+
+    return ret;
+}
+
+/* 一括デコード用: ブロックのデコードに使うレイヤー構造を先読み
+* 判定できない場合は0を返す（デコード時にエラーになる） */
+static uint8_t LINNEDecoder_PeekBlockPreset(
+        const struct LINNEHeader *header, const uint8_t *data, uint32_t data_size,
+        struct LINNEParameterPreset *preset)
+{
+    uint8_t preset_no;
+
+    LINNE_ASSERT(header != NULL);
+    LINNE_ASSERT(preset != NULL);
+
+    if (header->preset >= LINNE_NUM_PARAMETER_PRESETS) {
+        return 0;
+    }
+    if (header->num_custom_layers > LINNE_MAX_NUM_CUSTOM_LAYERS) {
+        return 0;
+    }
+    if (header->enable_block_preset != 1) {
+        (*preset) = *LINNE_GetLayerStructure(header, preset);
+        return 1;
+    }
+
+    /* 圧縮データブロックの先頭にあるプリセット番号を読む（データタイプは同期コード・ブロックサイズ・CRC16に続く8byte目） */
+    if ((data == NULL) || (data_size <= LINNE_BLOCK_HEADER_SIZE)
+            || ((data[8] & ~LINNE_BLOCK_DATA_TYPE_FLAGS) != LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)) {
+        return 0;
+    }
+    preset_no = data[LINNE_BLOCK_HEADER_SIZE];
+    if (preset_no > header->preset) {
+        return 0;
+    }
+
+    (*preset) = g_linne_parameter_preset[preset_no];
+    return 1;
+}
+
+/* レイヤー構造が等しいか判定 等しければ1を返す */
+static uint8_t LINNEDecoder_IsSameLayerStructure(
+        const struct LINNEParameterPreset *a, const struct LINNEParameterPreset *b)
+{
+    uint32_t l;
+
+    LINNE_ASSERT(a != NULL);
+    LINNE_ASSERT(b != NULL);
+
+    if (a->num_layers != b->num_layers) {
+        return 0;
+    }
+    for (l = 0; l < a->num_layers; l++) {
+        if (a->num_params_list[l] != b->num_params_list[l]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* 異なるストリームの複数ブロックを一括デコード */
+LINNEApiResult LINNEDecoder_DecodeBlocks(
+        struct LINNEDecoder *decoder,
+        struct LINNEDecodeBlockRequest *requests, uint32_t num_requests)
+{
+    uint32_t i, g, ch, num_group, num_lanes, max_num_lanes, group_bits_per_sample, group_format_version;
+    uint32_t group_request[LINNE_MAX_NUM_CHANNELS];
+    uint32_t group_ch_offset[LINNE_MAX_NUM_CHANNELS];
+    int32_t *lane_buffer[LINNE_MAX_NUM_CHANNELS];
+    uint32_t lane_num_samples[LINNE_MAX_NUM_CHANNELS];
+    struct LINNEParameterPreset group_preset, block_preset;
+    uint32_t group_num_params_list[LINNE_MAX_NUM_CUSTOM_LAYERS];
+    uint8_t has_group_preset;
+    struct LINNEHeader saved_header;
+    const struct LINNEParameterPreset *saved_preset;
+    struct LINNEParameterPreset saved_custom_preset;
+    uint8_t saved_status_flags;
+    LINNEApiResult ret = LINNE_APIRESULT_OK;
+
+    /* 引数チェック */
+    if ((decoder == NULL) || (requests == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ハンドルにセットされたヘッダを退避 */
+    saved_header = decoder->header;
+    saved_preset = decoder->parameter_preset;
+    saved_custom_preset = decoder->custom_preset;
+    saved_status_flags = decoder->status_flags;
+
+    /* 同時に合成するチャンネル数（レーン数） */
+    max_num_lanes = LINNEUTILITY_MIN(decoder->max_num_channels, LINNE_MAX_NUM_CHANNELS);
+
+    i = 0;
+    while (i < num_requests) {
+        /* チャンネル領域が埋まるまでLPC合成の直前までデコード */
+        num_group = 0;
+        num_lanes = 0;
+        has_group_preset = 0;
+        group_bits_per_sample = 0;
+        group_format_version = 0;
+        for (; i < num_requests; i++) {
+            struct LINNEDecodeBlockRequest *request = &requests[i];
+            uint8_t is_compressed;
+            if (request->header != NULL) {
+                const uint32_t num_channels = request->header->num_channels;
+                const uint8_t has_block_preset
+                    = LINNEDecoder_PeekBlockPreset(request->header, request->data, request->data_size, &block_preset);
+                /* 一度に合成できない */
+                if (num_channels > max_num_lanes) {
+                    request->result = LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+                    continue;
+                }
+                /* レーンが足りない・プリセットが異なる・ビット深度かフォーマットバージョンが異なる（演算精度の選択が変わる）場合はここで合成する */
+                if ((num_lanes + num_channels) > max_num_lanes) {
+                    break;
+                }
+                if (has_group_preset && has_block_preset
+                        && !LINNEDecoder_IsSameLayerStructure(&group_preset, &block_preset)) {
+                    break;
+                }
+                if (has_group_preset && ((request->header->bits_per_sample != group_bits_per_sample)
+                            || (request->header->format_version != group_format_version))) {
+                    break;
+                }
+            }
+            request->result = LINNEDecoder_DecodeRequestBeforeSynthesis(decoder, request, num_lanes, &is_compressed);
+            if ((request->result == LINNE_APIRESULT_OK) && is_compressed) {
+                /* 後続のリクエストでヘッダが書き換わっても参照できるよう構造をコピー */
+                if (!has_group_preset) {
+                    LINNE_ASSERT(decoder->parameter_preset->num_layers <= LINNE_MAX_NUM_CUSTOM_LAYERS);
+                    memcpy(group_num_params_list, decoder->parameter_preset->num_params_list,
+                            sizeof(uint32_t) * decoder->parameter_preset->num_layers);
+                    group_preset.num_layers = decoder->parameter_preset->num_layers;
+                    group_preset.num_params_list = group_num_params_list;
+                    group_bits_per_sample = request->header->bits_per_sample;
+                    group_format_version = request->header->format_version;
+                    has_group_preset = 1;
+                }
+                group_request[num_group] = i;
+                group_ch_offset[num_group] = num_lanes;
+                for (ch = 0; ch < request->header->num_channels; ch++) {
+                    lane_buffer[num_lanes + ch] = request->buffer[ch];
+                    lane_num_samples[num_lanes + ch] = request->num_decode_samples;
+                }
+                num_lanes += request->header->num_channels;
+                num_group++;
+            }
+        }
+
+        if (num_group == 0) {
+            continue;
+        }
+
+        /* ストリームをまたいでLPC合成 */
+        decoder->parameter_preset = &group_preset;
+        LINNEDecoder_SynthesizeLanes(decoder, 0, lane_buffer, lane_num_samples, num_lanes,
+                group_bits_per_sample, group_format_version);
+
+        /* デエンファシスとチャンネル処理 */
+        for (g = 0; g < num_group; g++) {
+            struct LINNEDecodeBlockRequest *request = &requests[group_request[g]];
+            decoder->header = (*request->header);
+            request->result = LINNEDecoder_PostProcess(decoder,
+                    group_ch_offset[g], request->buffer, request->num_decode_samples);
+        }
+    }
+
+    /* 最初の失敗結果を返す */
+    for (i = 0; i < num_requests; i++) {
+        if (requests[i].result != LINNE_APIRESULT_OK) {
+            ret = requests[i].result;
+            break;
+        }
+    }
+
+    /* ヘッダを復帰 */
+    decoder->header = saved_header;
+    decoder->parameter_preset = saved_preset;
+    decoder->custom_preset = saved_custom_preset;
+    /* 保持していたパラメータは上書きされたので再利用させない */
+    LINNEDecoder_InvalidateReference(decoder);
+    decoder->status_flags = saved_status_flags;
+
+    return ret;
+}
+
 /* ヘッダを含めて全ブロックデコード */
 LINNEApiResult LINNEDecoder_DecodeWhole(
         struct LINNEDecoder *decoder,
@@ -714,8 +1694,8 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
     }
 
     progress = 0;
-    read_offset = LINNE_HEADER_SIZE;
-    read_pos = data + LINNE_HEADER_SIZE;
+    read_offset = LINNE_CALCULATE_HEADER_SIZE(header);
+    read_pos = data + read_offset;
     while ((progress < header->num_samples) && (read_offset < data_size)) {
         /* サンプル書き出し位置のセット */
         for (ch = 0; ch < header->num_channels; ch++) {
@@ -739,3 +1719,244 @@ LINNEApiResult LINNEDecoder_DecodeWhole(
     /* 成功終了 */
     return LINNE_APIRESULT_OK;
 }
+
+/* 先頭のブロックのヘッダを読み、ブロックサイズ・サンプル数とCRC16検査結果を取得 */
+static LINNEApiResult LINNEDecoder_ParseBlockInfo(
+        const struct LINNEHeader *header, const uint8_t *data, uint32_t data_size, struct LINNEBlockInfo *block_info)
+{
+    uint8_t buf8;
+    uint16_t buf16, crc16;
+    uint32_t buf32;
+    const uint8_t *read_ptr = data;
+
+    LINNE_ASSERT(header != NULL);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(block_info != NULL);
+
+    if (data_size < LINNE_BLOCK_HEADER_SIZE) {
+        return LINNE_APIRESULT_INSUFFICIENT_DATA;
+    }
+
+    /* 同期コード */
+    ByteArray_GetUint16BE(read_ptr, &buf16);
+    if (buf16 != LINNE_BLOCK_SYNC_CODE) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    /* ブロックサイズ: CRC計算前に範囲を確認して無駄な計算を避ける */
+    ByteArray_GetUint32BE(read_ptr, &buf32);
+    if (buf32 < (LINNE_BLOCK_HEADER_SIZE - 6)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    if (buf32 > (data_size - 6)) {
+        return LINNE_APIRESULT_INSUFFICIENT_DATA;
+    }
+    /* ブロックCRC16 */
+    ByteArray_GetUint16BE(read_ptr, &crc16);
+    /* ブロックデータタイプ: 無効ビット・パラメータ再利用のフラグは圧縮データにのみ立つ */
+    ByteArray_GetUint8(read_ptr, &buf8);
+    if ((buf8 & LINNE_BLOCK_DATA_TYPE_FLAGS)
+            && ((buf8 & ~LINNE_BLOCK_DATA_TYPE_FLAGS) != LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    if ((buf8 & ~LINNE_BLOCK_DATA_TYPE_FLAGS) >= LINNE_BLOCK_DATA_TYPE_INVALID) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+    /* ブロックチャンネルあたりサンプル数 */
+    ByteArray_GetUint16BE(read_ptr, &buf16);
+    if ((buf16 == 0) || (buf16 > header->num_samples_per_block)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    block_info->data_offset = 0;
+    block_info->data_size = buf32 + 6;
+    block_info->sample_offset = 0;
+    block_info->num_samples = buf16;
+    /* CRC16は設定に関わらず必ず確認 */
+    block_info->corrupted = (LINNEUtility_CalculateCRC16(&data[8], buf32 - 2) != crc16) ? 1 : 0;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 同期コード位置のブロックが正常か判定 正常ならば1を返す */
+static uint8_t LINNEDecoder_IsValidBlock(
+        const struct LINNEHeader *header, const uint8_t *data, uint32_t data_size)
+{
+    struct LINNEBlockInfo block_info;
+
+    LINNE_ASSERT(header != NULL);
+    LINNE_ASSERT(data != NULL);
+
+    if (LINNEDecoder_ParseBlockInfo(header, data, data_size, &block_info) != LINNE_APIRESULT_OK) {
+        return 0;
+    }
+
+    return (block_info.corrupted == 0) ? 1 : 0;
+}
+
+/* dataの先頭にあるブロックの情報を取得 */
+LINNEApiResult LINNEDecoder_PeekBlockInfo(
+        const struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size, struct LINNEBlockInfo *block_info)
+{
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL) || (block_info == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダがまだセットされていない */
+    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    return LINNEDecoder_ParseBlockInfo(&(decoder->header), data, data_size, block_info);
+}
+
+/* dataの先頭から走査し、正常な最初のブロック位置を取得 */
+LINNEApiResult LINNEDecoder_FindNextBlock(
+        struct LINNEDecoder *decoder,
+        const uint8_t *data, uint32_t data_size, uint32_t *block_offset)
+{
+    const uint8_t *pos;
+    const uint8_t *tail;
+
+    /* 引数チェック */
+    if ((decoder == NULL) || (data == NULL) || (block_offset == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダがまだセットされていない */
+    if (!LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER)) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* 読み飛ばしたブロックがあり得るので、直前のブロックへの依存は解消できない */
+    LINNEDecoder_InvalidateReference(decoder);
+
+    /* 同期コードの上位バイトをmemchrで探す（多くの処理系でベクトル化されている） */
+    pos = data;
+    tail = data + data_size;
+    while ((pos < tail)
+            && ((pos = (const uint8_t *)memchr(pos, (LINNE_BLOCK_SYNC_CODE >> 8) & 0xFF, (size_t)(tail - pos))) != NULL)) {
+        if (((pos + 1) < tail) && (pos[1] == (LINNE_BLOCK_SYNC_CODE & 0xFF))
+                && LINNEDecoder_IsValidBlock(&(decoder->header), pos, (uint32_t)(tail - pos))) {
+            (*block_offset) = (uint32_t)(pos - data);
+            return LINNE_APIRESULT_OK;
+        }
+        pos++;
+    }
+
+    /* 見つからなかった */
+    return LINNE_APIRESULT_INSUFFICIENT_DATA;
+}
+
+/* ヘッダを含むデータから各ブロックの情報を取得 */
+LINNEApiResult LINNEDecoder_GetBlockInfo(
+        const uint8_t *data, uint32_t data_size,
+        struct LINNEBlockInfo *block_info, uint32_t max_num_blocks, uint32_t *num_blocks)
+{
+    LINNEApiResult ret;
+    uint16_t buf16;
+    uint32_t buf32, read_offset, progress, count;
+    const uint8_t *read_ptr;
+    struct LINNEHeader header;
+
+    /* 引数チェック */
+    if ((data == NULL) || (num_blocks == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* ヘッダデコード */
+    if ((ret = LINNEDecoder_DecodeHeader(data, data_size, &header))
+            != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    count = 0;
+    progress = 0;
+    read_offset = LINNE_CALCULATE_HEADER_SIZE(&header);
+    while ((progress < header.num_samples) && (read_offset < data_size)) {
+        /* ブロックヘッダ（同期コード〜サンプル数）が読めるか */
+        if ((read_offset + LINNE_BLOCK_HEADER_SIZE) > data_size) {
+            return LINNE_APIRESULT_INSUFFICIENT_DATA;
+        }
+        read_ptr = &data[read_offset];
+        /* 同期コード */
+        ByteArray_GetUint16BE(read_ptr, &buf16);
+        if (buf16 != LINNE_BLOCK_SYNC_CODE) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+        /* ブロックサイズ */
+        ByteArray_GetUint32BE(read_ptr, &buf32);
+        if ((buf32 + 6) < LINNE_BLOCK_HEADER_SIZE) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+        if ((buf32 + 6) > (data_size - read_offset)) {
+            return LINNE_APIRESULT_INSUFFICIENT_DATA;
+        }
+        /* CRC16とブロックデータタイプは読み飛ばす */
+        read_ptr += 3;
+        /* ブロックチャンネルあたりサンプル数 */
+        ByteArray_GetUint16BE(read_ptr, &buf16);
+
+        /* 情報記録 */
+        if (block_info != NULL) {
+            if (count >= max_num_blocks) {
+                return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+            }
+            block_info[count].data_offset = read_offset;
+            block_info[count].data_size = buf32 + 6;
+            block_info[count].sample_offset = progress;
+            block_info[count].num_samples = buf16;
+            block_info[count].corrupted = 0;
+        }
+
+        /* 進捗更新 */
+        count++;
+        read_offset += buf32 + 6;
+        progress += buf16;
+    }
+
+    (*num_blocks) = count;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* デコードせずにブロックのCRC16のみを検査 */
+LINNEApiResult LINNEDecoder_CheckBlocks(
+        const uint8_t *data, uint32_t data_size,
+        struct LINNEBlockInfo *block_info, uint32_t num_blocks)
+{
+    uint32_t blk;
+    uint16_t crc16;
+    const uint8_t *read_ptr;
+    LINNEApiResult ret = LINNE_APIRESULT_OK;
+
+    /* 引数チェック */
+    if ((data == NULL) || (block_info == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    for (blk = 0; blk < num_blocks; blk++) {
+        struct LINNEBlockInfo *pinfo = &block_info[blk];
+
+        /* 範囲外のブロック情報 */
+        if ((pinfo->data_size < LINNE_BLOCK_HEADER_SIZE)
+                || (pinfo->data_offset > data_size)
+                || (pinfo->data_size > (data_size - pinfo->data_offset))) {
+            return LINNE_APIRESULT_INVALID_ARGUMENT;
+        }
+
+        /* CRC16取得 */
+        read_ptr = &data[pinfo->data_offset + 6];
+        ByteArray_GetUint16BE(read_ptr, &crc16);
+
+        /* ブロックデータタイプ以降がCRC16の対象（CRC16自体とヘッダ6byteは除く） */
+        pinfo->corrupted
+            = (LINNEUtility_CalculateCRC16(read_ptr, pinfo->data_size - 8) != crc16) ? 1 : 0;
+        if (pinfo->corrupted) {
+            ret = LINNE_APIRESULT_DETECT_DATA_CORRUPTION;
+        }
+    }
+
+    return ret;
+}
@@ -2,6 +2,140 @@
 
 #include <string.h>
 #include "linne_internal.h"
+#include "linne_utility.h"
+
+/* SSE2によるユニット並列合成を使うか */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define LINNELPC_USE_SSE2
+#endif
+
+/* ユニット並列合成で扱える最大次数 */
+#define LINNELPC_UNITS_MAX_ORDER LINNE_NETWORK_MAX_PARAMS_PER_LAYER
+/* ユニット並列合成で履歴バッファを詰め直す間隔（サンプル数） */
+#define LINNELPC_UNITS_CHUNK_SIZE 128
+/* 64bit積和合成で扱える最大次数 */
+#define LINNELPC_INT64_MAX_ORDER LINNE_NETWORK_MAX_PARAMS_PER_LAYER
+/* 64bit積和合成で倍精度の履歴バッファを詰め直す間隔（サンプル数） */
+#define LINNELPC_INT64_CHUNK_SIZE 256
+/* 64bit積和合成でSSE2を使う最小次数（これより低次では整数→倍精度変換の遅延が積和より大きい） */
+#define LINNELPC_INT64_SSE2_MIN_ORDER 16
+
+/* 次数固定のLPC合成カーネル */
+typedef void (*LINNELPCSynthesizeKernel)(
+    int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_rshift);
+
+/* 次数固定のLPC合成カーネル定義（履歴と係数をレジスタに載せる低次用）
+* 全ループが定数長になるため、展開されて配列はレジスタに割り当てられる */
+#define LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(order)\
+static void LINNELPC_SynthesizeOrder ## order(\
+    int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_rshift)\
+{\
+    uint32_t smpl, ord;\
+    int32_t predict, hist[order], c[order];\
+    const int32_t half = 1 << (coef_rshift - 1);\
+    for (ord = 0; ord < (order); ord++) {\
+        c[ord] = coef[ord];\
+        hist[ord] = data[ord];\
+    }\
+    for (smpl = (order); smpl < num_samples; smpl++) {\
+        predict = half;\
+        for (ord = 0; ord < (order); ord++) {\
+            predict += c[ord] * hist[ord];\
+        }\
+        predict = data[smpl] - (predict >> coef_rshift);\
+        data[smpl] = predict;\
+        for (ord = 1; ord < (order); ord++) {\
+            hist[ord - 1] = hist[ord];\
+        }\
+        hist[(order) - 1] = predict;\
+    }\
+}
+
+/* 次数固定のLPC合成カーネル定義（高次用） */
+#define LINNELPC_DEFINE_SYNTHESIZE_KERNEL(order)\
+static void LINNELPC_SynthesizeOrder ## order(\
+    int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_rshift)\
+{\
+    uint32_t smpl, ord;\
+    int32_t predict;\
+    const int32_t half = 1 << (coef_rshift - 1);\
+    for (smpl = (order); smpl < num_samples; smpl++) {\
+        predict = half;\
+        for (ord = 0; ord < (order); ord++) {\
+            predict += coef[ord] * data[smpl - (order) + ord];\
+        }\
+        data[smpl] -= (predict >> coef_rshift);\
+    }\
+}
+
+/* プリセットで現れるユニットあたり次数: {4,8,16,32,64,96,128}を2の冪で割ったもの */
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(1)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(2)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(3)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(4)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(6)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(8)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(12)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER(16)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(24)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(32)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(48)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(64)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(96)
+LINNELPC_DEFINE_SYNTHESIZE_KERNEL(128)
+
+#undef LINNELPC_DEFINE_SYNTHESIZE_KERNEL_REGISTER
+#undef LINNELPC_DEFINE_SYNTHESIZE_KERNEL
+
+/* 次数に対応する固定次数カーネルの取得 対応するものがなければNULL */
+static LINNELPCSynthesizeKernel LINNELPC_GetSynthesizeKernel(uint32_t coef_order)
+{
+    switch (coef_order) {
+    case 1:     return LINNELPC_SynthesizeOrder1;
+    case 2:     return LINNELPC_SynthesizeOrder2;
+    case 3:     return LINNELPC_SynthesizeOrder3;
+    case 4:     return LINNELPC_SynthesizeOrder4;
+    case 6:     return LINNELPC_SynthesizeOrder6;
+    case 8:     return LINNELPC_SynthesizeOrder8;
+    case 12:    return LINNELPC_SynthesizeOrder12;
+    case 16:    return LINNELPC_SynthesizeOrder16;
+    case 24:    return LINNELPC_SynthesizeOrder24;
+    case 32:    return LINNELPC_SynthesizeOrder32;
+    case 48:    return LINNELPC_SynthesizeOrder48;
+    case 64:    return LINNELPC_SynthesizeOrder64;
+    case 96:    return LINNELPC_SynthesizeOrder96;
+    case 128:   return LINNELPC_SynthesizeOrder128;
+    default:    break;
+    }
+    return NULL;
+}
+
+/* 先頭coef_orderサンプルが合成済みのデータに対して、以降のサンプルを合成(in-place) */
+static void LINNELPC_SynthesizeTail(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    int32_t predict;
+    uint32_t smpl, ord;
+    const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
+    LINNELPCSynthesizeKernel kernel;
+
+    /* 固定次数カーネルがあればそちらで処理 */
+    if ((coef_order < num_samples)
+            && ((kernel = LINNELPC_GetSynthesizeKernel(coef_order)) != NULL)) {
+        kernel(data, num_samples, coef, coef_rshift);
+        return;
+    }
+
+    for (smpl = coef_order; smpl < num_samples; smpl++) {
+        predict = half;
+        for (ord = 0; ord < coef_order; ord++) {
+            predict += (coef[ord] * data[smpl - coef_order + ord]);
+        }
+        data[smpl] -= (predict >> coef_rshift);
+    }
+}
 
 /* LPC係数により合成(in-place) */
 void LINNELPC_Synthesize(
@@ -25,11 +159,361 @@ void LINNELPC_Synthesize(
         }
         data[smpl] -= (predict >> coef_rshift);
     }
+
+    /* 次数以降の合成 */
+    LINNELPC_SynthesizeTail(data, num_samples, coef, coef_order, coef_rshift);
+}
+
+/* 独立な4系列をインターリーブしてLPC合成(in-place) */
+void LINNELPC_SynthesizeInterleaved4(
+    int32_t *const *data, uint32_t num_samples,
+    const int32_t *const *coef, uint32_t coef_order, const uint32_t *coef_rshift)
+{
+    uint32_t smpl, ord;
+    int32_t predict0, predict1, predict2, predict3;
+    int32_t *data0, *data1, *data2, *data3;
+    const int32_t *coef0, *coef1, *coef2, *coef3;
+    const uint32_t rshift0 = coef_rshift[0], rshift1 = coef_rshift[1];
+    const uint32_t rshift2 = coef_rshift[2], rshift3 = coef_rshift[3];
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(coef_rshift != NULL);
+    LINNE_ASSERT((rshift0 != 0) && (rshift1 != 0) && (rshift2 != 0) && (rshift3 != 0));
+
+    data0 = data[0]; data1 = data[1]; data2 = data[2]; data3 = data[3];
+    coef0 = coef[0]; coef1 = coef[1]; coef2 = coef[2]; coef3 = coef[3];
+
+    /* 次数に満たない先頭部分は系列毎に処理 */
+    if (coef_order > num_samples) {
+        LINNELPC_Synthesize(data0, num_samples, coef0, coef_order, rshift0);
+        LINNELPC_Synthesize(data1, num_samples, coef1, coef_order, rshift1);
+        LINNELPC_Synthesize(data2, num_samples, coef2, coef_order, rshift2);
+        LINNELPC_Synthesize(data3, num_samples, coef3, coef_order, rshift3);
+        return;
+    }
+    LINNELPC_Synthesize(data0, coef_order, coef0, coef_order, rshift0);
+    LINNELPC_Synthesize(data1, coef_order, coef1, coef_order, rshift1);
+    LINNELPC_Synthesize(data2, coef_order, coef2, coef_order, rshift2);
+    LINNELPC_Synthesize(data3, coef_order, coef3, coef_order, rshift3);
+
+    /* 4系列の依存関係は独立なので、交互に計算して命令レベル並列性を引き出す */
+    for (smpl = coef_order; smpl < num_samples; smpl++) {
+        predict0 = 1 << (rshift0 - 1);
+        predict1 = 1 << (rshift1 - 1);
+        predict2 = 1 << (rshift2 - 1);
+        predict3 = 1 << (rshift3 - 1);
+        for (ord = 0; ord < coef_order; ord++) {
+            const uint32_t pos = smpl - coef_order + ord;
+            predict0 += (coef0[ord] * data0[pos]);
+            predict1 += (coef1[ord] * data1[pos]);
+            predict2 += (coef2[ord] * data2[pos]);
+            predict3 += (coef3[ord] * data3[pos]);
+        }
+        data0[smpl] -= (predict0 >> rshift0);
+        data1[smpl] -= (predict1 >> rshift1);
+        data2[smpl] -= (predict2 >> rshift2);
+        data3[smpl] -= (predict3 >> rshift3);
+    }
+}
+
+#ifdef LINNELPC_USE_SSE2
+/* SSE2による連続したnum_lanesユニットのLPC合成(in-place)の定義
+* 2ユニットずつ64bitレーンの下位32bitに並べ、_mm_mul_epu32で積の下位32bitを得る
+* （積の下位32bitは符号の有無によらないため、整数演算の結果はスカラー版と一致する） */
+#define LINNELPC_DEFINE_SYNTHESIZE_UNITS_SSE2(num_lanes)\
+static void LINNELPC_SynthesizeUnits ## num_lanes ## SSE2(\
+    int32_t *data, uint32_t num_samples,\
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)\
+{\
+    uint32_t smpl, ord, t, p, num_process;\
+    int32_t *pdata[(num_lanes)];\
+    __m128i acc[((num_lanes) / 2)];\
+    /* 係数: [次数][ペア] */\
+    __m128i pcoef[LINNELPC_UNITS_MAX_ORDER][((num_lanes) / 2)];\
+    /* 直近coef_orderサンプル + チャンクの出力履歴: [時刻][ペア] */\
+    __m128i hist[LINNELPC_UNITS_MAX_ORDER + LINNELPC_UNITS_CHUNK_SIZE][((num_lanes) / 2)];\
+    const __m128i half = _mm_set1_epi32(1 << (coef_rshift - 1));\
+    const __m128i shift = _mm_cvtsi32_si128((int)coef_rshift);\
+\
+    LINNE_ASSERT(coef_order <= LINNELPC_UNITS_MAX_ORDER);\
+    LINNE_ASSERT(coef_order < num_samples);\
+\
+    /* 次数に満たない先頭部分はユニット毎に処理 */\
+    for (p = 0; p < (num_lanes); p++) {\
+        pdata[p] = &data[p * num_samples];\
+        LINNELPC_Synthesize(pdata[p], coef_order, &coef[p * coef_order], coef_order, coef_rshift);\
+    }\
+\
+    /* 係数と履歴の転置 */\
+    for (ord = 0; ord < coef_order; ord++) {\
+        for (p = 0; p < ((num_lanes) / 2); p++) {\
+            pcoef[ord][p] = _mm_set_epi32(0, coef[(2 * p + 1) * coef_order + ord], 0, coef[2 * p * coef_order + ord]);\
+            hist[ord][p] = _mm_set_epi32(0, pdata[2 * p + 1][ord], 0, pdata[2 * p][ord]);\
+        }\
+    }\
+\
+    for (smpl = coef_order; smpl < num_samples; smpl += num_process) {\
+        num_process = LINNEUTILITY_MIN(LINNELPC_UNITS_CHUNK_SIZE, num_samples - smpl);\
+        for (t = 0; t < num_process; t++) {\
+            for (p = 0; p < ((num_lanes) / 2); p++) {\
+                acc[p] = half;\
+            }\
+            for (ord = 0; ord < coef_order; ord++) {\
+                for (p = 0; p < ((num_lanes) / 2); p++) {\
+                    acc[p] = _mm_add_epi32(acc[p], _mm_mul_epu32(pcoef[ord][p], hist[t + ord][p]));\
+                }\
+            }\
+            for (p = 0; p < ((num_lanes) / 2); p++) {\
+                int32_t *pdata0 = pdata[2 * p], *pdata1 = pdata[2 * p + 1];\
+                const __m128i out = _mm_sub_epi32(\
+                        _mm_set_epi32(0, pdata1[smpl + t], 0, pdata0[smpl + t]), _mm_sra_epi32(acc[p], shift));\
+                hist[coef_order + t][p] = out;\
+                pdata0[smpl + t] = _mm_cvtsi128_si32(out);\
+                pdata1[smpl + t] = _mm_cvtsi128_si32(_mm_srli_si128(out, 8));\
+            }\
+        }\
+        /* 直近の履歴を先頭に詰める */\
+        for (ord = 0; ord < coef_order; ord++) {\
+            for (p = 0; p < ((num_lanes) / 2); p++) {\
+                hist[ord][p] = hist[num_process + ord][p];\
+            }\
+        }\
+    }\
+}
+
+LINNELPC_DEFINE_SYNTHESIZE_UNITS_SSE2(4)
+LINNELPC_DEFINE_SYNTHESIZE_UNITS_SSE2(8)
+
+#undef LINNELPC_DEFINE_SYNTHESIZE_UNITS_SSE2
+#endif /* LINNELPC_USE_SSE2 */
+
+/* 連続して並んだ独立な複数ユニットのLPC合成(in-place) */
+void LINNELPC_SynthesizeUnits(
+    int32_t *data, uint32_t num_units, uint32_t num_samples_per_unit,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    uint32_t unit = 0;
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(coef_rshift != 0);
+
+#ifdef LINNELPC_USE_SSE2
+    /* 8または4ユニットずつSIMDレーンに割り当てて合成 */
+    if ((coef_order <= LINNELPC_UNITS_MAX_ORDER) && (coef_order < num_samples_per_unit)) {
+        for (unit = 0; (unit + 8) <= num_units; unit += 8) {
+            LINNELPC_SynthesizeUnits8SSE2(&data[unit * num_samples_per_unit],
+                    num_samples_per_unit, &coef[unit * coef_order], coef_order, coef_rshift);
+        }
+        if ((unit + 4) <= num_units) {
+            LINNELPC_SynthesizeUnits4SSE2(&data[unit * num_samples_per_unit],
+                    num_samples_per_unit, &coef[unit * coef_order], coef_order, coef_rshift);
+            unit += 4;
+        }
+    }
+#endif
+
+    /* 残りのユニットは1つずつ合成 */
+    for (; unit < num_units; unit++) {
+        LINNELPC_Synthesize(&data[unit * num_samples_per_unit],
+                num_samples_per_unit, &coef[unit * coef_order], coef_order, coef_rshift);
+    }
+}
+
+#ifdef LINNELPC_USE_SSE2
+/* SSE2の16bit積和(_mm_madd_epi16)による次数固定のLPC合成の定義
+* 直近の出力を16bitに詰めてレジスタに保持し、1サンプル毎に1要素ずつずらす
+* 出力が16bitに収まらなくなった時点で以降を32bit演算で合成する
+* 積和の結果は32bitで剰余をとった値になるため、32bit演算のスカラー版と一致する */
+#define LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(order)\
+static void LINNELPC_SynthesizeInt16Order ## order(\
+    int32_t *data, uint32_t num_samples, const int32_t *coef, uint32_t coef_rshift)\
+{\
+    uint32_t smpl, k;\
+    __m128i hist[(order) / 8], pcoef[(order) / 8], acc;\
+    const int32_t half = 1 << (coef_rshift - 1);\
+    for (k = 0; k < (order) / 8; k++) {\
+        pcoef[k] = _mm_packs_epi32(\
+                _mm_loadu_si128((const __m128i *)&coef[8 * k]), _mm_loadu_si128((const __m128i *)&coef[8 * k + 4]));\
+        hist[k] = _mm_packs_epi32(\
+                _mm_loadu_si128((const __m128i *)&data[8 * k]), _mm_loadu_si128((const __m128i *)&data[8 * k + 4]));\
+    }\
+    for (smpl = (order); smpl < num_samples; smpl++) {\
+        int32_t predict;\
+        acc = _mm_madd_epi16(pcoef[0], hist[0]);\
+        for (k = 1; k < (order) / 8; k++) {\
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(pcoef[k], hist[k]));\
+        }\
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));\
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));\
+        predict = data[smpl] - ((_mm_cvtsi128_si32(acc) + half) >> coef_rshift);\
+        data[smpl] = predict;\
+        if ((predict < INT16_MIN) || (predict > INT16_MAX)) {\
+            /* 16bitに収まらないので残りは32bit演算で合成 */\
+            LINNELPC_SynthesizeTail(&data[smpl + 1 - (order)], num_samples - (smpl + 1 - (order)), coef, (order), coef_rshift);\
+            return;\
+        }\
+        /* 履歴を1要素ずらして最新の出力を末尾に入れる */\
+        for (k = 0; k < (order) / 8 - 1; k++) {\
+            hist[k] = _mm_or_si128(_mm_srli_si128(hist[k], 2), _mm_slli_si128(hist[k + 1], 14));\
+        }\
+        hist[(order) / 8 - 1] = _mm_insert_epi16(_mm_srli_si128(hist[(order) / 8 - 1], 2), (int16_t)predict, 7);\
+    }\
+}
+
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(16)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(24)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(32)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(48)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(64)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(96)
+LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL(128)
+
+#undef LINNELPC_DEFINE_SYNTHESIZE_INT16_KERNEL
+
+/* 次数に対応する16bit積和カーネルの取得 対応するものがなければNULL */
+static LINNELPCSynthesizeKernel LINNELPC_GetSynthesizeInt16Kernel(uint32_t coef_order)
+{
+    switch (coef_order) {
+    case 16:    return LINNELPC_SynthesizeInt16Order16;
+    case 24:    return LINNELPC_SynthesizeInt16Order24;
+    case 32:    return LINNELPC_SynthesizeInt16Order32;
+    case 48:    return LINNELPC_SynthesizeInt16Order48;
+    case 64:    return LINNELPC_SynthesizeInt16Order64;
+    case 96:    return LINNELPC_SynthesizeInt16Order96;
+    case 128:   return LINNELPC_SynthesizeInt16Order128;
+    default:    break;
+    }
+    return NULL;
+}
+#endif /* LINNELPC_USE_SSE2 */
+
+/* 出力が16bitに収まると見込まれる場合のLPC係数による合成(in-place) */
+void LINNELPC_SynthesizeInt16(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+#ifdef LINNELPC_USE_SSE2
+    uint32_t smpl;
+    LINNELPCSynthesizeKernel kernel;
+#endif
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(coef_rshift != 0);
+
+#ifdef LINNELPC_USE_SSE2
+    if ((coef_order < num_samples)
+            && ((kernel = LINNELPC_GetSynthesizeInt16Kernel(coef_order)) != NULL)) {
+        /* 先頭coef_orderサンプルは通常版で処理 */
+        LINNELPC_Synthesize(data, coef_order, coef, coef_order, coef_rshift);
+        /* 履歴が16bitに収まっていれば16bit積和カーネルで合成 */
+        for (smpl = 0; smpl < coef_order; smpl++) {
+            if ((data[smpl] < INT16_MIN) || (data[smpl] > INT16_MAX)) {
+                break;
+            }
+        }
+        if (smpl == coef_order) {
+            kernel(data, num_samples, coef, coef_rshift);
+        } else {
+            LINNELPC_SynthesizeTail(data, num_samples, coef, coef_order, coef_rshift);
+        }
+        return;
+    }
+#endif
+
+    LINNELPC_Synthesize(data, num_samples, coef, coef_order, coef_rshift);
+}
+
+#ifdef LINNELPC_USE_SSE2
+/* SSE2の倍精度積和による64bit精度のLPC合成(in-place)
+* LINNE_LPC_COEFFICIENT_BITWIDTHビットの係数と32bit整数の積、およびその128次までの和は
+* 2^53未満に収まり倍精度で誤差なく表せるため、結果は64bit整数で積和したスカラー版と一致する */
+static void LINNELPC_SynthesizeInt64SSE2(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    uint32_t smpl, ord, t, num_process;
+    /* 直近coef_orderサンプル + チャンクの出力履歴 */
+    double hist[LINNELPC_INT64_MAX_ORDER + LINNELPC_INT64_CHUNK_SIZE];
+    double dcoef[LINNELPC_INT64_MAX_ORDER];
+    const double half = (double)(1 << (coef_rshift - 1));
+
+    LINNE_ASSERT(coef_order <= LINNELPC_INT64_MAX_ORDER);
+    LINNE_ASSERT(coef_order < num_samples);
+
+    for (ord = 0; ord < coef_order; ord++) {
+        LINNE_ASSERT(LINNEUTILITY_ABS(coef[ord]) <= (1 << LINNE_LPC_COEFFICIENT_BITWIDTH));
+        dcoef[ord] = coef[ord];
+        hist[ord] = data[ord];
+    }
+
+    for (smpl = coef_order; smpl < num_samples; smpl += num_process) {
+        num_process = LINNEUTILITY_MIN(LINNELPC_INT64_CHUNK_SIZE, num_samples - smpl);
+        for (t = 0; t < num_process; t++) {
+            __m128d acc0 = _mm_set_sd(half), acc1 = _mm_setzero_pd();
+            double predict;
+            /* 2レーン x 2系統で積和 */
+            for (ord = 0; (ord + 4) <= coef_order; ord += 4) {
+                acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&dcoef[ord + 0]), _mm_loadu_pd(&hist[t + ord + 0])));
+                acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&dcoef[ord + 2]), _mm_loadu_pd(&hist[t + ord + 2])));
+            }
+            acc0 = _mm_add_pd(acc0, acc1);
+            acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+            predict = _mm_cvtsd_f64(acc0);
+            for (; ord < coef_order; ord++) {
+                predict += dcoef[ord] * hist[t + ord];
+            }
+            /* 和は整数値なので64bit整数に変換しても誤差はない */
+            data[smpl + t] -= (int32_t)((int64_t)predict >> coef_rshift);
+            hist[coef_order + t] = data[smpl + t];
+        }
+        /* 直近の履歴を先頭に詰める */
+        memmove(&hist[0], &hist[num_process], sizeof(double) * coef_order);
+    }
+}
+#endif /* LINNELPC_USE_SSE2 */
+
+/* 予測値を64bitで積和するLPC係数による合成(in-place) */
+void LINNELPC_SynthesizeInt64(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    int64_t predict;
+    uint32_t smpl, ord;
+    const int64_t half = (int64_t)1 << (coef_rshift - 1); /* 固定小数の0.5 */
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(coef_rshift != 0);
+
+    /* LPC係数による予測 */
+    for (smpl = 1; (smpl < coef_order) && (smpl < num_samples); smpl++) {
+        predict = half;
+        for (ord = 0; ord < smpl; ord++) {
+            predict += ((int64_t)coef[coef_order - smpl + ord] * data[ord]);
+        }
+        data[smpl] -= (int32_t)(predict >> coef_rshift);
+    }
+
+#ifdef LINNELPC_USE_SSE2
+    if ((coef_order >= LINNELPC_INT64_SSE2_MIN_ORDER)
+            && (coef_order <= LINNELPC_INT64_MAX_ORDER) && (coef_order < num_samples)) {
+        LINNELPC_SynthesizeInt64SSE2(data, num_samples, coef, coef_order, coef_rshift);
+        return;
+    }
+#endif
+
     for (smpl = coef_order; smpl < num_samples; smpl++) {
         predict = half;
         for (ord = 0; ord < coef_order; ord++) {
-            predict += (coef[ord] * data[smpl - coef_order + ord]);
+            predict += ((int64_t)coef[ord] * data[smpl - coef_order + ord]);
         }
-        data[smpl] -= (predict >> coef_rshift);
+        data[smpl] -= (int32_t)(predict >> coef_rshift);
     }
 }
@@ -12,6 +12,31 @@ void LINNELPC_Synthesize(
     int32_t *data, uint32_t num_samples,
     const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift);
 
+/* 出力が16bitに収まると見込まれる場合のLPC係数による合成(in-place)
+* 係数は16bit符号付き整数の範囲にあること 出力が16bitに収まらなくても結果はLINNELPC_Synthesizeと一致する */
+void LINNELPC_SynthesizeInt16(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift);
+
+/* 予測値を64bitで積和するLPC係数による合成(in-place)
+* 32bitの積和が桁あふれしうる場合（LINNEUtility_IsLPCAccumulatorOverflowableが1の場合）に使う */
+void LINNELPC_SynthesizeInt64(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift);
+
+/* 独立な4系列をインターリーブしてLPC合成(in-place)
+* 系列間で次数とサンプル数は共通、係数と右シフト量は系列毎に指定 */
+void LINNELPC_SynthesizeInterleaved4(
+    int32_t *const *data, uint32_t num_samples,
+    const int32_t *const *coef, uint32_t coef_order, const uint32_t *coef_rshift);
+
+/* 連続して並んだ独立な複数ユニットのLPC合成(in-place)
+* ユニットuのデータはdata[u * num_samples_per_unit]から、係数はcoef[u * coef_order]から並ぶ
+* 右シフト量はユニット間で共通 */
+void LINNELPC_SynthesizeUnits(
+    int32_t *data, uint32_t num_units, uint32_t num_samples_per_unit,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift);
+
 #ifdef __cplusplus
 }
 #endif
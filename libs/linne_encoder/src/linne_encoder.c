@@ -12,6 +12,32 @@
 #include "linne_network.h"
 #include "linne_coder.h"
 
+/* チャンネルchの第l層のLPC係数の先頭 */
+#define LINNEENCODER_PARAMS(encoder, params, ch, l)\
+    (&(encoder)->params[((ch) * (encoder)->max_num_layers + (l)) * (encoder)->max_num_parameters_per_layer])
+/* チャンネルchの各層の情報（ユニット数・右シフト量）の先頭 */
+#define LINNEENCODER_LAYER_INFO(encoder, info, ch) (&(encoder)->info[(ch) * (encoder)->max_num_layers])
+/* チャンネルchの信号バッファの先頭 */
+#define LINNEENCODER_BUFFER(encoder, buffer, ch) (&(encoder)->buffer[(ch) * (encoder)->buffer_stride])
+/* チャンネルchの分析窓バッファの先頭 */
+#define LINNEENCODER_HISTORY(encoder, ch) (&(encoder)->lookback_history[(ch) * (encoder)->max_num_lookback_samples])
+
+/* 速度レベル数の上限: 学習なしの各プリセット + 最大プリセットで学習あり */
+#define LINNEENCODER_MAX_NUM_SPEED_LEVELS (LINNE_NUM_PARAMETER_PRESETS + 1)
+/* 処理時間の移動平均の更新係数 */
+#define LINNEENCODER_SPEED_COST_SMOOTHING 0.25
+/* 処理時間が未計測の上のレベルを試す余裕（目標時間に対する現レベルの処理時間の倍率） */
+#define LINNEENCODER_SPEED_PROBE_MARGIN 2.0
+/* 圧縮サイズ推定の95%信頼区間の係数（標準正規分布の上側2.5%点） */
+#define LINNEENCODER_ESTIMATE_CONFIDENCE_COEF 1.96
+/* 事前分析で候補にするブロックの最小サンプル数（推定に使うLPC次数に対する倍率） */
+#define LINNEENCODER_PRE_ANALYSIS_MIN_SAMPLES_PER_ORDER 8
+/* 事前分析で上位のプリセットを選ぶのに必要な推定サイズの削減率 */
+#define LINNEENCODER_PRE_ANALYSIS_MIN_PRESET_GAIN 0.005
+
+/* 差分の計算バッファはレイヤーあたりパラメータ数の分だけ確保し、チャンネル毎の値にも使う */
+LINNE_STATIC_ASSERT(LINNE_NETWORK_MAX_PARAMS_PER_LAYER >= LINNE_MAX_NUM_CHANNELS);
+
 /* エンコーダハンドル */
 struct LINNEEncoder {
     struct LINNEHeader header; /* ヘッダ */
@@ -20,20 +46,47 @@ struct LINNEEncoder {
     uint32_t max_num_samples_per_block; /* バッファサンプル数 */
     uint32_t max_num_layers; /* 最大レイヤー数 */
     uint32_t max_num_parameters_per_layer; /* 最大レイヤーあたりパラメータ数 */
+    uint32_t max_num_lookback_samples; /* 分析窓バッファのチャンネルあたりサンプル数 */
     uint8_t set_parameter; /* パラメータセット済み？ */
     uint8_t enable_learning; /* ネットワークの学習を行う？ */
+    uint32_t min_num_samples_per_block; /* 適応ブロックサイズ選択での最小ブロックあたりサンプル数 0で無効 */
+    uint32_t block_size_search_budget; /* ブロックサイズ探索の計算量上限 */
+    uint32_t target_realtime_factor; /* 目標の実時間倍率 0で無効 */
+    uint32_t num_speed_levels; /* 速度レベル数 */
+    uint32_t speed_level; /* 現在の速度レベル */
+    double speed_level_cost[LINNEENCODER_MAX_NUM_SPEED_LEVELS]; /* レベル毎のサンプルあたり処理時間[sec]の移動平均 0は未計測 */
     struct LINNEPreemphasisFilter **pre_emphasis; /* プリエンファシスフィルタ */
     int32_t **pre_emphasis_prev; /* プリエンファシスフィルタの直前のサンプル */
+    uint32_t wasted_bits[LINNE_MAX_NUM_CHANNELS]; /* チャンネル毎の下位の無効ビット数 */
+    uint8_t enable_parameter_reuse; /* 直前のブロックのパラメータを再利用する？ */
+    uint8_t reuse_parameters; /* 現在のブロックで直前のパラメータを再利用するか？ */
+    const struct LINNEParameterPreset *reusable_preset; /* 直前に出力したパラメータのレイヤー構造 NULLならば再利用できない */
+    double reuse_reference_gain; /* パラメータを計算したブロックのサンプルあたり予測利得（入力と残差の符号長の差）[bit] */
+    uint8_t enable_delta_parameters; /* パラメータを直前のブロックとの差分で記録する？ */
+    uint8_t delta_parameters; /* 現在のブロックのパラメータを差分で記録するか？ */
+    uint32_t keyframe_interval; /* キーフレームを置く最大間隔[ブロック] 0で制限しない */
+    uint32_t num_blocks_since_keyframe; /* 直前のキーフレームの後に書き出したブロック数 */
+    int32_t last_samples[LINNE_MAX_NUM_CHANNELS]; /* 直前に書き出したブロックのチャンネル毎の末尾サンプル（入力） */
+    int32_t *reference_params_int; /* 直前に出力したLPC係数（差分の基準） [チャンネル][層][パラメータ]の順に並ぶ 差分記録しないコンフィグではNULL */
+    uint32_t *reference_num_units; /* 直前に出力した各層のユニット数 [チャンネル][層]の順に並ぶ */
+    uint32_t *reference_rshifts; /* 直前に出力した各層のLPC係数右シフト量 [チャンネル][層]の順に並ぶ */
+    uint32_t num_lookback_samples; /* 分析に含める直前のブロックのサンプル数 0で無効 */
+    uint32_t num_history_samples; /* 分析窓バッファに蓄えたチャンネルあたりサンプル数 */
+    double *lookback_history; /* 分析窓バッファ（直前のブロックの正規化済みの前処理後信号） チャンネル毎にmax_num_lookback_samplesおきに並ぶ 0ならNULL */
     struct LINNENetwork *network; /* ネットワーク */
     struct LINNENetworkTrainer *trainer; /* LPCネットワークトレーナー */
-    double ***params_double; /* LPC係数(double) */
-    int32_t ***params_int; /* LPC係数(int) */
-    uint32_t **num_units; /* 各層のユニット数 */
-    uint32_t **rshifts; /* 各層のLPC係数右シフト量 */
-    int32_t **buffer_int; /* 信号バッファ(int) */
-    int32_t **residual; /* 残差信号 */
+    double *params_double; /* LPC係数(double) [チャンネル][層][パラメータ]の順に並ぶ */
+    int32_t *params_int; /* LPC係数(int) [チャンネル][層][パラメータ]の順に並ぶ */
+    uint32_t *num_units; /* 各層のユニット数 [チャンネル][層]の順に並ぶ */
+    uint32_t *rshifts; /* 各層のLPC係数右シフト量 [チャンネル][層]の順に並ぶ */
+    int32_t *buffer_int; /* 信号バッファ(int) チャンネル毎にbuffer_strideおきに並ぶ */
+    int32_t *residual; /* 残差信号 チャンネル毎にbuffer_strideおきに並ぶ */
+    uint32_t buffer_stride; /* 信号バッファのチャンネル間のストライド（要素数） */
     double *buffer_double; /* 信号バッファ(double) */
     const struct LINNEParameterPreset *parameter_preset; /* パラメータプリセット */
+    struct LINNEParameterPreset custom_preset; /* 独自レイヤー構造（ヘッダの配列を参照） */
+    LINNEEncoderRunTasksCallback run_tasks; /* タスク実行コールバック */
+    void *run_tasks_user_data; /* タスク実行コールバックに渡すユーザデータ */
     uint8_t alloced_by_own; /* 領域を自前確保しているか？ */
     void *work; /* ワーク領域先頭ポインタ */
 };
@@ -45,6 +98,10 @@ static LINNEError LINNEEncoder_ConvertParameterToHeader(
 /* ブロックデータタイプの判定 */
 static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
         struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples);
+/* 速度レベルの適用 */
+static void LINNEEncoder_ApplySpeedLevel(struct LINNEEncoder *encoder, uint32_t level);
+/* 前処理済みの信号を現在のLPC係数で予測 */
+static void LINNEEncoder_PredictPreprocessedData(struct LINNEEncoder *encoder, uint32_t num_samples);
 
 /* ヘッダエンコード */
 LINNEApiResult LINNEEncoder_EncodeHeader(
@@ -58,7 +115,7 @@ LINNEApiResult LINNEEncoder_EncodeHeader(
     }
 
     /* 出力先バッファサイズ不足 */
-    if (data_size < LINNE_HEADER_SIZE) {
+    if (data_size < LINNE_CALCULATE_HEADER_SIZE(header)) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
@@ -88,6 +145,15 @@ LINNEApiResult LINNEEncoder_EncodeHeader(
     if (header->preset >= LINNE_NUM_PARAMETER_PRESETS) {
         return LINNE_APIRESULT_INVALID_FORMAT;
     }
+    /* 独自レイヤー構造: ブロック毎のプリセット切り替えとは併用できない */
+    if (header->num_custom_layers > 0) {
+        if (LINNE_CheckCustomLayerStructure(header->num_custom_layers, header->custom_num_params_list) != LINNE_ERROR_OK) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+        if (header->enable_block_preset == 1) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+    }
     /* マルチチャンネル処理法 */
     if (header->ch_process_method >= LINNE_CH_PROCESS_METHOD_INVALID) {
         return LINNE_APIRESULT_INVALID_FORMAT;
@@ -122,13 +188,24 @@ LINNEApiResult LINNEEncoder_EncodeHeader(
     ByteArray_PutUint16BE(data_pos, header->bits_per_sample);
     /* 最大ブロックあたりサンプル数 */
     ByteArray_PutUint32BE(data_pos, header->num_samples_per_block);
-    /* パラメータプリセット */
-    ByteArray_PutUint8(data_pos, header->preset);
+    /* パラメータプリセット: ブロック毎に切り替える場合・独自レイヤー構造がある場合はフラグを立てる */
+    ByteArray_PutUint8(data_pos, (uint8_t)(header->preset
+                | ((header->enable_block_preset == 1) ? LINNE_HEADER_BLOCK_PRESET_FLAG : 0)
+                | ((header->num_custom_layers > 0) ? LINNE_HEADER_CUSTOM_LAYERS_FLAG : 0)));
     /* マルチチャンネル処理法 */
     ByteArray_PutUint8(data_pos, header->ch_process_method);
 
+    /* ヘッダ拡張: 独自レイヤー構造 */
+    if (header->num_custom_layers > 0) {
+        uint32_t l;
+        ByteArray_PutUint8(data_pos, header->num_custom_layers);
+        for (l = 0; l < header->num_custom_layers; l++) {
+            ByteArray_PutUint8(data_pos, (uint8_t)header->custom_num_params_list[l]);
+        }
+    }
+
     /* ヘッダサイズチェック */
-    LINNE_ASSERT((data_pos - data) == LINNE_HEADER_SIZE);
+    LINNE_ASSERT((data_pos - data) == LINNE_CALCULATE_HEADER_SIZE(header));
 
     /* 成功終了 */
     return LINNE_APIRESULT_OK;
@@ -165,30 +242,53 @@ static LINNEError LINNEEncoder_ConvertParameterToHeader(
     if (parameter->ch_process_method >= LINNE_CH_PROCESS_METHOD_INVALID) {
         return LINNE_ERROR_INVALID_FORMAT;
     }
+    if (parameter->min_num_samples_per_block > parameter->num_samples_per_block) {
+        return LINNE_ERROR_INVALID_FORMAT;
+    }
+    /* 独自レイヤー構造はヘッダに記録できる範囲に限る また、ブロック毎のプリセット切り替えとは併用できない */
+    if (parameter->num_custom_layers > 0) {
+        if (LINNE_CheckCustomLayerStructure(parameter->num_custom_layers, parameter->custom_num_params_list) != LINNE_ERROR_OK) {
+            return LINNE_ERROR_INVALID_FORMAT;
+        }
+        if ((parameter->target_realtime_factor != 0) || (parameter->enable_block_preset != 0)) {
+            return LINNE_ERROR_INVALID_FORMAT;
+        }
+    }
 
-    /* プリセットのパラメータ数がブロックサイズを超えていないかチェック */
+    /* 対応するメンバをコピー */
+    tmp_header.num_channels = parameter->num_channels;
+    tmp_header.sampling_rate = parameter->sampling_rate;
+    tmp_header.bits_per_sample = parameter->bits_per_sample;
+    tmp_header.num_samples_per_block = parameter->num_samples_per_block;
+    tmp_header.preset = parameter->preset;
+    tmp_header.enable_block_preset
+        = ((parameter->target_realtime_factor != 0) || (parameter->enable_block_preset != 0)) ? 1 : 0;
+    tmp_header.num_custom_layers = parameter->num_custom_layers;
+    memcpy(tmp_header.custom_num_params_list, parameter->custom_num_params_list,
+            sizeof(uint32_t) * parameter->num_custom_layers);
+    tmp_header.ch_process_method = parameter->ch_process_method;
+
+    /* レイヤー構造のパラメータ数がブロックサイズを超えていないかチェック */
     {
         uint32_t l;
-        const struct LINNEParameterPreset *preset = &g_linne_parameter_preset[parameter->preset];
+        struct LINNEParameterPreset custom;
+        const struct LINNEParameterPreset *preset = LINNE_GetLayerStructure(&tmp_header, &custom);
         for (l = 0; l < preset->num_layers; l++) {
             /* 1サンプル遅れの畳込みを行うため、サンプル数はパラメータ数よりも大きいことを要求 */
             if (parameter->num_samples_per_block <= preset->num_params_list[l]) {
                 return LINNE_ERROR_INVALID_FORMAT;
             }
+            /* 適応ブロックサイズ選択の最小ブロックにも同じ条件を課す */
+            if ((parameter->min_num_samples_per_block != 0)
+                    && (parameter->min_num_samples_per_block <= preset->num_params_list[l])) {
+                return LINNE_ERROR_INVALID_FORMAT;
+            }
         }
     }
 
     /* 総サンプル数 */
     tmp_header.num_samples = num_samples;
 
-    /* 対応するメンバをコピー */
-    tmp_header.num_channels = parameter->num_channels;
-    tmp_header.sampling_rate = parameter->sampling_rate;
-    tmp_header.bits_per_sample = parameter->bits_per_sample;
-    tmp_header.num_samples_per_block = parameter->num_samples_per_block;
-    tmp_header.preset = parameter->preset;
-    tmp_header.ch_process_method = parameter->ch_process_method;
-
     /* 成功終了 */
     (*header) = tmp_header;
     return LINNE_ERROR_OK;
@@ -226,9 +326,10 @@ int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config)
     }
     work_size += tmp_work_size;
 
-    /* LPCネットのサイズ */
+    /* LPCネットのサイズ 分析窓は直前のブロックを含む分だけ長い */
     if ((tmp_work_size = LINNENetwork_CalculateWorkSize(
-                    config->max_num_samples_per_block, config->max_num_layers, config->max_num_parameters_per_layer)) < 0) {
+                    config->max_num_samples_per_block + config->max_num_lookback_samples,
+                    config->max_num_layers, config->max_num_parameters_per_layer)) < 0) {
         return -1;
     }
     work_size += tmp_work_size;
@@ -245,26 +346,85 @@ int32_t LINNEEncoder_CalculateWorkSize(const struct LINNEEncoderConfig *config)
     work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
     /* パラメータバッファ領域 */
     /* LPC係数(int) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* LPC係数(double) */
-    work_size += LINNE_CALCULATE_3DIMARRAY_WORKSIZE(double, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(double, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* 各層のユニット数 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(uint32_t, config->max_num_channels * config->max_num_layers);
     /* 各層のLPC係数右シフト量 */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(uint32_t, config->max_num_channels, config->max_num_layers);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(uint32_t, config->max_num_channels * config->max_num_layers);
+    /* 差分の基準とする直前のLPC係数・ユニット数・右シフト量 */
+    if (config->enable_delta_parameters == 1) {
+        work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
+        work_size += 2 * LINNE_CALCULATE_FLATARRAY_WORKSIZE(uint32_t, config->max_num_channels * config->max_num_layers);
+    }
     /* 信号処理バッファのサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_samples_per_block);
-    work_size += config->max_num_samples_per_block * sizeof(double) + LINNE_MEMORY_ALIGNMENT;
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(int32_t,
+            config->max_num_channels * LINNE_CALCULATE_FLATARRAY_STRIDE(int32_t, config->max_num_samples_per_block));
+    work_size += (config->max_num_samples_per_block + config->max_num_lookback_samples) * sizeof(double) + LINNE_MEMORY_ALIGNMENT;
     /* 残差信号のサイズ */
-    work_size += LINNE_CALCULATE_2DIMARRAY_WORKSIZE(int32_t, config->max_num_channels, config->max_num_samples_per_block);
+    work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(int32_t,
+            config->max_num_channels * LINNE_CALCULATE_FLATARRAY_STRIDE(int32_t, config->max_num_samples_per_block));
+    /* 分析窓バッファのサイズ */
+    if (config->max_num_lookback_samples > 0) {
+        work_size += LINNE_CALCULATE_FLATARRAY_WORKSIZE(double, config->max_num_channels * config->max_num_lookback_samples);
+    }
 
     return work_size;
 }
 
+/* エンコードパラメータでのエンコードに必要な最小のコンフィグを取得 */
+LINNEApiResult LINNEEncoder_CalculateMinimumConfig(
+    const struct LINNEEncodeParameter *parameter, struct LINNEEncoderConfig *config)
+{
+    uint32_t l;
+    struct LINNEHeader tmp_header;
+    struct LINNEParameterPreset custom;
+    const struct LINNEParameterPreset *preset;
+
+    /* 引数チェック */
+    if ((parameter == NULL) || (config == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータ設定がおかしくないか、ヘッダへの変換を通じて確認 */
+    if (LINNEEncoder_ConvertParameterToHeader(parameter, 0, &tmp_header) != LINNE_ERROR_OK) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* プリセット（独自レイヤー構造があればその構造）から決定 */
+    /* 補足）パラメータ数がブロックサイズ未満であることは確認済み */
+    preset = LINNE_GetLayerStructure(&tmp_header, &custom);
+    config->max_num_channels = parameter->num_channels;
+    config->max_num_layers = preset->num_layers;
+    config->max_num_parameters_per_layer = 0;
+    for (l = 0; l < preset->num_layers; l++) {
+        config->max_num_parameters_per_layer
+            = LINNEUTILITY_MAX(config->max_num_parameters_per_layer, preset->num_params_list[l]);
+    }
+    config->max_num_samples_per_block = parameter->num_samples_per_block;
+    /* 分析窓バッファ・差分の基準は使うときだけ確保 */
+    config->max_num_lookback_samples = parameter->num_lookback_samples;
+    config->enable_delta_parameters = (parameter->enable_delta_parameters == 1) ? 1 : 0;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* エンコードパラメータでのエンコードに必要な最小のワークサイズ計算 */
+int32_t LINNEEncoder_CalculateWorkSizeFromParameter(const struct LINNEEncodeParameter *parameter)
+{
+    struct LINNEEncoderConfig config;
+
+    if (LINNEEncoder_CalculateMinimumConfig(parameter, &config) != LINNE_APIRESULT_OK) {
+        return -1;
+    }
+
+    return LINNEEncoder_CalculateWorkSize(&config);
+}
+
 /* エンコーダハンドル作成 */
 struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config, void *work, int32_t work_size)
 {
-    uint32_t ch, l;
     struct LINNEEncoder *encoder;
     uint8_t tmp_alloc_by_own = 0;
     uint8_t *work_ptr;
@@ -274,7 +434,7 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
         if ((work_size = LINNEEncoder_CalculateWorkSize(config)) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        work = LINNE_AllocateMemory((size_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -313,6 +473,7 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
     encoder->max_num_samples_per_block = config->max_num_samples_per_block;
     encoder->max_num_layers = config->max_num_layers;
     encoder->max_num_parameters_per_layer = config->max_num_parameters_per_layer;
+    encoder->max_num_lookback_samples = config->max_num_lookback_samples;
 
     /* 符号化ハンドルの作成 */
     {
@@ -325,10 +486,11 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
 
     /* ネットワークと領域確保 */
     {
+        const uint32_t max_num_analyze_samples = config->max_num_samples_per_block + config->max_num_lookback_samples;
         const int32_t network_size = LINNENetwork_CalculateWorkSize(
-                config->max_num_samples_per_block, config->max_num_layers, config->max_num_parameters_per_layer);
+                max_num_analyze_samples, config->max_num_layers, config->max_num_parameters_per_layer);
         if ((encoder->network = LINNENetwork_Create(
-                config->max_num_samples_per_block, config->max_num_layers,
+                max_num_analyze_samples, config->max_num_layers,
                 config->max_num_parameters_per_layer, work_ptr, network_size)) == NULL) {
             return NULL;
         }
@@ -353,41 +515,57 @@ struct LINNEEncoder *LINNEEncoder_Create(const struct LINNEEncoderConfig *config
     LINNE_ALLOCATE_2DIMARRAY(encoder->pre_emphasis_prev,
             work_ptr, int32_t, config->max_num_channels, LINNE_NUM_PREEMPHASIS_FILTERS);
 
-    /* バッファ領域の確保 全てのポインタをアラインメント */
+    /* バッファ領域の確保 各配列は連続領域に詰めて置き、先頭をキャッシュラインに揃える */
     /* LPC係数(int) */
-    LINNE_ALLOCATE_3DIMARRAY(encoder->params_int,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    LINNE_ALLOCATE_FLATARRAY(encoder->params_int,
+            work_ptr, int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* LPC係数(double) */
-    LINNE_ALLOCATE_3DIMARRAY(encoder->params_double,
-            work_ptr, double, config->max_num_channels, config->max_num_layers, config->max_num_parameters_per_layer);
+    LINNE_ALLOCATE_FLATARRAY(encoder->params_double,
+            work_ptr, double, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
     /* 各層のユニット数 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->num_units,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
+    LINNE_ALLOCATE_FLATARRAY(encoder->num_units,
+            work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
     /* 各層のLPC係数右シフト量 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->rshifts,
-            work_ptr, uint32_t, config->max_num_channels, config->max_num_layers);
+    LINNE_ALLOCATE_FLATARRAY(encoder->rshifts,
+            work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
+    /* 差分の基準とする直前のLPC係数・ユニット数・右シフト量 */
+    encoder->reference_params_int = NULL;
+    encoder->reference_num_units = NULL;
+    encoder->reference_rshifts = NULL;
+    if (config->enable_delta_parameters == 1) {
+        LINNE_ALLOCATE_FLATARRAY(encoder->reference_params_int,
+                work_ptr, int32_t, config->max_num_channels * config->max_num_layers * config->max_num_parameters_per_layer);
+        LINNE_ALLOCATE_FLATARRAY(encoder->reference_num_units,
+                work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
+        LINNE_ALLOCATE_FLATARRAY(encoder->reference_rshifts,
+                work_ptr, uint32_t, config->max_num_channels * config->max_num_layers);
+    }
 
-    /* 信号処理用バッファ領域 */
-    LINNE_ALLOCATE_2DIMARRAY(encoder->buffer_int,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_samples_per_block);
-    LINNE_ALLOCATE_2DIMARRAY(encoder->residual,
-            work_ptr, int32_t, config->max_num_channels, config->max_num_samples_per_block);
+    /* 信号処理用バッファ領域 チャンネルの先頭もキャッシュラインに揃える */
+    encoder->buffer_stride = LINNE_CALCULATE_FLATARRAY_STRIDE(int32_t, config->max_num_samples_per_block);
+    LINNE_ALLOCATE_FLATARRAY(encoder->buffer_int,
+            work_ptr, int32_t, config->max_num_channels * encoder->buffer_stride);
+    LINNE_ALLOCATE_FLATARRAY(encoder->residual,
+            work_ptr, int32_t, config->max_num_channels * encoder->buffer_stride);
 
-    /* doubleバッファ */
+    /* doubleバッファ 直前のブロックを含む分析窓も組み立てる */
     work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
     encoder->buffer_double = (double *)work_ptr;
-    work_ptr += config->max_num_samples_per_block * sizeof(double);
+    work_ptr += (config->max_num_samples_per_block + config->max_num_lookback_samples) * sizeof(double);
+
+    /* 分析窓バッファ */
+    encoder->lookback_history = NULL;
+    if (config->max_num_lookback_samples > 0) {
+        LINNE_ALLOCATE_FLATARRAY(encoder->lookback_history,
+                work_ptr, double, config->max_num_channels * config->max_num_lookback_samples);
+    }
 
     /* バッファオーバーランチェック */
     /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
     LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
 
-    /* プリエンファシスフィルタ初期化 */
-    for (ch = 0; ch < config->max_num_channels; ch++) {
-        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
-            LINNEPreemphasisFilter_Initialize(&encoder->pre_emphasis[ch][l]);
-        }
-    }
+    /* 内部状態の初期化 */
+    (void)LINNEEncoder_Reset(encoder);
 
     return encoder;
 }
@@ -398,9 +576,81 @@ void LINNEEncoder_Destroy(struct LINNEEncoder *encoder)
     if (encoder != NULL) {
         LINNECoder_Destroy(encoder->coder);
         if (encoder->alloced_by_own == 1) {
-            free(encoder->work);
+            LINNE_FreeMemory(encoder->work);
+        }
+    }
+}
+
+/* エンコーダハンドルを作成直後の状態に戻す */
+LINNEApiResult LINNEEncoder_Reset(struct LINNEEncoder *encoder)
+{
+    uint32_t ch, l;
+
+    /* 引数チェック */
+    if (encoder == NULL) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータ未設定に戻す */
+    encoder->set_parameter = 0;
+    encoder->parameter_preset = NULL;
+    encoder->enable_learning = 0;
+    encoder->min_num_samples_per_block = 0;
+    encoder->block_size_search_budget = 0;
+
+    /* 速度目標と計測済みの処理時間を破棄 */
+    encoder->target_realtime_factor = 0;
+    encoder->num_speed_levels = 0;
+    encoder->speed_level = 0;
+    for (l = 0; l < LINNEENCODER_MAX_NUM_SPEED_LEVELS; l++) {
+        encoder->speed_level_cost[l] = 0.0;
+    }
+
+    /* プリエンファシスフィルタ初期化 */
+    for (ch = 0; ch < encoder->max_num_channels; ch++) {
+        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+            LINNEPreemphasisFilter_Initialize(&encoder->pre_emphasis[ch][l]);
+            encoder->pre_emphasis_prev[ch][l] = 0;
         }
     }
+
+    /* ネットワークのパラメータをクリア */
+    LINNENetwork_ResetParameters(encoder->network);
+
+    /* タスク実行コールバックを外す */
+    encoder->run_tasks = NULL;
+    encoder->run_tasks_user_data = NULL;
+
+    /* パラメータ再利用を無効化 */
+    encoder->enable_parameter_reuse = 0;
+    encoder->reuse_parameters = 0;
+    encoder->reusable_preset = NULL;
+    encoder->reuse_reference_gain = 0.0;
+
+    /* 低遅延向けの設定を無効化 */
+    encoder->enable_delta_parameters = 0;
+    encoder->delta_parameters = 0;
+    encoder->keyframe_interval = 0;
+    encoder->num_blocks_since_keyframe = 0;
+    encoder->num_lookback_samples = 0;
+    encoder->num_history_samples = 0;
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* プリセット競争の分析を実行するタスク実行コールバックの設定 */
+LINNEApiResult LINNEEncoder_SetTaskCallback(
+        struct LINNEEncoder *encoder, LINNEEncoderRunTasksCallback callback, void *user_data)
+{
+    /* 引数チェック */
+    if (encoder == NULL) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    encoder->run_tasks = callback;
+    encoder->run_tasks_user_data = (callback != NULL) ? user_data : NULL;
+
+    return LINNE_APIRESULT_OK;
 }
 
 /* エンコードパラメータの設定 */
@@ -422,14 +672,21 @@ LINNEApiResult LINNEEncoder_SetEncodeParameter(
 
     /* エンコーダの容量を越えてないかチェック */
     if ((encoder->max_num_samples_per_block < parameter->num_samples_per_block)
+            || (encoder->max_num_lookback_samples < parameter->num_lookback_samples)
             || (encoder->max_num_channels < parameter->num_channels)) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
+    /* 差分の基準を保持する領域がなければ差分記録はできない */
+    if ((parameter->enable_delta_parameters == 1) && (encoder->reference_params_int == NULL)) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
     /* 最大レイヤー数/パラメータ数のチェック */
     {
         uint32_t i;
-        const struct LINNEParameterPreset* preset = &g_linne_parameter_preset[parameter->preset];
+        struct LINNEParameterPreset custom;
+        const struct LINNEParameterPreset* preset = LINNE_GetLayerStructure(&tmp_header, &custom);
         if (encoder->max_num_layers < preset->num_layers) {
             return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
         }
@@ -445,28 +702,62 @@ LINNEApiResult LINNEEncoder_SetEncodeParameter(
 
     /* エンコードプリセットを取得 */
     LINNE_ASSERT(parameter->preset < LINNE_NUM_PARAMETER_PRESETS);
-    encoder->parameter_preset = &g_linne_parameter_preset[parameter->preset];
+    encoder->parameter_preset = LINNE_GetLayerStructure(&encoder->header, &encoder->custom_preset);
 
-    /* LPCネットのパラメータ設定 */
+    /* LPCネットのパラメータ設定 分析窓は直前のブロックを含む分だけ長い */
+    encoder->num_lookback_samples = parameter->num_lookback_samples;
+    encoder->num_history_samples = 0;
     LINNENetwork_SetLayerStructure(encoder->network,
-            parameter->num_samples_per_block,
+            parameter->num_samples_per_block + encoder->num_lookback_samples,
             encoder->parameter_preset->num_layers, encoder->parameter_preset->num_params_list);
 
     /* 学習を行うかのフラグを立てる */
     encoder->enable_learning = parameter->enable_learning;
 
+    /* パラメータ再利用の設定 前のストリームのパラメータは使えない */
+    encoder->enable_parameter_reuse = parameter->enable_parameter_reuse;
+    encoder->reuse_parameters = 0;
+    encoder->reusable_preset = NULL;
+
+    /* パラメータの差分記録とキーフレーム間隔の設定 */
+    encoder->enable_delta_parameters = parameter->enable_delta_parameters;
+    encoder->delta_parameters = 0;
+    encoder->keyframe_interval = parameter->keyframe_interval;
+    encoder->num_blocks_since_keyframe = 0;
+
+    /* 速度目標の設定: 最も速いレベルから始める */
+    /* 補足）前のストリームで計測した処理時間は引き継がない */
+    {
+        uint32_t level;
+        for (level = 0; level < LINNEENCODER_MAX_NUM_SPEED_LEVELS; level++) {
+            encoder->speed_level_cost[level] = 0.0;
+        }
+    }
+    encoder->target_realtime_factor = parameter->target_realtime_factor;
+    encoder->num_speed_levels = 0;
+    encoder->speed_level = 0;
+    if (encoder->target_realtime_factor != 0) {
+        encoder->num_speed_levels = parameter->preset + 1U + ((parameter->enable_learning == 1) ? 1U : 0U);
+        LINNEEncoder_ApplySpeedLevel(encoder, 0);
+    }
+
+    /* 適応ブロックサイズ選択の設定 */
+    encoder->min_num_samples_per_block = parameter->min_num_samples_per_block;
+    encoder->block_size_search_budget = parameter->block_size_search_budget;
+
     /* パラメータ設定済みフラグを立てる */
     encoder->set_parameter = 1;
 
     return LINNE_APIRESULT_OK;
 }
 
-/* ブロックデータタイプの判定 */
-static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
-        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+/* チャンネル平均のサンプルあたり推定符号長[bit]を計算
+* 推定にはorder次のLPCを使う */
+static double LINNEEncoder_EstimateMeanCodeLength(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples, uint32_t order)
 {
     uint32_t ch, smpl;
-    double mean_length;
+    double mean_length, scale;
     const struct LINNEHeader *header;
 
     LINNE_ASSERT(encoder != NULL);
@@ -474,43 +765,245 @@ static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
     LINNE_ASSERT(encoder->set_parameter == 1);
 
     header = &encoder->header;
+    scale = pow(2.0, -(int32_t)(header->bits_per_sample - 1));
 
     /* 平均符号長の計算 */
     mean_length = 0.0;
     for (ch = 0; ch < header->num_channels; ch++) {
         /* 入力をdouble化 */
         for (smpl = 0; smpl < num_samples; smpl++) {
-            encoder->buffer_double[smpl] = input[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
+            encoder->buffer_double[smpl] = input[ch][smpl] * scale;
         }
         /* 推定符号長計算 */
-        mean_length += LINNENetwork_EstimateCodeLength(encoder->network,
-                encoder->buffer_double, num_samples, header->bits_per_sample);
+        mean_length += LINNENetwork_EstimateCodeLengthWithOrder(encoder->network,
+                encoder->buffer_double, num_samples, header->bits_per_sample, order);
+    }
+
+    return mean_length / header->num_channels;
+}
+
+/* 全チャンネルが一定値の区間のブロックデータタイプの判定
+* 全て0ならば無音、チャンネル毎に一定値ならば定数、それ以外はLINNE_BLOCK_DATA_TYPE_INVALIDを返す */
+static LINNEBlockDataType LINNEEncoder_DecideConstantBlockDataType(
+        const struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+{
+    uint32_t ch, smpl;
+    uint8_t is_silent = 1;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        const int32_t *pinput = input[ch];
+        const int32_t value = pinput[0];
+        for (smpl = 1; smpl < num_samples; smpl++) {
+            if (pinput[smpl] != value) {
+                return LINNE_BLOCK_DATA_TYPE_INVALID;
+            }
+        }
+        if (value != 0) {
+            is_silent = 0;
+        }
+    }
+
+    return (is_silent == 1) ? LINNE_BLOCK_DATA_TYPE_SILENT : LINNE_BLOCK_DATA_TYPE_CONSTANT;
+}
+
+/* ブロックデータタイプの判定 */
+static LINNEBlockDataType LINNEEncoder_DecideBlockDataType(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+{
+    double mean_length;
+    LINNEBlockDataType block_type;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(encoder->set_parameter == 1);
+
+    header = &encoder->header;
+
+    /* 無音・定数判定: 符号長の推定より先に行い、分析を省く */
+    if ((block_type = LINNEEncoder_DecideConstantBlockDataType(encoder, input, num_samples))
+            != LINNE_BLOCK_DATA_TYPE_INVALID) {
+        return block_type;
     }
-    mean_length /= header->num_channels;
+
+    /* 平均符号長の計算: 次数はネットワークの1層目のパラメータ数 */
+    mean_length = LINNEEncoder_EstimateMeanCodeLength(encoder, input, num_samples,
+            encoder->parameter_preset->num_params_list[0]);
 
     /* ビット幅に占める比に変換 */
     mean_length /= header->bits_per_sample;
 
-    /* データタイプ判定 */
-
     /* 圧縮が効きにくい: 生データ出力 */
     if (mean_length >= LINNE_ESTIMATED_CODELENGTH_THRESHOLD) {
         return LINNE_BLOCK_DATA_TYPE_RAWDATA;
     }
 
-    /* 無音判定 */
-    for (ch = 0; ch < header->num_channels; ch++) {
-        for (smpl = 0; smpl < num_samples; smpl++) {
-            if (input[ch][smpl] != 0) {
-                goto NOT_SILENCE;
-            }
+    /* それ以外は圧縮データ */
+    return LINNE_BLOCK_DATA_TYPE_COMPRESSDATA;
+}
+
+/* 区間をpresetのレイヤー構造の1ブロックとしてエンコードしたときの推定サイズ[bit]を計算
+* 残差の符号長はorder次のLPCで見積もる */
+static double LINNEEncoder_EstimateBlockBitsWithPreset(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        const struct LINNEParameterPreset *preset, uint32_t order, LINNEBlockDataType *block_type)
+{
+    uint32_t l, parameter_bits;
+    double mean_length;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(preset != NULL);
+    LINNE_ASSERT(block_type != NULL);
+
+    header = &encoder->header;
+
+    /* 無音・定数: 符号長の推定は不要 */
+    switch (LINNEEncoder_DecideConstantBlockDataType(encoder, input, num_samples)) {
+    case LINNE_BLOCK_DATA_TYPE_SILENT:
+        (*block_type) = LINNE_BLOCK_DATA_TYPE_SILENT;
+        return 8.0 * LINNE_BLOCK_HEADER_SIZE;
+    case LINNE_BLOCK_DATA_TYPE_CONSTANT:
+        (*block_type) = LINNE_BLOCK_DATA_TYPE_CONSTANT;
+        return 8.0 * LINNE_BLOCK_HEADER_SIZE + (double)header->bits_per_sample * header->num_channels;
+    default:
+        break;
+    }
+
+    mean_length = LINNEEncoder_EstimateMeanCodeLength(encoder, input, num_samples, order);
+
+    /* 圧縮が効きにくい: 生データ出力 */
+    if ((mean_length / header->bits_per_sample) >= LINNE_ESTIMATED_CODELENGTH_THRESHOLD) {
+        (*block_type) = LINNE_BLOCK_DATA_TYPE_RAWDATA;
+        return 8.0 * LINNE_BLOCK_HEADER_SIZE + (double)header->bits_per_sample * num_samples * header->num_channels;
+    }
+
+    /* 推定符号長が0になるのは（ほぼ）無音のとき */
+    if (mean_length <= 0.0) {
+        (*block_type) = LINNE_BLOCK_DATA_TYPE_SILENT;
+        return 8.0 * LINNE_BLOCK_HEADER_SIZE;
+    }
+
+    /* 圧縮データ: 残差の推定符号長にチャンネル毎のパラメータ分を加える */
+    parameter_bits = LINNE_NUM_PREEMPHASIS_FILTERS * (uint32_t)(header->bits_per_sample + LINNE_PREEMPHASIS_COEF_SHIFT);
+    for (l = 0; l < preset->num_layers; l++) {
+        parameter_bits += LINNE_LOG2_NUM_UNITS_BITWIDTH + LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH
+            + preset->num_params_list[l] * LINNE_LPC_COEFFICIENT_BITWIDTH;
+    }
+    (*block_type) = LINNE_BLOCK_DATA_TYPE_COMPRESSDATA;
+    return 8.0 * (LINNE_BLOCK_HEADER_SIZE + ((header->enable_block_preset == 1) ? 1 : 0))
+        + (mean_length * num_samples + parameter_bits) * header->num_channels;
+}
+
+/* 区間を1ブロックとしてエンコードしたときの推定サイズ[bit]を計算
+* ブロックデータタイプもLINNEEncoder_DecideBlockDataTypeと同じ推定符号長で見積もる */
+static double LINNEEncoder_EstimateBlockBits(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        LINNEBlockDataType *block_type)
+{
+    LINNE_ASSERT(encoder != NULL);
+
+    return LINNEEncoder_EstimateBlockBitsWithPreset(encoder, input, num_samples,
+            encoder->parameter_preset, encoder->parameter_preset->num_params_list[0], block_type);
+}
+
+/* 区間を前後半に分割した方が推定サイズが小さければ再帰的に分割し、結果のブロックを順に追記
+* budgetは残りの推定に使ってよいサンプル数。分割の評価は深さ優先で行う */
+static void LINNEEncoder_SplitBlock(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        double block_bits, LINNEBlockDataType block_type, uint32_t depth, uint64_t *budget,
+        uint32_t *block_num_samples, uint32_t *num_blocks)
+{
+    uint32_t ch;
+    const uint32_t num_half_samples = num_samples / 2;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(budget != NULL);
+    LINNE_ASSERT(block_num_samples != NULL);
+    LINNE_ASSERT(num_blocks != NULL);
+
+    /* 無音・定数・生データと見積もった区間は分割しても縮まないので枝刈り */
+    if ((block_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)
+            && (depth < LINNEENCODER_MAX_BLOCK_SPLIT_DEPTH)
+            && (num_half_samples >= encoder->min_num_samples_per_block)
+            && ((*budget) >= num_samples)) {
+        const int32_t *input_latter[LINNE_MAX_NUM_CHANNELS];
+        LINNEBlockDataType former_type, latter_type;
+        double former_bits, latter_bits;
+
+        for (ch = 0; ch < encoder->header.num_channels; ch++) {
+            input_latter[ch] = &input[ch][num_half_samples];
+        }
+
+        (*budget) -= num_samples;
+        former_bits = LINNEEncoder_EstimateBlockBits(encoder, input, num_half_samples, &former_type);
+        latter_bits = LINNEEncoder_EstimateBlockBits(encoder, input_latter, num_samples - num_half_samples, &latter_type);
+
+        if ((former_bits + latter_bits) < block_bits) {
+            LINNEEncoder_SplitBlock(encoder, input, num_half_samples,
+                    former_bits, former_type, depth + 1, budget, block_num_samples, num_blocks);
+            LINNEEncoder_SplitBlock(encoder, input_latter, num_samples - num_half_samples,
+                    latter_bits, latter_type, depth + 1, budget, block_num_samples, num_blocks);
+            return;
         }
     }
-    return LINNE_BLOCK_DATA_TYPE_SILENT;
 
-NOT_SILENCE:
-    /* それ以外は圧縮データ */
-    return LINNE_BLOCK_DATA_TYPE_COMPRESSDATA;
+    /* 分割しない */
+    block_num_samples[(*num_blocks)++] = num_samples;
+}
+
+/* 入力先頭の区間をブロックに分割 */
+LINNEApiResult LINNEEncoder_DecideBlockPartition(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples,
+        uint32_t *block_num_samples, uint32_t max_num_blocks, uint32_t *num_blocks)
+{
+    uint32_t num_span_samples;
+    uint64_t budget;
+    LINNEBlockDataType block_type;
+    double block_bits;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (block_num_samples == NULL) || (num_blocks == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* 分割結果の領域が足りない */
+    if (max_num_blocks < LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    num_span_samples = LINNEUTILITY_MIN(encoder->header.num_samples_per_block, num_samples);
+    /* 計算量上限×ブロックあたりサンプル数は32bitで溢れうるので64bitで計算 */
+    budget = (uint64_t)encoder->block_size_search_budget * encoder->header.num_samples_per_block;
+    (*num_blocks) = 0;
+
+    /* 適応選択が無効、あるいは区間全体の推定もできない計算量上限なら分割しない */
+    if ((encoder->min_num_samples_per_block == 0) || (budget < num_span_samples)) {
+        block_num_samples[(*num_blocks)++] = num_span_samples;
+        return LINNE_APIRESULT_OK;
+    }
+
+    /* 区間全体の推定サイズから分割を探索 */
+    budget -= num_span_samples;
+    block_bits = LINNEEncoder_EstimateBlockBits(encoder, input, num_span_samples, &block_type);
+    LINNEEncoder_SplitBlock(encoder, input, num_span_samples,
+            block_bits, block_type, 0, &budget, block_num_samples, num_blocks);
+    LINNE_ASSERT((*num_blocks) <= LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS);
+
+    return LINNE_APIRESULT_OK;
 }
 
 /* 生データブロックエンコード */
@@ -545,7 +1038,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint8(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -553,7 +1046,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint16BE(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -561,7 +1054,7 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
                 for (smpl = 0; smpl < num_samples; smpl++) {
                     for (ch = 0; ch < header->num_channels; ch++) {
                         ByteArray_PutUint24BE(data_ptr, LINNEUTILITY_SINT32_TO_UINT32(input[ch][smpl]));
-                        LINNE_ASSERT((uint32_t)(data_ptr - data) < data_size);
+                        LINNE_ASSERT((uint32_t)(data_ptr - data) <= data_size);
                     }
                 }
                 break;
@@ -575,124 +1068,666 @@ static LINNEApiResult LINNEEncoder_EncodeRawData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 圧縮データブロックエンコード */
-static LINNEApiResult LINNEEncoder_EncodeCompressData(
-        struct LINNEEncoder *encoder,
-        const int32_t *const *input, uint32_t num_samples,
-        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* 全てのサンプルが16bit符号付き整数の範囲にあるか */
+static uint8_t LINNEEncoder_IsInt16Range(const int32_t *data, uint32_t num_samples)
 {
-    uint32_t ch, l, num_analyze_samples;
-    struct BitStream writer;
+    uint32_t smpl;
+    int32_t min = 0, max = 0;
+
+    LINNE_ASSERT(data != NULL);
+
+    /* 分岐なしで最小値と最大値を求める（ベクトル化できる） */
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        min = (data[smpl] < min) ? data[smpl] : min;
+        max = (data[smpl] > max) ? data[smpl] : max;
+    }
+
+    return ((min >= INT16_MIN) && (max <= INT16_MAX)) ? 1 : 0;
+}
+
+/* チャンネル毎の下位の無効ビット数（全サンプルに共通する末尾の0ビット数）を判定
+* MS処理を行う場合はMS変換前に揃えてシフトするためL/Rで小さい方に合わせる
+* 無効ビットを持つチャンネルがあれば1を返す */
+static uint8_t LINNEEncoder_DecideWastedBits(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+{
+    uint32_t ch, smpl;
+    uint8_t has_wasted_bits = 0;
     const struct LINNEHeader *header;
 
-    /* 内部関数なので不正な引数はアサートで落とす */
     LINNE_ASSERT(encoder != NULL);
     LINNE_ASSERT(input != NULL);
-    LINNE_ASSERT(num_samples > 0);
-    LINNE_ASSERT(data != NULL);
-    LINNE_ASSERT(data_size > 0);
-    LINNE_ASSERT(output_size != NULL);
 
     header = &(encoder->header);
 
-    /* 入力をバッファにコピー */
     for (ch = 0; ch < header->num_channels; ch++) {
-        memcpy(encoder->buffer_int[ch], input[ch], sizeof(int32_t) * num_samples);
-        /* バッファサイズより小さい入力のときは、末尾を0埋め */
-        if (num_samples < encoder->max_num_samples_per_block) {
-            const uint32_t remain = encoder->max_num_samples_per_block - num_samples;
-            memset(&encoder->buffer_int[ch][num_samples], 0, sizeof(int32_t) * remain);
+        uint32_t bits = 0, shift = 0;
+        /* 全サンプルのOR（ベクトル化できる） */
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            bits |= (uint32_t)input[ch][smpl];
+        }
+        /* 末尾の0ビットを数える 全て0のチャンネルはシフトしない */
+        if (bits != 0) {
+            while (((bits >> shift) & 1) == 0) {
+                shift++;
+            }
         }
+        LINNE_ASSERT(shift < (1 << LINNE_WASTED_BITS_BITWIDTH));
+        encoder->wasted_bits[ch] = shift;
     }
 
-    /* マルチチャンネル処理 */
-    if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
-        /* チャンネル数チェック */
-        if (header->num_channels < 2) {
-            return LINNE_APIRESULT_INVALID_FORMAT;
-        }
-        /* LR -> MS */
-        LINNEUtility_MSConversion(encoder->buffer_int, num_samples);
+    if ((header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) && (header->num_channels >= 2)) {
+        const uint32_t shift = LINNEUTILITY_MIN(encoder->wasted_bits[0], encoder->wasted_bits[1]);
+        encoder->wasted_bits[0] = encoder->wasted_bits[1] = shift;
     }
 
-    /* プリエンファシス */
     for (ch = 0; ch < header->num_channels; ch++) {
-        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
-            /* 直前値には先頭の同一値が続くと考える */
-            encoder->pre_emphasis[ch][l].prev = encoder->pre_emphasis_prev[ch][l] = encoder->buffer_int[ch][0];
-            LINNEPreemphasisFilter_CalculateCoefficient(&encoder->pre_emphasis[ch][l], encoder->buffer_int[ch], num_samples);
-            LINNEPreemphasisFilter_Preemphasis(&encoder->pre_emphasis[ch][l], encoder->buffer_int[ch], num_samples);
+        if (encoder->wasted_bits[ch] != 0) {
+            has_wasted_bits = 1;
         }
     }
 
-    /* LPCで分析するサンプル数を決定 */
-    {
-        uint32_t max_num_parameters_per_layer = 0;
-        for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
-            if (max_num_parameters_per_layer < encoder->parameter_preset->num_params_list[l]) {
-                max_num_parameters_per_layer = encoder->parameter_preset->num_params_list[l];
-            }
-        }
+    return has_wasted_bits;
+}
+
+/* 圧縮データブロックの前処理
+* 事前にLINNEEncoder_DecideWastedBitsで判定した下位の無効ビットを落としてから
+* チャンネル処理とプリエンファシスを行い、結果を信号バッファに残す
+* 補足）前処理はプリセットに依存しない */
+static LINNEApiResult LINNEEncoder_PreprocessCompressData(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples)
+{
+    uint32_t ch;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    header = &(encoder->header);
+
+    /* チャンネル数チェック */
+    if ((header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) && (header->num_channels < 2)) {
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 入力をバッファにコピー 下位の無効ビットはここで落とす */
+    ch = 0;
+    if (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) {
+        /* コピーと同時にLR -> MS変換（L/Rの無効ビット数は揃えてある） */
+        uint32_t smpl;
+        const uint32_t shift = encoder->wasted_bits[0];
+        const int32_t *lch = input[0], *rch = input[1];
+        int32_t *mch = LINNEENCODER_BUFFER(encoder, buffer_int, 0), *sch = LINNEENCODER_BUFFER(encoder, buffer_int, 1);
+        LINNE_ASSERT(encoder->wasted_bits[0] == encoder->wasted_bits[1]);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            const int32_t side = (rch[smpl] >> shift) - (lch[smpl] >> shift);
+            mch[smpl] = (lch[smpl] >> shift) + (side >> 1);
+            sch[smpl] = side;
+        }
+        ch = 2;
+    }
+    for (; ch < header->num_channels; ch++) {
+        const uint32_t shift = encoder->wasted_bits[ch];
+        int32_t *buffer_int = LINNEENCODER_BUFFER(encoder, buffer_int, ch);
+        if (shift > 0) {
+            uint32_t smpl;
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                buffer_int[smpl] = input[ch][smpl] >> shift;
+            }
+        } else {
+            memcpy(buffer_int, input[ch], sizeof(int32_t) * num_samples);
+        }
+    }
+    /* バッファサイズより小さい入力のときは、末尾を0埋め */
+    if (num_samples < encoder->max_num_samples_per_block) {
+        const uint32_t remain = encoder->max_num_samples_per_block - num_samples;
+        for (ch = 0; ch < header->num_channels; ch++) {
+            memset(&LINNEENCODER_BUFFER(encoder, buffer_int, ch)[num_samples], 0, sizeof(int32_t) * remain);
+        }
+    }
+
+    /* プリエンファシス */
+    for (ch = 0; ch < header->num_channels; ch++) {
+        LINNEPreemphasisFilter_MultiStagePreemphasis(encoder->pre_emphasis[ch],
+                encoder->pre_emphasis_prev[ch], LINNEENCODER_BUFFER(encoder, buffer_int, ch), num_samples);
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 分析窓バッファと前処理済みの信号をつなげた分析窓をdoubleバッファに組み立てる
+* 分析窓バッファは次のブロックのために分析窓の末尾num_lookback_samplesまでに置き換える（蓄えたサンプル数の更新は呼び出し側で行う） */
+static void LINNEEncoder_SetupLookbackWindow(struct LINNEEncoder *encoder, uint32_t ch, uint32_t num_samples)
+{
+    uint32_t smpl, num_window_samples, num_keep_samples;
+    double scale, *history;
+    const int32_t *buffer_int;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(encoder->lookback_history != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(encoder->num_history_samples <= encoder->num_lookback_samples);
+
+    header = &(encoder->header);
+    history = LINNEENCODER_HISTORY(encoder, ch);
+    buffer_int = LINNEENCODER_BUFFER(encoder, buffer_int, ch);
+    num_window_samples = encoder->num_history_samples + num_samples;
+
+    /* ブロック毎に無効ビット数が変わっても振幅が揃うよう、分析と同じ正規化をしてつなげる */
+    scale = pow(2.0, -(int32_t)(header->bits_per_sample - 1 - encoder->wasted_bits[ch]));
+    memcpy(encoder->buffer_double, history, sizeof(double) * encoder->num_history_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        encoder->buffer_double[encoder->num_history_samples + smpl] = buffer_int[smpl] * scale;
+    }
+
+    /* 直前のブロックのサンプルはnum_lookback_samplesまで残す */
+    num_keep_samples = LINNEUTILITY_MIN(num_window_samples, encoder->num_lookback_samples);
+    memcpy(history, &encoder->buffer_double[num_window_samples - num_keep_samples], sizeof(double) * num_keep_samples);
+}
+
+/* 前処理済みの信号を分析窓バッファに追加
+* 分析を省いたブロックも次のブロックの分析窓に含めるために使う */
+static void LINNEEncoder_AppendLookbackHistory(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        LINNEEncoder_SetupLookbackWindow(encoder, ch, num_samples);
+    }
+
+    encoder->num_history_samples
+        = LINNEUTILITY_MIN(encoder->num_history_samples + num_samples, encoder->num_lookback_samples);
+}
+
+/* 前処理済みの圧縮データブロックの分析
+* LPC係数計算・予測を行い、残差をバッファに残す */
+static void LINNEEncoder_AnalyzePreprocessedData(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch, l, num_analyze_samples, num_window_samples;
+    uint8_t use_lookback;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    header = &(encoder->header);
+
+    /* LPCで分析するサンプル数を決定 */
+    {
+        uint32_t max_num_parameters_per_layer = 0;
+        for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
+            if (max_num_parameters_per_layer < encoder->parameter_preset->num_params_list[l]) {
+                max_num_parameters_per_layer = encoder->parameter_preset->num_params_list[l];
+            }
+        }
         /* ユニット数で割り切れるように、分析サンプル数はユニット分割数の倍数に切り上げ */
         num_analyze_samples = LINNEUTILITY_ROUNDUP(num_samples, (1 << LINNE_LOG2_NUM_UNITS_BITWIDTH));
-        /* クリップ */
-        num_analyze_samples = LINNEUTILITY_INNER_VALUE(num_analyze_samples, max_num_parameters_per_layer, header->num_samples_per_block);
+        /* クリップ 自己相関の計算には次数+1サンプル以上が必要なので、次数以下の短いブロックは0埋めした末尾まで含めて分析 */
+        num_analyze_samples = LINNEUTILITY_INNER_VALUE(num_analyze_samples, max_num_parameters_per_layer + 1, header->num_samples_per_block);
+        /* 直前のブロックとつなげた分析窓が次数を超えるサンプルを含めば、直前のブロックを含めて分析 */
+        num_window_samples = encoder->num_history_samples + num_samples;
+        use_lookback = ((encoder->num_lookback_samples > 0)
+                && (num_window_samples > max_num_parameters_per_layer)) ? 1 : 0;
     }
 
     /* チャンネル毎にLINNENetworkのパラメータ計算 */
     for (ch = 0; ch < header->num_channels; ch++) {
-        uint32_t smpl;
-        /* double精度の信号に変換（[-1,1]の範囲に正規化） */
-        for (smpl = 0; smpl < num_analyze_samples; smpl++) {
-            encoder->buffer_double[smpl] = encoder->buffer_int[ch][smpl] * pow(2.0, -(int32_t)(header->bits_per_sample - 1));
+        uint32_t *rshifts = LINNEENCODER_LAYER_INFO(encoder, rshifts, ch);
+        const double *analyze_input;
+        uint32_t num_input_samples;
+        /* 直前のブロックを使わない分析でも、次のブロックのために分析窓バッファは更新する */
+        if (encoder->num_lookback_samples > 0) {
+            LINNEEncoder_SetupLookbackWindow(encoder, ch, num_samples);
+        }
+        if (use_lookback) {
+            /* 直前のブロックを含む分析窓は区間分割とずれるので、ユニット数は1に固定 */
+            analyze_input = encoder->buffer_double;
+            num_input_samples = num_window_samples;
+            LINNENetwork_SetSingleUnitParameters(encoder->network, analyze_input, num_input_samples);
+        } else {
+            /* 無効ビットを落とした分だけ振幅が小さいので、その分を除いたビット幅で正規化 */
+            const double scale = pow(2.0, -(int32_t)(header->bits_per_sample - 1 - encoder->wasted_bits[ch]));
+            const int32_t *buffer_int = LINNEENCODER_BUFFER(encoder, buffer_int, ch);
+            num_input_samples = num_analyze_samples;
+            if (encoder->enable_learning != 0) {
+                uint32_t smpl;
+                /* 学習は反復毎に入力を読み直すので、double精度の信号（[-1,1]の範囲に正規化）を残しておく */
+                for (smpl = 0; smpl < num_analyze_samples; smpl++) {
+                    encoder->buffer_double[smpl] = buffer_int[smpl] * scale;
+                }
+                analyze_input = encoder->buffer_double;
+                LINNENetwork_SetUnitsAndParameters(encoder->network, analyze_input, num_input_samples);
+            } else {
+                /* 学習しないときはネットワークへの取り込みと同時に正規化し、中間バッファを経由しない */
+                analyze_input = NULL;
+                LINNENetwork_SetUnitsAndParametersInt32(encoder->network, buffer_int, scale, num_input_samples);
+            }
         }
-        /* ユニット数とパラメータ設定 */
-        LINNENetwork_SetUnitsAndParameters(encoder->network, encoder->buffer_double, num_analyze_samples);
         /* ネットワーク学習 */
         if (encoder->enable_learning != 0) {
             LINNENetworkTrainer_Train(encoder->trainer,
-                    encoder->network, encoder->buffer_double, num_analyze_samples,
+                    encoder->network, analyze_input, num_input_samples,
                     LINNE_TRAINING_PARAMETER_MAX_NUM_ITRATION,
                     LINNE_TRAINING_PARAMETER_LEARNING_RATE,
                     LINNE_TRAINING_PARAMETER_LOSS_EPSILON);
         }
         /* ユニット数とパラメータ取得・量子化 */
-        LINNENetwork_GetLayerNumUnits(encoder->network, encoder->num_units[ch], encoder->max_num_layers);
-        LINNENetwork_GetParameters(encoder->network, encoder->params_double[ch], encoder->max_num_layers, encoder->max_num_parameters_per_layer);
+        LINNENetwork_GetLayerNumUnits(encoder->network, LINNEENCODER_LAYER_INFO(encoder, num_units, ch), encoder->max_num_layers);
+        LINNENetwork_GetParameters(encoder->network, LINNEENCODER_PARAMS(encoder, params_double, ch, 0),
+                encoder->max_num_layers, encoder->max_num_parameters_per_layer);
         for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
-            LPC_QuantizeCoefficients(encoder->params_double[ch][l],
+            LPC_QuantizeCoefficients(LINNEENCODER_PARAMS(encoder, params_double, ch, l),
                     encoder->parameter_preset->num_params_list[l], LINNE_LPC_COEFFICIENT_BITWIDTH,
-                    encoder->params_int[ch][l], &encoder->rshifts[ch][l]);
+                    LINNEENCODER_PARAMS(encoder, params_int, ch, l), &rshifts[l]);
         }
     }
 
+    /* 全チャンネルの分析窓バッファを更新したのでサンプル数を更新 */
+    if (encoder->num_lookback_samples > 0) {
+        encoder->num_history_samples = LINNEUTILITY_MIN(num_window_samples, encoder->num_lookback_samples);
+    }
+
+    /* LPC予測 */
+    LINNEEncoder_PredictPreprocessedData(encoder, num_samples);
+}
+
+/* 前処理済みの信号を現在のLPC係数で予測
+* 残差をバッファに残す 補足）信号バッファは最終層の残差で上書きされる */
+static void LINNEEncoder_PredictPreprocessedData(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch, l;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    header = &(encoder->header);
+
     /* チャンネル毎にLPC予測 */
     for (ch = 0; ch < header->num_channels; ch++) {
+        int32_t *buffer_int = LINNEENCODER_BUFFER(encoder, buffer_int, ch);
+        int32_t *residual = LINNEENCODER_BUFFER(encoder, residual, ch);
+        const uint32_t *num_units = LINNEENCODER_LAYER_INFO(encoder, num_units, ch);
+        const uint32_t *rshifts = LINNEENCODER_LAYER_INFO(encoder, rshifts, ch);
         /* LPC予測 */
         for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
             uint32_t i;
-            const uint32_t nunits = encoder->num_units[ch][l];
+            const uint32_t nunits = num_units[l];
             const uint32_t nparams_per_unit = encoder->parameter_preset->num_params_list[l] / nunits;
             /* 補足: num_samplesはnunitsで割り切れなくてもよい 剰余分の末尾サンプルは予測しない */
             const uint32_t nsmpls_per_unit = num_samples / nunits;
+            /* レイヤーの入力が16bitに収まっていれば16bit積和で予測 */
+            const uint8_t int16_input = LINNEEncoder_IsInt16Range(buffer_int, num_samples);
+            const int32_t *params_int = LINNEENCODER_PARAMS(encoder, params_int, ch, l);
             for (i = 0; i < nunits; i++) {
-                const int32_t *pinput = &encoder->buffer_int[ch][i * nsmpls_per_unit];
-                int32_t *poutput = &encoder->residual[ch][i * nsmpls_per_unit];
-                const int32_t *pcoef = &encoder->params_int[ch][l][i * nparams_per_unit];
-                /* 予測 */
-                LINNELPC_Predict(pinput, nsmpls_per_unit, pcoef, nparams_per_unit, poutput, encoder->rshifts[ch][l]);
+                const int32_t *pinput = &buffer_int[i * nsmpls_per_unit];
+                int32_t *poutput = &residual[i * nsmpls_per_unit];
+                const int32_t *pcoef = &params_int[i * nparams_per_unit];
+                /* 予測 32bitの積和が桁あふれしうる場合は64bitで積和 */
+                if (LINNEUtility_IsLPCAccumulatorOverflowable(pcoef, nparams_per_unit, rshifts[l], header->bits_per_sample)) {
+                    LINNELPC_PredictInt64(pinput, nsmpls_per_unit, pcoef, nparams_per_unit, poutput, rshifts[l]);
+                } else if (int16_input) {
+                    LINNELPC_PredictInt16(pinput, nsmpls_per_unit, pcoef, nparams_per_unit, poutput, rshifts[l]);
+                } else {
+                    LINNELPC_Predict(pinput, nsmpls_per_unit, pcoef, nparams_per_unit, poutput, rshifts[l]);
+                }
             }
             /* 残差を次のレイヤーの入力へ */
-            memcpy(encoder->buffer_int[ch], encoder->residual[ch], sizeof(int32_t) * num_samples);
+            memcpy(buffer_int, residual, sizeof(int32_t) * num_samples);
         }
     }
+}
+
+/* 全チャンネルのユニット数/LPC係数右シフト量/LPC係数の符号長[bit]計算 */
+static uint32_t LINNEEncoder_CalculateParameterBits(const struct LINNEEncoder *encoder)
+{
+    uint32_t l, bits;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+
+    bits = 0;
+    for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
+        bits += encoder->header.num_channels * (LINNE_LOG2_NUM_UNITS_BITWIDTH + LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH
+                + encoder->parameter_preset->num_params_list[l] * LINNE_LPC_COEFFICIENT_BITWIDTH);
+    }
+
+    return bits;
+}
+
+/* 全チャンネルの残差の符号長[bit]計算 */
+static uint32_t LINNEEncoder_CalculateResidualBits(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch, bits;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    bits = 0;
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        bits += LINNECoder_CalculateCodeLength(encoder->coder, LINNEENCODER_BUFFER(encoder, residual, ch), num_samples);
+    }
+
+    return bits;
+}
+
+/* 全チャンネルの前処理済み信号（予測前）の符号長[bit]計算 */
+static uint32_t LINNEEncoder_CalculatePreprocessedBits(struct LINNEEncoder *encoder, uint32_t num_samples)
+{
+    uint32_t ch, bits;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    bits = 0;
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        bits += LINNECoder_CalculateCodeLength(encoder->coder, LINNEENCODER_BUFFER(encoder, buffer_int, ch), num_samples);
+    }
+
+    return bits;
+}
+
+/* 直前のブロックに依存するブロック（パラメータの再利用・差分記録）にできるか
+* 直前に出力したパラメータのレイヤー構造が同じで、キーフレームを置く位置でなければ依存できる */
+static uint8_t LINNEEncoder_CanDependOnPreviousBlock(const struct LINNEEncoder *encoder)
+{
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+
+    if ((encoder->reusable_preset == NULL) || (encoder->reusable_preset != encoder->parameter_preset)) {
+        return 0;
+    }
+    if ((encoder->keyframe_interval != 0) && ((encoder->num_blocks_since_keyframe + 1) >= encoder->keyframe_interval)) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/* 符号長[bit]が最小になるRice符号のパラメータを探索 */
+static uint32_t LINNEEncoder_SearchRiceParameter(
+        const uint32_t *uvals, uint32_t num_uvals, uint32_t max_parameter, uint32_t *code_length)
+{
+    uint32_t i, k, best_k;
+    uint64_t bits, min_bits;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(uvals != NULL);
+    LINNE_ASSERT(code_length != NULL);
+
+    best_k = 0;
+    min_bits = 0;
+    for (k = 0; k <= max_parameter; k++) {
+        /* 商のalpha符号（終端の1を含む）と剰余kビット */
+        bits = 0;
+        for (i = 0; i < num_uvals; i++) {
+            bits += (uvals[i] >> k) + 1 + k;
+        }
+        if ((k == 0) || (bits < min_bits)) {
+            min_bits = bits;
+            best_k = k;
+        }
+    }
+
+    (*code_length) = (uint32_t)min_bits;
+    return best_k;
+}
+
+/* Rice符号の出力 */
+static void LINNEEncoder_PutRiceCode(struct BitStream *writer, uint32_t uval, uint32_t k)
+{
+    LINNE_ASSERT(writer != NULL);
+
+    BitWriter_PutZeroRun(writer, uval >> k);
+    BitWriter_PutBits(writer, uval & ((1U << k) - 1), k);
+}
+
+/* チャンネル毎のプリエンファシスフィルタ初段の初期値の差分
+* 基準は直前のブロックの末尾サンプルを現在のブロックと同じように前処理した値 */
+static void LINNEEncoder_CalculatePreemphasisDeltas(const struct LINNEEncoder *encoder, uint32_t *uvals)
+{
+    uint32_t ch;
+    int32_t basis[LINNE_MAX_NUM_CHANNELS];
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(uvals != NULL);
+
+    header = &(encoder->header);
+
+    LINNEUtility_CalculatePreemphasisBasis(encoder->last_samples, encoder->wasted_bits, header->num_channels,
+            (header->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) ? 1 : 0, basis);
+    for (ch = 0; ch < header->num_channels; ch++) {
+        uvals[ch] = LINNEUTILITY_SINT32_TO_UINT32(encoder->pre_emphasis_prev[ch][0] - basis[ch]);
+    }
+}
+
+/* チャンネルchの第l層のLPC係数の差分
+* ユニット数と右シフト量が直前に出力したものと同じときのみ直前の係数を引く */
+static void LINNEEncoder_CalculateCoefficientDeltas(
+        const struct LINNEEncoder *encoder, uint32_t ch, uint32_t l, uint32_t *uvals)
+{
+    uint32_t i;
+    uint8_t same_shape;
+    const int32_t *params_int, *reference;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(uvals != NULL);
+
+    params_int = LINNEENCODER_PARAMS(encoder, params_int, ch, l);
+    reference = LINNEENCODER_PARAMS(encoder, reference_params_int, ch, l);
+    same_shape = ((LINNEENCODER_LAYER_INFO(encoder, num_units, ch)[l] == LINNEENCODER_LAYER_INFO(encoder, reference_num_units, ch)[l])
+            && (LINNEENCODER_LAYER_INFO(encoder, rshifts, ch)[l] == LINNEENCODER_LAYER_INFO(encoder, reference_rshifts, ch)[l])) ? 1 : 0;
+
+    for (i = 0; i < encoder->parameter_preset->num_params_list[l]; i++) {
+        uvals[i] = LINNEUTILITY_SINT32_TO_UINT32(params_int[i] - ((same_shape == 1) ? reference[i] : 0));
+    }
+}
+
+/* 差分を取らずに記録するパラメータ（プリエンファシス/ユニット数/LPC係数右シフト量/LPC係数）の符号長[bit]計算
+* パラメータを再利用する場合はプリエンファシスのみ */
+static uint32_t LINNEEncoder_CalculateFullParameterBits(const struct LINNEEncoder *encoder)
+{
+    uint32_t bits;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+
+    header = &(encoder->header);
+
+    /* プリエンファシス */
+    bits = header->num_channels * LINNE_NUM_PREEMPHASIS_FILTERS
+        * ((header->bits_per_sample + 1U) + (LINNE_PREEMPHASIS_COEF_SHIFT - 1U));
+    /* ユニット数/LPC係数右シフト量/LPC係数 再利用する場合は記録しない */
+    if (encoder->reuse_parameters != 1) {
+        bits += LINNEEncoder_CalculateParameterBits(encoder);
+    }
+
+    return bits;
+}
+
+/* 直前のブロックとの差分で記録するパラメータの符号長[bit]計算
+* パラメータを再利用する場合はプリエンファシスのみ */
+static uint32_t LINNEEncoder_CalculateDeltaParameterBits(const struct LINNEEncoder *encoder)
+{
+    uint32_t ch, l, bits, rice_bits;
+    uint32_t uvals[LINNE_NETWORK_MAX_PARAMS_PER_LAYER];
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+
+    header = &(encoder->header);
+
+    /* プリエンファシス: 初段の初期値の差分と各段の係数 2段目以降の初期値は前段から決まるので記録しない */
+    LINNEEncoder_CalculatePreemphasisDeltas(encoder, uvals);
+    (void)LINNEEncoder_SearchRiceParameter(uvals, header->num_channels,
+            (1U << LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH) - 1, &rice_bits);
+    bits = LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH + rice_bits
+        + header->num_channels * LINNE_NUM_PREEMPHASIS_FILTERS * (LINNE_PREEMPHASIS_COEF_SHIFT - 1U);
+
+    /* ユニット数/LPC係数右シフト量/LPC係数の差分 再利用する場合は記録しない */
+    for (ch = 0; (encoder->reuse_parameters != 1) && (ch < header->num_channels); ch++) {
+        for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
+            LINNEEncoder_CalculateCoefficientDeltas(encoder, ch, l, uvals);
+            (void)LINNEEncoder_SearchRiceParameter(uvals, encoder->parameter_preset->num_params_list[l],
+                    (1U << LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH) - 1, &rice_bits);
+            bits += LINNE_LOG2_NUM_UNITS_BITWIDTH + LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH
+                + LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH + rice_bits;
+        }
+    }
+
+    return bits;
+}
+
+/* 分析済みの圧縮データブロックのサイズ[byte]計算
+* LINNEEncoder_EncodeCompressDataの出力サイズと一致する */
+static uint32_t LINNEEncoder_CalculateCompressDataSize(
+        struct LINNEEncoder *encoder, uint32_t num_samples, uint8_t has_wasted_bits)
+{
+    uint32_t bits, preset_size;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    header = &(encoder->header);
+
+    /* プリセット番号 */
+    preset_size = (header->enable_block_preset == 1) ? 1 : 0;
+
+    /* 下位の無効ビット数 */
+    bits = (has_wasted_bits == 1) ? (LINNE_WASTED_BITS_BITWIDTH * header->num_channels) : 0;
+    /* プリエンファシス/ユニット数/LPC係数右シフト量/LPC係数 */
+    bits += (encoder->delta_parameters == 1)
+        ? LINNEEncoder_CalculateDeltaParameterBits(encoder) : LINNEEncoder_CalculateFullParameterBits(encoder);
+    /* 残差 */
+    bits += LINNEEncoder_CalculateResidualBits(encoder, num_samples);
+
+    /* バイト境界に揃える */
+    return preset_size + (bits + 7) / 8;
+}
+
+/* 直前のブロックとの差分で記録するパラメータの符号化 */
+static void LINNEEncoder_PutDeltaParameters(struct LINNEEncoder *encoder, struct BitStream *writer)
+{
+    uint32_t ch, l, i, k, rice_bits, uval;
+    uint32_t uvals[LINNE_NETWORK_MAX_PARAMS_PER_LAYER];
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(writer != NULL);
+
+    header = &(encoder->header);
+
+    /* プリエンファシス */
+    /* 初段の初期値の差分 */
+    LINNEEncoder_CalculatePreemphasisDeltas(encoder, uvals);
+    k = LINNEEncoder_SearchRiceParameter(uvals, header->num_channels,
+            (1U << LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH) - 1, &rice_bits);
+    BitWriter_PutBits(writer, k, LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH);
+    for (ch = 0; ch < header->num_channels; ch++) {
+        LINNEEncoder_PutRiceCode(writer, uvals[ch], k);
+    }
+    /* 各段の係数 */
+    for (ch = 0; ch < header->num_channels; ch++) {
+        for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+            /* 2段目以降の初期値は前段の初期値を前段でプリエンファシスした値 */
+            LINNE_ASSERT((l == 0) || (encoder->pre_emphasis_prev[ch][l] == encoder->pre_emphasis_prev[ch][l - 1]
+                        - ((encoder->pre_emphasis_prev[ch][l - 1] * encoder->pre_emphasis[ch][l - 1].coef) >> LINNE_PREEMPHASIS_COEF_SHIFT)));
+            LINNE_ASSERT(encoder->pre_emphasis[ch][l].coef >= 0);
+            uval = (uint32_t)encoder->pre_emphasis[ch][l].coef;
+            LINNE_ASSERT(uval < (1 << (LINNE_PREEMPHASIS_COEF_SHIFT - 1)));
+            BitWriter_PutBits(writer, uval, LINNE_PREEMPHASIS_COEF_SHIFT - 1);
+        }
+    }
+
+    /* ユニット数/LPC係数右シフト量/LPC係数の差分 再利用する場合は記録しない */
+    for (ch = 0; (encoder->reuse_parameters != 1) && (ch < header->num_channels); ch++) {
+        const uint32_t *num_units = LINNEENCODER_LAYER_INFO(encoder, num_units, ch);
+        const uint32_t *rshifts = LINNEENCODER_LAYER_INFO(encoder, rshifts, ch);
+        for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
+            /* log2(ユニット数) */
+            uval = LINNEUTILITY_LOG2CEIL(num_units[l]);
+            LINNE_ASSERT(uval < (1 << LINNE_LOG2_NUM_UNITS_BITWIDTH));
+            BitWriter_PutBits(writer, uval, LINNE_LOG2_NUM_UNITS_BITWIDTH);
+            /* LPC係数右シフト量 */
+            uval = LINNEUTILITY_SINT32_TO_UINT32(LINNE_LPC_COEFFICIENT_BITWIDTH - (int32_t)rshifts[l]);
+            LINNE_ASSERT(uval < (1 << LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH));
+            BitWriter_PutBits(writer, uval, LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH);
+            /* LPC係数の差分 */
+            LINNEEncoder_CalculateCoefficientDeltas(encoder, ch, l, uvals);
+            k = LINNEEncoder_SearchRiceParameter(uvals, encoder->parameter_preset->num_params_list[l],
+                    (1U << LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH) - 1, &rice_bits);
+            BitWriter_PutBits(writer, k, LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH);
+            for (i = 0; i < encoder->parameter_preset->num_params_list[l]; i++) {
+                LINNEEncoder_PutRiceCode(writer, uvals[i], k);
+            }
+        }
+    }
+}
+
+/* 分析済みの圧縮データブロックエンコード
+* has_wasted_bitsが1のときはチャンネル毎の無効ビット数を記録する
+* 書き込み先のサイズは呼び出し側でLINNEEncoder_CalculateCompressDataSizeを使って確認すること */
+static LINNEApiResult LINNEEncoder_EncodeCompressData(
+        struct LINNEEncoder *encoder, uint32_t num_samples, uint8_t has_wasted_bits,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    uint32_t ch, l, preset_size;
+    struct BitStream writer;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(data_size > 0);
+    LINNE_ASSERT(output_size != NULL);
+
+    header = &(encoder->header);
+
+    /* ブロック毎にプリセットを切り替える場合は先頭にプリセット番号を置く */
+    preset_size = 0;
+    if (header->enable_block_preset == 1) {
+        uint8_t *data_ptr = data;
+        ByteArray_PutUint8(data_ptr, (uint8_t)(encoder->parameter_preset - g_linne_parameter_preset));
+        preset_size = (uint32_t)(data_ptr - data);
+    }
 
     /* ビットライタ作成 */
-    BitWriter_Open(&writer, data, data_size);
+    BitWriter_Open(&writer, data + preset_size, data_size - preset_size);
 
     /* パラメータ符号化 */
+    /* 下位の無効ビット数 */
+    if (has_wasted_bits == 1) {
+        for (ch = 0; ch < header->num_channels; ch++) {
+            BitWriter_PutBits(&writer, encoder->wasted_bits[ch], LINNE_WASTED_BITS_BITWIDTH);
+        }
+    }
+    /* 直前のブロックとの差分で記録 */
+    if (encoder->delta_parameters == 1) {
+        LINNEEncoder_PutDeltaParameters(encoder, &writer);
+    }
     /* プリエンファシス */
-    for (ch = 0; ch < header->num_channels; ch++) {
+    for (ch = 0; (encoder->delta_parameters != 1) && (ch < header->num_channels); ch++) {
         uint32_t uval;
         for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
             /* プリエンファシスフィルタのバッファ */
@@ -706,21 +1741,24 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
             BitWriter_PutBits(&writer, uval, LINNE_PREEMPHASIS_COEF_SHIFT - 1);
         }
     }
-    /* ユニット数/LPC係数右シフト量/LPC係数 */
-    for (ch = 0; ch < header->num_channels; ch++) {
+    /* ユニット数/LPC係数右シフト量/LPC係数 再利用する場合・差分で記録した場合は記録しない */
+    for (ch = 0; (encoder->reuse_parameters != 1) && (encoder->delta_parameters != 1) && (ch < header->num_channels); ch++) {
+        const uint32_t *num_units = LINNEENCODER_LAYER_INFO(encoder, num_units, ch);
+        const uint32_t *rshifts = LINNEENCODER_LAYER_INFO(encoder, rshifts, ch);
         for (l = 0; l < encoder->parameter_preset->num_layers; l++) {
             uint32_t i, uval;
+            const int32_t *params_int = LINNEENCODER_PARAMS(encoder, params_int, ch, l);
             /* log2(ユニット数) */
-            uval = LINNEUTILITY_LOG2CEIL(encoder->num_units[ch][l]);
+            uval = LINNEUTILITY_LOG2CEIL(num_units[l]);
             LINNE_ASSERT(uval < (1 << LINNE_LOG2_NUM_UNITS_BITWIDTH));
             BitWriter_PutBits(&writer, uval, LINNE_LOG2_NUM_UNITS_BITWIDTH);
             /* 各レイヤーでのLPC係数右シフト量: 基準のLPC_COEF_BITWIDTHと差分をとる */
-            uval = LINNEUTILITY_SINT32_TO_UINT32(LINNE_LPC_COEFFICIENT_BITWIDTH - (int32_t)encoder->rshifts[ch][l]);
+            uval = LINNEUTILITY_SINT32_TO_UINT32(LINNE_LPC_COEFFICIENT_BITWIDTH - (int32_t)rshifts[l]);
             LINNE_ASSERT(uval < (1 << LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH));
             BitWriter_PutBits(&writer, uval, LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH);
             /* LPC係数 */
             for (i = 0; i < encoder->parameter_preset->num_params_list[l]; i++) {
-                uval = LINNEUTILITY_SINT32_TO_UINT32(encoder->params_int[ch][l][i]);
+                uval = LINNEUTILITY_SINT32_TO_UINT32(params_int[i]);
                 LINNE_ASSERT(uval < (1 << LINNE_LPC_COEFFICIENT_BITWIDTH));
                 BitWriter_PutBits(&writer, uval, LINNE_LPC_COEFFICIENT_BITWIDTH);
             }
@@ -729,7 +1767,7 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
 
     /* 残差符号化 */
     for (ch = 0; ch < header->num_channels; ch++) {
-        LINNECoder_Encode(encoder->coder, &writer, encoder->residual[ch], num_samples);
+        LINNECoder_Encode(encoder->coder, &writer, LINNEENCODER_BUFFER(encoder, residual, ch), num_samples);
     }
 
     /* バイト境界に揃える */
@@ -737,6 +1775,7 @@ static LINNEApiResult LINNEEncoder_EncodeCompressData(
 
     /* 書き込みサイズの取得 */
     BitStream_Tell(&writer, (int32_t *)output_size);
+    (*output_size) += preset_size;
 
     /* ビットライタ破棄 */
     BitStream_Close(&writer);
@@ -763,39 +1802,287 @@ static LINNEApiResult LINNEEncoder_EncodeSilentData(
     return LINNE_APIRESULT_OK;
 }
 
-/* 単一データブロックエンコード */
-LINNEApiResult LINNEEncoder_EncodeBlock(
+/* 定数データブロックエンコード */
+static LINNEApiResult LINNEEncoder_EncodeConstantData(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    uint32_t ch;
+    struct BitStream writer;
+    const struct LINNEHeader *header;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(data_size > 0);
+    LINNE_ASSERT(output_size != NULL);
+
+    header = &(encoder->header);
+
+    /* 書き込み先のバッファサイズチェック */
+    if (data_size < (uint32_t)((header->bits_per_sample * header->num_channels + 7) / 8)) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* チャンネル毎の定数値のみを記録 */
+    BitWriter_Open(&writer, data, data_size);
+    for (ch = 0; ch < header->num_channels; ch++) {
+        const uint32_t uval = LINNEUTILITY_SINT32_TO_UINT32(input[ch][0]);
+        LINNE_ASSERT(uval < (1UL << header->bits_per_sample));
+        BitWriter_PutBits(&writer, uval, header->bits_per_sample);
+    }
+    BitStream_Flush(&writer);
+    BitStream_Tell(&writer, (int32_t *)output_size);
+    BitStream_Close(&writer);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 速度レベルの適用: レベルに対応するプリセットと学習の有無をセット
+* レベルは学習なしのプリセット0, 1, ..., ヘッダのプリセットの順で、
+* 学習を許す場合は最後に学習ありのヘッダのプリセットが続く */
+static void LINNEEncoder_ApplySpeedLevel(struct LINNEEncoder *encoder, uint32_t level)
+{
+    const struct LINNEParameterPreset *preset;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(level < encoder->num_speed_levels);
+
+    /* プリセットが変わった時のみネットワークを作り直す */
+    preset = &g_linne_parameter_preset[LINNEUTILITY_MIN(level, encoder->header.preset)];
+    if (preset != encoder->parameter_preset) {
+        encoder->parameter_preset = preset;
+        LINNENetwork_SetLayerStructure(encoder->network,
+                encoder->header.num_samples_per_block + encoder->num_lookback_samples, preset->num_layers, preset->num_params_list);
+    }
+    encoder->enable_learning = (level > encoder->header.preset) ? 1 : 0;
+    encoder->speed_level = level;
+}
+
+/* 速度レベルの更新: 直前のブロックの処理時間から次のブロックのレベルを決める */
+static void LINNEEncoder_UpdateSpeedLevel(
+        struct LINNEEncoder *encoder, uint32_t num_samples, double elapsed_sec)
+{
+    uint32_t level;
+    double *cost, target_cost;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(encoder->target_realtime_factor != 0);
+
+    cost = encoder->speed_level_cost;
+    level = encoder->speed_level;
+
+    /* 目標の実時間倍率を満たすサンプルあたり処理時間 */
+    target_cost = 1.0 / ((double)encoder->header.sampling_rate * encoder->target_realtime_factor);
+
+    /* 処理時間の移動平均を更新 計測できないほど短ければ更新しない */
+    if (elapsed_sec > 0.0) {
+        const double block_cost = elapsed_sec / num_samples;
+        if (cost[level] > 0.0) {
+            cost[level] += LINNEENCODER_SPEED_COST_SMOOTHING * (block_cost - cost[level]);
+        } else {
+            cost[level] = block_cost;
+        }
+    }
+
+    if (cost[level] > target_cost) {
+        /* 目標に届かない: 目標を満たす（あるいは未計測の）レベルまで下げる */
+        while ((level > 0) && (cost[level] > target_cost)) {
+            level--;
+        }
+    } else if ((level + 1) < encoder->num_speed_levels) {
+        /* 上のレベルも目標を満たす見込みなら上げる 未計測ならば十分な余裕がある時に試す */
+        if ((cost[level + 1] > 0.0) ?
+                (cost[level + 1] <= target_cost) : ((cost[level] * LINNEENCODER_SPEED_PROBE_MARGIN) <= target_cost)) {
+            level++;
+        }
+    }
+
+    if (level != encoder->speed_level) {
+        LINNEEncoder_ApplySpeedLevel(encoder, level);
+    }
+}
+
+/* ブロックデータの準備
+* 圧縮データは分析まで済ませ、実際のサイズが生データを超える場合は生データに切り替える
+* 補足）これによりブロックサイズはブロックヘッダ + 生データのサイズを超えない */
+static LINNEApiResult LINNEEncoder_PrepareBlockData(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        LINNEBlockDataType *block_type, uint8_t *has_wasted_bits, uint32_t *block_data_size)
+{
+    LINNEApiResult ret;
+    const struct LINNEHeader *header;
+    uint32_t raw_data_size, preprocessed_bits = 0;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(block_type != NULL);
+    LINNE_ASSERT(has_wasted_bits != NULL);
+    LINNE_ASSERT(block_data_size != NULL);
+
+    header = &(encoder->header);
+
+    /* 生データのサイズ */
+    raw_data_size = (header->bits_per_sample * num_samples * header->num_channels) / 8;
+
+    (*has_wasted_bits) = 0;
+    encoder->reuse_parameters = 0;
+    encoder->delta_parameters = 0;
+
+    /* 分析しないブロックを挟むと分析窓の信号が途切れるので、蓄えた直前のブロックは捨てる */
+    if ((*block_type) != LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) {
+        encoder->num_history_samples = 0;
+    }
+
+    switch (*block_type) {
+    case LINNE_BLOCK_DATA_TYPE_RAWDATA:
+        (*block_data_size) = raw_data_size;
+        break;
+    case LINNE_BLOCK_DATA_TYPE_SILENT:
+        (*block_data_size) = 0;
+        break;
+    case LINNE_BLOCK_DATA_TYPE_CONSTANT:
+        (*block_data_size) = (uint32_t)((header->bits_per_sample * header->num_channels + 7) / 8);
+        break;
+    case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
+        /* 下位の無効ビットを判定 */
+        (*has_wasted_bits) = LINNEEncoder_DecideWastedBits(encoder, input, num_samples);
+        if ((ret = LINNEEncoder_PreprocessCompressData(encoder, input, num_samples)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        /* 予測利得の基準となる入力の符号長 */
+        if (encoder->enable_parameter_reuse == 1) {
+            preprocessed_bits = LINNEEncoder_CalculatePreprocessedBits(encoder, num_samples);
+        }
+        /* 直前のパラメータで予測し、予測利得の低下が記録を省けるパラメータの符号長に収まれば分析を省く
+        * 利得で比べるのは、信号レベルが下がったブロックを残差の絶対量だけで判断しないため */
+        if ((encoder->enable_parameter_reuse == 1) && LINNEEncoder_CanDependOnPreviousBlock(encoder)) {
+            LINNEEncoder_PredictPreprocessedData(encoder, num_samples);
+            if ((double)preprocessed_bits - LINNEEncoder_CalculateResidualBits(encoder, num_samples)
+                    >= (encoder->reuse_reference_gain * num_samples - LINNEEncoder_CalculateParameterBits(encoder))) {
+                encoder->reuse_parameters = 1;
+                /* 分析を省いたブロックも次の分析窓に含める 前処理をやり直して蓄え、残差を信号バッファに戻す */
+                if (encoder->num_lookback_samples > 0) {
+                    uint32_t ch;
+                    if ((ret = LINNEEncoder_PreprocessCompressData(encoder, input, num_samples)) != LINNE_APIRESULT_OK) {
+                        return ret;
+                    }
+                    LINNEEncoder_AppendLookbackHistory(encoder, num_samples);
+                    for (ch = 0; ch < header->num_channels; ch++) {
+                        memcpy(LINNEENCODER_BUFFER(encoder, buffer_int, ch),
+                                LINNEENCODER_BUFFER(encoder, residual, ch), sizeof(int32_t) * num_samples);
+                    }
+                }
+            } else if ((ret = LINNEEncoder_PreprocessCompressData(encoder, input, num_samples)) != LINNE_APIRESULT_OK) {
+                /* 予測で信号バッファが残差に置き換わったので前処理からやり直す */
+                return ret;
+            }
+        }
+        if (encoder->reuse_parameters != 1) {
+            LINNEEncoder_AnalyzePreprocessedData(encoder, num_samples);
+        }
+        /* 直前のブロックとの差分の方が短ければ差分で記録 */
+        if ((encoder->enable_delta_parameters == 1) && LINNEEncoder_CanDependOnPreviousBlock(encoder)
+                && (LINNEEncoder_CalculateDeltaParameterBits(encoder) < LINNEEncoder_CalculateFullParameterBits(encoder))) {
+            encoder->delta_parameters = 1;
+        }
+        (*block_data_size) = LINNEEncoder_CalculateCompressDataSize(encoder, num_samples, (*has_wasted_bits));
+        /* 生データより大きくなる場合は生データで記録 */
+        if ((*block_data_size) > raw_data_size) {
+            (*block_type) = LINNE_BLOCK_DATA_TYPE_RAWDATA;
+            (*has_wasted_bits) = 0;
+            (*block_data_size) = raw_data_size;
+            /* 新たに計算したパラメータはデコーダに届かないので再利用・差分の基準にできない */
+            if (encoder->reuse_parameters != 1) {
+                encoder->reusable_preset = NULL;
+            }
+            encoder->reuse_parameters = 0;
+            encoder->delta_parameters = 0;
+        } else if (encoder->reuse_parameters != 1) {
+            /* 新たに計算したパラメータを次のブロックの再利用・差分の基準にする */
+            if ((encoder->enable_parameter_reuse == 1) || (encoder->enable_delta_parameters == 1)) {
+                encoder->reusable_preset = encoder->parameter_preset;
+            }
+            /* 次のブロックで再利用する基準として予測利得を記録 */
+            if (encoder->enable_parameter_reuse == 1) {
+                encoder->reuse_reference_gain
+                    = ((double)preprocessed_bits - LINNEEncoder_CalculateResidualBits(encoder, num_samples)) / num_samples;
+            }
+        }
+        break;
+    default:
+        return LINNE_APIRESULT_INVALID_FORMAT;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 書き出したブロックを次のブロックの差分の基準にし、キーフレームからのブロック数を数える */
+static void LINNEEncoder_UpdateBlockReference(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples, LINNEBlockDataType block_type)
+{
+    uint32_t ch;
+    const uint8_t has_new_parameters
+        = ((block_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) && (encoder->reuse_parameters != 1)) ? 1 : 0;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+
+    /* プリエンファシスフィルタ初期値の差分の基準 */
+    for (ch = 0; ch < encoder->header.num_channels; ch++) {
+        encoder->last_samples[ch] = input[ch][num_samples - 1];
+    }
+
+    /* LPC係数の差分の基準 */
+    if ((encoder->enable_delta_parameters == 1) && (has_new_parameters == 1)) {
+        memcpy(encoder->reference_params_int, encoder->params_int,
+                sizeof(int32_t) * encoder->max_num_channels * encoder->max_num_layers * encoder->max_num_parameters_per_layer);
+        memcpy(encoder->reference_num_units, encoder->num_units,
+                sizeof(uint32_t) * encoder->max_num_channels * encoder->max_num_layers);
+        memcpy(encoder->reference_rshifts, encoder->rshifts,
+                sizeof(uint32_t) * encoder->max_num_channels * encoder->max_num_layers);
+    }
+
+    /* 直前のブロックに依存しない圧縮ブロックがキーフレーム */
+    if ((has_new_parameters == 1) && (encoder->delta_parameters != 1)) {
+        encoder->num_blocks_since_keyframe = 0;
+    } else {
+        encoder->num_blocks_since_keyframe++;
+    }
+}
+
+/* 準備済みのデータブロックの書き出し
+* block_type, has_wasted_bits, block_data_sizeはLINNEEncoder_PrepareBlockDataの結果を渡す */
+static LINNEApiResult LINNEEncoder_WriteBlock(
         struct LINNEEncoder *encoder,
         const int32_t *const *input, uint32_t num_samples,
+        LINNEBlockDataType block_type, uint8_t has_wasted_bits, uint32_t block_data_size,
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     uint8_t *data_ptr;
-    const struct LINNEHeader *header;
-    LINNEBlockDataType block_type;
     LINNEApiResult ret;
-    uint32_t block_header_size, block_data_size;
-
-    /* 引数チェック */
-    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
-            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
-        return LINNE_APIRESULT_INVALID_ARGUMENT;
-    }
-    header = &(encoder->header);
+    uint32_t block_header_size, write_size;
 
-    /* パラメータがセットされてない */
-    if (encoder->set_parameter != 1) {
-        return LINNE_APIRESULT_PARAMETER_NOT_SET;
-    }
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples > 0);
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(output_size != NULL);
 
-    /* エンコードサンプル数チェック */
-    if (num_samples > header->num_samples_per_block) {
+    /* 書き込み先のバッファサイズチェック */
+    if (data_size < (LINNE_BLOCK_HEADER_SIZE + block_data_size)) {
         return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
     }
 
-    /* 圧縮手法の判定 */
-    block_type = LINNEEncoder_DecideBlockDataType(encoder, input, num_samples);
-    LINNE_ASSERT(block_type != LINNE_BLOCK_DATA_TYPE_INVALID);
-
     /* ブロックヘッダをエンコード */
     data_ptr = data;
     /* ブロック先頭の同期コード */
@@ -804,27 +2091,37 @@ LINNEApiResult LINNEEncoder_EncodeBlock(
     ByteArray_PutUint32BE(data_ptr, 0);
     /* ブロックCRC16: 仮値で埋めておく */
     ByteArray_PutUint16BE(data_ptr, 0);
-    /* ブロックデータタイプ */
-    ByteArray_PutUint8(data_ptr, block_type);
+    /* ブロックデータタイプ 無効ビットを落とした場合・パラメータを再利用する場合・差分で記録する場合はフラグを立てる */
+    ByteArray_PutUint8(data_ptr,
+            (uint8_t)(block_type | ((has_wasted_bits == 1) ? LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG : 0)
+                | (((block_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) && (encoder->reuse_parameters == 1))
+                    ? LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG : 0)
+                | (((block_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) && (encoder->delta_parameters == 1))
+                    ? LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG : 0)));
     /* ブロックチャンネルあたりサンプル数 */
     ByteArray_PutUint16BE(data_ptr, num_samples);
     /* ブロックヘッダサイズ */
     block_header_size = (uint32_t)(data_ptr - data);
+    LINNE_ASSERT(block_header_size == LINNE_BLOCK_HEADER_SIZE);
 
     /* データ部のエンコード */
     /* 手法によりエンコードする関数を呼び分け */
     switch (block_type) {
     case LINNE_BLOCK_DATA_TYPE_RAWDATA:
         ret = LINNEEncoder_EncodeRawData(encoder, input, num_samples,
-                data_ptr, data_size - block_header_size, &block_data_size);
+                data_ptr, data_size - block_header_size, &write_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_COMPRESSDATA:
-        ret = LINNEEncoder_EncodeCompressData(encoder, input, num_samples,
-                data_ptr, data_size - block_header_size, &block_data_size);
+        ret = LINNEEncoder_EncodeCompressData(encoder, num_samples, has_wasted_bits,
+                data_ptr, data_size - block_header_size, &write_size);
         break;
     case LINNE_BLOCK_DATA_TYPE_SILENT:
         ret = LINNEEncoder_EncodeSilentData(encoder, input, num_samples,
-                data_ptr, data_size - block_header_size, &block_data_size);
+                data_ptr, data_size - block_header_size, &write_size);
+        break;
+    case LINNE_BLOCK_DATA_TYPE_CONSTANT:
+        ret = LINNEEncoder_EncodeConstantData(encoder, input, num_samples,
+                data_ptr, data_size - block_header_size, &write_size);
         break;
     default:
         ret = LINNE_APIRESULT_INVALID_FORMAT;
@@ -835,25 +2132,253 @@ LINNEApiResult LINNEEncoder_EncodeBlock(
     if (ret != LINNE_APIRESULT_OK) {
         return ret;
     }
+    LINNE_ASSERT(write_size == block_data_size);
 
     /* ブロックサイズ書き込み:
     * CRC16(2byte) + ブロックチャンネルあたりサンプル数(2byte) + ブロックデータタイプ(1byte) */
-    ByteArray_WriteUint32BE(&data[2], block_data_size + 5);
+    ByteArray_WriteUint32BE(&data[2], write_size + 5);
 
     /* CRC16の領域以降のCRC16を計算し書き込み */
     {
         /* ブロックチャンネルあたりサンプル数(2byte) + ブロックデータタイプ(1byte) を加算 */
-        const uint16_t crc16 = LINNEUtility_CalculateCRC16(&data[8], block_data_size + 3);
+        const uint16_t crc16 = LINNEUtility_CalculateCRC16(&data[8], write_size + 3);
         ByteArray_WriteUint16BE(&data[6], crc16);
     }
 
     /* 出力サイズ */
-    (*output_size) = block_header_size + block_data_size;
+    (*output_size) = block_header_size + write_size;
+
+    /* 次のブロックの差分の基準を更新 */
+    LINNEEncoder_UpdateBlockReference(encoder, input, num_samples, block_type);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 単一データブロックエンコード */
+LINNEApiResult LINNEEncoder_EncodeBlock(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    const struct LINNEHeader *header;
+    LINNEBlockDataType block_type, analyzed_type;
+    LINNEApiResult ret;
+    uint32_t block_data_size;
+    uint8_t has_wasted_bits;
+    double start_time;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+    header = &(encoder->header);
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+
+    /* エンコードサンプル数チェック */
+    if (num_samples > header->num_samples_per_block) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* 速度目標があれば処理時間を計測 */
+    start_time = (encoder->target_realtime_factor != 0) ? LINNEUtility_GetMonotonicTime() : 0.0;
+
+    /* 圧縮手法の判定 */
+    block_type = analyzed_type = LINNEEncoder_DecideBlockDataType(encoder, input, num_samples);
+    LINNE_ASSERT(block_type != LINNE_BLOCK_DATA_TYPE_INVALID);
+
+    /* データ部の準備 */
+    if ((ret = LINNEEncoder_PrepareBlockData(encoder, input, num_samples,
+                    &block_type, &has_wasted_bits, &block_data_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* ブロックの書き出し */
+    if ((ret = LINNEEncoder_WriteBlock(encoder, input, num_samples,
+                    block_type, has_wasted_bits, block_data_size, data, data_size, output_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* 次のブロックの速度レベルを決定
+    * 補足）無音・定数・生データのブロックは処理が軽く目安にならないため分析したブロックのみで判断 */
+    if ((encoder->target_realtime_factor != 0) && (analyzed_type == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)) {
+        LINNEEncoder_UpdateSpeedLevel(encoder, num_samples, LINNEUtility_GetMonotonicTime() - start_time);
+    }
 
     /* エンコード成功 */
     return LINNE_APIRESULT_OK;
 }
 
+/* プリセット競争の分析タスクの共有データ */
+struct LINNEEncoderRaceContext {
+    struct LINNEEncoder *const *encoders; /* 競争するエンコーダ */
+    uint32_t num_samples; /* ブロックのサンプル数 */
+    uint8_t has_wasted_bits; /* 下位の無効ビットを持つか？ */
+    uint32_t block_data_size[LINNEENCODER_MAX_NUM_RACE_ENCODERS]; /* エンコーダ毎の圧縮データサイズ */
+};
+
+/* 前処理結果を他のエンコーダに共有
+* 分析は信号バッファを残差で上書きするため、分析を始める前に共有しておくこと */
+static void LINNEEncoder_SharePreprocessedData(
+        struct LINNEEncoder *encoder, const struct LINNEEncoder *primary)
+{
+    uint32_t ch;
+    const uint32_t num_copy_samples = primary->header.num_samples_per_block;
+
+    /* 内部関数なので不正な引数はアサートで落とす */
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(primary != NULL);
+    LINNE_ASSERT(encoder->header.num_channels == primary->header.num_channels);
+    LINNE_ASSERT(encoder->header.num_samples_per_block == num_copy_samples);
+
+    for (ch = 0; ch < primary->header.num_channels; ch++) {
+        encoder->wasted_bits[ch] = primary->wasted_bits[ch];
+        memcpy(LINNEENCODER_BUFFER(encoder, buffer_int, ch),
+                LINNEENCODER_BUFFER(primary, buffer_int, ch), sizeof(int32_t) * num_copy_samples);
+        memcpy(encoder->pre_emphasis[ch], primary->pre_emphasis[ch],
+                sizeof(struct LINNEPreemphasisFilter) * LINNE_NUM_PREEMPHASIS_FILTERS);
+        memcpy(encoder->pre_emphasis_prev[ch], primary->pre_emphasis_prev[ch],
+                sizeof(int32_t) * LINNE_NUM_PREEMPHASIS_FILTERS);
+    }
+}
+
+/* プリセット競争の分析タスク
+* 共有済みの前処理結果を分析し、圧縮データサイズを記録する */
+static void LINNEEncoder_RaceTask(void *task_context, uint32_t task_index)
+{
+    struct LINNEEncoderRaceContext *context = (struct LINNEEncoderRaceContext *)task_context;
+    struct LINNEEncoder *encoder;
+
+    LINNE_ASSERT(context != NULL);
+
+    encoder = context->encoders[task_index];
+    LINNEEncoder_AnalyzePreprocessedData(encoder, context->num_samples);
+    context->block_data_size[task_index]
+        = LINNEEncoder_CalculateCompressDataSize(encoder, context->num_samples, context->has_wasted_bits);
+}
+
+/* プリセット競争による単一データブロックエンコード */
+LINNEApiResult LINNEEncoder_EncodeBlockRace(
+        struct LINNEEncoder *const *encoders, uint32_t num_encoders,
+        const int32_t *const *input, uint32_t num_samples,
+        uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+    uint32_t i, best, raw_data_size;
+    LINNEApiResult ret;
+    LINNEBlockDataType block_type;
+    struct LINNEEncoder *primary;
+    const struct LINNEHeader *header;
+    struct LINNEEncoderRaceContext context;
+
+    /* 引数チェック */
+    if ((encoders == NULL) || (num_encoders == 0) || (num_encoders > LINNEENCODER_MAX_NUM_RACE_ENCODERS)
+            || (input == NULL) || (num_samples == 0)
+            || (data == NULL) || (data_size == 0) || (output_size == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+    for (i = 0; i < num_encoders; i++) {
+        if (encoders[i] == NULL) {
+            return LINNE_APIRESULT_INVALID_ARGUMENT;
+        }
+    }
+    primary = encoders[0];
+    header = &(primary->header);
+
+    /* パラメータがセットされてない */
+    for (i = 0; i < num_encoders; i++) {
+        if (encoders[i]->set_parameter != 1) {
+            return LINNE_APIRESULT_PARAMETER_NOT_SET;
+        }
+    }
+
+    /* 前処理を共有するため、プリセットに依存しないパラメータは全て一致している必要がある
+    * また、どのエンコーダの出力か区別できるようにブロック毎のプリセット番号を記録していること */
+    for (i = 0; i < num_encoders; i++) {
+        const struct LINNEHeader *other = &(encoders[i]->header);
+        if ((other->enable_block_preset != 1)
+                || (other->num_channels != header->num_channels)
+                || (other->bits_per_sample != header->bits_per_sample)
+                || (other->num_samples_per_block != header->num_samples_per_block)
+                || (other->ch_process_method != header->ch_process_method)) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+        /* 分析窓の延長は直前のブロックを蓄える必要があり前処理を共有できない */
+        if (encoders[i]->num_lookback_samples != 0) {
+            return LINNE_APIRESULT_INVALID_FORMAT;
+        }
+    }
+
+    /* エンコードサンプル数チェック */
+    if (num_samples > header->num_samples_per_block) {
+        return LINNE_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* 圧縮手法の判定 プリセットに依存しないので先頭のエンコーダで行う */
+    block_type = LINNEEncoder_DecideBlockDataType(primary, input, num_samples);
+    LINNE_ASSERT(block_type != LINNE_BLOCK_DATA_TYPE_INVALID);
+
+    /* 圧縮しないブロックは競争不要 */
+    if (block_type != LINNE_BLOCK_DATA_TYPE_COMPRESSDATA) {
+        uint8_t has_wasted_bits;
+        uint32_t block_data_size;
+        if ((ret = LINNEEncoder_PrepareBlockData(primary, input, num_samples,
+                        &block_type, &has_wasted_bits, &block_data_size)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        return LINNEEncoder_WriteBlock(primary, input, num_samples,
+                block_type, has_wasted_bits, block_data_size, data, data_size, output_size);
+    }
+
+    /* 前処理は先頭のエンコーダで1度だけ行う */
+    context.encoders = encoders;
+    context.num_samples = num_samples;
+    context.has_wasted_bits = LINNEEncoder_DecideWastedBits(primary, input, num_samples);
+    if ((ret = LINNEEncoder_PreprocessCompressData(primary, input, num_samples)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    for (i = 1; i < num_encoders; i++) {
+        LINNEEncoder_SharePreprocessedData(encoders[i], primary);
+    }
+    /* 競争ではパラメータの再利用・差分記録をしない 分析でパラメータが上書きされるので以降も基準にできない */
+    for (i = 0; i < num_encoders; i++) {
+        encoders[i]->reuse_parameters = 0;
+        encoders[i]->delta_parameters = 0;
+        encoders[i]->reusable_preset = NULL;
+    }
+
+    /* 各エンコーダで分析 コールバックがあれば並列に実行 */
+    if (primary->run_tasks != NULL) {
+        primary->run_tasks(LINNEEncoder_RaceTask, &context, num_encoders, primary->run_tasks_user_data);
+    } else {
+        for (i = 0; i < num_encoders; i++) {
+            LINNEEncoder_RaceTask(&context, i);
+        }
+    }
+
+    /* 最小サイズのエンコーダを選ぶ 同じサイズなら先に指定されたものを優先 */
+    best = 0;
+    for (i = 1; i < num_encoders; i++) {
+        if (context.block_data_size[i] < context.block_data_size[best]) {
+            best = i;
+        }
+    }
+
+    /* 生データより大きくなる場合は生データで記録 */
+    raw_data_size = (header->bits_per_sample * num_samples * header->num_channels) / 8;
+    if (context.block_data_size[best] > raw_data_size) {
+        return LINNEEncoder_WriteBlock(primary, input, num_samples,
+                LINNE_BLOCK_DATA_TYPE_RAWDATA, 0, raw_data_size, data, data_size, output_size);
+    }
+
+    return LINNEEncoder_WriteBlock(encoders[best], input, num_samples,
+            LINNE_BLOCK_DATA_TYPE_COMPRESSDATA, context.has_wasted_bits, context.block_data_size[best],
+            data, data_size, output_size);
+}
+
 /* ヘッダ含めファイル全体をエンコード */
 LINNEApiResult LINNEEncoder_EncodeWhole(
         struct LINNEEncoder *encoder,
@@ -861,7 +2386,8 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
         uint8_t *data, uint32_t data_size, uint32_t *output_size)
 {
     LINNEApiResult ret;
-    uint32_t progress, ch, write_size, write_offset, num_encode_samples;
+    uint32_t progress, ch, blk, write_size, write_offset, num_blocks;
+    uint32_t block_num_samples[LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS];
     uint8_t *data_pos;
     const int32_t *input_ptr[LINNE_MAX_NUM_CHANNELS];
     const struct LINNEHeader *header;
@@ -888,38 +2414,359 @@ LINNEApiResult LINNEEncoder_EncodeWhole(
     }
     header = &(encoder->header);
 
+    /* 新しいストリームなので直前のパラメータ・分析窓は使えない */
+    encoder->reusable_preset = NULL;
+    encoder->num_history_samples = 0;
+    encoder->num_blocks_since_keyframe = 0;
+
     /* 進捗状況初期化 */
     progress = 0;
-    write_offset = LINNE_HEADER_SIZE;
-    data_pos = data + LINNE_HEADER_SIZE;
+    write_offset = LINNE_CALCULATE_HEADER_SIZE(header);
+    data_pos = data + write_offset;
 
     /* ブロックを時系列順にエンコード */
     while (progress < num_samples) {
 
-        /* エンコードサンプル数の確定 */
-        num_encode_samples
-            = LINNEUTILITY_MIN(header->num_samples_per_block, num_samples - progress);
-
         /* サンプル参照位置のセット */
         for (ch = 0; ch < header->num_channels; ch++) {
             input_ptr[ch] = &input[ch][progress];
         }
 
-        /* ブロックエンコード */
-        if ((ret = LINNEEncoder_EncodeBlock(encoder,
-                        input_ptr, num_encode_samples,
-                        data_pos, data_size - write_offset, &write_size)) != LINNE_APIRESULT_OK) {
+        /* エンコードサンプル数の確定 */
+        if ((ret = LINNEEncoder_DecideBlockPartition(encoder,
+                        input_ptr, num_samples - progress,
+                        block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks)) != LINNE_APIRESULT_OK) {
             return ret;
         }
 
-        /* 進捗更新 */
-        data_pos      += write_size;
-        write_offset  += write_size;
-        progress      += num_encode_samples;
-        LINNE_ASSERT(write_offset <= data_size);
+        for (blk = 0; blk < num_blocks; blk++) {
+            /* サンプル参照位置のセット */
+            for (ch = 0; ch < header->num_channels; ch++) {
+                input_ptr[ch] = &input[ch][progress];
+            }
+
+            /* ブロックエンコード */
+            if ((ret = LINNEEncoder_EncodeBlock(encoder,
+                            input_ptr, block_num_samples[blk],
+                            data_pos, data_size - write_offset, &write_size)) != LINNE_APIRESULT_OK) {
+                return ret;
+            }
+
+            /* 進捗更新 */
+            data_pos      += write_size;
+            write_offset  += write_size;
+            progress      += block_num_samples[blk];
+            LINNE_ASSERT(write_offset <= data_size);
+        }
     }
 
     /* 成功終了 */
     (*output_size) = write_offset;
     return LINNE_APIRESULT_OK;
 }
+
+/* ファイル全体の圧縮サイズとエンコード時間の推定 */
+LINNEApiResult LINNEEncoder_EstimateWhole(
+        struct LINNEEncoder *encoder,
+        const int32_t *const *input, uint32_t num_samples, uint32_t num_analyze_blocks,
+        struct LINNEEncodeEstimate *estimate)
+{
+    LINNEApiResult ret;
+    uint32_t i, ch, num_blocks, header_size, num_analyzed_samples;
+    const int32_t *input_ptr[LINNE_MAX_NUM_CHANNELS];
+    const struct LINNEHeader *header;
+    double size_sum, size_square_sum, nsmpl_square_sum, cross_sum, encode_time, rate, residual_var, half_width;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (num_analyze_blocks == 0) || (estimate == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* パラメータがセットされてない */
+    if (encoder->set_parameter != 1) {
+        return LINNE_APIRESULT_PARAMETER_NOT_SET;
+    }
+    header = &(encoder->header);
+
+    /* 全ブロック数 分析ブロック数はこれを超えない */
+    num_blocks = (num_samples + header->num_samples_per_block - 1) / header->num_samples_per_block;
+    num_analyze_blocks = LINNEUTILITY_MIN(num_analyze_blocks, num_blocks);
+
+    /* ファイル全体に等間隔に散らばるブロックを実際のエンコードと同じ手順で分析 */
+    size_sum = size_square_sum = nsmpl_square_sum = cross_sum = encode_time = 0.0;
+    num_analyzed_samples = 0;
+    for (i = 0; i < num_analyze_blocks; i++) {
+        LINNEBlockDataType block_type;
+        uint8_t has_wasted_bits;
+        uint32_t block_data_size;
+        double block_size, start_time;
+        /* 各区間の中央のブロックを選ぶ */
+        const uint32_t block = (uint32_t)(((2 * (uint64_t)i + 1) * num_blocks) / (2 * (uint64_t)num_analyze_blocks));
+        const uint32_t offset = block * header->num_samples_per_block;
+        const uint32_t num_block_samples = LINNEUTILITY_MIN(header->num_samples_per_block, num_samples - offset);
+
+        for (ch = 0; ch < header->num_channels; ch++) {
+            input_ptr[ch] = &input[ch][offset];
+        }
+
+        /* ブロックヘッダとビットストリームの書き出し以外はEncodeBlockと同じ処理
+        * 補足）パラメータの再利用・差分記録・分析窓の延長は連続するブロック間でしか行えないため推定では考慮しない */
+        encoder->reusable_preset = NULL;
+        encoder->num_history_samples = 0;
+        start_time = LINNEUtility_GetMonotonicTime();
+        block_type = LINNEEncoder_DecideBlockDataType(encoder, input_ptr, num_block_samples);
+        if ((ret = LINNEEncoder_PrepareBlockData(encoder, input_ptr, num_block_samples,
+                        &block_type, &has_wasted_bits, &block_data_size)) != LINNE_APIRESULT_OK) {
+            return ret;
+        }
+        encode_time += LINNEUtility_GetMonotonicTime() - start_time;
+
+        /* ブロックサイズとサンプル数の統計を蓄積 */
+        block_size = (double)(LINNE_BLOCK_HEADER_SIZE + block_data_size);
+        size_sum += block_size;
+        size_square_sum += block_size * block_size;
+        nsmpl_square_sum += (double)num_block_samples * num_block_samples;
+        cross_sum += block_size * num_block_samples;
+        num_analyzed_samples += num_block_samples;
+    }
+    /* 分析したパラメータは出力されていないので再利用させない */
+    encoder->reusable_preset = NULL;
+    encoder->num_history_samples = 0;
+
+    /* サンプルあたりのサイズ（比推定: 末尾の短いブロックも重みが偏らない） */
+    rate = size_sum / num_analyzed_samples;
+
+    /* 比推定の残差 size - rate * num_samples の不偏分散 */
+    residual_var = 0.0;
+    if (num_analyze_blocks > 1) {
+        residual_var = (size_square_sum - 2.0 * rate * cross_sum + rate * rate * nsmpl_square_sum) / (num_analyze_blocks - 1);
+        residual_var = LINNEUTILITY_MAX(residual_var, 0.0);
+    }
+
+    /* 信頼区間の半幅: 全ブロックから非復元抽出しているので有限母集団修正を掛ける */
+    half_width = 0.0;
+    if (num_blocks > 1) {
+        const double fpc = (double)(num_blocks - num_analyze_blocks) / (num_blocks - 1);
+        const double mean_nsmpl = (double)num_analyzed_samples / num_analyze_blocks;
+        half_width = LINNEENCODER_ESTIMATE_CONFIDENCE_COEF
+            * sqrt(residual_var * fpc / num_analyze_blocks) * ((double)num_samples / mean_nsmpl);
+    }
+
+    /* 結果出力 */
+    header_size = LINNE_CALCULATE_HEADER_SIZE(header);
+    estimate->num_analyzed_blocks = num_analyze_blocks;
+    estimate->num_blocks = num_blocks;
+    estimate->estimated_size = header_size + rate * num_samples;
+    estimate->estimated_size_lower = LINNEUTILITY_MAX(estimate->estimated_size - half_width, (double)header_size);
+    estimate->estimated_size_upper = estimate->estimated_size + half_width;
+    estimate->estimated_encode_time = encode_time * ((double)num_samples / num_analyzed_samples);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 事前分析: プリセットの推定符号長に使うLPC次数（最も大きい層のパラメータ数） */
+static uint32_t LINNEEncoder_GetPreAnalysisOrder(const struct LINNEParameterPreset *preset)
+{
+    uint32_t l, order;
+
+    LINNE_ASSERT(preset != NULL);
+
+    order = 0;
+    for (l = 0; l < preset->num_layers; l++) {
+        order = LINNEUTILITY_MAX(order, preset->num_params_list[l]);
+    }
+
+    return order;
+}
+
+/* 事前分析: ファイル全体に等間隔に散らばるnum_spans個の区間を
+* num_block_samples毎のブロックに分けてpresetでエンコードしたときの推定サイズ[bit]の合計
+* ms_conversionが1のときはMS処理した信号で見積もる */
+static double LINNEEncoder_EstimatePreAnalysisBits(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        uint32_t num_spans, uint32_t num_span_samples, uint8_t ms_conversion,
+        uint32_t num_block_samples, const struct LINNEParameterPreset *preset)
+{
+    uint32_t i, ch, offset;
+    double bits;
+    LINNEBlockDataType block_type;
+    int32_t *buffer[LINNE_MAX_NUM_CHANNELS];
+    const int32_t *span_ptr[LINNE_MAX_NUM_CHANNELS];
+    const int32_t *block_ptr[LINNE_MAX_NUM_CHANNELS];
+    uint32_t order;
+    const struct LINNEHeader *header;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_spans > 0);
+    LINNE_ASSERT(num_span_samples <= num_samples);
+    LINNE_ASSERT(num_span_samples <= encoder->max_num_samples_per_block);
+    LINNE_ASSERT(num_block_samples > 0);
+
+    header = &(encoder->header);
+    order = LINNEEncoder_GetPreAnalysisOrder(preset);
+    LINNE_ASSERT((ms_conversion == 0) || (header->num_channels == 2));
+
+    bits = 0.0;
+    for (i = 0; i < num_spans; i++) {
+        /* 各区間はファイル内に収まるように配置 */
+        const uint32_t span_offset
+            = (uint32_t)(((2 * (uint64_t)i + 1) * (num_samples - num_span_samples)) / (2 * (uint64_t)num_spans));
+
+        /* 区間の信号を取得 MS処理する場合はバッファで変換 */
+        for (ch = 0; ch < header->num_channels; ch++) {
+            span_ptr[ch] = &input[ch][span_offset];
+        }
+        if (ms_conversion == 1) {
+            for (ch = 0; ch < header->num_channels; ch++) {
+                buffer[ch] = LINNEENCODER_BUFFER(encoder, buffer_int, ch);
+                memcpy(buffer[ch], span_ptr[ch], sizeof(int32_t) * num_span_samples);
+                span_ptr[ch] = buffer[ch];
+            }
+            LINNEUtility_MSConversion(buffer, num_span_samples);
+        }
+
+        /* ブロック毎の推定サイズを合計 */
+        for (offset = 0; offset < num_span_samples; offset += num_block_samples) {
+            for (ch = 0; ch < header->num_channels; ch++) {
+                block_ptr[ch] = &span_ptr[ch][offset];
+            }
+            bits += LINNEEncoder_EstimateBlockBitsWithPreset(encoder, block_ptr,
+                    LINNEUTILITY_MIN(num_block_samples, num_span_samples - offset), preset, order, &block_type);
+        }
+    }
+
+    return bits;
+}
+
+/* 事前分析: parameterでエンコードしたときの推定サイズ[byte]
+* LPCの推定符号長ではなく、実際のエンコードと同じ手順の分析で見積もる */
+static LINNEApiResult LINNEEncoder_EstimatePreAnalysisSize(
+        struct LINNEEncoder *encoder, const int32_t *const *input, uint32_t num_samples,
+        uint32_t num_analyze_blocks, const struct LINNEEncodeParameter *parameter, double *size)
+{
+    LINNEApiResult ret;
+    struct LINNEEncodeEstimate estimate;
+
+    LINNE_ASSERT(encoder != NULL);
+    LINNE_ASSERT(parameter != NULL);
+    LINNE_ASSERT(size != NULL);
+
+    if ((ret = LINNEEncoder_SetEncodeParameter(encoder, parameter)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    if ((ret = LINNEEncoder_EstimateWhole(encoder, input, num_samples, num_analyze_blocks, &estimate)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    (*size) = estimate.estimated_size;
+    return LINNE_APIRESULT_OK;
+}
+
+/* ファイル全体の事前分析によるエンコードパラメータの決定 */
+LINNEApiResult LINNEEncoder_PreAnalyzeWhole(
+    struct LINNEEncoder *encoder,
+    const int32_t *const *input, uint32_t num_samples, uint32_t num_analyze_blocks,
+    struct LINNEEncodeParameter *parameter)
+{
+    LINNEApiResult ret;
+    uint32_t k, p, num_span_samples, num_spans, max_order, num_block_samples, preset_no;
+    uint8_t ms_conversion;
+    double bits, min_bits, size, min_size, caller_size;
+    const struct LINNEParameterPreset *base_preset, *max_preset;
+    struct LINNEEncodeParameter candidate;
+
+    /* 引数チェック */
+    if ((encoder == NULL) || (input == NULL) || (num_samples == 0)
+            || (num_analyze_blocks == 0) || (parameter == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* 分析に使うパラメータを設定（パラメータとハンドルの容量の検査を含む） */
+    if ((ret = LINNEEncoder_SetEncodeParameter(encoder, parameter)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    candidate = (*parameter);
+
+    /* 分析する区間: ブロックあたりサンプル数毎 */
+    num_span_samples = LINNEUTILITY_MIN(encoder->header.num_samples_per_block, num_samples);
+    num_spans = LINNEUTILITY_MIN(num_analyze_blocks, num_samples / num_span_samples);
+
+    /* 上限のレイヤー構造（独自レイヤー構造ならばそれのみ）と最小のレイヤー構造 */
+    max_preset = encoder->parameter_preset;
+    base_preset = (parameter->num_custom_layers > 0) ? max_preset : &g_linne_parameter_preset[0];
+    max_order = LINNEEncoder_GetPreAnalysisOrder(max_preset);
+
+    /* 区間が短すぎて推定できないときは何も変えない */
+    if (num_span_samples < (LINNEENCODER_PRE_ANALYSIS_MIN_SAMPLES_PER_ORDER * max_order)) {
+        return LINNE_APIRESULT_OK;
+    }
+
+    /* チャンネル処理法: 2chではチャンネル間の相関が強ければMS処理 */
+    ms_conversion = (parameter->ch_process_method == LINNE_CH_PROCESS_METHOD_MS) ? 1 : 0;
+    if (parameter->num_channels == 2) {
+        const double lr_bits = LINNEEncoder_EstimatePreAnalysisBits(encoder, input, num_samples,
+                num_spans, num_span_samples, 0, num_span_samples, base_preset);
+        const double ms_bits = LINNEEncoder_EstimatePreAnalysisBits(encoder, input, num_samples,
+                num_spans, num_span_samples, 1, num_span_samples, base_preset);
+        ms_conversion = (ms_bits < lr_bits) ? 1 : 0;
+        candidate.ch_process_method = (ms_conversion == 1) ? LINNE_CH_PROCESS_METHOD_MS : LINNE_CH_PROCESS_METHOD_NONE;
+    }
+
+    /* ブロックサイズ: 定常性が低ければ短くする 適応ブロックサイズ選択を使う場合はブロック毎に決まるので変えない */
+    num_block_samples = num_span_samples;
+    if (parameter->min_num_samples_per_block == 0) {
+        min_bits = LINNEEncoder_EstimatePreAnalysisBits(encoder, input, num_samples,
+                num_spans, num_span_samples, ms_conversion, num_span_samples, max_preset);
+        for (k = 1; k <= LINNEENCODER_MAX_BLOCK_SPLIT_DEPTH; k++) {
+            const uint32_t candidate = num_span_samples >> k;
+            if (candidate < (LINNEENCODER_PRE_ANALYSIS_MIN_SAMPLES_PER_ORDER * max_order)) {
+                break;
+            }
+            bits = LINNEEncoder_EstimatePreAnalysisBits(encoder, input, num_samples,
+                    num_spans, num_span_samples, ms_conversion, candidate, max_preset);
+            if (bits < min_bits) {
+                min_bits = bits;
+                num_block_samples = candidate;
+            }
+        }
+        if (num_block_samples < num_span_samples) {
+            candidate.num_samples_per_block = (uint16_t)num_block_samples;
+        }
+    }
+
+    /* プリセット: 推定サイズが十分に縮む場合のみ上位のプリセットを選ぶ 独自レイヤー構造は変えない
+    * 層の構成による差はLPCの推定符号長に現れにくいので、実際の分析で見積もる */
+    if (parameter->num_custom_layers == 0) {
+        preset_no = 0;
+        min_size = 0.0;
+        for (p = 0; p <= parameter->preset; p++) {
+            candidate.preset = (uint8_t)p;
+            if ((ret = LINNEEncoder_EstimatePreAnalysisSize(encoder, input, num_samples,
+                            num_analyze_blocks, &candidate, &size)) != LINNE_APIRESULT_OK) {
+                return ret;
+            }
+            if ((p == 0) || (size < (min_size * (1.0 - LINNEENCODER_PRE_ANALYSIS_MIN_PRESET_GAIN)))) {
+                min_size = size;
+                preset_no = p;
+            }
+        }
+        candidate.preset = (uint8_t)preset_no;
+    } else if ((ret = LINNEEncoder_EstimatePreAnalysisSize(encoder, input, num_samples,
+                    num_analyze_blocks, &candidate, &min_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+
+    /* 呼び出し元の設定も候補に含め、推定サイズが縮む場合のみ決め直した設定を採用する
+    * 最後に呼び出し元の設定を見積もるので、エンコーダには決め直す前のパラメータが設定された状態になる */
+    if ((ret = LINNEEncoder_EstimatePreAnalysisSize(encoder, input, num_samples,
+                    num_analyze_blocks, parameter, &caller_size)) != LINNE_APIRESULT_OK) {
+        return ret;
+    }
+    if (min_size < caller_size) {
+        (*parameter) = candidate;
+    }
+
+    return LINNE_APIRESULT_OK;
+}
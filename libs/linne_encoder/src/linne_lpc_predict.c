@@ -2,6 +2,87 @@
 
 #include <string.h>
 #include "linne_internal.h"
+#include "linne_utility.h"
+
+/* SSE2による16bit積和カーネルを使うか */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define LINNELPC_USE_SSE2
+#endif
+
+/* 16bit積和カーネルで扱える最大次数 */
+#define LINNELPC_INT16_MAX_ORDER LINNE_NETWORK_MAX_PARAMS_PER_LAYER
+/* 16bit積和カーネルで入力を16bitに詰め直す単位（サンプル数） */
+#define LINNELPC_INT16_CHUNK_SIZE 256
+/* 64bit積和カーネルで扱える最大次数 */
+#define LINNELPC_INT64_MAX_ORDER LINNE_NETWORK_MAX_PARAMS_PER_LAYER
+/* 64bit積和カーネルで入力を倍精度に変換する単位（サンプル数） */
+#define LINNELPC_INT64_CHUNK_SIZE 256
+
+/* 次数固定のLPC予測カーネル */
+typedef void (*LINNELPCPredictKernel)(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, int32_t *residual, uint32_t coef_rshift);
+
+/* 次数固定のLPC予測カーネル定義
+* 次数が定数になるため内側ループは展開され、係数はレジスタに保持される */
+#define LINNELPC_DEFINE_PREDICT_KERNEL(order)\
+static void LINNELPC_PredictOrder ## order(\
+    const int32_t *data, uint32_t num_samples,\
+    const int32_t *coef, int32_t *residual, uint32_t coef_rshift)\
+{\
+    uint32_t smpl, ord;\
+    int32_t predict;\
+    const int32_t half = 1 << (coef_rshift - 1);\
+    for (smpl = (order); smpl < num_samples; smpl++) {\
+        predict = half;\
+        for (ord = 0; ord < (order); ord++) {\
+            predict += coef[ord] * data[smpl - (order) + ord];\
+        }\
+        residual[smpl] = data[smpl] + (predict >> coef_rshift);\
+    }\
+}
+
+/* プリセットで現れるユニットあたり次数: {4,8,16,32,64,96,128}を2の冪で割ったもの */
+LINNELPC_DEFINE_PREDICT_KERNEL(1)
+LINNELPC_DEFINE_PREDICT_KERNEL(2)
+LINNELPC_DEFINE_PREDICT_KERNEL(3)
+LINNELPC_DEFINE_PREDICT_KERNEL(4)
+LINNELPC_DEFINE_PREDICT_KERNEL(6)
+LINNELPC_DEFINE_PREDICT_KERNEL(8)
+LINNELPC_DEFINE_PREDICT_KERNEL(12)
+LINNELPC_DEFINE_PREDICT_KERNEL(16)
+LINNELPC_DEFINE_PREDICT_KERNEL(24)
+LINNELPC_DEFINE_PREDICT_KERNEL(32)
+LINNELPC_DEFINE_PREDICT_KERNEL(48)
+LINNELPC_DEFINE_PREDICT_KERNEL(64)
+LINNELPC_DEFINE_PREDICT_KERNEL(96)
+LINNELPC_DEFINE_PREDICT_KERNEL(128)
+
+#undef LINNELPC_DEFINE_PREDICT_KERNEL
+
+/* 次数に対応する固定次数カーネルの取得 対応するものがなければNULL */
+static LINNELPCPredictKernel LINNELPC_GetPredictKernel(uint32_t coef_order)
+{
+    switch (coef_order) {
+    case 1:     return LINNELPC_PredictOrder1;
+    case 2:     return LINNELPC_PredictOrder2;
+    case 3:     return LINNELPC_PredictOrder3;
+    case 4:     return LINNELPC_PredictOrder4;
+    case 6:     return LINNELPC_PredictOrder6;
+    case 8:     return LINNELPC_PredictOrder8;
+    case 12:    return LINNELPC_PredictOrder12;
+    case 16:    return LINNELPC_PredictOrder16;
+    case 24:    return LINNELPC_PredictOrder24;
+    case 32:    return LINNELPC_PredictOrder32;
+    case 48:    return LINNELPC_PredictOrder48;
+    case 64:    return LINNELPC_PredictOrder64;
+    case 96:    return LINNELPC_PredictOrder96;
+    case 128:   return LINNELPC_PredictOrder128;
+    default:    break;
+    }
+    return NULL;
+}
 
 /* LPC係数により予測/誤差出力 */
 void LINNELPC_Predict(
@@ -11,6 +92,7 @@ void LINNELPC_Predict(
     int32_t predict;
     uint32_t smpl, ord;
     const int32_t half = 1 << (coef_rshift - 1); /* 固定小数の0.5 */
+    LINNELPCPredictKernel kernel;
 
     /* 引数チェック */
     LINNE_ASSERT(data != NULL);
@@ -28,6 +110,14 @@ void LINNELPC_Predict(
         }
         residual[smpl] += (predict >> coef_rshift);
     }
+
+    /* 固定次数カーネルがあればそちらで処理 */
+    if ((coef_order < num_samples)
+            && ((kernel = LINNELPC_GetPredictKernel(coef_order)) != NULL)) {
+        kernel(data, num_samples, coef, residual, coef_rshift);
+        return;
+    }
+
     for (smpl = coef_order; smpl < num_samples; smpl++) {
         predict = half;
         for (ord = 0; ord < coef_order; ord++) {
@@ -36,3 +126,192 @@ void LINNELPC_Predict(
         residual[smpl] += (predict >> coef_rshift);
     }
 }
+
+#ifdef LINNELPC_USE_SSE2
+/* 4つの32bit積和ベクトルをそれぞれ水平加算して1ベクトルにまとめる */
+static __m128i LINNELPC_HorizontalAdd4(__m128i a0, __m128i a1, __m128i a2, __m128i a3)
+{
+    const __m128i t0 = _mm_add_epi32(_mm_unpacklo_epi32(a0, a1), _mm_unpackhi_epi32(a0, a1));
+    const __m128i t1 = _mm_add_epi32(_mm_unpacklo_epi32(a2, a3), _mm_unpackhi_epi32(a2, a3));
+    return _mm_add_epi32(_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1));
+}
+
+/* SSE2の16bit積和(_mm_madd_epi16)によるLPC予測
+* 次数は8の倍数、入力と係数は16bitに収まること
+* 積和の結果は32bitで剰余をとった値になるため、32bit演算のスカラー版と一致する */
+static void LINNELPC_PredictInt16SSE2(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    uint32_t smpl, ord, t, k, num_process;
+    const uint32_t num_vecs = coef_order / 8;
+    int16_t buf[LINNELPC_INT16_MAX_ORDER + LINNELPC_INT16_CHUNK_SIZE];
+    __m128i pcoef[LINNELPC_INT16_MAX_ORDER / 8];
+    const __m128i half = _mm_set1_epi32(1 << (coef_rshift - 1));
+    const __m128i shift = _mm_cvtsi32_si128((int)coef_rshift);
+
+    LINNE_ASSERT((coef_order % 8) == 0);
+    LINNE_ASSERT(coef_order <= LINNELPC_INT16_MAX_ORDER);
+    LINNE_ASSERT(coef_order < num_samples);
+
+    /* 係数を16bitに詰める */
+    for (k = 0; k < num_vecs; k++) {
+        pcoef[k] = _mm_packs_epi32(
+                _mm_loadu_si128((const __m128i *)&coef[8 * k]), _mm_loadu_si128((const __m128i *)&coef[8 * k + 4]));
+    }
+
+    for (smpl = coef_order; smpl < num_samples; smpl += num_process) {
+        const int32_t *pdata = &data[smpl - coef_order];
+        num_process = LINNEUTILITY_MIN(LINNELPC_INT16_CHUNK_SIZE, num_samples - smpl);
+
+        /* 直前coef_orderサンプルとチャンクの入力を16bitに詰める */
+        for (ord = 0; (ord + 8) <= (coef_order + num_process); ord += 8) {
+            _mm_storeu_si128((__m128i *)&buf[ord], _mm_packs_epi32(
+                    _mm_loadu_si128((const __m128i *)&pdata[ord]), _mm_loadu_si128((const __m128i *)&pdata[ord + 4])));
+        }
+        for (; ord < (coef_order + num_process); ord++) {
+            buf[ord] = (int16_t)pdata[ord];
+        }
+
+        /* 4サンプルずつ予測 */
+        for (t = 0; (t + 4) <= num_process; t += 4) {
+            __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+            __m128i acc2 = _mm_setzero_si128(), acc3 = _mm_setzero_si128();
+            __m128i predict;
+            for (k = 0; k < num_vecs; k++) {
+                acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(pcoef[k], _mm_loadu_si128((const __m128i *)&buf[t + 8 * k + 0])));
+                acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(pcoef[k], _mm_loadu_si128((const __m128i *)&buf[t + 8 * k + 1])));
+                acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(pcoef[k], _mm_loadu_si128((const __m128i *)&buf[t + 8 * k + 2])));
+                acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(pcoef[k], _mm_loadu_si128((const __m128i *)&buf[t + 8 * k + 3])));
+            }
+            predict = _mm_add_epi32(half, LINNELPC_HorizontalAdd4(acc0, acc1, acc2, acc3));
+            _mm_storeu_si128((__m128i *)&residual[smpl + t],
+                    _mm_add_epi32(_mm_loadu_si128((const __m128i *)&data[smpl + t]), _mm_sra_epi32(predict, shift)));
+        }
+        /* 端数 */
+        for (; t < num_process; t++) {
+            int32_t predict = 1 << (coef_rshift - 1);
+            for (ord = 0; ord < coef_order; ord++) {
+                predict += coef[ord] * buf[t + ord];
+            }
+            residual[smpl + t] = data[smpl + t] + (predict >> coef_rshift);
+        }
+    }
+}
+#endif /* LINNELPC_USE_SSE2 */
+
+/* 入力が16bitに収まる場合のLPC係数による予測/誤差出力 */
+void LINNELPC_PredictInt16(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(residual != NULL);
+    LINNE_ASSERT(coef_rshift != 0);
+
+#ifdef LINNELPC_USE_SSE2
+    if (((coef_order % 8) == 0) && (coef_order <= LINNELPC_INT16_MAX_ORDER) && (coef_order < num_samples)) {
+        /* 先頭coef_orderサンプルは通常版で処理 */
+        LINNELPC_Predict(data, coef_order, coef, coef_order, residual, coef_rshift);
+        LINNELPC_PredictInt16SSE2(data, num_samples, coef, coef_order, residual, coef_rshift);
+        return;
+    }
+#endif
+
+    LINNELPC_Predict(data, num_samples, coef, coef_order, residual, coef_rshift);
+}
+
+#ifdef LINNELPC_USE_SSE2
+/* SSE2の倍精度積和による64bit精度のLPC予測
+* LINNE_LPC_COEFFICIENT_BITWIDTHビットの係数と32bit整数の積、およびその128次までの和は
+* 2^53未満に収まり倍精度で誤差なく表せるため、結果は64bit整数で積和したスカラー版と一致する */
+static void LINNELPC_PredictInt64SSE2(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    uint32_t smpl, ord, t, num_process;
+    double buf[LINNELPC_INT64_MAX_ORDER + LINNELPC_INT64_CHUNK_SIZE];
+    double dcoef[LINNELPC_INT64_MAX_ORDER];
+    const double half = (double)(1 << (coef_rshift - 1));
+
+    LINNE_ASSERT(coef_order <= LINNELPC_INT64_MAX_ORDER);
+    LINNE_ASSERT(coef_order < num_samples);
+
+    for (ord = 0; ord < coef_order; ord++) {
+        LINNE_ASSERT(LINNEUTILITY_ABS(coef[ord]) <= (1 << LINNE_LPC_COEFFICIENT_BITWIDTH));
+        dcoef[ord] = coef[ord];
+    }
+
+    for (smpl = coef_order; smpl < num_samples; smpl += num_process) {
+        const int32_t *pdata = &data[smpl - coef_order];
+        num_process = LINNEUTILITY_MIN(LINNELPC_INT64_CHUNK_SIZE, num_samples - smpl);
+
+        /* 直前coef_orderサンプルとチャンクの入力を倍精度に変換 */
+        for (ord = 0; ord < (coef_order + num_process); ord++) {
+            buf[ord] = pdata[ord];
+        }
+
+        for (t = 0; t < num_process; t++) {
+            __m128d acc0 = _mm_set_sd(half), acc1 = _mm_setzero_pd();
+            double predict;
+            /* 2レーン x 2系統で積和 */
+            for (ord = 0; (ord + 4) <= coef_order; ord += 4) {
+                acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&dcoef[ord + 0]), _mm_loadu_pd(&buf[t + ord + 0])));
+                acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&dcoef[ord + 2]), _mm_loadu_pd(&buf[t + ord + 2])));
+            }
+            acc0 = _mm_add_pd(acc0, acc1);
+            acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+            predict = _mm_cvtsd_f64(acc0);
+            for (; ord < coef_order; ord++) {
+                predict += dcoef[ord] * buf[t + ord];
+            }
+            /* 和は整数値なので64bit整数に変換しても誤差はない */
+            residual[smpl + t] = data[smpl + t] + (int32_t)((int64_t)predict >> coef_rshift);
+        }
+    }
+}
+#endif /* LINNELPC_USE_SSE2 */
+
+/* 予測値を64bitで積和するLPC係数による予測/誤差出力 */
+void LINNELPC_PredictInt64(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    int64_t predict;
+    uint32_t smpl, ord;
+    const int64_t half = (int64_t)1 << (coef_rshift - 1); /* 固定小数の0.5 */
+
+    /* 引数チェック */
+    LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(coef != NULL);
+    LINNE_ASSERT(residual != NULL);
+    LINNE_ASSERT(coef_rshift != 0);
+
+    memcpy(residual, data, sizeof(int32_t) * num_samples);
+
+    /* LPC係数による予測 */
+    for (smpl = 1; (smpl < coef_order) && (smpl < num_samples); smpl++) {
+        predict = half;
+        for (ord = 0; ord < smpl; ord++) {
+            predict += ((int64_t)coef[coef_order - smpl + ord] * data[ord]);
+        }
+        residual[smpl] += (int32_t)(predict >> coef_rshift);
+    }
+
+#ifdef LINNELPC_USE_SSE2
+    if ((coef_order <= LINNELPC_INT64_MAX_ORDER) && (coef_order < num_samples)) {
+        LINNELPC_PredictInt64SSE2(data, num_samples, coef, coef_order, residual, coef_rshift);
+        return;
+    }
+#endif
+
+    for (smpl = coef_order; smpl < num_samples; smpl++) {
+        predict = half;
+        for (ord = 0; ord < coef_order; ord++) {
+            predict += ((int64_t)coef[ord] * data[smpl - coef_order + ord]);
+        }
+        residual[smpl] += (int32_t)(predict >> coef_rshift);
+    }
+}
@@ -12,6 +12,18 @@ void LINNELPC_Predict(
     const int32_t *data, uint32_t num_samples,
     const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift);
 
+/* 入力が16bitに収まる場合のLPC係数による予測/誤差出力
+* dataと係数は全て16bit符号付き整数の範囲にあること 結果はLINNELPC_Predictと一致する */
+void LINNELPC_PredictInt16(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift);
+
+/* 予測値を64bitで積和するLPC係数による予測/誤差出力
+* 32bitの積和が桁あふれしうる場合（LINNEUtility_IsLPCAccumulatorOverflowableが1の場合）に使う */
+void LINNELPC_PredictInt64(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,75 @@
+#ifndef LINNE_HANDLE_POOL_H_INCLUDED
+#define LINNE_HANDLE_POOL_H_INCLUDED
+
+#include "linne.h"
+#include "linne_encoder.h"
+#include "linne_decoder.h"
+#include "linne_stdint.h"
+
+/* エンコーダハンドルプール */
+struct LINNEEncoderPool;
+
+/* デコーダハンドルプール */
+struct LINNEDecoderPool;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* エンコーダハンドルプール作成に必要なワークサイズ計算 */
+int32_t LINNEEncoderPool_CalculateWorkSize(const struct LINNEEncoderConfig *config, uint32_t num_handles);
+
+/* エンコーダハンドルプール作成
+* configの容量を持つエンコーダハンドルをnum_handles個まとめて作成する
+* workにNULL, work_sizeに0を指定すると領域を自前確保する */
+struct LINNEEncoderPool *LINNEEncoderPool_Create(
+        const struct LINNEEncoderConfig *config, uint32_t num_handles, void *work, int32_t work_size);
+
+/* エンコーダハンドルプールの破棄
+* 貸し出したハンドルは全て返却してから呼ぶこと */
+void LINNEEncoderPool_Destroy(struct LINNEEncoderPool *pool);
+
+/* エンコーダハンドルの貸し出し
+* 空きハンドルがなければNULLを返す（領域確保は行わない）
+* 取得したハンドルはパラメータ未設定なので、LINNEEncoder_SetEncodeParameterを呼んでから使う */
+struct LINNEEncoder *LINNEEncoderPool_Acquire(struct LINNEEncoderPool *pool);
+
+/* エンコーダハンドルの返却
+* ハンドルはLINNEEncoder_Resetで作成直後の状態に戻してからプールに戻す
+* プールが貸し出していないハンドルを渡すとLINNE_APIRESULT_INVALID_ARGUMENTを返す */
+LINNEApiResult LINNEEncoderPool_Release(struct LINNEEncoderPool *pool, struct LINNEEncoder *encoder);
+
+/* 空きエンコーダハンドル数の取得 */
+uint32_t LINNEEncoderPool_GetNumFreeHandles(struct LINNEEncoderPool *pool);
+
+/* デコーダハンドルプール作成に必要なワークサイズ計算 */
+int32_t LINNEDecoderPool_CalculateWorkSize(const struct LINNEDecoderConfig *config, uint32_t num_handles);
+
+/* デコーダハンドルプール作成
+* configの容量を持つデコーダハンドルをnum_handles個まとめて作成する
+* workにNULL, work_sizeに0を指定すると領域を自前確保する */
+struct LINNEDecoderPool *LINNEDecoderPool_Create(
+        const struct LINNEDecoderConfig *config, uint32_t num_handles, void *work, int32_t work_size);
+
+/* デコーダハンドルプールの破棄
+* 貸し出したハンドルは全て返却してから呼ぶこと */
+void LINNEDecoderPool_Destroy(struct LINNEDecoderPool *pool);
+
+/* デコーダハンドルの貸し出し
+* 空きハンドルがなければNULLを返す（領域確保は行わない）
+* 取得したハンドルはヘッダ未設定なので、LINNEDecoder_SetHeaderを呼んでから使う */
+struct LINNEDecoder *LINNEDecoderPool_Acquire(struct LINNEDecoderPool *pool);
+
+/* デコーダハンドルの返却
+* ハンドルはLINNEDecoder_Resetで作成直後の状態に戻してからプールに戻す
+* プールが貸し出していないハンドルを渡すとLINNE_APIRESULT_INVALID_ARGUMENTを返す */
+LINNEApiResult LINNEDecoderPool_Release(struct LINNEDecoderPool *pool, struct LINNEDecoder *decoder);
+
+/* 空きデコーダハンドル数の取得 */
+uint32_t LINNEDecoderPool_GetNumFreeHandles(struct LINNEDecoderPool *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LINNE_HANDLE_POOL_H_INCLUDED */
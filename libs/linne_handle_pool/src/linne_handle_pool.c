@@ -0,0 +1,446 @@
+#include "linne_handle_pool.h"
+
+#include <stdlib.h>
+#include "linne_internal.h"
+#include "linne_utility.h"
+
+/* 排他制御 */
+#if defined(_WIN32)
+#include <windows.h>
+typedef CRITICAL_SECTION LINNEHandlePoolMutex;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t LINNEHandlePoolMutex;
+#endif
+
+/* ハンドル操作関数群 エンコーダ/デコーダの違いを吸収する */
+struct LINNEHandlePoolInterface {
+    /* ハンドル作成に必要なワークサイズ計算 */
+    int32_t (*calculate_work_size)(const void *config);
+    /* ハンドル作成 */
+    void *(*create)(const void *config, void *work, int32_t work_size);
+    /* ハンドル破棄 */
+    void (*destroy)(void *handle);
+    /* ハンドルを作成直後の状態に戻す */
+    LINNEApiResult (*reset)(void *handle);
+};
+
+/* ハンドルプール */
+struct LINNEHandlePool {
+    LINNEHandlePoolMutex mutex; /* 貸し出し状態の排他制御 */
+    const struct LINNEHandlePoolInterface *functions; /* ハンドル操作関数群 */
+    uint32_t num_handles; /* ハンドル数 */
+    void **handles; /* 全ハンドル */
+    uint8_t *in_use; /* 貸し出し中フラグ */
+    uint32_t *free_list; /* 空きハンドルのインデックス */
+    uint32_t num_free; /* 空きハンドル数 */
+    uint8_t alloced_by_own; /* 領域を自前確保しているか？ */
+    void *work; /* ワーク領域先頭ポインタ */
+};
+
+/* エンコーダハンドルプール */
+struct LINNEEncoderPool {
+    struct LINNEHandlePool pool;
+};
+
+/* デコーダハンドルプール */
+struct LINNEDecoderPool {
+    struct LINNEHandlePool pool;
+};
+
+/* 排他制御の初期化 */
+static void LINNEHandlePoolMutex_Initialize(LINNEHandlePoolMutex *mutex)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(mutex);
+#else
+    (void)pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+/* 排他制御の終了 */
+static void LINNEHandlePoolMutex_Finalize(LINNEHandlePoolMutex *mutex)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(mutex);
+#else
+    (void)pthread_mutex_destroy(mutex);
+#endif
+}
+
+/* ロック */
+static void LINNEHandlePoolMutex_Lock(LINNEHandlePoolMutex *mutex)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(mutex);
+#else
+    (void)pthread_mutex_lock(mutex);
+#endif
+}
+
+/* アンロック */
+static void LINNEHandlePoolMutex_Unlock(LINNEHandlePoolMutex *mutex)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(mutex);
+#else
+    (void)pthread_mutex_unlock(mutex);
+#endif
+}
+
+/* ハンドルプール作成に必要なワークサイズ計算 */
+static int32_t LINNEHandlePool_CalculateWorkSize(
+        const struct LINNEHandlePoolInterface *functions, const void *config, uint32_t num_handles)
+{
+    int32_t work_size, handle_size;
+
+    LINNE_ASSERT(functions != NULL);
+
+    /* 引数チェック */
+    if ((config == NULL) || (num_handles == 0)) {
+        return -1;
+    }
+
+    /* ハンドル1つあたりのサイズ */
+    if ((handle_size = functions->calculate_work_size(config)) < 0) {
+        return -1;
+    }
+
+    /* 構造体本体 */
+    work_size = (int32_t)sizeof(struct LINNEHandlePool) + LINNE_MEMORY_ALIGNMENT;
+    /* ハンドル・貸し出し中フラグ・空きリストの配列 int32_tで表せない個数は扱えない */
+    if (num_handles > (uint32_t)((INT32_MAX - work_size - 3 * LINNE_MEMORY_ALIGNMENT)
+                / (int32_t)(sizeof(void *) + sizeof(uint8_t) + sizeof(uint32_t)))) {
+        return -1;
+    }
+    work_size += (int32_t)(num_handles * sizeof(void *)) + LINNE_MEMORY_ALIGNMENT;
+    work_size += (int32_t)(num_handles * sizeof(uint8_t)) + LINNE_MEMORY_ALIGNMENT;
+    work_size += (int32_t)(num_handles * sizeof(uint32_t)) + LINNE_MEMORY_ALIGNMENT;
+    /* ハンドル本体 int32_tで表せないサイズは扱えない */
+    if ((handle_size > 0) && (num_handles > (uint32_t)((INT32_MAX - work_size) / handle_size))) {
+        return -1;
+    }
+    work_size += (int32_t)num_handles * handle_size;
+
+    return work_size;
+}
+
+/* ハンドルプール作成 */
+static struct LINNEHandlePool *LINNEHandlePool_Create(
+        const struct LINNEHandlePoolInterface *functions,
+        const void *config, uint32_t num_handles, void *work, int32_t work_size)
+{
+    uint32_t i;
+    int32_t handle_size;
+    struct LINNEHandlePool *pool;
+    uint8_t tmp_alloc_by_own = 0;
+    uint8_t *work_ptr;
+
+    LINNE_ASSERT(functions != NULL);
+
+    /* ワーク領域時前確保の場合 */
+    if ((work == NULL) && (work_size == 0)) {
+        if ((work_size = LINNEHandlePool_CalculateWorkSize(functions, config, num_handles)) < 0) {
+            return NULL;
+        }
+        work = LINNE_AllocateMemory((size_t)work_size);
+        tmp_alloc_by_own = 1;
+    }
+
+    /* 引数チェック */
+    if ((config == NULL) || (num_handles == 0) || (work == NULL)
+            || (work_size < LINNEHandlePool_CalculateWorkSize(functions, config, num_handles))) {
+        if (tmp_alloc_by_own == 1) {
+            LINNE_FreeMemory(work);
+        }
+        return NULL;
+    }
+
+    handle_size = functions->calculate_work_size(config);
+
+    /* ワーク領域先頭ポインタ取得 */
+    work_ptr = (uint8_t *)work;
+
+    /* プール本体の領域確保 */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    pool = (struct LINNEHandlePool *)work_ptr;
+    work_ptr += sizeof(struct LINNEHandlePool);
+
+    /* プールメンバ設定 */
+    pool->functions = functions;
+    pool->num_handles = num_handles;
+    pool->alloced_by_own = tmp_alloc_by_own;
+    pool->work = work;
+
+    /* 配列領域の確保 */
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    pool->handles = (void **)work_ptr;
+    work_ptr += num_handles * sizeof(void *);
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    pool->in_use = (uint8_t *)work_ptr;
+    work_ptr += num_handles * sizeof(uint8_t);
+    work_ptr = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_MEMORY_ALIGNMENT);
+    pool->free_list = (uint32_t *)work_ptr;
+    work_ptr += num_handles * sizeof(uint32_t);
+
+    /* ハンドルの作成 */
+    for (i = 0; i < num_handles; i++) {
+        if ((pool->handles[i] = functions->create(config, work_ptr, handle_size)) == NULL) {
+            /* 作成済みのハンドルを破棄 */
+            while (i > 0) {
+                i--;
+                functions->destroy(pool->handles[i]);
+            }
+            if (tmp_alloc_by_own == 1) {
+                LINNE_FreeMemory(work);
+            }
+            return NULL;
+        }
+        work_ptr += handle_size;
+        pool->in_use[i] = 0;
+        /* 先頭のハンドルから貸し出すよう逆順に積む */
+        pool->free_list[i] = num_handles - i - 1;
+    }
+    pool->num_free = num_handles;
+
+    /* バッファオーバーランチェック */
+    /* 補足）既にメモリを破壊している可能性があるので、チェックに失敗したら落とす */
+    LINNE_ASSERT((work_ptr - (uint8_t *)work) <= work_size);
+
+    LINNEHandlePoolMutex_Initialize(&pool->mutex);
+
+    return pool;
+}
+
+/* ハンドルプールの破棄 */
+static void LINNEHandlePool_Destroy(struct LINNEHandlePool *pool)
+{
+    uint32_t i;
+
+    if (pool != NULL) {
+        /* 貸し出し中のハンドルがあってはならない */
+        LINNE_ASSERT(pool->num_free == pool->num_handles);
+        for (i = 0; i < pool->num_handles; i++) {
+            pool->functions->destroy(pool->handles[i]);
+        }
+        LINNEHandlePoolMutex_Finalize(&pool->mutex);
+        if (pool->alloced_by_own == 1) {
+            LINNE_FreeMemory(pool->work);
+        }
+    }
+}
+
+/* ハンドルの貸し出し */
+static void *LINNEHandlePool_Acquire(struct LINNEHandlePool *pool)
+{
+    void *handle = NULL;
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    LINNEHandlePoolMutex_Lock(&pool->mutex);
+    if (pool->num_free > 0) {
+        const uint32_t index = pool->free_list[--pool->num_free];
+        LINNE_ASSERT(pool->in_use[index] == 0);
+        pool->in_use[index] = 1;
+        handle = pool->handles[index];
+    }
+    LINNEHandlePoolMutex_Unlock(&pool->mutex);
+
+    return handle;
+}
+
+/* ハンドルの返却 */
+static LINNEApiResult LINNEHandlePool_Release(struct LINNEHandlePool *pool, void *handle)
+{
+    uint32_t index;
+
+    /* 引数チェック */
+    if ((pool == NULL) || (handle == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* プールのハンドルか探す ハンドルの並びは作成後不変なのでロック不要 */
+    for (index = 0; index < pool->num_handles; index++) {
+        if (pool->handles[index] == handle) {
+            break;
+        }
+    }
+    if (index == pool->num_handles) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    LINNEHandlePoolMutex_Lock(&pool->mutex);
+
+    /* 貸し出していないハンドルの返却（二重返却）は受け付けない */
+    if (pool->in_use[index] == 0) {
+        LINNEHandlePoolMutex_Unlock(&pool->mutex);
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    /* 作成直後の状態に戻して空きに積む */
+    (void)pool->functions->reset(handle);
+    pool->in_use[index] = 0;
+    pool->free_list[pool->num_free++] = index;
+
+    LINNEHandlePoolMutex_Unlock(&pool->mutex);
+
+    return LINNE_APIRESULT_OK;
+}
+
+/* 空きハンドル数の取得 */
+static uint32_t LINNEHandlePool_GetNumFreeHandles(struct LINNEHandlePool *pool)
+{
+    uint32_t num_free;
+
+    if (pool == NULL) {
+        return 0;
+    }
+
+    LINNEHandlePoolMutex_Lock(&pool->mutex);
+    num_free = pool->num_free;
+    LINNEHandlePoolMutex_Unlock(&pool->mutex);
+
+    return num_free;
+}
+
+/* エンコーダ: ワークサイズ計算 */
+static int32_t LINNEEncoderPool_CalculateHandleWorkSize(const void *config)
+{
+    return LINNEEncoder_CalculateWorkSize((const struct LINNEEncoderConfig *)config);
+}
+
+/* エンコーダ: ハンドル作成 */
+static void *LINNEEncoderPool_CreateHandle(const void *config, void *work, int32_t work_size)
+{
+    return LINNEEncoder_Create((const struct LINNEEncoderConfig *)config, work, work_size);
+}
+
+/* エンコーダ: ハンドル破棄 */
+static void LINNEEncoderPool_DestroyHandle(void *handle)
+{
+    LINNEEncoder_Destroy((struct LINNEEncoder *)handle);
+}
+
+/* エンコーダ: ハンドルリセット */
+static LINNEApiResult LINNEEncoderPool_ResetHandle(void *handle)
+{
+    return LINNEEncoder_Reset((struct LINNEEncoder *)handle);
+}
+
+/* エンコーダハンドル操作関数群 */
+static const struct LINNEHandlePoolInterface st_encoder_pool_interface = {
+    LINNEEncoderPool_CalculateHandleWorkSize,
+    LINNEEncoderPool_CreateHandle,
+    LINNEEncoderPool_DestroyHandle,
+    LINNEEncoderPool_ResetHandle
+};
+
+/* デコーダ: ワークサイズ計算 */
+static int32_t LINNEDecoderPool_CalculateHandleWorkSize(const void *config)
+{
+    return LINNEDecoder_CalculateWorkSize((const struct LINNEDecoderConfig *)config);
+}
+
+/* デコーダ: ハンドル作成 */
+static void *LINNEDecoderPool_CreateHandle(const void *config, void *work, int32_t work_size)
+{
+    return LINNEDecoder_Create((const struct LINNEDecoderConfig *)config, work, work_size);
+}
+
+/* デコーダ: ハンドル破棄 */
+static void LINNEDecoderPool_DestroyHandle(void *handle)
+{
+    LINNEDecoder_Destroy((struct LINNEDecoder *)handle);
+}
+
+/* デコーダ: ハンドルリセット */
+static LINNEApiResult LINNEDecoderPool_ResetHandle(void *handle)
+{
+    return LINNEDecoder_Reset((struct LINNEDecoder *)handle);
+}
+
+/* デコーダハンドル操作関数群 */
+static const struct LINNEHandlePoolInterface st_decoder_pool_interface = {
+    LINNEDecoderPool_CalculateHandleWorkSize,
+    LINNEDecoderPool_CreateHandle,
+    LINNEDecoderPool_DestroyHandle,
+    LINNEDecoderPool_ResetHandle
+};
+
+/* エンコーダハンドルプール作成に必要なワークサイズ計算 */
+int32_t LINNEEncoderPool_CalculateWorkSize(const struct LINNEEncoderConfig *config, uint32_t num_handles)
+{
+    return LINNEHandlePool_CalculateWorkSize(&st_encoder_pool_interface, config, num_handles);
+}
+
+/* エンコーダハンドルプール作成 */
+struct LINNEEncoderPool *LINNEEncoderPool_Create(
+        const struct LINNEEncoderConfig *config, uint32_t num_handles, void *work, int32_t work_size)
+{
+    return (struct LINNEEncoderPool *)LINNEHandlePool_Create(
+            &st_encoder_pool_interface, config, num_handles, work, work_size);
+}
+
+/* エンコーダハンドルプールの破棄 */
+void LINNEEncoderPool_Destroy(struct LINNEEncoderPool *pool)
+{
+    LINNEHandlePool_Destroy((struct LINNEHandlePool *)pool);
+}
+
+/* エンコーダハンドルの貸し出し */
+struct LINNEEncoder *LINNEEncoderPool_Acquire(struct LINNEEncoderPool *pool)
+{
+    return (struct LINNEEncoder *)LINNEHandlePool_Acquire((struct LINNEHandlePool *)pool);
+}
+
+/* エンコーダハンドルの返却 */
+LINNEApiResult LINNEEncoderPool_Release(struct LINNEEncoderPool *pool, struct LINNEEncoder *encoder)
+{
+    return LINNEHandlePool_Release((struct LINNEHandlePool *)pool, encoder);
+}
+
+/* 空きエンコーダハンドル数の取得 */
+uint32_t LINNEEncoderPool_GetNumFreeHandles(struct LINNEEncoderPool *pool)
+{
+    return LINNEHandlePool_GetNumFreeHandles((struct LINNEHandlePool *)pool);
+}
+
+/* デコーダハンドルプール作成に必要なワークサイズ計算 */
+int32_t LINNEDecoderPool_CalculateWorkSize(const struct LINNEDecoderConfig *config, uint32_t num_handles)
+{
+    return LINNEHandlePool_CalculateWorkSize(&st_decoder_pool_interface, config, num_handles);
+}
+
+/* デコーダハンドルプール作成 */
+struct LINNEDecoderPool *LINNEDecoderPool_Create(
+        const struct LINNEDecoderConfig *config, uint32_t num_handles, void *work, int32_t work_size)
+{
+    return (struct LINNEDecoderPool *)LINNEHandlePool_Create(
+            &st_decoder_pool_interface, config, num_handles, work, work_size);
+}
+
+/* デコーダハンドルプールの破棄 */
+void LINNEDecoderPool_Destroy(struct LINNEDecoderPool *pool)
+{
+    LINNEHandlePool_Destroy((struct LINNEHandlePool *)pool);
+}
+
+/* デコーダハンドルの貸し出し */
+struct LINNEDecoder *LINNEDecoderPool_Acquire(struct LINNEDecoderPool *pool)
+{
+    return (struct LINNEDecoder *)LINNEHandlePool_Acquire((struct LINNEHandlePool *)pool);
+}
+
+/* デコーダハンドルの返却 */
+LINNEApiResult LINNEDecoderPool_Release(struct LINNEDecoderPool *pool, struct LINNEDecoder *decoder)
+{
+    return LINNEHandlePool_Release((struct LINNEHandlePool *)pool, decoder);
+}
+
+/* 空きデコーダハンドル数の取得 */
+uint32_t LINNEDecoderPool_GetNumFreeHandles(struct LINNEDecoderPool *pool)
+{
+    return LINNEHandlePool_GetNumFreeHandles((struct LINNEHandlePool *)pool);
+}
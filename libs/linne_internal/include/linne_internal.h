@@ -6,8 +6,15 @@
 
 /* 本ライブラリのメモリアラインメント */
 #define LINNE_MEMORY_ALIGNMENT 16
+/* キャッシュラインサイズ */
+#define LINNE_CACHE_LINE_SIZE 64
 /* ブロック先頭の同期コード */
 #define LINNE_BLOCK_SYNC_CODE 0xFFFF
+/* ブロックヘッダサイズ（同期コード, ブロックサイズ, CRC16, データタイプ, サンプル数） */
+#define LINNE_BLOCK_HEADER_SIZE 11
+
+/* LPC合成の積和を常に32bitで行っていた（桁あふれを許容していた）最後のフォーマットバージョン */
+#define LINNE_LAST_32BIT_ACCUMULATOR_FORMAT_VERSION 1
 
 /* 内部エンコードパラメータ */
 /* プリエンファシスの係数シフト量 */
@@ -20,6 +27,12 @@
 #define LINNE_LOG2_NUM_UNITS_BITWIDTH 3
 /* LPC係数右シフト量のビット幅 */
 #define LINNE_RSHIFT_LPC_COEFFICIENT_BITWIDTH 4
+/* 下位の無効ビット数のビット幅 */
+#define LINNE_WASTED_BITS_BITWIDTH 5
+/* 差分で記録するLPC係数のRice符号パラメータのビット幅 */
+#define LINNE_DELTA_COEF_RICE_PARAMETER_BITWIDTH 3
+/* 差分で記録するプリエンファシスフィルタ初期値のRice符号パラメータのビット幅 */
+#define LINNE_DELTA_PREEMPHASIS_RICE_PARAMETER_BITWIDTH 5
 /* 圧縮をやめて生データを出力するときの閾値（サンプルあたりビット数に占める比率） */
 #define LINNE_ESTIMATED_CODELENGTH_THRESHOLD 0.95f
 /* ユニット数決定時の補助関数法の繰り返し回数（0は初期値のまま） */
@@ -48,12 +61,28 @@
 /* 静的アサートマクロ */
 #define LINNE_STATIC_ASSERT(expr) extern void assertion_failed(char dummy[(expr) ? 1 : -1])
 
+/* ヘッダのプリセット値に立てる、ブロック毎にプリセットを切り替えることを示すフラグ */
+#define LINNE_HEADER_BLOCK_PRESET_FLAG 0x80
+/* ヘッダのプリセット値に立てる、ヘッダ拡張に独自レイヤー構造があることを示すフラグ */
+#define LINNE_HEADER_CUSTOM_LAYERS_FLAG 0x40
+
+/* ブロックデータタイプに立てる、圧縮データ先頭にチャンネル毎の下位の無効ビット数があることを示すフラグ */
+#define LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG 0x80
+/* ブロックデータタイプに立てる、圧縮データにLPCパラメータがなく直前の圧縮データのものを使うことを示すフラグ */
+#define LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG 0x40
+/* ブロックデータタイプに立てる、圧縮データのパラメータを直前のブロックとの差分で記録したことを示すフラグ */
+#define LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG 0x20
+/* ブロックデータタイプに立つフラグ全体 */
+#define LINNE_BLOCK_DATA_TYPE_FLAGS (LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG\
+        | LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG | LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG)
+
 /* ブロックデータタイプ */
 typedef enum LINNEBlockDataTypeTag {
     LINNE_BLOCK_DATA_TYPE_COMPRESSDATA  = 0, /* 圧縮済みデータ */
     LINNE_BLOCK_DATA_TYPE_SILENT        = 1, /* 無音データ     */
     LINNE_BLOCK_DATA_TYPE_RAWDATA       = 2, /* 生データ       */
-    LINNE_BLOCK_DATA_TYPE_INVALID       = 3  /* 無効           */
+    LINNE_BLOCK_DATA_TYPE_CONSTANT      = 3, /* 定数データ     */
+    LINNE_BLOCK_DATA_TYPE_INVALID       = 4  /* 無効           */
 } LINNEBlockDataType;
 
 /* 内部エラー型 */
@@ -79,6 +108,20 @@ extern "C" {
 /* パラメータプリセット配列 */
 extern const struct LINNEParameterPreset g_linne_parameter_preset[LINNE_NUM_PARAMETER_PRESETS];
 
+/* 独自レイヤー構造の検査 ヘッダ拡張に記録できない構造であればLINNE_ERROR_INVALID_FORMATを返す */
+LINNEError LINNE_CheckCustomLayerStructure(uint32_t num_layers, const uint32_t *num_params_list);
+
+/* ヘッダが指すレイヤー構造の取得
+* 独自レイヤー構造があればヘッダの配列を参照する構造をcustomにセットしてcustomを、なければプリセットを返す */
+const struct LINNEParameterPreset *LINNE_GetLayerStructure(
+        const struct LINNEHeader *header, struct LINNEParameterPreset *custom);
+
+/* 設定中のアロケータによる領域確保 LINNE_MEMORY_ALIGNMENT境界を要求する */
+void *LINNE_AllocateMemory(size_t size);
+
+/* 設定中のアロケータによる領域解放 */
+void LINNE_FreeMemory(void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -107,6 +107,22 @@ __inline uint32_t LINNEUTILITY_NLZ(uint32_t x)
         }\
     } while (0)
 
+/* フラット配列の行ストライド（要素数）計算: 各行の先頭をキャッシュラインに揃える */
+#define LINNE_CALCULATE_FLATARRAY_STRIDE(type, row_size)\
+    ((uint32_t)(LINNEUTILITY_ROUNDUP((row_size) * sizeof(type), LINNE_CACHE_LINE_SIZE) / sizeof(type)))
+
+/* フラット配列の領域ワークサイズ計算 */
+#define LINNE_CALCULATE_FLATARRAY_WORKSIZE(type, num_elements)\
+    ((int32_t)((num_elements) * sizeof(type)) + LINNE_CACHE_LINE_SIZE)
+
+/* フラット配列の領域割当て 先頭はキャッシュラインに揃える */
+#define LINNE_ALLOCATE_FLATARRAY(ptr, work_ptr, type, num_elements)\
+    do {\
+        (work_ptr) = (uint8_t *)LINNEUTILITY_ROUNDUP((uintptr_t)work_ptr, LINNE_CACHE_LINE_SIZE);\
+        (ptr) = (type *)work_ptr;\
+        (work_ptr) += sizeof(type) * (num_elements);\
+    } while (0)
+
 /* プリエンファシス/デエンファシスフィルタ */
 struct LINNEPreemphasisFilter {
     int32_t prev;
@@ -138,6 +154,23 @@ void LINNEUtility_MSConversion(int32_t **buffer, uint32_t num_samples);
 /* MS -> LR (in-place) */
 void LINNEUtility_LRConversion(int32_t **buffer, uint32_t num_samples);
 
+/* 差分で記録するプリエンファシスフィルタ初期値の基準を計算
+* 直前のブロックのチャンネル毎の末尾サンプルを、現在のブロックの無効ビット数で落とし（ms_conversionが1ならば先頭2チャンネルをLR -> MS変換し）た値を基準とする
+* エンコーダとデコーダで同一の計算を使うこと */
+void LINNEUtility_CalculatePreemphasisBasis(
+        const int32_t *last_samples, const uint32_t *wasted_bits, uint32_t num_channels,
+        uint8_t ms_conversion, int32_t *basis);
+
+/* LPCの予測値を32bitで積和すると桁あふれしうるか
+* 入力の振幅をビット幅とプリエンファシス・MS変換による増加分から見積もり、係数の絶対値和と掛けて判定する
+* 1ならば予測値を64bitで積和しなければならない（エンコーダとデコーダで同一の判定を使うこと） */
+uint8_t LINNEUtility_IsLPCAccumulatorOverflowable(
+        const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift, uint32_t bits_per_sample);
+
+/* 単調増加する壁時計の時刻[sec]を取得
+* 処理時間の計測用 clock()と異なりプロセスCPU時間ではないので、タスクを並列実行しても実時間が得られる */
+double LINNEUtility_GetMonotonicTime(void);
+
 /* プリエンファシスフィルタ初期化 */
 void LINNEPreemphasisFilter_Initialize(struct LINNEPreemphasisFilter *preem);
 
@@ -149,10 +182,27 @@ void LINNEPreemphasisFilter_CalculateCoefficient(
 void LINNEPreemphasisFilter_Preemphasis(
         struct LINNEPreemphasisFilter *preem, int32_t *buffer, uint32_t num_samples);
 
+/* 多段プリエンファシス
+* preem[0], ..., preem[LINNE_NUM_PREEMPHASIS_FILTERS - 1]の順に係数を計算してプリエンファシスする
+* 各段の直前値は各段の入力の先頭サンプルとし、initial_prev[l]にも記録する
+* 結果はLINNEPreemphasisFilter_CalculateCoefficientとLINNEPreemphasisFilter_Preemphasisを各段で行った場合と一致する */
+void LINNEPreemphasisFilter_MultiStagePreemphasis(
+        struct LINNEPreemphasisFilter *preem, int32_t *initial_prev, int32_t *buffer, uint32_t num_samples);
+
 /* デエンファシス */
 void LINNEPreemphasisFilter_Deemphasis(
         struct LINNEPreemphasisFilter *preem, int32_t *buffer, uint32_t num_samples);
 
+/* 多段デエンファシス
+* preem[LINNE_NUM_PREEMPHASIS_FILTERS - 1], ..., preem[0]の順にデエンファシスした結果を1パスで計算する */
+void LINNEPreemphasisFilter_MultiStageDeemphasis(
+        struct LINNEPreemphasisFilter *preem, int32_t *buffer, uint32_t num_samples);
+
+/* 2チャンネルの多段デエンファシスとMS -> LR変換
+* 各チャンネルにpreem[ch]で多段デエンファシスした後のMS -> LR変換を1パスで計算する */
+void LINNEPreemphasisFilter_MultiStageDeemphasisLRConversion(
+        struct LINNEPreemphasisFilter **preem, int32_t **buffer, uint32_t num_samples);
+
 #ifdef __cplusplus
 }
 #endif
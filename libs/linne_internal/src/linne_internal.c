@@ -1,5 +1,8 @@
 #include "linne_internal.h"
 
+#include <stddef.h>
+#include <stdlib.h>
+
 /* 配列の要素数を取得 */
 #define LINNE_NUM_ARRAY_ELEMENTS(array) ((sizeof(array)) / (sizeof(array[0])))
 /* プリセットの要素定義 */
@@ -14,6 +17,28 @@ static const uint32_t num_params_preset2[] = {  4,  64,  16 };
 static const uint32_t num_params_preset3[] = {  4,  96,  16 };
 static const uint32_t num_params_preset4[] = {  4, 128,  16 };
 
+/* 標準の領域確保 mallocはLINNE_MEMORY_ALIGNMENT以上の境界を返さない場合があるが、各ハンドルは内部で境界を揃え直す */
+static void *LINNE_DefaultAllocate(size_t size, size_t alignment, void *context)
+{
+    (void)alignment;
+    (void)context;
+    return malloc(size);
+}
+
+/* 標準の領域解放 */
+static void LINNE_DefaultDeallocate(void *ptr, void *context)
+{
+    (void)context;
+    free(ptr);
+}
+
+/* 設定中のアロケータ LPC・WAVライブラリも含めて共有する 排他制御はしない */
+static struct LINNEAllocator st_linne_allocator = {
+    LINNE_DefaultAllocate,
+    LINNE_DefaultDeallocate,
+    NULL
+};
+
 /* パラメータプリセット配列 */
 const struct LINNEParameterPreset g_linne_parameter_preset[LINNE_NUM_PARAMETER_PRESETS] = {
     LINNE_DEFINE_PARAMETER_PRESET(num_params_preset1),
@@ -21,3 +46,86 @@ const struct LINNEParameterPreset g_linne_parameter_preset[LINNE_NUM_PARAMETER_P
     LINNE_DEFINE_PARAMETER_PRESET(num_params_preset3),
     LINNE_DEFINE_PARAMETER_PRESET(num_params_preset4),
 };
+
+/* 独自レイヤー構造の検査 */
+LINNEError LINNE_CheckCustomLayerStructure(uint32_t num_layers, const uint32_t *num_params_list)
+{
+    uint32_t l;
+
+    if (num_params_list == NULL) {
+        return LINNE_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* レイヤー数 */
+    if ((num_layers == 0) || (num_layers > LINNE_MAX_NUM_CUSTOM_LAYERS)) {
+        return LINNE_ERROR_INVALID_FORMAT;
+    }
+
+    /* パラメータ数: ヘッダ拡張には1byteで記録する */
+    for (l = 0; l < num_layers; l++) {
+        if ((num_params_list[l] == 0) || (num_params_list[l] > LINNE_NETWORK_MAX_PARAMS_PER_LAYER)) {
+            return LINNE_ERROR_INVALID_FORMAT;
+        }
+    }
+
+    return LINNE_ERROR_OK;
+}
+
+/* ヘッダが指すレイヤー構造の取得 */
+const struct LINNEParameterPreset *LINNE_GetLayerStructure(
+        const struct LINNEHeader *header, struct LINNEParameterPreset *custom)
+{
+    LINNE_ASSERT(header != NULL);
+    LINNE_ASSERT(custom != NULL);
+
+    if (header->num_custom_layers == 0) {
+        LINNE_ASSERT(header->preset < LINNE_NUM_PARAMETER_PRESETS);
+        return &g_linne_parameter_preset[header->preset];
+    }
+
+    custom->num_layers = header->num_custom_layers;
+    custom->num_params_list = header->custom_num_params_list;
+    return custom;
+}
+
+/* アロケータの設定 */
+LINNEApiResult LINNE_SetAllocator(const struct LINNEAllocator *allocator)
+{
+    /* NULLなら標準に戻す */
+    if (allocator == NULL) {
+        st_linne_allocator.allocate = LINNE_DefaultAllocate;
+        st_linne_allocator.deallocate = LINNE_DefaultDeallocate;
+        st_linne_allocator.context = NULL;
+        return LINNE_APIRESULT_OK;
+    }
+
+    /* 確保と解放は対で指定させる */
+    if ((allocator->allocate == NULL) || (allocator->deallocate == NULL)) {
+        return LINNE_APIRESULT_INVALID_ARGUMENT;
+    }
+
+    st_linne_allocator = (*allocator);
+    return LINNE_APIRESULT_OK;
+}
+
+/* 現在のアロケータの取得 */
+void LINNE_GetAllocator(struct LINNEAllocator *allocator)
+{
+    if (allocator != NULL) {
+        (*allocator) = st_linne_allocator;
+    }
+}
+
+/* 設定中のアロケータによる領域確保 */
+void *LINNE_AllocateMemory(size_t size)
+{
+    return st_linne_allocator.allocate(size, LINNE_MEMORY_ALIGNMENT, st_linne_allocator.context);
+}
+
+/* 設定中のアロケータによる領域解放 */
+void LINNE_FreeMemory(void *ptr)
+{
+    if (ptr != NULL) {
+        st_linne_allocator.deallocate(ptr, st_linne_allocator.context);
+    }
+}
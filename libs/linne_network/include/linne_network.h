@@ -36,6 +36,15 @@ double LINNENetwork_CalculateLoss(
 void LINNENetwork_SetUnitsAndParameters(
         struct LINNENetwork *net, const double *input, uint32_t num_samples);
 
+/* 整数信号をscale倍しながら取り込み、最適なユニット数とパラメータの設定 */
+void LINNENetwork_SetUnitsAndParametersInt32(
+        struct LINNENetwork *net, const int32_t *input, double scale, uint32_t num_samples);
+
+/* ユニット数を1に固定したパラメータの設定
+* ブロックの区間分割に合わせられない分析窓（過去のブロックを含むもの）で使う */
+void LINNENetwork_SetSingleUnitParameters(
+        struct LINNENetwork *net, const double *input, uint32_t num_samples);
+
 /* パラメータのクリア */
 void LINNENetwork_ResetParameters(struct LINNENetwork *net);
 
@@ -43,9 +52,10 @@ void LINNENetwork_ResetParameters(struct LINNENetwork *net);
 void LINNENetwork_GetLayerNumUnits(
         const struct LINNENetwork *net, uint32_t *num_units_buffer, uint32_t buffer_size);
 
-/* パラメータ取得 */
+/* パラメータ取得
+* 第l層のパラメータはparams_buffer[l * buffer_num_params_per_layer]から並べる */
 void LINNENetwork_GetParameters(
-        const struct LINNENetwork *net, double **params_buffer,
+        const struct LINNENetwork *net, double *params_buffer,
         uint32_t buffer_num_layers, uint32_t buffer_num_params_per_layer);
 
 /* 入力データからサンプルあたりの推定符号長を求める */
@@ -53,6 +63,12 @@ double LINNENetwork_EstimateCodeLength(
         struct LINNENetwork *net,
         const double *data, uint32_t num_samples, uint32_t bits_per_sample);
 
+/* 入力データから指定次数のLPCによるサンプルあたりの推定符号長を求める
+* 次数はネットワーク作成時のレイヤーあたり最大パラメータ数以下であること */
+double LINNENetwork_EstimateCodeLengthWithOrder(
+        struct LINNENetwork *net,
+        const double *data, uint32_t num_samples, uint32_t bits_per_sample, uint32_t order);
+
 /* LINNEネットトレーナー作成に必要なワークサイズ計算 */
 int32_t LINNENetworkTrainer_CalculateWorkSize(
         uint32_t max_num_layers, uint32_t max_num_params_per_layer);
@@ -279,8 +279,8 @@ static void LINNENetworkLayer_SearchOptimalNumUnits(
     LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(best_num_units != NULL);
     LINNE_ASSERT(layer->num_params >= max_num_units);
-    LINNE_ASSERT(LINNEUTILITY_IS_POWERED_OF_2(max_num_units));
 
+    /* 上限はパラメータ数で抑えるので2の冪とは限らない（プリセット3の96など） 上限以下の2の冪を試す */
     for (nunits = 1; nunits <= max_num_units; nunits <<= 1) {
         const uint32_t nparams_per_unit = layer->num_params / nunits;
         const uint32_t nsmpls_per_unit = num_samples / nunits;
@@ -564,18 +564,15 @@ static double LINNENetwork_CalculateGradient(
     return loss;
 }
 
-/* Levinson-Durbin法に基づく最適なユニット数とパラメータの設定 */
-void LINNENetwork_SetUnitsAndParameters(
-        struct LINNENetwork *net, const double *input, uint32_t num_samples)
+/* data_bufferの信号に対してLevinson-Durbin法に基づく最適なユニット数とパラメータの設定 */
+static void LINNENetwork_SetUnitsAndParametersCore(struct LINNENetwork *net, uint32_t num_samples)
 {
     int32_t l;
     const uint32_t max_num_units = 1UL << ((1UL << LINNE_LOG2_NUM_UNITS_BITWIDTH) - 1);
 
     LINNE_ASSERT(net != NULL);
-    LINNE_ASSERT(input != NULL);
     LINNE_ASSERT(num_samples <= net->num_samples);
 
-    memcpy(net->data_buffer, input, sizeof(double) * num_samples);
     for (l = 0; l < net->num_layers; l++) {
         uint32_t best_num_units;
         struct LINNENetworkLayer* layer = net->layers[l];
@@ -588,6 +585,55 @@ void LINNENetwork_SetUnitsAndParameters(
     }
 }
 
+/* Levinson-Durbin法に基づく最適なユニット数とパラメータの設定 */
+void LINNENetwork_SetUnitsAndParameters(
+        struct LINNENetwork *net, const double *input, uint32_t num_samples)
+{
+    LINNE_ASSERT(net != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples <= net->num_samples);
+
+    memcpy(net->data_buffer, input, sizeof(double) * num_samples);
+    LINNENetwork_SetUnitsAndParametersCore(net, num_samples);
+}
+
+/* 整数信号から最適なユニット数とパラメータの設定
+* scale倍したdouble信号をLINNENetwork_SetUnitsAndParametersに与えたのと同じ結果になる */
+void LINNENetwork_SetUnitsAndParametersInt32(
+        struct LINNENetwork *net, const int32_t *input, double scale, uint32_t num_samples)
+{
+    uint32_t smpl;
+
+    LINNE_ASSERT(net != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples <= net->num_samples);
+
+    /* 変換しながら作業領域に取り込む */
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        net->data_buffer[smpl] = input[smpl] * scale;
+    }
+    LINNENetwork_SetUnitsAndParametersCore(net, num_samples);
+}
+
+/* ユニット数を1に固定したパラメータの設定 */
+void LINNENetwork_SetSingleUnitParameters(
+        struct LINNENetwork *net, const double *input, uint32_t num_samples)
+{
+    int32_t l;
+
+    LINNE_ASSERT(net != NULL);
+    LINNE_ASSERT(input != NULL);
+    LINNE_ASSERT(num_samples <= net->num_samples);
+
+    memcpy(net->data_buffer, input, sizeof(double) * num_samples);
+    for (l = 0; l < net->num_layers; l++) {
+        struct LINNENetworkLayer* layer = net->layers[l];
+        layer->num_units = 1;
+        LINNENetworkLayer_SetParameter(layer, net->lpcc, net->data_buffer, num_samples);
+        LINNENetworkLayer_Forward(layer, net->data_buffer, num_samples);
+    }
+}
+
 /* パラメータのクリア */
 void LINNENetwork_ResetParameters(struct LINNENetwork *net)
 {
@@ -617,7 +663,7 @@ void LINNENetwork_GetLayerNumUnits(
 
 /* パラメータ取得 */
 void LINNENetwork_GetParameters(
-        const struct LINNENetwork *net, double **params_buffer,
+        const struct LINNENetwork *net, double *params_buffer,
         const uint32_t buffer_num_layers, const uint32_t buffer_num_params_per_layer)
 {
     int32_t l;
@@ -628,10 +674,9 @@ void LINNENetwork_GetParameters(
 
     for (l = 0; l < net->num_layers; l++) {
         const struct LINNENetworkLayer *layer = net->layers[l];
-        LINNE_ASSERT(params_buffer[l] != NULL);
         LINNE_ASSERT(buffer_num_params_per_layer >= layer->num_params);
         /* バッファ領域にコピー */
-        memcpy(params_buffer[l], layer->params, sizeof(double) * layer->num_params);
+        memcpy(&params_buffer[(uint32_t)l * buffer_num_params_per_layer], layer->params, sizeof(double) * layer->num_params);
     }
 }
 
@@ -639,16 +684,29 @@ void LINNENetwork_GetParameters(
 double LINNENetwork_EstimateCodeLength(
         struct LINNENetwork *net,
         const double *data, uint32_t num_samples, uint32_t bits_per_sample)
+{
+    LINNE_ASSERT(net != NULL);
+    LINNE_ASSERT(data != NULL);
+
+    /* TODO: 仮実装。1層目のパラメータのみを用いて推定 */
+    return LINNENetwork_EstimateCodeLengthWithOrder(net, data, num_samples, bits_per_sample, net->layers[0]->num_params);
+}
+
+/* 入力データから指定次数のLPCによるサンプルあたりの推定符号長を求める */
+double LINNENetwork_EstimateCodeLengthWithOrder(
+        struct LINNENetwork *net,
+        const double *data, uint32_t num_samples, uint32_t bits_per_sample, uint32_t order)
 {
     double tmp_length;
     LPCApiResult ret;
 
     LINNE_ASSERT(net != NULL);
     LINNE_ASSERT(data != NULL);
+    LINNE_ASSERT(order > 0);
+    LINNE_ASSERT(order <= net->max_num_params);
 
-    /* TODO: 仮実装。1層目のパラメータのみを用いて推定 */
     ret = LPCCalculator_EstimateCodeLength(net->lpcc,
-            data, num_samples, bits_per_sample, net->layers[0]->num_params, &tmp_length, LPC_WINDOWTYPE_SIN);
+            data, num_samples, bits_per_sample, order, &tmp_length, LPC_WINDOWTYPE_SIN);
     LINNE_ASSERT(ret == LPC_APIRESULT_OK);
 
     return tmp_length;
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <float.h>
 #include <assert.h>
+#include "linne_internal.h"
 
 /* メモリアラインメント */
 #define LPC_ALIGNMENT 16
@@ -94,7 +95,7 @@ struct LPCCalculator* LPCCalculator_Create(const struct LPCCalculatorConfig *con
         if ((work_size = LPCCalculator_CalculateWorkSize(config)) < 0) {
             return NULL;
         }
-        work = malloc((uint32_t)work_size);
+        work = LINNE_AllocateMemory((size_t)work_size);
         tmp_alloc_by_own = 1;
     }
 
@@ -103,7 +104,7 @@ struct LPCCalculator* LPCCalculator_Create(const struct LPCCalculatorConfig *con
             || (work_size < LPCCalculator_CalculateWorkSize(config))
             || (config->max_order == 0) || (config->max_num_samples == 0)) {
         if (tmp_alloc_by_own == 1) {
-            free(work);
+            LINNE_FreeMemory(work);
         }
         return NULL;
     }
@@ -167,7 +168,7 @@ void LPCCalculator_Destroy(struct LPCCalculator *lpcc)
     if (lpcc != NULL) {
         /* ワーク領域を時前確保していたときは開放 */
         if (lpcc->alloced_by_own == 1) {
-            free(lpcc->work);
+            LINNE_FreeMemory(lpcc->work);
         }
     }
 }
@@ -745,8 +746,8 @@ static LPCError LPC_CalculateCoefBurg(
     double tmp1, tmp2;
 
     /* ベクトル領域割り当て */
-    f_vec = malloc(sizeof(double) * num_samples);
-    b_vec = malloc(sizeof(double) * num_samples);
+    f_vec = (double *)LINNE_AllocateMemory(sizeof(double) * num_samples);
+    b_vec = (double *)LINNE_AllocateMemory(sizeof(double) * num_samples);
 
     /* 各ベクトル初期化 */
     for (k = 0; k < coef_order + 1; k++) {
@@ -791,8 +792,8 @@ static LPCError LPC_CalculateCoefBurg(
     /* 係数コピー */
     memcpy(lpcc->lpc_coef, &a_vec[1], sizeof(double) * coef_order);
 
-    free(b_vec);
-    free(f_vec);
+    LINNE_FreeMemory(b_vec);
+    LINNE_FreeMemory(f_vec);
 #endif
     return LPC_ERROR_OK;
 }
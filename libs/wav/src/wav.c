@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include "linne_internal.h"
 
 /* パーサの読み込みバッファサイズ */
 #define WAVBITBUFFER_BUFFER_SIZE         (10 * 1024)
@@ -358,24 +359,29 @@ struct WAVFile* WAV_Create(const struct WAVFileFormat* format)
     }
 
     /* ハンドル作成 */
-    wavfile = (struct WAVFile *)malloc(sizeof(struct WAVFile));
+    wavfile = (struct WAVFile *)LINNE_AllocateMemory(sizeof(struct WAVFile));
     if (wavfile == NULL) {
-        goto EXIT_FAILURE_WITH_DATA_RELEASE;
+        return NULL;
     }
 
     /* 構造体コピーによりフォーマット情報取得 */
     wavfile->format = (*format);
 
     /* データ領域の割り当て */
-    wavfile->data = (WAVPcmData **)malloc(sizeof(WAVPcmData *) * format->num_channels);
+    /* 途中で失敗しても破棄できるよう、チャンネル毎のポインタはNULLで埋めておく */
+    wavfile->data = (WAVPcmData **)LINNE_AllocateMemory(sizeof(WAVPcmData *) * format->num_channels);
     if (wavfile->data == NULL) {
         goto EXIT_FAILURE_WITH_DATA_RELEASE;
     }
     for (ch = 0; ch < format->num_channels; ch++) {
-        wavfile->data[ch] = (WAVPcmData *)calloc(format->num_samples, sizeof(WAVPcmData));
+        wavfile->data[ch] = NULL;
+    }
+    for (ch = 0; ch < format->num_channels; ch++) {
+        wavfile->data[ch] = (WAVPcmData *)LINNE_AllocateMemory(sizeof(WAVPcmData) * format->num_samples);
         if (wavfile->data[ch] == NULL) {
             goto EXIT_FAILURE_WITH_DATA_RELEASE;
         }
+        memset(wavfile->data[ch], 0, sizeof(WAVPcmData) * format->num_samples);
     }
 
     return wavfile;
@@ -503,17 +509,19 @@ void WAV_Destroy(struct WAVFile* wavfile)
     /* NULLチェックして解放 */
 #define NULLCHECK_AND_FREE(ptr) { \
     if ((ptr) != NULL) {            \
-        free(ptr);                    \
+        LINNE_FreeMemory(ptr);        \
         ptr = NULL;                   \
     }                               \
 }
 
     if (wavfile != NULL) {
-        for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-            NULLCHECK_AND_FREE(wavfile->data[ch]);
+        if (wavfile->data != NULL) {
+            for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+                NULLCHECK_AND_FREE(wavfile->data[ch]);
+            }
         }
         NULLCHECK_AND_FREE(wavfile->data);
-        free(wavfile);
+        LINNE_FreeMemory(wavfile);
     }
 
 #undef NULLCHECK_AND_FREE
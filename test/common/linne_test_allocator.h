@@ -0,0 +1,53 @@
+#ifndef LINNE_TEST_ALLOCATOR_H_INCLUDED
+#define LINNE_TEST_ALLOCATOR_H_INCLUDED
+
+/* テスト共通: 確保/解放回数を数えるアロケータ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "linne.h"
+
+/* アロケータの状態 */
+struct LINNETestAllocatorContext {
+    uint32_t num_allocate;      /* 確保回数 */
+    uint32_t num_deallocate;    /* 解放回数 */
+    uint32_t max_num_allocate;  /* この回数を超えた確保は失敗させる */
+    size_t last_alignment;      /* 直前の確保で要求された境界 */
+};
+
+/* 回数を数える確保関数 */
+static void *LINNETestAllocator_Allocate(size_t size, size_t alignment, void *context)
+{
+    struct LINNETestAllocatorContext *ctx = (struct LINNETestAllocatorContext *)context;
+    if (ctx->num_allocate >= ctx->max_num_allocate) {
+        return NULL;
+    }
+    ctx->num_allocate++;
+    ctx->last_alignment = alignment;
+    return malloc(size);
+}
+
+/* 回数を数える解放関数 */
+static void LINNETestAllocator_Deallocate(void *ptr, void *context)
+{
+    struct LINNETestAllocatorContext *ctx = (struct LINNETestAllocatorContext *)context;
+    ctx->num_deallocate++;
+    free(ptr);
+}
+
+/* 回数を数えるアロケータを設定 max_num_allocate回を超えた確保は失敗させる
+* 使い終わったらLINNE_SetAllocator(NULL)で標準に戻すこと */
+static void LINNETestAllocator_Install(struct LINNETestAllocatorContext *context, uint32_t max_num_allocate)
+{
+    struct LINNEAllocator allocator;
+
+    memset(context, 0, sizeof(struct LINNETestAllocatorContext));
+    context->max_num_allocate = max_num_allocate;
+
+    allocator.allocate = LINNETestAllocator_Allocate;
+    allocator.deallocate = LINNETestAllocator_Deallocate;
+    allocator.context = context;
+    (void)LINNE_SetAllocator(&allocator);
+}
+
+#endif /* LINNE_TEST_ALLOCATOR_H_INCLUDED */
@@ -303,6 +303,53 @@ TEST(LINNECoderTest, RecursiveRiceTest)
     }
 }
 
+/* 符号長計算テスト */
+TEST(LINNECoderTest, CalculateCodeLengthTest)
+{
+    /* 符号化したビット数と一致するか */
+    {
+#define TEST_NUM_SAMPLES (1024)
+        uint32_t i, j, bits;
+        int32_t bitsize;
+        struct LINNECoder *coder;
+        struct BitStream strm;
+        int32_t test_pattern[TEST_NUM_SAMPLES];
+        uint8_t data[TEST_NUM_SAMPLES * 8];
+
+        coder = LINNECoder_Create(NULL, 0);
+        ASSERT_TRUE(coder != NULL);
+
+        srand(0);
+        for (j = 0; j < 4; j++) {
+            /* 振幅を変えて信号を生成 */
+            for (i = 0; i < TEST_NUM_SAMPLES; i++) {
+                switch (j) {
+                case 0: test_pattern[i] = 0; break;
+                case 1: test_pattern[i] = (rand() % 0x10) - 0x8; break;
+                case 2: test_pattern[i] = (rand() % 0x10000) - 0x8000; break;
+                default:
+                    /* 前半と後半で振幅を大きく変える */
+                    test_pattern[i] = (i < TEST_NUM_SAMPLES / 2) ? ((rand() % 4) - 2) : ((rand() % 0x1000) - 0x800);
+                    break;
+                }
+            }
+
+            /* 符号化 */
+            BitWriter_Open(&strm, data, sizeof(data));
+            LINNECoder_Encode(coder, &strm, test_pattern, TEST_NUM_SAMPLES);
+            BitStream_Tell(&strm, &bitsize);
+            /* 書き出し済みのバイト + バッファに残っているビット */
+            bits = (uint32_t)bitsize * 8 + (8 - strm.bit_count);
+            BitStream_Close(&strm);
+
+            EXPECT_EQ(bits, LINNECoder_CalculateCodeLength(coder, test_pattern, TEST_NUM_SAMPLES));
+        }
+
+        LINNECoder_Destroy(coder);
+#undef TEST_NUM_SAMPLES
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <math.h>
 #include <string.h>
 
 #include <gtest/gtest.h>
@@ -22,6 +23,8 @@ extern "C" {
         header__p->num_samples              = 8192;\
         header__p->num_samples_per_block    = 1024;\
         header__p->preset                   = 0;\
+        header__p->enable_block_preset      = 0;\
+        header__p->num_custom_layers        = 0;\
         header__p->ch_process_method        = LINNE_CH_PROCESS_METHOD_NONE;\
     } while (0);
 
@@ -36,6 +39,17 @@ extern "C" {
         param__p->num_samples_per_block = header__p->num_samples_per_block;\
         param__p->preset = header__p->preset;\
         param__p->ch_process_method = header__p->ch_process_method;\
+        param__p->enable_learning = 0;\
+        param__p->min_num_samples_per_block = 0;\
+        param__p->block_size_search_budget = 0;\
+        param__p->target_realtime_factor = 0;\
+        param__p->num_custom_layers = header__p->num_custom_layers;\
+        memcpy(param__p->custom_num_params_list, header__p->custom_num_params_list, sizeof(header__p->custom_num_params_list));\
+        param__p->enable_block_preset = header__p->enable_block_preset;\
+        param__p->enable_parameter_reuse = 0;\
+        param__p->num_lookback_samples = 0;\
+        param__p->enable_delta_parameters = 0;\
+        param__p->keyframe_interval = 0;\
     } while (0);
 
 /* 有効なエンコードパラメータをセット */
@@ -48,6 +62,16 @@ extern "C" {
         param__p->num_samples_per_block = 1024;\
         param__p->preset                = 0;\
         param__p->ch_process_method     = LINNE_CH_PROCESS_METHOD_NONE;\
+        param__p->enable_learning       = 0;\
+        param__p->min_num_samples_per_block = 0;\
+        param__p->block_size_search_budget = 0;\
+        param__p->target_realtime_factor = 0;\
+        param__p->num_custom_layers = 0;\
+        param__p->enable_block_preset = 0;\
+        param__p->enable_parameter_reuse = 0;\
+        param__p->num_lookback_samples = 0;\
+        param__p->enable_delta_parameters = 0;\
+        param__p->keyframe_interval = 0;\
     } while (0);
 
 /* 有効なエンコーダコンフィグをセット */
@@ -58,6 +82,8 @@ extern "C" {
         config__p->max_num_samples_per_block    = 8192;\
         config__p->max_num_layers               = 4;\
         config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_lookback_samples     = 4096;\
+        config__p->enable_delta_parameters      = 1;\
     } while (0);
 
 /* 有効なデコーダコンフィグをセット */
@@ -94,6 +120,67 @@ TEST(LINNEDecoderTest, DecodeHeaderTest)
         EXPECT_EQ(header.num_samples_per_block, tmp_header.num_samples_per_block);
         EXPECT_EQ(header.preset, tmp_header.preset);
         EXPECT_EQ(header.ch_process_method, tmp_header.ch_process_method);
+        EXPECT_EQ(header.enable_block_preset, tmp_header.enable_block_preset);
+    }
+
+    /* ブロック毎プリセット切り替えフラグ付きヘッダのエンコード->デコード */
+    {
+        uint8_t data[LINNE_HEADER_SIZE] = { 0, };
+        struct LINNEHeader header, tmp_header;
+
+        LINNE_SetValidHeader(&header);
+        header.preset = LINNE_NUM_PARAMETER_PRESETS - 1;
+        header.enable_block_preset = 1;
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        EXPECT_EQ(header.preset, tmp_header.preset);
+        EXPECT_EQ(1, tmp_header.enable_block_preset);
+    }
+
+    /* 独自レイヤー構造付きヘッダのエンコード->デコード */
+    {
+        uint8_t data[LINNE_MAX_HEADER_SIZE] = { 0, };
+        struct LINNEHeader header, tmp_header;
+        uint32_t l;
+
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = LINNE_MAX_NUM_CUSTOM_LAYERS;
+        for (l = 0; l < LINNE_MAX_NUM_CUSTOM_LAYERS; l++) {
+            header.custom_num_params_list[l] = LINNE_NETWORK_MAX_PARAMS_PER_LAYER >> l;
+        }
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        EXPECT_EQ(header.preset, tmp_header.preset);
+        EXPECT_EQ(0, tmp_header.enable_block_preset);
+        EXPECT_EQ(header.num_custom_layers, tmp_header.num_custom_layers);
+        for (l = 0; l < LINNE_MAX_NUM_CUSTOM_LAYERS; l++) {
+            EXPECT_EQ(header.custom_num_params_list[l], tmp_header.custom_num_params_list[l]);
+        }
+        EXPECT_EQ(LINNE_ERROR_OK, LINNEDecoder_CheckHeaderFormat(&tmp_header));
+
+        /* 拡張部が足りない */
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA, LINNEDecoder_DecodeHeader(data, LINNE_HEADER_SIZE, &tmp_header));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA, LINNEDecoder_DecodeHeader(data, sizeof(data) - 1, &tmp_header));
+
+        /* 異常なレイヤー数 */
+        data[LINNE_HEADER_SIZE] = 0;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        data[LINNE_HEADER_SIZE] = LINNE_MAX_NUM_CUSTOM_LAYERS + 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+
+        /* 異常なパラメータ数 */
+        data[LINNE_HEADER_SIZE] = LINNE_MAX_NUM_CUSTOM_LAYERS;
+        data[LINNE_HEADER_SIZE + 1] = 0;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&tmp_header));
+
+        /* ブロック毎のプリセット切り替えとの併用 */
+        data[LINNE_HEADER_SIZE + 1] = 16;
+        data[28] |= LINNE_HEADER_BLOCK_PRESET_FLAG;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, sizeof(data), &tmp_header));
+        EXPECT_EQ(LINNE_ERROR_INVALID_FORMAT, LINNEDecoder_CheckHeaderFormat(&tmp_header));
     }
 
     /* ヘッダデコード失敗ケース */
@@ -246,12 +333,11 @@ TEST(LINNEDecoderTest, CreateDestroyHandleTest)
         EXPECT_FALSE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN));
         EXPECT_FALSE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
         EXPECT_TRUE(decoder->params_int != NULL);
-        EXPECT_TRUE(decoder->params_int[0] != NULL);
-        EXPECT_TRUE(decoder->params_int[0][0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->params_int % LINNE_CACHE_LINE_SIZE);
         EXPECT_TRUE(decoder->num_units != NULL);
-        EXPECT_TRUE(decoder->num_units[0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->num_units % LINNE_CACHE_LINE_SIZE);
         EXPECT_TRUE(decoder->rshifts != NULL);
-        EXPECT_TRUE(decoder->rshifts[0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->rshifts % LINNE_CACHE_LINE_SIZE);
 
         LINNEDecoder_Destroy(decoder);
         free(work);
@@ -270,12 +356,11 @@ TEST(LINNEDecoderTest, CreateDestroyHandleTest)
         EXPECT_TRUE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN));
         EXPECT_FALSE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
         EXPECT_TRUE(decoder->params_int != NULL);
-        EXPECT_TRUE(decoder->params_int[0] != NULL);
-        EXPECT_TRUE(decoder->params_int[0][0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->params_int % LINNE_CACHE_LINE_SIZE);
         EXPECT_TRUE(decoder->num_units != NULL);
-        EXPECT_TRUE(decoder->num_units[0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->num_units % LINNE_CACHE_LINE_SIZE);
         EXPECT_TRUE(decoder->rshifts != NULL);
-        EXPECT_TRUE(decoder->rshifts[0] != NULL);
+        EXPECT_EQ(0U, (uintptr_t)decoder->rshifts % LINNE_CACHE_LINE_SIZE);
 
         LINNEDecoder_Destroy(decoder);
     }
@@ -578,3 +663,1464 @@ TEST(LINNEDecoderTest, DecodeBlockTest)
         LINNEEncoder_Destroy(encoder);
     }
 }
+
+/* ブロックサイズ（先頭から2byte目のビッグエンディアン32bit）に合わせてブロックのCRC16を付け直す */
+static void LINNEDecoderTest_UpdateBlockCRC16(uint8_t *block)
+{
+    uint16_t crc16;
+    const uint32_t block_size = ((uint32_t)block[2] << 24) | ((uint32_t)block[3] << 16)
+        | ((uint32_t)block[4] << 8) | (uint32_t)block[5];
+
+    /* CRC16自体の領域は外すために-2 */
+    crc16 = LINNEUtility_CalculateCRC16(&block[8], block_size - 2);
+    block[6] = (uint8_t)(crc16 >> 8);
+    block[7] = (uint8_t)(crc16 & 0xFF);
+}
+
+/* ブロックサイズを書き換えてCRC16を付け直す */
+static void LINNEDecoderTest_SetBlockSize(uint8_t *block, uint32_t block_size)
+{
+    block[2] = (uint8_t)((block_size >> 24) & 0xFF);
+    block[3] = (uint8_t)((block_size >> 16) & 0xFF);
+    block[4] = (uint8_t)((block_size >>  8) & 0xFF);
+    block[5] = (uint8_t)((block_size >>  0) & 0xFF);
+    LINNEDecoderTest_UpdateBlockCRC16(block);
+}
+
+/* 定数ブロック・無効ビットのデコードテスト */
+TEST(LINNEDecoderTest, DecodeConstantAndWastedBitsBlockTest)
+{
+    /* 定数ブロックをエンコードデコードしてみる */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEHeader header, tmp_header;
+        struct LINNEDecodeBlockRequest request;
+        uint8_t *data;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        int32_t *output[LINNE_MAX_NUM_CHANNELS];
+        uint32_t ch, smpl, sufficient_size, output_size, decode_output_size, out_num_samples;
+
+        LINNE_SetValidHeader(&header);
+        header.num_channels = 2;
+        header.num_samples = header.num_samples_per_block;
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * header.num_channels * header.num_samples_per_block * header.bits_per_sample) / 8;
+
+        /* データ領域確保 */
+        data = (uint8_t *)malloc(sufficient_size);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+            output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+        }
+
+        /* エンコーダデコーダ作成 */
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+
+        /* チャンネル毎に異なる定数をセット */
+        for (smpl = 0; smpl < header.num_samples_per_block; smpl++) {
+            input[0][smpl] = 1234;
+            input[1][smpl] = -5678;
+        }
+
+        /* 入力データをエンコード */
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+
+        /* 定数ブロックになり、データ部はチャンネル毎に1サンプル分だけ */
+        EXPECT_EQ(LINNE_BLOCK_DATA_TYPE_CONSTANT, data[LINNE_HEADER_SIZE + 8]);
+        EXPECT_EQ(LINNE_HEADER_SIZE + LINNE_BLOCK_HEADER_SIZE + (header.num_channels * header.bits_per_sample + 7) / 8, output_size);
+
+        /* デコード */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, output_size, &tmp_header));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &tmp_header));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_DecodeBlock(decoder, data + LINNE_HEADER_SIZE, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, tmp_header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* 出力チェック */
+        EXPECT_EQ(output_size - LINNE_HEADER_SIZE, decode_output_size);
+        EXPECT_EQ(header.num_samples_per_block, out_num_samples);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples_per_block));
+        }
+
+        /* 一括デコードでも元に戻るか */
+        for (ch = 0; ch < header.num_channels; ch++) {
+            memset(output[ch], 0, sizeof(int32_t) * header.num_samples_per_block);
+        }
+        request.header = &tmp_header;
+        request.data = data + LINNE_HEADER_SIZE;
+        request.data_size = output_size - LINNE_HEADER_SIZE;
+        request.buffer = output;
+        request.buffer_num_channels = header.num_channels;
+        request.buffer_num_samples = header.num_samples_per_block;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeBlocks(decoder, &request, 1));
+        EXPECT_EQ(LINNE_APIRESULT_OK, request.result);
+        EXPECT_EQ(output_size - LINNE_HEADER_SIZE, request.decode_size);
+        EXPECT_EQ(header.num_samples_per_block, request.num_decode_samples);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples_per_block));
+        }
+
+        /* 領域の開放 */
+        for (ch = 0; ch < header.num_channels; ch++) {
+            free(output[ch]);
+            free(input[ch]);
+        }
+        free(data);
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* サンプル数やデータ部が食い違った定数ブロック */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEHeader header, tmp_header;
+        struct LINNEDecodeBlockRequest request;
+        uint8_t *data, *block;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        int32_t *output[LINNE_MAX_NUM_CHANNELS];
+        uint32_t ch, smpl, sufficient_size, output_size, block_size, decode_output_size, out_num_samples;
+
+        LINNE_SetValidHeader(&header);
+        header.num_channels = 2;
+        header.num_samples = header.num_samples_per_block;
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * header.num_channels * header.num_samples_per_block * header.bits_per_sample) / 8;
+
+        /* データ領域確保 サンプル数が多すぎるブロックでバッファ不足にならないよう出力は大きめに取る */
+        data = (uint8_t *)malloc(sufficient_size);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+            output[ch] = (int32_t *)malloc(sizeof(int32_t) * 2 * header.num_samples_per_block);
+        }
+
+        /* エンコーダデコーダ作成 */
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+
+        for (smpl = 0; smpl < header.num_samples_per_block; smpl++) {
+            input[0][smpl] = 1234;
+            input[1][smpl] = -5678;
+        }
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+
+        block = data + LINNE_HEADER_SIZE;
+
+        /* サンプル数0 */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        ASSERT_EQ(LINNE_BLOCK_DATA_TYPE_CONSTANT, block[8]);
+        block[9] = block[10] = 0;
+        LINNEDecoderTest_UpdateBlockCRC16(block);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, 2 * header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* ヘッダのブロックあたりサンプル数を超える */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        block[9] = (uint8_t)(((header.num_samples_per_block + 1) >> 8) & 0xFF);
+        block[10] = (uint8_t)((header.num_samples_per_block + 1) & 0xFF);
+        LINNEDecoderTest_UpdateBlockCRC16(block);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, 2 * header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* ブロックサイズがチャンネル分の値より短い（後続データがあっても読み込まない） */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        block_size = output_size - LINNE_HEADER_SIZE;
+        LINNEDecoderTest_SetBlockSize(block, block_size - 6 - 1);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, block_size,
+                    output, header.num_channels, header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* ブロックサイズがチャンネル分の値より長い */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        block_size = output_size - LINNE_HEADER_SIZE;
+        block[block_size] = 0;
+        LINNEDecoderTest_SetBlockSize(block, block_size - 6 + 1);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, block_size + 1,
+                    output, header.num_channels, header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* 一括デコードでも同じ結果になるか */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, output_size, &tmp_header));
+        request.header = &tmp_header;
+        request.data = block;
+        request.data_size = block_size + 1;
+        request.buffer = output;
+        request.buffer_num_channels = header.num_channels;
+        request.buffer_num_samples = header.num_samples_per_block;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEDecoder_DecodeBlocks(decoder, &request, 1));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, request.result);
+
+        /* 領域の開放 */
+        for (ch = 0; ch < header.num_channels; ch++) {
+            free(output[ch]);
+            free(input[ch]);
+        }
+        free(data);
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* 下位の無効ビットを持つブロック */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEHeader header, tmp_header;
+        uint8_t *data, *block;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        int32_t *output[LINNE_MAX_NUM_CHANNELS];
+        uint32_t ch, smpl, sufficient_size, output_size, decode_output_size, out_num_samples;
+
+        LINNE_SetValidHeader(&header);
+        header.num_samples = header.num_samples_per_block;
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * header.num_channels * header.num_samples_per_block * header.bits_per_sample) / 8;
+
+        /* データ領域確保 */
+        data = (uint8_t *)malloc(sufficient_size);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+            output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+        }
+
+        /* エンコーダデコーダ作成 */
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+
+        /* 下位3bitが常に0の信号 */
+        srand(0);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            for (smpl = 0; smpl < header.num_samples_per_block; smpl++) {
+                input[ch][smpl] = (int32_t)(2000.0 * sin(0.01 * smpl) + ((rand() % 64) - 32)) * 8;
+            }
+        }
+
+        /* 入力データをエンコード */
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        block = data + LINNE_HEADER_SIZE;
+
+        /* 無効ビット付きの圧縮ブロックになり、先頭に無効ビット数3が記録される */
+        EXPECT_EQ(LINNE_BLOCK_DATA_TYPE_COMPRESSDATA | LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG,
+                block[8] & (LINNE_BLOCK_DATA_TYPE_COMPRESSDATA | LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG));
+        EXPECT_EQ(3, block[LINNE_BLOCK_HEADER_SIZE] >> (8 - LINNE_WASTED_BITS_BITWIDTH));
+
+        /* デコードして元に戻るか */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(data, output_size, &tmp_header));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &tmp_header));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_DecodeBlock(decoder, block, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, tmp_header.num_samples_per_block, &decode_output_size, &out_num_samples));
+        EXPECT_EQ(output_size - LINNE_HEADER_SIZE, decode_output_size);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples_per_block));
+        }
+
+        /* 無効ビット数をサンプルのビット幅にする: 不正なフォーマット */
+        block[LINNE_BLOCK_HEADER_SIZE] = (uint8_t)((block[LINNE_BLOCK_HEADER_SIZE] & ((1 << (8 - LINNE_WASTED_BITS_BITWIDTH)) - 1))
+                | (header.bits_per_sample << (8 - LINNE_WASTED_BITS_BITWIDTH)));
+        LINNEDecoderTest_UpdateBlockCRC16(block);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, tmp_header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* 圧縮データ以外に無効ビットのフラグが立っている: 不正なフォーマット */
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples_per_block, data, sufficient_size, &output_size));
+        block[8] = LINNE_BLOCK_DATA_TYPE_RAWDATA | LINNE_BLOCK_DATA_TYPE_WASTED_BITS_FLAG;
+        LINNEDecoderTest_UpdateBlockCRC16(block);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_DecodeBlock(decoder, block, output_size - LINNE_HEADER_SIZE,
+                    output, header.num_channels, tmp_header.num_samples_per_block, &decode_output_size, &out_num_samples));
+
+        /* 領域の開放 */
+        for (ch = 0; ch < header.num_channels; ch++) {
+            free(output[ch]);
+            free(input[ch]);
+        }
+        free(data);
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* ブロック情報取得・CRC検査テスト */
+TEST(LINNEDecoderTest, CheckBlocksTest)
+{
+    /* 複数ブロックのデータを作成し1ブロックだけ破壊 */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEHeader header;
+        struct LINNEBlockInfo block_info[16];
+        uint8_t *data;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint32_t ch, smpl, blk, sufficient_size, output_size, num_blocks;
+
+        LINNE_SetValidHeader(&header);
+        LINNEEncoder_SetValidConfig(&encoder_config);
+
+        /* 十分なデータサイズ */
+        sufficient_size = (2 * header.num_channels * header.num_samples * header.bits_per_sample) / 8;
+
+        /* データ領域確保 */
+        data = (uint8_t *)malloc(sufficient_size);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+            srand(0);
+            for (smpl = 0; smpl < header.num_samples; smpl++) {
+                input[ch][smpl] = (rand() % 2048) - 1024;
+            }
+        }
+
+        /* エンコード */
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input, header.num_samples, data, sufficient_size, &output_size));
+
+        /* ブロック数のみ取得 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_GetBlockInfo(data, output_size, NULL, 0, &num_blocks));
+        EXPECT_EQ(header.num_samples / header.num_samples_per_block, num_blocks);
+
+        /* 不正な引数 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_GetBlockInfo(NULL, output_size, block_info, 16, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_GetBlockInfo(data, output_size, block_info, 16, NULL));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_GetBlockInfo(data, output_size, block_info, 1, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA, LINNEDecoder_GetBlockInfo(data, output_size - 1, block_info, 16, &num_blocks));
+
+        /* ブロック情報取得 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_GetBlockInfo(data, output_size, block_info, 16, &num_blocks));
+        EXPECT_EQ((uint32_t)LINNE_HEADER_SIZE, block_info[0].data_offset);
+        for (blk = 0; blk < num_blocks; blk++) {
+            EXPECT_EQ(blk * header.num_samples_per_block, block_info[blk].sample_offset);
+            EXPECT_EQ(header.num_samples_per_block, block_info[blk].num_samples);
+            if (blk > 0) {
+                EXPECT_EQ(block_info[blk - 1].data_offset + block_info[blk - 1].data_size, block_info[blk].data_offset);
+            }
+        }
+        EXPECT_EQ(output_size, block_info[num_blocks - 1].data_offset + block_info[num_blocks - 1].data_size);
+
+        /* 破壊前は全て正常 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_CheckBlocks(data, output_size, block_info, num_blocks));
+        for (blk = 0; blk < num_blocks; blk++) {
+            EXPECT_EQ(0, block_info[blk].corrupted);
+        }
+
+        /* 3番目のブロック（インデックス2）のデータ部を破壊 */
+        data[block_info[2].data_offset + block_info[2].data_size / 2] ^= 0xFF;
+        EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION, LINNEDecoder_CheckBlocks(data, output_size, block_info, num_blocks));
+        for (blk = 0; blk < num_blocks; blk++) {
+            EXPECT_EQ((blk == 2) ? 1 : 0, block_info[blk].corrupted);
+        }
+
+        /* 範囲を分けて検査しても同じ結果 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_CheckBlocks(data, output_size, &block_info[0], 2));
+        EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION, LINNEDecoder_CheckBlocks(data, output_size, &block_info[2], num_blocks - 2));
+
+        /* 不正な引数 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_CheckBlocks(NULL, output_size, block_info, num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_CheckBlocks(data, output_size, NULL, num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_CheckBlocks(data, output_size - 1, block_info, num_blocks));
+
+        /* 領域の開放 */
+        for (ch = 0; ch < header.num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* 破損後の再同期テスト */
+TEST(LINNEDecoderTest, FindNextBlockTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEDecoder *decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    struct LINNEBlockInfo block_info[16];
+    uint8_t *data;
+    int32_t *input[LINNE_MAX_NUM_CHANNELS];
+    int32_t *output[LINNE_MAX_NUM_CHANNELS];
+    uint32_t ch, smpl, sufficient_size, output_size, num_blocks, offset, decode_size, num_decode_samples;
+
+    LINNE_SetValidHeader(&header);
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+
+    /* 十分なデータサイズ */
+    sufficient_size = (2 * header.num_channels * header.num_samples * header.bits_per_sample) / 8;
+
+    /* データ領域確保 */
+    data = (uint8_t *)malloc(sufficient_size);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+        srand(0);
+        for (smpl = 0; smpl < header.num_samples; smpl++) {
+            input[ch][smpl] = (rand() % 2048) - 1024;
+        }
+    }
+
+    /* エンコード */
+    encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    ASSERT_TRUE(decoder != NULL);
+    LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EncodeWhole(encoder, input, header.num_samples, data, sufficient_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_GetBlockInfo(data, output_size, block_info, 16, &num_blocks));
+    ASSERT_TRUE(num_blocks >= 4);
+
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_FindNextBlock(NULL, data, output_size, &offset));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_FindNextBlock(decoder, NULL, output_size, &offset));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_FindNextBlock(decoder, data, output_size, NULL));
+
+    /* ヘッダセット前 */
+    EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET, LINNEDecoder_FindNextBlock(decoder, data, output_size, &offset));
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+
+    /* 正常なブロック先頭からはそのブロックを返す */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_FindNextBlock(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &offset));
+    EXPECT_EQ(0, offset);
+
+    /* ブロック情報の取得 */
+    {
+        struct LINNEBlockInfo info;
+
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_PeekBlockInfo(NULL, data, output_size, &info));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_PeekBlockInfo(decoder, NULL, output_size, &info));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_PeekBlockInfo(decoder, data, output_size, NULL));
+
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_PeekBlockInfo(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &info));
+        EXPECT_EQ(block_info[1].data_size, info.data_size);
+        EXPECT_EQ(block_info[1].num_samples, info.num_samples);
+        EXPECT_EQ(0, info.corrupted);
+
+        /* 同期コードでない位置 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+                LINNEDecoder_PeekBlockInfo(decoder, &data[block_info[1].data_offset + 1], output_size - block_info[1].data_offset - 1, &info));
+        /* ブロックが途中で切れている */
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+                LINNEDecoder_PeekBlockInfo(decoder, &data[block_info[1].data_offset], block_info[1].data_size - 1, &info));
+    }
+
+    /* ブロック1のデータ部を破壊し、ブロック1の途中から探索すると次のブロックが見つかる */
+    data[block_info[1].data_offset + block_info[1].data_size / 2] ^= 0xFF;
+    EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION,
+            LINNEDecoder_DecodeBlock(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset,
+                output, header.num_channels, header.num_samples_per_block, &decode_size, &num_decode_samples));
+    /* 破損ブロックもヘッダが壊れていなければサイズとサンプル数は取得できる */
+    {
+        struct LINNEBlockInfo info;
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_PeekBlockInfo(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &info));
+        EXPECT_EQ(block_info[1].data_size, info.data_size);
+        EXPECT_EQ(block_info[1].num_samples, info.num_samples);
+        EXPECT_EQ(1, info.corrupted);
+    }
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_FindNextBlock(decoder, &data[block_info[1].data_offset + 1], output_size - block_info[1].data_offset - 1, &offset));
+    EXPECT_EQ(block_info[2].data_offset, block_info[1].data_offset + 1 + offset);
+
+    /* 破損ブロックの先頭からでも破損ブロックは返さない */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_FindNextBlock(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &offset));
+    EXPECT_EQ(block_info[2].data_offset, block_info[1].data_offset + offset);
+
+    /* ブロック2の同期コードを破壊するとブロック3まで進む */
+    data[block_info[2].data_offset] = 0;
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_FindNextBlock(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &offset));
+    EXPECT_EQ(block_info[3].data_offset, block_info[1].data_offset + offset);
+
+    /* ブロック2の同期コードを戻し、ブロックサイズを不正な値にしても範囲外を読まずにブロック3まで進む */
+    {
+        uint32_t i;
+        /* ブロックヘッダに満たないサイズは不正、データ末尾を超えるサイズはデータ不足 */
+        const struct {
+            uint32_t block_size;
+            LINNEApiResult result;
+        } invalid_block_sizes[] = {
+            { 0,             LINNE_APIRESULT_INVALID_FORMAT },
+            { 1,             LINNE_APIRESULT_INVALID_FORMAT },
+            { 0xFFFFFFFFUL,  LINNE_APIRESULT_INSUFFICIENT_DATA },
+        };
+        uint8_t *block = &data[block_info[2].data_offset];
+        struct LINNEBlockInfo info;
+
+        block[0] = (LINNE_BLOCK_SYNC_CODE >> 8) & 0xFF;
+        block[1] = LINNE_BLOCK_SYNC_CODE & 0xFF;
+        for (i = 0; i < sizeof(invalid_block_sizes) / sizeof(invalid_block_sizes[0]); i++) {
+            block[2] = (uint8_t)((invalid_block_sizes[i].block_size >> 24) & 0xFF);
+            block[3] = (uint8_t)((invalid_block_sizes[i].block_size >> 16) & 0xFF);
+            block[4] = (uint8_t)((invalid_block_sizes[i].block_size >>  8) & 0xFF);
+            block[5] = (uint8_t)((invalid_block_sizes[i].block_size >>  0) & 0xFF);
+            EXPECT_EQ(invalid_block_sizes[i].result,
+                    LINNEDecoder_PeekBlockInfo(decoder, block, output_size - block_info[2].data_offset, &info));
+            EXPECT_EQ(invalid_block_sizes[i].result,
+                    LINNEDecoder_DecodeBlock(decoder, block, output_size - block_info[2].data_offset,
+                        output, header.num_channels, header.num_samples_per_block, &decode_size, &num_decode_samples));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_FindNextBlock(decoder, &data[block_info[1].data_offset], output_size - block_info[1].data_offset, &offset));
+            EXPECT_EQ(block_info[3].data_offset, block_info[1].data_offset + offset);
+        }
+    }
+
+    /* 見つかったブロックは正しくデコードできる */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeBlock(decoder, &data[block_info[3].data_offset], output_size - block_info[3].data_offset,
+                output, header.num_channels, header.num_samples_per_block, &decode_size, &num_decode_samples));
+    EXPECT_EQ(header.num_samples_per_block, num_decode_samples);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        EXPECT_EQ(0, memcmp(&input[ch][block_info[3].sample_offset], output[ch], sizeof(int32_t) * num_decode_samples));
+    }
+
+    /* 最終ブロックが途中で切れている場合は見つからない */
+    EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+            LINNEDecoder_FindNextBlock(decoder, &data[block_info[num_blocks - 1].data_offset], block_info[num_blocks - 1].data_size - 1, &offset));
+
+    /* 領域の開放 */
+    for (ch = 0; ch < header.num_channels; ch++) {
+        free(output[ch]);
+        free(input[ch]);
+    }
+    free(data);
+    LINNEDecoder_Destroy(decoder);
+    LINNEEncoder_Destroy(encoder);
+}
+
+/* 最小コンフィグ計算テスト */
+TEST(LINNEDecoderTest, CalculateMinimumConfigTest)
+{
+    /* 全プリセットで最小コンフィグのハンドルにヘッダがセットできる */
+    {
+        uint32_t i, l;
+        struct LINNEDecoder *decoder;
+        struct LINNEDecoderConfig config, max_config;
+        struct LINNEHeader header;
+
+        LINNEDecoder_SetValidConfig(&max_config);
+        for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+            const struct LINNEParameterPreset *preset = &g_linne_parameter_preset[i];
+            LINNE_SetValidHeader(&header);
+            header.preset = (uint8_t)i;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_CalculateMinimumConfig(&header, &config));
+            EXPECT_EQ(header.num_channels, config.max_num_channels);
+            EXPECT_EQ(preset->num_layers, config.max_num_layers);
+            for (l = 0; l < preset->num_layers; l++) {
+                EXPECT_TRUE(preset->num_params_list[l] <= config.max_num_parameters_per_layer);
+            }
+            EXPECT_EQ(1, config.check_crc);
+            EXPECT_EQ(LINNEDecoder_CalculateWorkSize(&config), LINNEDecoder_CalculateWorkSizeFromHeader(&header));
+            EXPECT_TRUE(LINNEDecoder_CalculateWorkSizeFromHeader(&header) < LINNEDecoder_CalculateWorkSize(&max_config));
+
+            decoder = LINNEDecoder_Create(&config, NULL, 0);
+            ASSERT_TRUE(decoder != NULL);
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+
+            /* 容量を超えるヘッダはセットできない */
+            header.num_channels++;
+            EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_SetHeader(decoder, &header));
+
+            LINNEDecoder_Destroy(decoder);
+        }
+    }
+
+    /* 失敗ケース */
+    {
+        struct LINNEDecoderConfig config;
+        struct LINNEHeader header;
+
+        LINNE_SetValidHeader(&header);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_CalculateMinimumConfig(NULL, &config));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_CalculateMinimumConfig(&header, NULL));
+        EXPECT_TRUE(LINNEDecoder_CalculateWorkSizeFromHeader(NULL) < 0);
+
+        header.preset = LINNE_NUM_PARAMETER_PRESETS;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEDecoder_CalculateMinimumConfig(&header, &config));
+        EXPECT_TRUE(LINNEDecoder_CalculateWorkSizeFromHeader(&header) < 0);
+    }
+
+    /* 独自レイヤー構造の最小コンフィグ */
+    {
+        struct LINNEDecoder *decoder;
+        struct LINNEDecoderConfig config;
+        struct LINNEHeader header;
+
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = 4;
+        header.custom_num_params_list[0] = 32;
+        header.custom_num_params_list[1] = 16;
+        header.custom_num_params_list[2] = 8;
+        header.custom_num_params_list[3] = 4;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_CalculateMinimumConfig(&header, &config));
+        EXPECT_EQ(4U, config.max_num_layers);
+        EXPECT_EQ(32U, config.max_num_parameters_per_layer);
+
+        decoder = LINNEDecoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(decoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+        EXPECT_EQ(&decoder->custom_preset, decoder->parameter_preset);
+        EXPECT_EQ(decoder->header.custom_num_params_list, decoder->parameter_preset->num_params_list);
+
+        /* 容量を超える構造はセットできない */
+        header.num_custom_layers = 5;
+        header.custom_num_params_list[4] = 2;
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_SetHeader(decoder, &header));
+        header.num_custom_layers = 1;
+        header.custom_num_params_list[0] = 64;
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEDecoder_SetHeader(decoder, &header));
+
+        LINNEDecoder_Destroy(decoder);
+    }
+}
+
+/* 一括デコードテスト */
+TEST(LINNEDecoderTest, DecodeBlocksTest)
+{
+#define NUM_STREAMS 11
+    struct LINNEEncoder *encoder;
+    struct LINNEDecoder *decoder, *ref_decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header[NUM_STREAMS];
+    struct LINNEDecodeBlockRequest requests[NUM_STREAMS];
+    uint8_t *data[NUM_STREAMS];
+    int32_t *input[NUM_STREAMS][2];
+    int32_t *output[NUM_STREAMS][2];
+    int32_t *ref_output[2];
+    uint32_t s, ch, smpl, sufficient_size, output_size[NUM_STREAMS], ref_decode_size, ref_num_samples;
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+
+    encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ref_decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    ASSERT_TRUE(decoder != NULL);
+    ASSERT_TRUE(ref_decoder != NULL);
+
+    /* 1ブロックのストリームを作成: 6番目はステレオ, 3番目は無音, 8番目はプリセット違い,
+    * 9・10番目は独自レイヤー構造（10番目はプリセット0と同じ構造） */
+    srand(0);
+    for (s = 0; s < NUM_STREAMS; s++) {
+        LINNE_SetValidHeader(&header[s]);
+        header[s].num_samples = header[s].num_samples_per_block;
+        header[s].preset = 1;
+        if (s == 6) {
+            header[s].num_channels = 2;
+            header[s].ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+        }
+        if (s == 8) {
+            header[s].preset = 1;
+        }
+        if (s == 9) {
+            header[s].num_custom_layers = 2;
+            header[s].custom_num_params_list[0] = 16;
+            header[s].custom_num_params_list[1] = 8;
+        }
+        if (s == 10) {
+            header[s].num_custom_layers = 2;
+            header[s].custom_num_params_list[0] = 8;
+            header[s].custom_num_params_list[1] = 32;
+        }
+        sufficient_size = (2 * header[s].num_channels * header[s].num_samples * header[s].bits_per_sample) / 8;
+        data[s] = (uint8_t *)malloc(sufficient_size);
+        for (ch = 0; ch < header[s].num_channels; ch++) {
+            input[s][ch] = (int32_t *)malloc(sizeof(int32_t) * header[s].num_samples);
+            output[s][ch] = (int32_t *)malloc(sizeof(int32_t) * header[s].num_samples);
+            for (smpl = 0; smpl < header[s].num_samples; smpl++) {
+                input[s][ch][smpl] = (s == 3) ? 0 : (int32_t)(((rand() % 512) - 256) + 4096.0 * sin(0.01 * (s + 1) * smpl));
+            }
+        }
+        LINNEEncoder_ConvertHeaderToParameter(&header[s], &parameter);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input[s], header[s].num_samples, data[s], sufficient_size, &output_size[s]));
+
+        requests[s].header = &header[s];
+        requests[s].data = data[s] + LINNE_CALCULATE_HEADER_SIZE(&header[s]);
+        requests[s].data_size = output_size[s] - LINNE_CALCULATE_HEADER_SIZE(&header[s]);
+        requests[s].buffer = output[s];
+        requests[s].buffer_num_channels = header[s].num_channels;
+        requests[s].buffer_num_samples = header[s].num_samples;
+    }
+
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeBlocks(NULL, requests, NUM_STREAMS));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_DecodeBlocks(decoder, NULL, NUM_STREAMS));
+
+    /* 一括デコードで全て元に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeBlocks(decoder, requests, NUM_STREAMS));
+    for (s = 0; s < NUM_STREAMS; s++) {
+        EXPECT_EQ(LINNE_APIRESULT_OK, requests[s].result);
+        EXPECT_EQ(output_size[s] - LINNE_CALCULATE_HEADER_SIZE(&header[s]), requests[s].decode_size);
+        EXPECT_EQ(header[s].num_samples, requests[s].num_decode_samples);
+        for (ch = 0; ch < header[s].num_channels; ch++) {
+            EXPECT_EQ(0, memcmp(input[s][ch], output[s][ch], sizeof(int32_t) * header[s].num_samples));
+        }
+    }
+
+    /* ヘッダセットされていないハンドルはそのまま */
+    EXPECT_FALSE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
+
+    /* 1ブロック破壊しても他のブロックはデコードできる */
+    data[5][output_size[5] - 1] ^= 0xFF;
+    for (s = 0; s < NUM_STREAMS; s++) {
+        for (ch = 0; ch < header[s].num_channels; ch++) {
+            memset(output[s][ch], 0, sizeof(int32_t) * header[s].num_samples);
+        }
+    }
+    EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION, LINNEDecoder_DecodeBlocks(decoder, requests, NUM_STREAMS));
+    for (s = 0; s < NUM_STREAMS; s++) {
+        if (s == 5) {
+            EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION, requests[s].result);
+            continue;
+        }
+        EXPECT_EQ(LINNE_APIRESULT_OK, requests[s].result);
+        for (ch = 0; ch < header[s].num_channels; ch++) {
+            EXPECT_EQ(0, memcmp(input[s][ch], output[s][ch], sizeof(int32_t) * header[s].num_samples));
+        }
+    }
+
+    /* 単一ブロックデコードと一致するか */
+    ref_output[0] = (int32_t *)malloc(sizeof(int32_t) * header[6].num_samples);
+    ref_output[1] = (int32_t *)malloc(sizeof(int32_t) * header[6].num_samples);
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(ref_decoder, &header[6]));
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeBlock(ref_decoder, requests[6].data, requests[6].data_size,
+                ref_output, 2, header[6].num_samples, &ref_decode_size, &ref_num_samples));
+    EXPECT_EQ(ref_decode_size, requests[6].decode_size);
+    for (ch = 0; ch < 2; ch++) {
+        EXPECT_EQ(0, memcmp(ref_output[ch], output[6][ch], sizeof(int32_t) * header[6].num_samples));
+    }
+    free(ref_output[0]);
+    free(ref_output[1]);
+
+    /* 領域の開放 */
+    for (s = 0; s < NUM_STREAMS; s++) {
+        for (ch = 0; ch < header[s].num_channels; ch++) {
+            free(input[s][ch]);
+            free(output[s][ch]);
+        }
+        free(data[s]);
+    }
+    LINNEDecoder_Destroy(ref_decoder);
+    LINNEDecoder_Destroy(decoder);
+    LINNEEncoder_Destroy(encoder);
+#undef NUM_STREAMS
+}
+
+/* ビット深度の異なるストリームの一括デコードテスト */
+TEST(LINNEDecoderTest, DecodeBlocksMixedBitsTest)
+{
+#define NUM_STREAMS 4
+    struct LINNEEncoder *encoder;
+    struct LINNEDecoder *decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header[NUM_STREAMS];
+    struct LINNEDecodeBlockRequest requests[NUM_STREAMS];
+    uint8_t *data[NUM_STREAMS];
+    int32_t *input[NUM_STREAMS][1];
+    int32_t *output[NUM_STREAMS][1];
+    uint32_t s, smpl, sufficient_size, output_size;
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+
+    encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    ASSERT_TRUE(decoder != NULL);
+
+    /* 24bitと16bitのストリームを交互に並べる 最後のストリームを16bitにし、
+    * 24bitのレーンが16bitのヘッダで合成されないことを確かめる
+    * 24bitはフルスケール近くに偏った信号を学習ありで符号化し、32bitの積和が桁あふれするユニットを作る */
+    srand(0);
+    for (s = 0; s < NUM_STREAMS; s++) {
+        LINNE_SetValidHeader(&header[s]);
+        header[s].bits_per_sample = ((s % 2) == 0) ? 24 : 16;
+        header[s].num_samples = header[s].num_samples_per_block;
+        header[s].preset = 1;
+        sufficient_size = (2 * header[s].num_channels * header[s].num_samples * header[s].bits_per_sample) / 8;
+        data[s] = (uint8_t *)malloc(sufficient_size);
+        input[s][0] = (int32_t *)malloc(sizeof(int32_t) * header[s].num_samples);
+        output[s][0] = (int32_t *)malloc(sizeof(int32_t) * header[s].num_samples);
+        for (smpl = 0; smpl < header[s].num_samples; smpl++) {
+            if (header[s].bits_per_sample == 24) {
+                input[s][0][smpl] = (int32_t)(8300000.0 + 80000.0 * sin(0.02 * smpl));
+            } else {
+                input[s][0][smpl] = (int32_t)(((rand() % 64) - 32) + 12000.0 * sin(0.05 * (s + 1) * smpl));
+            }
+        }
+        LINNEEncoder_ConvertHeaderToParameter(&header[s], &parameter);
+        parameter.enable_learning = (header[s].bits_per_sample == 24) ? 1 : 0;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, input[s], header[s].num_samples,
+                    data[s], sufficient_size, &output_size));
+
+        requests[s].header = &header[s];
+        requests[s].data = data[s] + LINNE_CALCULATE_HEADER_SIZE(&header[s]);
+        requests[s].data_size = output_size - LINNE_CALCULATE_HEADER_SIZE(&header[s]);
+        requests[s].buffer = output[s];
+        requests[s].buffer_num_channels = header[s].num_channels;
+        requests[s].buffer_num_samples = header[s].num_samples;
+    }
+
+    /* 全て元に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeBlocks(decoder, requests, NUM_STREAMS));
+    for (s = 0; s < NUM_STREAMS; s++) {
+        EXPECT_EQ(LINNE_APIRESULT_OK, requests[s].result);
+        EXPECT_EQ(header[s].num_samples, requests[s].num_decode_samples);
+        EXPECT_EQ(0, memcmp(input[s][0], output[s][0], sizeof(int32_t) * header[s].num_samples));
+    }
+
+    for (s = 0; s < NUM_STREAMS; s++) {
+        free(input[s][0]);
+        free(output[s][0]);
+        free(data[s]);
+    }
+    LINNEDecoder_Destroy(decoder);
+    LINNEEncoder_Destroy(encoder);
+#undef NUM_STREAMS
+}
+
+/* フォーマットバージョン1（32bit積和で予測していた旧エンコーダ）のストリームのデコードテスト */
+TEST(LINNEDecoderTest, DecodeLegacyFormatVersionTest)
+{
+    /* 旧エンコーダで符号化した24bitフルスケールのステップ信号（プリセット1、学習あり）
+    * 予測の積和が32bitで桁あふれし、その巡回した値で残差が記録されている */
+    static const uint8_t legacy_data[] = {
+        0x49, 0x42, 0x52, 0x41, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+        0x00, 0x01, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0xBB, 0x80, 0x00, 0x18,
+        0x00, 0x00, 0x28, 0x00, 0x01, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0x01, 0x00,
+        0xE1, 0xEC, 0x00, 0x00, 0x80, 0x7F, 0xFD, 0x9F, 0xFA, 0x1F, 0xF5, 0xE7,
+        0xC1, 0x3C, 0xC0, 0x9E, 0x9D, 0x30, 0x02, 0x15, 0x28, 0x3F, 0x36, 0x05,
+        0x74, 0xE3, 0x43, 0x2B, 0x2F, 0x1B, 0x41, 0x5F, 0x45, 0x67, 0x31, 0x29,
+        0x33, 0x0F, 0x4B, 0x73, 0x39, 0x6D, 0x33, 0x29, 0x31, 0x11, 0x4B, 0x73,
+        0x39, 0x6D, 0x31, 0x29, 0x31, 0x11, 0x4B, 0x73, 0x39, 0x6D, 0x33, 0x27,
+        0x33, 0x0F, 0x4B, 0x73, 0x3B, 0x6B, 0x01, 0x08, 0x28, 0x2C, 0x9A, 0x9E,
+        0xEC, 0xFA, 0x67, 0x3B, 0x2F, 0x61, 0x35, 0x15, 0x2D, 0x31, 0x04, 0x04,
+        0x02, 0x04, 0x08, 0x02, 0x12, 0x24, 0x0A, 0x16, 0x0C, 0x3C, 0x42, 0x06,
+        0x74, 0x13, 0x8E, 0x02, 0xCC, 0x02, 0x0F, 0xA9, 0xE0, 0x00, 0x01, 0x11,
+        0xB5, 0x38, 0xAE, 0xBD, 0x0A, 0x89, 0x0E, 0x14, 0xD3, 0x4C, 0x77, 0xB7,
+        0x53, 0xB3, 0xB8, 0x7F, 0xB1, 0x0F, 0xBC, 0xCF, 0x02, 0xFF, 0x1B, 0x87,
+        0x0B, 0x02, 0xEE, 0x64, 0x9E, 0xAE, 0x87, 0x26, 0xBA, 0xF5, 0x58, 0xB4,
+        0xB1, 0x53, 0x30, 0xFE, 0xC5, 0xBD, 0xAA, 0x3B, 0x72, 0x20, 0x2C, 0x0D,
+        0x0B, 0x59, 0x21, 0x84, 0x2A, 0xB5, 0x5A, 0xAD, 0x56, 0xAB, 0x55, 0xAA,
+        0xD5, 0x6A, 0xB5, 0x5A, 0xAD, 0x56, 0xAB, 0x55, 0xAA, 0xD5, 0x6A, 0xB5,
+        0x40, 0xBC, 0xFF, 0xF6, 0x80, 0x80, 0xFF, 0xFA, 0x9F, 0x5D, 0x82, 0xE4,
+        0x19, 0x96, 0xF1, 0x2B, 0x59, 0x7B, 0x15, 0xEA, 0xF3, 0xC6, 0x8B, 0x18,
+        0x48, 0x7A, 0x6C, 0x8B, 0xB8, 0xB3, 0xCA, 0x8E, 0x47, 0xEA, 0xB6, 0x55,
+        0xBE, 0xE6, 0x48, 0x5C, 0x10, 0xBA, 0xA2, 0xD7, 0x2A, 0xFD, 0x01, 0x26,
+        0xB3, 0x53, 0x47, 0x25, 0x81, 0x72, 0x5A, 0x42, 0xF8, 0xD4, 0x30, 0x83,
+        0x1F, 0x07, 0xAA, 0x48, 0xB0, 0xAB, 0x47, 0x6C, 0x81, 0xF0, 0x3F, 0x34,
+        0x4D, 0x4D, 0x59, 0x80,
+    };
+    struct LINNEDecoder *decoder;
+    struct LINNEDecoderConfig config;
+    struct LINNEHeader header;
+    int32_t output_buffer[128];
+    int32_t *output[1];
+    uint32_t smpl;
+
+    LINNEDecoder_SetValidConfig(&config);
+    decoder = LINNEDecoder_Create(&config, NULL, 0);
+    ASSERT_TRUE(decoder != NULL);
+    output[0] = output_buffer;
+
+    /* 旧フォーマットのヘッダとして読める */
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_DecodeHeader(legacy_data, sizeof(legacy_data), &header));
+    EXPECT_EQ(LINNE_LAST_32BIT_ACCUMULATOR_FORMAT_VERSION, header.format_version);
+    EXPECT_EQ(24, header.bits_per_sample);
+    ASSERT_EQ(128, header.num_samples);
+
+    /* 旧デコーダと同じく32bit積和で合成し、元の信号に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeWhole(decoder, legacy_data, sizeof(legacy_data), output, 1, 128));
+    for (smpl = 0; smpl < 128; smpl++) {
+        EXPECT_EQ((smpl < 100) ? -8388000 : 8388000, output_buffer[smpl]);
+    }
+
+    LINNEDecoder_Destroy(decoder);
+}
+
+/* テスト用タスク実行コールバック: 実行順に依存しないことを確かめるため逆順に実行 */
+static void LINNEDecoderTest_RunTasksReverse(
+        LINNEDecoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data)
+{
+    uint32_t i;
+    uint32_t *num_executed_tasks = (uint32_t *)user_data;
+
+    for (i = num_tasks; i > 0; i--) {
+        task(task_context, i - 1);
+        (*num_executed_tasks)++;
+    }
+}
+
+/* タスク実行コールバックによるチャンネル並列合成テスト */
+TEST(LINNEDecoderTest, SetTaskCallbackTest)
+{
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_SetTaskCallback(NULL, NULL, NULL));
+
+    /* コールバックを使っても逐次処理と同じ結果になるか */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEDecoder *decoder;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEHeader header;
+        uint8_t *data;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS], *output[LINNE_MAX_NUM_CHANNELS];
+        uint32_t ch, smpl, trial, sufficient_size, output_size, num_executed_tasks;
+        const uint32_t nums_channels[] = { 1, 2, 6, 8 };
+        const uint8_t presets[] = { 0, 1, 3, 0 };
+
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+        encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(decoder != NULL);
+
+        srand(0);
+        for (trial = 0; trial < sizeof(nums_channels) / sizeof(nums_channels[0]); trial++) {
+            LINNE_SetValidHeader(&header);
+            header.num_channels = nums_channels[trial];
+            header.preset = presets[trial];
+            header.num_samples = 2 * header.num_samples_per_block;
+            if (header.num_channels == 2) {
+                header.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+            }
+            sufficient_size = (2 * header.num_channels * header.num_samples * header.bits_per_sample) / 8;
+            data = (uint8_t *)malloc(sufficient_size);
+            for (ch = 0; ch < header.num_channels; ch++) {
+                input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+                output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+                for (smpl = 0; smpl < header.num_samples; smpl++) {
+                    input[ch][smpl] = (int32_t)(((rand() % 512) - 256) + 4096.0 * sin(0.01 * (ch + 1) * smpl));
+                }
+            }
+            LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeWhole(encoder, input, header.num_samples, data, sufficient_size, &output_size));
+
+            num_executed_tasks = 0;
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_SetTaskCallback(decoder, LINNEDecoderTest_RunTasksReverse, &num_executed_tasks));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_DecodeWhole(decoder, data, output_size, output, header.num_channels, header.num_samples));
+            for (ch = 0; ch < header.num_channels; ch++) {
+                EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples));
+            }
+            /* 多チャンネルのときのみブロック毎にチャンネル数分タスクが実行される */
+            if (header.num_channels > 1) {
+                EXPECT_EQ(header.num_channels * (header.num_samples / header.num_samples_per_block), num_executed_tasks);
+            } else {
+                EXPECT_EQ(0U, num_executed_tasks);
+            }
+
+            /* コールバック解除後は使われない */
+            num_executed_tasks = 0;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetTaskCallback(decoder, NULL, &num_executed_tasks));
+            EXPECT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_DecodeWhole(decoder, data, output_size, output, header.num_channels, header.num_samples));
+            EXPECT_EQ(0U, num_executed_tasks);
+            for (ch = 0; ch < header.num_channels; ch++) {
+                EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples));
+            }
+
+            for (ch = 0; ch < header.num_channels; ch++) {
+                free(input[ch]);
+                free(output[ch]);
+            }
+            free(data);
+        }
+
+        LINNEDecoder_Destroy(decoder);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* プリセット競争でエンコードしたデータのデコードテスト */
+TEST(LINNEDecoderTest, DecodeRaceBlocksTest)
+{
+    struct LINNEEncoder *encoders[LINNEENCODER_MAX_NUM_RACE_ENCODERS];
+    struct LINNEDecoder *decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    uint8_t *data;
+    int32_t *input[2], *output[2];
+    const int32_t *input_ptr[2];
+    uint32_t i, ch, smpl, progress, data_size, write_offset, write_size;
+    const uint32_t num_encoders = LINNEENCODER_MAX_NUM_RACE_ENCODERS;
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(decoder != NULL);
+
+    /* 末尾に短いブロックが残るステレオ信号 */
+    LINNE_SetValidHeader(&header);
+    header.num_channels = 2;
+    header.num_samples = 3 * header.num_samples_per_block + 100;
+    header.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    header.enable_block_preset = 1;
+    data_size = LINNE_HEADER_SIZE
+        + 4 * LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(header.num_channels, header.bits_per_sample, header.num_samples_per_block);
+    data = (uint8_t *)malloc(data_size);
+    srand(0);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        for (smpl = 0; smpl < header.num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(((rand() % 512) - 256) + 4096.0 * sin(0.01 * (ch + 1) * smpl));
+        }
+    }
+
+    /* 全プリセット x 学習の有無で競争 */
+    LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+    for (i = 0; i < num_encoders; i++) {
+        encoders[i] = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        ASSERT_TRUE(encoders[i] != NULL);
+        parameter.preset = (uint8_t)(i % LINNE_NUM_PARAMETER_PRESETS);
+        parameter.enable_learning = (uint8_t)(i / LINNE_NUM_PARAMETER_PRESETS);
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoders[i], &parameter));
+    }
+
+    /* ヘッダとブロックを順に書き出し */
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, data_size));
+    write_offset = LINNE_HEADER_SIZE;
+    for (progress = 0; progress < header.num_samples; progress += header.num_samples_per_block) {
+        const uint32_t num_block_samples = LINNEUTILITY_MIN(header.num_samples_per_block, header.num_samples - progress);
+        for (ch = 0; ch < header.num_channels; ch++) {
+            input_ptr[ch] = &input[ch][progress];
+        }
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlockRace(encoders, num_encoders, input_ptr, num_block_samples,
+                    &data[write_offset], data_size - write_offset, &write_size));
+        write_offset += write_size;
+    }
+
+    /* 元の信号に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeWhole(decoder, data, write_offset, output, header.num_channels, header.num_samples));
+    for (ch = 0; ch < header.num_channels; ch++) {
+        EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples));
+    }
+
+    for (ch = 0; ch < header.num_channels; ch++) {
+        free(input[ch]);
+        free(output[ch]);
+    }
+    free(data);
+    for (i = 0; i < num_encoders; i++) {
+        LINNEEncoder_Destroy(encoders[i]);
+    }
+    LINNEDecoder_Destroy(decoder);
+}
+
+/* パラメータを再利用したブロックのデコードテスト */
+TEST(LINNEDecoderTest, DecodeReuseParametersTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEDecoder *decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    uint8_t *data;
+    int32_t *input[2], *output[2];
+    const int32_t *input_ptr[2];
+    uint32_t ch, smpl, progress, data_size, write_offset, write_size, decode_size, num_decode_samples;
+    uint32_t num_reuse_blocks, reuse_block_offset, reuse_total_size, analyze_total_size;
+    uint8_t reuse;
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+    encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    ASSERT_TRUE(decoder != NULL);
+
+    /* 定常なステレオ信号 */
+    LINNE_SetValidHeader(&header);
+    header.num_channels = 2;
+    header.num_samples = 8 * header.num_samples_per_block;
+    header.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    data_size = LINNE_HEADER_SIZE
+        + 8 * LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(header.num_channels, header.bits_per_sample, header.num_samples_per_block);
+    data = (uint8_t *)malloc(data_size);
+    srand(0);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        for (smpl = 0; smpl < header.num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(((rand() % 64) - 32) + 4096.0 * sin(0.01 * (ch + 1) * smpl));
+        }
+    }
+
+    /* 再利用の有無でエンコード */
+    analyze_total_size = reuse_total_size = 0;
+    num_reuse_blocks = reuse_block_offset = 0;
+    for (reuse = 0; reuse <= 1; reuse++) {
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        parameter.enable_parameter_reuse = reuse;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, data_size));
+        write_offset = LINNE_HEADER_SIZE;
+        for (progress = 0; progress < header.num_samples; progress += header.num_samples_per_block) {
+            for (ch = 0; ch < header.num_channels; ch++) {
+                input_ptr[ch] = &input[ch][progress];
+            }
+            ASSERT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input_ptr, header.num_samples_per_block,
+                        &data[write_offset], data_size - write_offset, &write_size));
+            /* 再利用フラグはブロックタイプのバイトに立つ */
+            if (data[write_offset + 8] & LINNE_BLOCK_DATA_TYPE_REUSE_PARAMETERS_FLAG) {
+                EXPECT_EQ(1, reuse);
+                EXPECT_EQ(LINNE_BLOCK_DATA_TYPE_COMPRESSDATA, data[write_offset + 8] & ~LINNE_BLOCK_DATA_TYPE_FLAGS);
+                if (num_reuse_blocks == 0) {
+                    reuse_block_offset = write_offset;
+                }
+                num_reuse_blocks++;
+            }
+            write_offset += write_size;
+        }
+        if (reuse == 0) {
+            analyze_total_size = write_offset;
+        } else {
+            reuse_total_size = write_offset;
+        }
+    }
+
+    /* 定常な信号ではパラメータを省いたブロックが現れ、サイズが小さくなる */
+    EXPECT_GT(num_reuse_blocks, 0U);
+    EXPECT_LT(reuse_total_size, analyze_total_size);
+    /* 先頭のブロックは再利用できない */
+    EXPECT_GT(reuse_block_offset, (uint32_t)LINNE_HEADER_SIZE);
+
+    /* 元の信号に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeWhole(decoder, data, reuse_total_size, output, header.num_channels, header.num_samples));
+    for (ch = 0; ch < header.num_channels; ch++) {
+        EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples));
+    }
+
+    /* 直前のブロックをデコードしていなければ再利用ブロックはデコードできない */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+    EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+            LINNEDecoder_DecodeBlock(decoder, &data[reuse_block_offset], reuse_total_size - reuse_block_offset,
+                output, header.num_channels, header.num_samples, &decode_size, &num_decode_samples));
+
+    for (ch = 0; ch < header.num_channels; ch++) {
+        free(input[ch]);
+        free(output[ch]);
+    }
+    free(data);
+    LINNEEncoder_Destroy(encoder);
+    LINNEDecoder_Destroy(decoder);
+}
+
+/* パラメータを差分で記録したブロックのデコードテスト */
+TEST(LINNEDecoderTest, DecodeDeltaParametersTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEDecoder *decoder;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEHeader header;
+    uint8_t *data;
+    int32_t *input[2], *output[2], *output_ptr[2];
+    const int32_t *input_ptr[2];
+    uint32_t ch, smpl, progress, data_size, write_offset, write_size, decode_size, num_decode_samples;
+    uint32_t num_delta_blocks, num_dependent_blocks, max_num_dependent_blocks;
+    uint32_t delta_block_offset, keyframe_offset, keyframe_progress, delta_total_size, full_total_size;
+    uint32_t prev_block_offset, pre_delta_block_offset, second_delta_block_offset;
+    uint8_t delta;
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+    encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+    decoder = LINNEDecoder_Create(&decoder_config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    ASSERT_TRUE(decoder != NULL);
+
+    /* 短いブロックに分けた定常なステレオ信号 */
+    LINNE_SetValidHeader(&header);
+    header.num_channels = 2;
+    header.num_samples_per_block = 256;
+    header.num_samples = 64 * header.num_samples_per_block;
+    header.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    data_size = LINNE_HEADER_SIZE
+        + 64 * LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(header.num_channels, header.bits_per_sample, header.num_samples_per_block);
+    data = (uint8_t *)malloc(data_size);
+    srand(0);
+    for (ch = 0; ch < header.num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples);
+        for (smpl = 0; smpl < header.num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(((rand() % 64) - 32) + 4096.0 * sin(0.01 * (ch + 1) * smpl));
+        }
+    }
+
+    /* 差分記録の有無でエンコード 分析窓は直前のブロックまで延ばす */
+    full_total_size = delta_total_size = 0;
+    num_delta_blocks = max_num_dependent_blocks = 0;
+    delta_block_offset = keyframe_offset = keyframe_progress = 0;
+    prev_block_offset = pre_delta_block_offset = second_delta_block_offset = 0;
+    for (delta = 0; delta <= 1; delta++) {
+        LINNEEncoder_ConvertHeaderToParameter(&header, &parameter);
+        parameter.num_lookback_samples = 2048;
+        parameter.enable_delta_parameters = delta;
+        parameter.keyframe_interval = 16;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, data_size));
+        write_offset = LINNE_HEADER_SIZE;
+        num_dependent_blocks = 0;
+        for (progress = 0; progress < header.num_samples; progress += header.num_samples_per_block) {
+            for (ch = 0; ch < header.num_channels; ch++) {
+                input_ptr[ch] = &input[ch][progress];
+            }
+            ASSERT_EQ(LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input_ptr, header.num_samples_per_block,
+                        &data[write_offset], data_size - write_offset, &write_size));
+            /* 差分記録フラグはブロックタイプのバイトに立つ */
+            if (data[write_offset + 8] & LINNE_BLOCK_DATA_TYPE_DELTA_PARAMETERS_FLAG) {
+                EXPECT_EQ(1, delta);
+                EXPECT_EQ(LINNE_BLOCK_DATA_TYPE_COMPRESSDATA, data[write_offset + 8] & ~LINNE_BLOCK_DATA_TYPE_FLAGS);
+                if (num_delta_blocks == 0) {
+                    delta_block_offset = write_offset;
+                }
+                num_delta_blocks++;
+                num_dependent_blocks++;
+                /* 直前のブロックも差分記録した最初のブロック（破損テストに使う） */
+                if ((num_dependent_blocks == 2) && (pre_delta_block_offset == 0)) {
+                    second_delta_block_offset = write_offset;
+                    pre_delta_block_offset = prev_block_offset;
+                }
+            } else {
+                /* 先頭以外のキーフレームを記録 */
+                if ((delta == 1) && (progress > 0) && (keyframe_offset == 0)) {
+                    keyframe_offset = write_offset;
+                    keyframe_progress = progress;
+                }
+                num_dependent_blocks = 0;
+            }
+            max_num_dependent_blocks = LINNEUTILITY_MAX(max_num_dependent_blocks, num_dependent_blocks);
+            prev_block_offset = write_offset;
+            write_offset += write_size;
+        }
+        if (delta == 0) {
+            full_total_size = write_offset;
+        } else {
+            delta_total_size = write_offset;
+        }
+    }
+
+    /* 短いブロックではパラメータを差分で記録したブロックが現れ、サイズが小さくなる */
+    EXPECT_GT(num_delta_blocks, 0U);
+    EXPECT_LT(delta_total_size, full_total_size);
+    /* 先頭のブロックは差分で記録できない */
+    EXPECT_GT(delta_block_offset, (uint32_t)LINNE_HEADER_SIZE);
+    /* キーフレームの間隔を守っている */
+    EXPECT_LT(max_num_dependent_blocks, 16U);
+    EXPECT_GT(keyframe_offset, 0U);
+
+    /* 元の信号に戻るか */
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEDecoder_DecodeWhole(decoder, data, delta_total_size, output, header.num_channels, header.num_samples));
+    for (ch = 0; ch < header.num_channels; ch++) {
+        EXPECT_EQ(0, memcmp(input[ch], output[ch], sizeof(int32_t) * header.num_samples));
+    }
+
+    /* 直前のブロックをデコードしていなければ差分記録したブロックはデコードできない */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+    EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+            LINNEDecoder_DecodeBlock(decoder, &data[delta_block_offset], delta_total_size - delta_block_offset,
+                output, header.num_channels, header.num_samples, &decode_size, &num_decode_samples));
+
+    /* 直前のブロックが破損していれば、それより前のブロックを基準にデコードせず失敗する */
+    ASSERT_GT(pre_delta_block_offset, 0U);
+    {
+        uint8_t *corrupt_data = (uint8_t *)malloc(delta_total_size);
+        memcpy(corrupt_data, data, delta_total_size);
+        /* 差分記録したブロックの直前のブロックのデータ部を壊す */
+        corrupt_data[pre_delta_block_offset + LINNE_BLOCK_HEADER_SIZE] ^= 0xFF;
+
+        /* 破損ブロックの直前までは正常にデコードできる */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+        write_offset = LINNE_HEADER_SIZE;
+        for (progress = 0; write_offset < pre_delta_block_offset; progress += num_decode_samples) {
+            for (ch = 0; ch < header.num_channels; ch++) {
+                output_ptr[ch] = &output[ch][progress];
+            }
+            ASSERT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_DecodeBlock(decoder, &corrupt_data[write_offset], delta_total_size - write_offset,
+                        output_ptr, header.num_channels, header.num_samples - progress, &decode_size, &num_decode_samples));
+            write_offset += decode_size;
+        }
+        EXPECT_EQ(pre_delta_block_offset, write_offset);
+
+        /* 破損検知後の差分記録ブロックは拒否される */
+        EXPECT_EQ(LINNE_APIRESULT_DETECT_DATA_CORRUPTION,
+                LINNEDecoder_DecodeBlock(decoder, &corrupt_data[pre_delta_block_offset], delta_total_size - pre_delta_block_offset,
+                    output, header.num_channels, header.num_samples, &decode_size, &num_decode_samples));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+                LINNEDecoder_DecodeBlock(decoder, &corrupt_data[second_delta_block_offset], delta_total_size - second_delta_block_offset,
+                    output, header.num_channels, header.num_samples, &decode_size, &num_decode_samples));
+
+        /* 同期し直して見つけた差分記録ブロックも拒否される */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+        write_offset = LINNE_HEADER_SIZE;
+        for (progress = 0; write_offset < pre_delta_block_offset; progress += num_decode_samples) {
+            for (ch = 0; ch < header.num_channels; ch++) {
+                output_ptr[ch] = &output[ch][progress];
+            }
+            ASSERT_EQ(LINNE_APIRESULT_OK,
+                    LINNEDecoder_DecodeBlock(decoder, &corrupt_data[write_offset], delta_total_size - write_offset,
+                        output_ptr, header.num_channels, header.num_samples - progress, &decode_size, &num_decode_samples));
+            write_offset += decode_size;
+        }
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_FindNextBlock(decoder, &corrupt_data[pre_delta_block_offset],
+                    delta_total_size - pre_delta_block_offset, &write_offset));
+        EXPECT_EQ(second_delta_block_offset, pre_delta_block_offset + write_offset);
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_DATA,
+                LINNEDecoder_DecodeBlock(decoder, &corrupt_data[second_delta_block_offset], delta_total_size - second_delta_block_offset,
+                    output, header.num_channels, header.num_samples, &decode_size, &num_decode_samples));
+
+        free(corrupt_data);
+    }
+
+    /* キーフレームからデコードを始めると元の信号に戻る */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+    write_offset = keyframe_offset;
+    for (progress = keyframe_progress; progress < header.num_samples; progress += num_decode_samples) {
+        for (ch = 0; ch < header.num_channels; ch++) {
+            output_ptr[ch] = &output[ch][progress];
+        }
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_DecodeBlock(decoder, &data[write_offset], delta_total_size - write_offset,
+                    output_ptr, header.num_channels, header.num_samples - progress, &decode_size, &num_decode_samples));
+        write_offset += decode_size;
+    }
+    for (ch = 0; ch < header.num_channels; ch++) {
+        EXPECT_EQ(0, memcmp(&input[ch][keyframe_progress], &output[ch][keyframe_progress],
+                    sizeof(int32_t) * (header.num_samples - keyframe_progress)));
+    }
+
+    for (ch = 0; ch < header.num_channels; ch++) {
+        free(input[ch]);
+        free(output[ch]);
+    }
+    free(data);
+    LINNEEncoder_Destroy(encoder);
+    LINNEDecoder_Destroy(decoder);
+}
+
+/* ハンドルリセットテスト */
+TEST(LINNEDecoderTest, ResetTest)
+{
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoder_Reset(NULL));
+
+    /* 作成直後の状態に戻るか */
+    {
+        struct LINNEDecoder *decoder;
+        struct LINNEDecoderConfig config;
+        struct LINNEHeader header;
+        uint32_t num_executed_tasks;
+        int32_t buffer[32];
+        int32_t *output[1];
+        uint8_t data[64];
+        uint32_t decode_size, num_decode_samples;
+
+        LINNEDecoder_SetValidConfig(&config);
+        decoder = LINNEDecoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(decoder != NULL);
+
+        LINNE_SetValidHeader(&header);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_SetHeader(decoder, &header));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEDecoder_SetTaskCallback(decoder, LINNEDecoderTest_RunTasksReverse, &num_executed_tasks));
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoder_Reset(decoder));
+        EXPECT_FALSE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_SET_HEADER));
+        EXPECT_TRUE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_ALLOCED_BY_OWN));
+        EXPECT_TRUE(LINNEDECODER_GET_STATUS_FLAG(decoder, LINNEDECODER_STATUS_FLAG_CRC16_CHECK));
+        EXPECT_TRUE(decoder->run_tasks == NULL);
+        EXPECT_TRUE(decoder->run_tasks_user_data == NULL);
+        EXPECT_TRUE(decoder->parameter_preset == NULL);
+
+        /* ヘッダを設定し直すまでデコードできない */
+        output[0] = buffer;
+        memset(data, 0, sizeof(data));
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEDecoder_DecodeBlock(decoder, data, sizeof(data), output, 1, 32, &decode_size, &num_decode_samples));
+
+        LINNEDecoder_Destroy(decoder);
+    }
+}
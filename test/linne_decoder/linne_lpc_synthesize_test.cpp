@@ -1,4 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_decoder/src/linne_lpc_synthesize.c"
 }
+
+/* 参照用の次数可変なLPC合成 */
+static void LINNELPCSynthesizeTest_SynthesizeReference(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    int32_t predict;
+    uint32_t smpl, ord;
+    const int32_t half = 1 << (coef_rshift - 1);
+
+    for (smpl = 1; smpl < coef_order; smpl++) {
+        predict = half;
+        for (ord = 0; ord < smpl; ord++) {
+            predict += (coef[coef_order - smpl + ord] * data[ord]);
+        }
+        data[smpl] -= (predict >> coef_rshift);
+    }
+    for (smpl = coef_order; smpl < num_samples; smpl++) {
+        predict = half;
+        for (ord = 0; ord < coef_order; ord++) {
+            predict += (coef[ord] * data[smpl - coef_order + ord]);
+        }
+        data[smpl] -= (predict >> coef_rshift);
+    }
+}
+
+/* 参照用の64bit積和によるLPC合成 */
+static void LINNELPCSynthesizeTest_SynthesizeInt64Reference(
+    int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, uint32_t coef_rshift)
+{
+    int64_t predict;
+    uint32_t smpl, ord;
+
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        const uint32_t order = (smpl < coef_order) ? smpl : coef_order;
+        predict = (int64_t)1 << (coef_rshift - 1);
+        for (ord = 0; ord < order; ord++) {
+            predict += ((int64_t)coef[coef_order - order + ord] * data[smpl - order + ord]);
+        }
+        data[smpl] -= (int32_t)(predict >> coef_rshift);
+    }
+}
+
+/* 固定次数カーネルが次数可変の合成と一致するか */
+TEST(LINNELPCSynthesizeTest, FixedOrderKernelTest)
+{
+    uint32_t i, j, smpl;
+    /* カーネルを持つ次数と持たない次数(5, 7)の両方を確認 */
+    const uint32_t orders[] = { 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 1024 };
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            const uint32_t order = orders[i];
+            const uint32_t num_samples = nums_samples[j];
+            int32_t *data, *answer;
+            int32_t coef[128];
+
+            if (order > num_samples) {
+                continue;
+            }
+
+            data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                data[smpl] = answer[smpl] = (rand() % 4096) - 2048;
+            }
+            for (smpl = 0; smpl < order; smpl++) {
+                coef[smpl] = (rand() % 64) - 32;
+            }
+
+            LINNELPCSynthesizeTest_SynthesizeReference(answer, num_samples, coef, order, 8);
+            LINNELPC_Synthesize(data, num_samples, coef, order, 8);
+            EXPECT_EQ(0, memcmp(answer, data, sizeof(int32_t) * num_samples));
+
+            free(data);
+            free(answer);
+        }
+    }
+}
+
+/* 16bit積和による合成が参照実装と一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeInt16Test)
+{
+    uint32_t i, j, k, smpl;
+    /* 16bit積和カーネルを持つ次数と持たない次数の両方を確認 */
+    const uint32_t orders[] = { 1, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 1024 };
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            /* k == 0: 出力が16bitに収まる場合, k == 1: 途中で16bitを超える場合 */
+            for (k = 0; k < 2; k++) {
+                const uint32_t order = orders[i];
+                const uint32_t num_samples = nums_samples[j];
+                int32_t *data, *answer;
+                int32_t coef[128];
+
+                if (order > num_samples) {
+                    continue;
+                }
+
+                data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                for (smpl = 0; smpl < order; smpl++) {
+                    coef[smpl] = 0;
+                }
+                if (k == 0) {
+                    /* 直前サンプルを半分にして加える安定なフィルタ */
+                    for (smpl = 0; smpl < num_samples; smpl++) {
+                        data[smpl] = answer[smpl] = (rand() % 256) - 128;
+                    }
+                    coef[order - 1] = -128;
+                } else {
+                    /* 正の残差を積分し続けるフィルタ 途中で大きな残差を加えて16bitを超えさせる */
+                    for (smpl = 0; smpl < num_samples; smpl++) {
+                        data[smpl] = answer[smpl] = rand() % 128;
+                    }
+                    data[num_samples / 2] = answer[num_samples / 2] = 30000;
+                    coef[order - 1] = -256;
+                }
+
+                LINNELPCSynthesizeTest_SynthesizeReference(answer, num_samples, coef, order, 8);
+                LINNELPC_SynthesizeInt16(data, num_samples, coef, order, 8);
+                EXPECT_EQ(0, memcmp(answer, data, sizeof(int32_t) * num_samples));
+
+                free(data);
+                free(answer);
+            }
+        }
+    }
+}
+
+/* 4系列インターリーブ合成が単一系列の合成と一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeInterleaved4Test)
+{
+    uint32_t i, j, smpl, trial;
+    const uint32_t orders[] = { 1, 2, 3, 8, 16, 32 };
+    const uint32_t nums_samples[] = { 1, 7, 32, 1024 };
+
+    srand(0);
+    for (trial = 0; trial < sizeof(orders) / sizeof(orders[0]); trial++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            const uint32_t order = orders[trial];
+            const uint32_t num_samples = nums_samples[j];
+            int32_t *data[4], *answer[4];
+            int32_t coef[4][32];
+            const int32_t *pcoef[4];
+            uint32_t rshift[4];
+
+            /* 次数はサンプル数以下 */
+            if (order > num_samples) {
+                continue;
+            }
+
+            for (i = 0; i < 4; i++) {
+                data[i] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                answer[i] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    data[i][smpl] = answer[i][smpl] = (rand() % 4096) - 2048;
+                }
+                for (smpl = 0; smpl < order; smpl++) {
+                    coef[i][smpl] = (rand() % 64) - 32;
+                }
+                pcoef[i] = coef[i];
+                rshift[i] = 5 + i;
+                LINNELPC_Synthesize(answer[i], num_samples, coef[i], order, rshift[i]);
+            }
+
+            LINNELPC_SynthesizeInterleaved4(data, num_samples, pcoef, order, rshift);
+
+            for (i = 0; i < 4; i++) {
+                EXPECT_EQ(0, memcmp(answer[i], data[i], sizeof(int32_t) * num_samples));
+                free(data[i]);
+                free(answer[i]);
+            }
+        }
+    }
+}
+
+/* ユニット並列合成がユニット毎の合成と一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeUnitsTest)
+{
+    uint32_t i, j, k, smpl;
+    const uint32_t orders[] = { 1, 2, 3, 4, 8, 16, 32, 128 };
+    const uint32_t nums_units[] = { 1, 2, 4, 5, 8, 13, 16, 32 };
+    const uint32_t nums_samples_per_unit[] = { 1, 4, 128, 300 };
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_units) / sizeof(nums_units[0]); j++) {
+            for (k = 0; k < sizeof(nums_samples_per_unit) / sizeof(nums_samples_per_unit[0]); k++) {
+                const uint32_t order = orders[i];
+                const uint32_t num_units = nums_units[j];
+                const uint32_t num_samples_per_unit = nums_samples_per_unit[k];
+                const uint32_t num_samples = num_units * num_samples_per_unit;
+                int32_t *data, *answer, *coef;
+                uint32_t unit;
+
+                /* 次数はユニットあたりサンプル数以下 */
+                if (order > num_samples_per_unit) {
+                    continue;
+                }
+
+                data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                coef = (int32_t *)malloc(sizeof(int32_t) * num_units * order);
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    data[smpl] = answer[smpl] = (rand() % 4096) - 2048;
+                }
+                for (smpl = 0; smpl < num_units * order; smpl++) {
+                    coef[smpl] = (rand() % 64) - 32;
+                }
+
+                for (unit = 0; unit < num_units; unit++) {
+                    LINNELPC_Synthesize(&answer[unit * num_samples_per_unit],
+                            num_samples_per_unit, &coef[unit * order], order, 7);
+                }
+                LINNELPC_SynthesizeUnits(data, num_units, num_samples_per_unit, coef, order, 7);
+                EXPECT_EQ(0, memcmp(answer, data, sizeof(int32_t) * num_samples));
+
+                free(data);
+                free(answer);
+                free(coef);
+            }
+        }
+    }
+}
+
+/* 64bit積和による合成が参照実装と一致するか */
+TEST(LINNELPCSynthesizeTest, SynthesizeInt64Test)
+{
+    uint32_t i, j, k, smpl;
+    const uint32_t orders[] = { 1, 2, 3, 8, 15, 16, 32, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 300, 1024 };
+    /* 24bit音源のMS変換・プリエンファシス後の最大振幅 */
+    const int32_t amplitude = (1 << 25) - 1;
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            /* k == 0: 出力がフルスケールの正負を往復する最悪ケース, k == 1: フルスケールの乱数 */
+            for (k = 0; k < 2; k++) {
+                const uint32_t order = orders[i];
+                const uint32_t num_samples = nums_samples[j];
+                int32_t *data, *answer;
+                int32_t coef[128];
+
+                if (order > num_samples) {
+                    continue;
+                }
+
+                data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                for (smpl = 0; smpl < order; smpl++) {
+                    coef[smpl] = (k == 0) ? 127 : ((rand() % 256) - 128);
+                }
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    data[smpl] = answer[smpl] = (k == 0) ? amplitude : ((rand() % (2 * amplitude + 1)) - amplitude);
+                }
+
+                /* 最悪ケースは32bitの積和では桁あふれすると判定される */
+                if (k == 0) {
+                    EXPECT_EQ(1, LINNEUtility_IsLPCAccumulatorOverflowable(coef, order, 8, 24));
+                }
+
+                LINNELPCSynthesizeTest_SynthesizeInt64Reference(answer, num_samples, coef, order, 8);
+                LINNELPC_SynthesizeInt64(data, num_samples, coef, order, 8);
+                EXPECT_EQ(0, memcmp(answer, data, sizeof(int32_t) * num_samples));
+
+                free(data);
+                free(answer);
+            }
+        }
+    }
+}
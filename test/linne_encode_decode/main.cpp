@@ -7,6 +7,7 @@
 #include "linne_encoder.h"
 #include "linne_decoder.h"
 #include "linne_utility.h"
+#include "wav.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
@@ -220,16 +221,18 @@ static int32_t LINNEEncodeDecodeTest_ExecuteTestCase(const struct EncodeDecodeTe
     num_samples   = test_case->num_samples;
     num_channels  = test_case->encode_parameter.num_channels;
     /* 十分なデータサイズを用意（入力データPCMの2倍） */
-    data_size     = LINNE_HEADER_SIZE + (2 * num_channels * num_samples * test_case->encode_parameter.bits_per_sample) / 8;
+    data_size     = LINNE_MAX_HEADER_SIZE + (2 * num_channels * num_samples * test_case->encode_parameter.bits_per_sample) / 8;
 
     /* エンコード・デコードコンフィグ作成 */
     /* FIXME: 仮値 */
     encoder_config.max_num_channels             = num_channels;
     encoder_config.max_num_samples_per_block    = test_case->encode_parameter.num_samples_per_block;
-    encoder_config.max_num_layers               = 3;
+    encoder_config.max_num_layers               = LINNE_MAX_NUM_CUSTOM_LAYERS;
     encoder_config.max_num_parameters_per_layer = 128;
+    encoder_config.max_num_lookback_samples     = 0;
+    encoder_config.enable_delta_parameters      = 0;
     decoder_config.max_num_channels             = num_channels;
-    decoder_config.max_num_layers               = 3;
+    decoder_config.max_num_layers               = LINNE_MAX_NUM_CUSTOM_LAYERS;
     decoder_config.max_num_parameters_per_layer = 128;
     decoder_config.check_crc                    = 1;
 
@@ -481,6 +484,40 @@ TEST(LINNEEncodeDecodeTest, EncodeDecodeCheckTest)
         { { 8,  8, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0 }, 0, 8192, LINNEEncodeDecodeTest_GenerateGaussNoise },
         { { 8, 16, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0 }, 0, 8192, LINNEEncodeDecodeTest_GenerateGaussNoise },
         { { 8, 24, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0 }, 0, 8192, LINNEEncodeDecodeTest_GenerateGaussNoise },
+
+        /* 適応ブロックサイズ選択の部 */
+        { { 1, 16, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_NONE, 0, 512, 3 }, 0, 8192, LINNEEncodeDecodeTest_GenerateSilence },
+        { { 1, 16, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_NONE, 0, 512, 3 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 3 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 24, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 1 }, 0, 8192, LINNEEncodeDecodeTest_GenerateSinWave },
+        { { 2, 16, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 2 }, 0, 8192, LINNEEncodeDecodeTest_GenerateWhiteNoise },
+        { { 8, 16, 8000, 4096, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 3 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+
+        /* 実時間倍率目標によるブロック毎のプリセット切り替えの部 */
+        { { 1, 16, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_NONE, 0, 0, 0, 1 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0, 0, 0, 1 }, 0, 8192, LINNEEncodeDecodeTest_GenerateSinWave },
+        { { 2, 16, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 1, 0, 0, 1 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 24, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0, 0, 0, UINT16_MAX }, 0, 8192, LINNEEncodeDecodeTest_GenerateWhiteNoise },
+        { { 8, 16, 8000, 1024, 1, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 3, 1 }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+
+        /* 独自レイヤー構造の部 */
+        { { 1, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_NONE, 0, 0, 0, 0, 1, { 1 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateSinWave },
+        { { 1, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_NONE, 0, 0, 0, 0, 2, { 16, 8 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 0, 0, 0, 2, { 16, 8 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateWhiteNoise },
+        { { 2, 24, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 0, 0, 0, 4, { 4, 128, 16, 8 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 1, 0, 0, 0, 3, { 4, 24, 12 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 8, 16, 8000, 4096, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 3, 0, 8, { 32, 32, 32, 32, 16, 8, 4, 2 } }, 0, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+
+        /* 下位ビットが無効な信号の部 */
+        { { 1, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_NONE, 0 }, 1, 8192, LINNEEncodeDecodeTest_GenerateSinWave },
+        { { 1, 24, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_NONE, 0 }, 8, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_NONE, 0 }, 4, 8192, LINNEEncodeDecodeTest_GenerateWhiteNoise },
+        { { 2, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0 }, 3, 8192, LINNEEncodeDecodeTest_GenerateSinWave },
+        { { 2, 24, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0 }, 8, 8192, LINNEEncodeDecodeTest_GenerateGaussNoise },
+        { { 2,  8, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 0 }, 7, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 2, 16, 8000, 1024, LINNE_NUM_PARAMETER_PRESETS - 1, LINNE_CH_PROCESS_METHOD_MS, 1 }, 2, 8192, LINNEEncodeDecodeTest_GenerateChirp },
+        { { 8, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 512, 3 }, 5, 8192, LINNEEncodeDecodeTest_GenerateGaussNoise },
+        { { 2, 16, 8000, 1024, 0, LINNE_CH_PROCESS_METHOD_MS, 0, 0, 0, 1 }, 4, 8192, LINNEEncodeDecodeTest_GenerateChirp },
     };
 
     /* テストケース数 */
@@ -498,6 +535,83 @@ TEST(LINNEEncodeDecodeTest, EncodeDecodeCheckTest)
     }
 }
 
+/* 事前分析で決め直したパラメータが、決め直す前より大きく圧縮しないかを同梱のWAVファイルで確認するテスト */
+TEST(LINNEEncodeDecodeTest, PreAnalyzeWholeWAVTest)
+{
+    uint32_t i, ch, smpl;
+    /* 32bitは生データブロックが出力できないので対象外 */
+    const char *test_filenames[] = {
+        "a.wav",
+        "8bit.wav",
+        "16bit.wav",
+        "24bit.wav",
+        "8bit_2ch.wav",
+        "16bit_2ch.wav",
+        "24bit_2ch.wav",
+    };
+    const uint32_t num_test_files = sizeof(test_filenames) / sizeof(test_filenames[0]);
+
+    for (i = 0; i < num_test_files; i++) {
+        struct WAVFile *wavfile;
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter, analyzed;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data;
+        uint32_t num_channels, num_samples, data_size, default_size, analyzed_size;
+
+        wavfile = WAV_CreateFromFile(test_filenames[i]);
+        ASSERT_TRUE(wavfile != NULL);
+        num_channels = wavfile->format.num_channels;
+        num_samples = wavfile->format.num_samples;
+
+        /* コーデックと同じく、情報が失われない程度に右シフトした入力 */
+        for (ch = 0; ch < num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                input[ch][smpl] = (int32_t)(WAVFile_PCM(wavfile, smpl, ch) >> (32 - wavfile->format.bits_per_sample));
+            }
+        }
+        data_size = LINNE_MAX_HEADER_SIZE + (2 * num_channels * num_samples * wavfile->format.bits_per_sample) / 8;
+        data = (uint8_t *)malloc(data_size);
+
+        /* コーデックの既定値に合わせたパラメータ 事前分析は最大のプリセットから下位のプリセットも選びうる */
+        memset(&parameter, 0, sizeof(parameter));
+        parameter.num_channels = (uint16_t)num_channels;
+        parameter.bits_per_sample = (uint16_t)wavfile->format.bits_per_sample;
+        parameter.sampling_rate = wavfile->format.sampling_rate;
+        parameter.num_samples_per_block = 10240;
+        parameter.preset = LINNE_NUM_PARAMETER_PRESETS - 1;
+        parameter.ch_process_method = (num_channels == 2) ? LINNE_CH_PROCESS_METHOD_MS : LINNE_CH_PROCESS_METHOD_NONE;
+
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* 決め直す前のパラメータでのサイズ */
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &default_size));
+
+        /* 事前分析で決め直したパラメータでのサイズ */
+        analyzed = parameter;
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, &analyzed));
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &analyzed));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &analyzed_size));
+        EXPECT_LE(analyzed_size, default_size) << test_filenames[i];
+
+        LINNEEncoder_Destroy(encoder);
+
+        for (ch = 0; ch < num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        WAV_Destroy(wavfile);
+    }
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -8,6 +8,8 @@ extern "C" {
 #include "../../libs/linne_encoder/src/linne_encoder.c"
 }
 
+#include "../common/linne_test_allocator.h"
+
 /* 有効なヘッダをセット */
 #define LINNE_SetValidHeader(p_header)\
     do {\
@@ -20,6 +22,8 @@ extern "C" {
         header__p->num_samples              = 1024;\
         header__p->num_samples_per_block    = 32;\
         header__p->preset                   = 0;\
+        header__p->enable_block_preset      = 0;\
+        header__p->num_custom_layers        = 0;\
         header__p->ch_process_method        = LINNE_CH_PROCESS_METHOD_NONE;\
     } while (0);
 
@@ -33,6 +37,16 @@ extern "C" {
         param__p->num_samples_per_block = 1024;\
         param__p->preset                = 0;\
         param__p->ch_process_method     = LINNE_CH_PROCESS_METHOD_NONE;\
+        param__p->enable_learning       = 0;\
+        param__p->min_num_samples_per_block = 0;\
+        param__p->block_size_search_budget = 0;\
+        param__p->target_realtime_factor = 0;\
+        param__p->num_custom_layers = 0;\
+        param__p->enable_block_preset = 0;\
+        param__p->enable_parameter_reuse = 0;\
+        param__p->num_lookback_samples = 0;\
+        param__p->enable_delta_parameters = 0;\
+        param__p->keyframe_interval = 0;\
     } while (0);
 
 /* 有効なコンフィグをセット */
@@ -43,6 +57,8 @@ extern "C" {
         config__p->max_num_samples_per_block    = 8192;\
         config__p->max_num_layers               = 4;\
         config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_lookback_samples     = 4096;\
+        config__p->enable_delta_parameters      = 1;\
     } while (0);
 
 /* ヘッダエンコードテスト */
@@ -63,6 +79,26 @@ TEST(LINNEEncoderTest, EncodeHeaderTest)
         EXPECT_EQ('A', data[3]);
     }
 
+    /* 独自レイヤー構造を持つヘッダのエンコード */
+    {
+        struct LINNEHeader header;
+        uint8_t data[LINNE_MAX_HEADER_SIZE] = { 0, };
+
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = 2;
+        header.custom_num_params_list[0] = 16;
+        header.custom_num_params_list[1] = 8;
+        EXPECT_EQ(LINNE_HEADER_SIZE + 3U, LINNE_CALCULATE_HEADER_SIZE(&header));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_EncodeHeader(&header, data, LINNE_HEADER_SIZE + 2));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeHeader(&header, data, LINNE_HEADER_SIZE + 3));
+
+        /* プリセットのフラグと拡張部のチェック */
+        EXPECT_EQ(LINNE_HEADER_CUSTOM_LAYERS_FLAG, data[28] & LINNE_HEADER_CUSTOM_LAYERS_FLAG);
+        EXPECT_EQ(2, data[LINNE_HEADER_SIZE]);
+        EXPECT_EQ(16, data[LINNE_HEADER_SIZE + 1]);
+        EXPECT_EQ(8, data[LINNE_HEADER_SIZE + 2]);
+    }
+
     /* ヘッダエンコード失敗ケース */
     {
         struct LINNEHeader header;
@@ -120,6 +156,32 @@ TEST(LINNEEncoderTest, EncodeHeaderTest)
         EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
     }
 
+    /* 独自レイヤー構造のヘッダエンコード失敗ケース */
+    {
+        struct LINNEHeader header;
+        uint8_t data[LINNE_MAX_HEADER_SIZE + 1] = { 0, };
+
+        /* レイヤー数が多すぎる */
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = LINNE_MAX_NUM_CUSTOM_LAYERS + 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+
+        /* パラメータ数が不正 */
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = 1;
+        header.custom_num_params_list[0] = 0;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+        header.custom_num_params_list[0] = LINNE_NETWORK_MAX_PARAMS_PER_LAYER + 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+
+        /* ブロック毎のプリセット切り替えとは併用できない */
+        LINNE_SetValidHeader(&header);
+        header.num_custom_layers = 1;
+        header.custom_num_params_list[0] = 16;
+        header.enable_block_preset = 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_EncodeHeader(&header, data, sizeof(data)));
+    }
+
 }
 
 /* エンコードハンドル作成破棄テスト */
@@ -276,6 +338,47 @@ TEST(LINNEEncoderTest, CreateDestroyHandleTest)
     }
 }
 
+/* アロケータ差し替えテスト */
+TEST(LINNEEncoderTest, AllocatorTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEEncoderConfig config;
+    struct LINNETestAllocatorContext ctx;
+
+    LINNEEncoder_SetValidConfig(&config);
+
+    /* 自前確保のハンドルは設定したアロケータを通る */
+    LINNETestAllocator_Install(&ctx, UINT32_MAX);
+    encoder = LINNEEncoder_Create(&config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+    EXPECT_EQ(1, ctx.num_allocate);
+    EXPECT_EQ(LINNE_MEMORY_ALIGNMENT, ctx.last_alignment);
+    EXPECT_EQ(0, ctx.num_deallocate);
+    LINNEEncoder_Destroy(encoder);
+    EXPECT_EQ(1, ctx.num_deallocate);
+
+    /* ワーク領域渡しでは呼ばれない */
+    {
+        void *work;
+        int32_t work_size;
+
+        work_size = LINNEEncoder_CalculateWorkSize(&config);
+        work = malloc(work_size);
+        encoder = LINNEEncoder_Create(&config, work, work_size);
+        ASSERT_TRUE(encoder != NULL);
+        LINNEEncoder_Destroy(encoder);
+        free(work);
+        EXPECT_EQ(1, ctx.num_allocate);
+        EXPECT_EQ(1, ctx.num_deallocate);
+    }
+
+    /* 確保に失敗したら作成できない */
+    LINNETestAllocator_Install(&ctx, 0);
+    EXPECT_TRUE(LINNEEncoder_Create(&config, NULL, 0) == NULL);
+
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNE_SetAllocator(NULL));
+}
+
 /* 1ブロックエンコードテスト */
 TEST(LINNEEncoderTest, EncodeBlockTest)
 {
@@ -442,7 +545,8 @@ TEST(LINNEEncoderTest, EncodeBlockTest)
         BitReader_GetBits(&stream, &bitbuf, 2);
         EXPECT_TRUE((bitbuf == LINNE_BLOCK_DATA_TYPE_COMPRESSDATA)
                 || (bitbuf == LINNE_BLOCK_DATA_TYPE_SILENT)
-                || (bitbuf == LINNE_BLOCK_DATA_TYPE_RAWDATA));
+                || (bitbuf == LINNE_BLOCK_DATA_TYPE_RAWDATA)
+                || (bitbuf == LINNE_BLOCK_DATA_TYPE_CONSTANT));
         /* この後データがエンコードされているので、まだ終端ではないはず */
         BitStream_Tell(&stream, (int32_t *)&bitbuf);
         EXPECT_TRUE(bitbuf < output_size);
@@ -455,4 +559,795 @@ TEST(LINNEEncoderTest, EncodeBlockTest)
         free(data);
         LINNEEncoder_Destroy(encoder);
     }
+
+    /* 最大ブロックサイズぴったりの領域でエンコード */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data;
+        uint32_t ch, smpl, preset, max_block_size, output_size;
+        const uint32_t num_samples_list[] = { 160, 256, 1024 };
+        uint32_t i;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_channels = 2;
+        parameter.bits_per_sample = 8;
+        parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+
+        /* エンコーダ作成 */
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* データ領域確保 */
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * parameter.num_samples_per_block);
+        }
+
+        /* 圧縮が効かない白色雑音で、パラメータの比率が大きくなる短いブロックも試す */
+        srand(0);
+        for (i = 0; i < sizeof(num_samples_list) / sizeof(num_samples_list[0]); i++) {
+            for (preset = 0; preset < LINNE_NUM_PARAMETER_PRESETS; preset++) {
+                parameter.num_samples_per_block = (uint16_t)num_samples_list[i];
+                parameter.preset = (uint8_t)preset;
+                EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+                for (ch = 0; ch < parameter.num_channels; ch++) {
+                    for (smpl = 0; smpl < parameter.num_samples_per_block; smpl++) {
+                        input[ch][smpl] = (rand() % 256) - 128;
+                    }
+                }
+                max_block_size = LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(
+                        parameter.num_channels, parameter.bits_per_sample, parameter.num_samples_per_block);
+                data = (uint8_t *)malloc(max_block_size);
+                EXPECT_EQ(
+                        LINNE_APIRESULT_OK,
+                        LINNEEncoder_EncodeBlock(encoder, input, parameter.num_samples_per_block,
+                            data, max_block_size, &output_size));
+                EXPECT_TRUE(output_size <= max_block_size);
+                free(data);
+            }
+        }
+
+        /* 領域の開放 */
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            free(input[ch]);
+        }
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* LPC次数以下のサンプル数しかない末尾ブロックのエンコード */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint8_t *data;
+        uint32_t ch, smpl, l, preset, max_num_params, sufficient_size, output_size;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+
+        /* エンコーダ作成 */
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* データ領域確保 */
+        sufficient_size = (2 * parameter.num_channels * parameter.num_samples_per_block * parameter.bits_per_sample) / 8;
+        data = (uint8_t *)malloc(sufficient_size);
+        srand(0);
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            input[ch] = (int32_t *)malloc(sizeof(int32_t) * parameter.num_samples_per_block);
+            for (smpl = 0; smpl < parameter.num_samples_per_block; smpl++) {
+                input[ch][smpl] = (int32_t)(8192.0 * sin(0.05 * smpl)) + (rand() % 64) - 32;
+            }
+        }
+
+        /* 分析サンプル数が次数ちょうどに切り詰められないか、次数と同じサンプル数のブロックで確認 */
+        for (preset = 0; preset < LINNE_NUM_PARAMETER_PRESETS; preset++) {
+            const struct LINNEParameterPreset *layers = &g_linne_parameter_preset[preset];
+            max_num_params = 0;
+            for (l = 0; l < layers->num_layers; l++) {
+                max_num_params = LINNEUTILITY_MAX(max_num_params, layers->num_params_list[l]);
+            }
+            parameter.preset = (uint8_t)preset;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            EXPECT_EQ(
+                    LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, max_num_params,
+                        data, sufficient_size, &output_size));
+            EXPECT_EQ(
+                    LINNE_APIRESULT_OK,
+                    LINNEEncoder_EncodeBlock(encoder, input, 1,
+                        data, sufficient_size, &output_size));
+        }
+
+        /* 領域の開放 */
+        for (ch = 0; ch < parameter.num_channels; ch++) {
+            free(input[ch]);
+        }
+        free(data);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* 最小コンフィグ計算テスト */
+TEST(LINNEEncoderTest, CalculateMinimumConfigTest)
+{
+    /* 全プリセットで最小コンフィグのハンドルにパラメータがセットできる */
+    {
+        uint32_t i, l;
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config, max_config;
+        struct LINNEEncodeParameter parameter;
+
+        LINNEEncoder_SetValidConfig(&max_config);
+        for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+            const struct LINNEParameterPreset *preset = &g_linne_parameter_preset[i];
+            LINNEEncoder_SetValidEncodeParameter(&parameter);
+            parameter.preset = (uint8_t)i;
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+            EXPECT_EQ(parameter.num_channels, config.max_num_channels);
+            EXPECT_EQ(parameter.num_samples_per_block, config.max_num_samples_per_block);
+            EXPECT_EQ(preset->num_layers, config.max_num_layers);
+            for (l = 0; l < preset->num_layers; l++) {
+                EXPECT_TRUE(preset->num_params_list[l] <= config.max_num_parameters_per_layer);
+            }
+            EXPECT_EQ(LINNEEncoder_CalculateWorkSize(&config), LINNEEncoder_CalculateWorkSizeFromParameter(&parameter));
+            EXPECT_TRUE(LINNEEncoder_CalculateWorkSizeFromParameter(&parameter) < LINNEEncoder_CalculateWorkSize(&max_config));
+
+            encoder = LINNEEncoder_Create(&config, NULL, 0);
+            ASSERT_TRUE(encoder != NULL);
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+            /* 容量を超えるパラメータはセットできない */
+            parameter.num_channels++;
+            EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            parameter.num_channels--;
+            parameter.num_samples_per_block++;
+            EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            parameter.num_samples_per_block--;
+            /* 分析窓バッファ・差分の基準の領域は確保されていない */
+            EXPECT_EQ(0U, config.max_num_lookback_samples);
+            EXPECT_EQ(0, config.enable_delta_parameters);
+            parameter.num_lookback_samples = 1;
+            EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+            parameter.num_lookback_samples = 0;
+            parameter.enable_delta_parameters = 1;
+            EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+            LINNEEncoder_Destroy(encoder);
+        }
+    }
+
+    /* 分析窓の延長・差分記録を使うときだけ領域を確保する */
+    {
+        int32_t base_work_size;
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_samples_per_block = 256;
+        base_work_size = LINNEEncoder_CalculateWorkSizeFromParameter(&parameter);
+        ASSERT_TRUE(base_work_size > 0);
+        parameter.num_lookback_samples = 2048;
+        parameter.enable_delta_parameters = 1;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+        EXPECT_EQ(256U, config.max_num_samples_per_block);
+        EXPECT_EQ(2048U, config.max_num_lookback_samples);
+        EXPECT_EQ(1, config.enable_delta_parameters);
+        EXPECT_TRUE(LINNEEncoder_CalculateWorkSize(&config) > base_work_size);
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        parameter.num_lookback_samples++;
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* 失敗ケース */
+    {
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMinimumConfig(NULL, &config));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_CalculateMinimumConfig(&parameter, NULL));
+        EXPECT_TRUE(LINNEEncoder_CalculateWorkSizeFromParameter(NULL) < 0);
+
+        parameter.num_channels = 0;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+        EXPECT_TRUE(LINNEEncoder_CalculateWorkSizeFromParameter(&parameter) < 0);
+
+        /* 独自レイヤー構造のパラメータ数がブロックサイズ以上 */
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_custom_layers = 1;
+        parameter.custom_num_params_list[0] = 64;
+        parameter.num_samples_per_block = 64;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+
+        /* 独自レイヤー構造は速度目標によるプリセット切り替えと併用できない */
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_custom_layers = 1;
+        parameter.custom_num_params_list[0] = 16;
+        parameter.target_realtime_factor = 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+    }
+
+    /* 独自レイヤー構造の最小コンフィグ */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.num_custom_layers = 4;
+        parameter.custom_num_params_list[0] = 32;
+        parameter.custom_num_params_list[1] = 16;
+        parameter.custom_num_params_list[2] = 8;
+        parameter.custom_num_params_list[3] = 4;
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_CalculateMinimumConfig(&parameter, &config));
+        EXPECT_EQ(4U, config.max_num_layers);
+        EXPECT_EQ(32U, config.max_num_parameters_per_layer);
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(&encoder->custom_preset, encoder->parameter_preset);
+
+        /* 容量を超える構造はセットできない */
+        parameter.num_custom_layers = 5;
+        parameter.custom_num_params_list[4] = 2;
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        parameter.num_custom_layers = 1;
+        parameter.custom_num_params_list[0] = 64;
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* ブロック分割テスト */
+TEST(LINNEEncoderTest, DecideBlockPartitionTest)
+{
+    /* 無効な引数 */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint32_t block_num_samples[LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS];
+        uint32_t num_blocks;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        input[0] = (int32_t *)calloc(parameter.num_samples_per_block, sizeof(int32_t));
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* パラメータ未セット */
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_DecideBlockPartition(NULL, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_DecideBlockPartition(encoder, NULL, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_DecideBlockPartition(encoder, input, 0,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    NULL, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, NULL));
+        EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS - 1, &num_blocks));
+
+        /* 最小ブロックサンプル数がブロックサンプル数を超えている */
+        parameter.min_num_samples_per_block = parameter.num_samples_per_block + 1;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+        free(input[0]);
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    /* 分割の確認 */
+    {
+        struct LINNEEncoder *encoder;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[LINNE_MAX_NUM_CHANNELS];
+        uint32_t block_num_samples[LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS];
+        uint32_t i, smpl, num_blocks, total;
+
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        LINNEEncoder_SetValidConfig(&config);
+        parameter.num_samples_per_block = 8192;
+        input[0] = (int32_t *)malloc(sizeof(int32_t) * parameter.num_samples_per_block);
+
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+
+        /* 前半は正弦波、後半は雑音 */
+        srand(0);
+        for (smpl = 0; smpl < parameter.num_samples_per_block / 2; smpl++) {
+            input[0][smpl] = (int32_t)(8192.0 * sin(0.05 * smpl));
+        }
+        for (; smpl < parameter.num_samples_per_block; smpl++) {
+            input[0][smpl] = (rand() % 32768) - 16384;
+        }
+
+        /* 適応選択無効: 最大ブロックで区切る */
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(1U, num_blocks);
+        EXPECT_EQ(parameter.num_samples_per_block, block_num_samples[0]);
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, 100,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(1U, num_blocks);
+        EXPECT_EQ(100U, block_num_samples[0]);
+
+        /* 性質の異なる前後半は分割される */
+        parameter.min_num_samples_per_block = 1024;
+        parameter.block_size_search_budget = 3;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_TRUE(num_blocks >= 2);
+        total = 0;
+        for (i = 0; i < num_blocks; i++) {
+            EXPECT_TRUE(block_num_samples[i] >= parameter.min_num_samples_per_block);
+            total += block_num_samples[i];
+        }
+        EXPECT_EQ(parameter.num_samples_per_block, total);
+        /* 境界で区切られる */
+        total = 0;
+        for (i = 0; (i < num_blocks) && (total < parameter.num_samples_per_block / 2); i++) {
+            total += block_num_samples[i];
+        }
+        EXPECT_EQ(parameter.num_samples_per_block / 2, total);
+
+        /* 計算量上限×ブロックサンプル数が32bitを超えても上限は0に潰れず分割される */
+        encoder->block_size_search_budget = (uint32_t)((1ULL << 32) / parameter.num_samples_per_block);
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_TRUE(num_blocks >= 2);
+
+        /* 全体の推定しかできない計算量上限では分割しない */
+        parameter.block_size_search_budget = 1;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(1U, num_blocks);
+        EXPECT_EQ(parameter.num_samples_per_block, block_num_samples[0]);
+
+        /* 無音は分割しない */
+        memset(input[0], 0, sizeof(int32_t) * parameter.num_samples_per_block);
+        parameter.block_size_search_budget = 3;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_DecideBlockPartition(encoder, input, parameter.num_samples_per_block,
+                    block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks));
+        EXPECT_EQ(1U, num_blocks);
+        EXPECT_EQ(parameter.num_samples_per_block, block_num_samples[0]);
+
+        free(input[0]);
+        LINNEEncoder_Destroy(encoder);
+    }
+}
+
+/* ハンドルリセットテスト */
+TEST(LINNEEncoderTest, ResetTest)
+{
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_Reset(NULL));
+
+    /* 作成直後の状態に戻り、再設定後は新規ハンドルと同じ結果になるか */
+    {
+        struct LINNEEncoder *encoder, *fresh;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        int32_t *input[1];
+        uint8_t *data, *fresh_data;
+        uint32_t smpl, l, output_size, fresh_output_size;
+        const uint32_t num_samples = 4096;
+        const uint32_t data_size = 4 * num_samples;
+
+        LINNEEncoder_SetValidConfig(&config);
+        encoder = LINNEEncoder_Create(&config, NULL, 0);
+        fresh = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_TRUE(fresh != NULL);
+
+        input[0] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        data = (uint8_t *)malloc(data_size);
+        fresh_data = (uint8_t *)malloc(data_size);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[0][smpl] = (int32_t)(8192.0 * sin(0.03 * smpl));
+        }
+
+        /* 速度目標付きでエンコードして状態を残す */
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.preset = 2;
+        parameter.target_realtime_factor = 1;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &output_size));
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_Reset(encoder));
+        EXPECT_EQ(0, encoder->set_parameter);
+        EXPECT_TRUE(encoder->parameter_preset == NULL);
+        EXPECT_EQ(0U, encoder->target_realtime_factor);
+        EXPECT_EQ(0U, encoder->num_speed_levels);
+        EXPECT_EQ(0U, encoder->speed_level);
+        for (l = 0; l < LINNEENCODER_MAX_NUM_SPEED_LEVELS; l++) {
+            EXPECT_EQ(0.0, encoder->speed_level_cost[l]);
+        }
+
+        /* パラメータを設定し直すまでエンコードできない */
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &output_size));
+
+        /* 再設定後は新規ハンドルと一致 */
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        parameter.preset = 1;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(fresh, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &output_size));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeWhole(fresh, (const int32_t *const *)input, num_samples, fresh_data, data_size, &fresh_output_size));
+        EXPECT_EQ(fresh_output_size, output_size);
+        EXPECT_EQ(0, memcmp(data, fresh_data, output_size));
+
+        free(input[0]);
+        free(data);
+        free(fresh_data);
+        LINNEEncoder_Destroy(encoder);
+        LINNEEncoder_Destroy(fresh);
+    }
+}
+
+/* 圧縮サイズ推定テスト */
+TEST(LINNEEncoderTest, EstimateWholeTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEEncoderConfig config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEEncodeEstimate estimate;
+    int32_t *input[1];
+    uint8_t *data;
+    uint32_t smpl, output_size;
+    /* 末尾に短いブロックが残るサンプル数 */
+    const uint32_t num_samples = 10 * 1024 + 300;
+    const uint32_t data_size = 4 * num_samples;
+
+    LINNEEncoder_SetValidConfig(&config);
+    encoder = LINNEEncoder_Create(&config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+
+    input[0] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+    data = (uint8_t *)malloc(data_size);
+    /* 途中から振幅と雑音が増える信号 */
+    srand(0);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        const double amp = (smpl < num_samples / 2) ? 1024.0 : 8192.0;
+        input[0][smpl] = (int32_t)(amp * sin(0.03 * smpl)) + (rand() % 64) - 32;
+    }
+
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EstimateWhole(NULL, (const int32_t *const *)input, num_samples, 4, &estimate));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EstimateWhole(encoder, NULL, num_samples, 4, &estimate));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, 0, 4, &estimate));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, num_samples, 0, &estimate));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, num_samples, 4, NULL));
+
+    /* パラメータ未設定 */
+    EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, num_samples, 4, &estimate));
+
+    LINNEEncoder_SetValidEncodeParameter(&parameter);
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+
+    /* 一部のブロックのみ分析: 推定値は信頼区間に収まる */
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, num_samples, 4, &estimate));
+    EXPECT_EQ(11U, estimate.num_blocks);
+    EXPECT_EQ(4U, estimate.num_analyzed_blocks);
+    EXPECT_TRUE(estimate.estimated_size_lower <= estimate.estimated_size);
+    EXPECT_TRUE(estimate.estimated_size <= estimate.estimated_size_upper);
+    EXPECT_TRUE(estimate.estimated_size_lower < estimate.estimated_size_upper);
+    EXPECT_TRUE(estimate.estimated_encode_time >= 0.0);
+
+    /* 全ブロックを分析すると実際のエンコード結果と一致し、区間の幅は0 */
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EstimateWhole(encoder, (const int32_t *const *)input, num_samples, 100, &estimate));
+    EXPECT_EQ(11U, estimate.num_analyzed_blocks);
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EncodeWhole(encoder, (const int32_t *const *)input, num_samples, data, data_size, &output_size));
+    EXPECT_NEAR((double)output_size, estimate.estimated_size, 1e-6);
+    EXPECT_NEAR(estimate.estimated_size, estimate.estimated_size_lower, 1e-6);
+    EXPECT_NEAR(estimate.estimated_size, estimate.estimated_size_upper, 1e-6);
+
+    free(input[0]);
+    free(data);
+    LINNEEncoder_Destroy(encoder);
+}
+
+/* 事前分析によるエンコードパラメータ決定テスト */
+TEST(LINNEEncoderTest, PreAnalyzeWholeTest)
+{
+    struct LINNEEncoder *encoder;
+    struct LINNEEncoderConfig config;
+    struct LINNEEncodeParameter parameter, analyzed;
+    int32_t *input[2];
+    uint32_t ch, smpl;
+    const uint32_t num_samples = 16 * 8192;
+
+    LINNEEncoder_SetValidConfig(&config);
+    encoder = LINNEEncoder_Create(&config, NULL, 0);
+    ASSERT_TRUE(encoder != NULL);
+
+    for (ch = 0; ch < 2; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+    }
+
+    /* 最大のプリセット・ブロックサイズを上限にMS処理を指定したステレオのパラメータ */
+    LINNEEncoder_SetValidEncodeParameter(&parameter);
+    parameter.num_channels = 2;
+    parameter.num_samples_per_block = 8192;
+    parameter.preset = LINNE_NUM_PARAMETER_PRESETS - 1;
+    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+
+    /* 不正な引数 */
+    analyzed = parameter;
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_PreAnalyzeWhole(NULL, (const int32_t *const *)input, num_samples, 8, &analyzed));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_PreAnalyzeWhole(encoder, NULL, num_samples, 8, &analyzed));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, 0, 8, &analyzed));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 0, &analyzed));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, NULL));
+
+    /* 容量を超えるパラメータ */
+    analyzed = parameter;
+    analyzed.num_samples_per_block = 16384;
+    EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, &analyzed));
+
+    /* 両チャンネルが同じ定常な信号: MS処理し、ブロックサイズは変えない */
+    srand(0);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        input[0][smpl] = input[1][smpl] = (int32_t)(((rand() % 64) - 32) + 4096.0 * sin(0.01 * smpl));
+    }
+    analyzed = parameter;
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, &analyzed));
+    EXPECT_EQ(LINNE_CH_PROCESS_METHOD_MS, analyzed.ch_process_method);
+    EXPECT_EQ(parameter.num_samples_per_block, analyzed.num_samples_per_block);
+    EXPECT_TRUE(analyzed.preset <= parameter.preset);
+    /* 決め直したパラメータはそのまま設定できる */
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &analyzed));
+
+    /* 振幅の大きく異なる無相関な雑音: チャンネル処理せず、最小のプリセットを選ぶ */
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        input[0][smpl] = (rand() % 32768) - 16384;
+        input[1][smpl] = (rand() % 64) - 32;
+    }
+    analyzed = parameter;
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, &analyzed));
+    EXPECT_EQ(LINNE_CH_PROCESS_METHOD_NONE, analyzed.ch_process_method);
+    EXPECT_EQ(0, analyzed.preset);
+
+    /* 短い区間毎に正弦波と雑音が入れ替わる信号: ブロックサイズを短くする
+    * ブロックサイズの効果だけを見るため最小のプリセットから始め、
+    * 区間の周期と分析ブロックの間隔が揃って推定が偏らないよう全ブロックを分析する */
+    for (smpl = 0; smpl < num_samples; smpl++) {
+        for (ch = 0; ch < 2; ch++) {
+            input[ch][smpl] = ((smpl / 2048) % 2 == 0)
+                ? (int32_t)(16384.0 * sin(0.05 * smpl)) : ((rand() % 16384) - 8192);
+        }
+    }
+    analyzed = parameter;
+    analyzed.preset = 0;
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, num_samples, &analyzed));
+    EXPECT_LT(analyzed.num_samples_per_block, parameter.num_samples_per_block);
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &analyzed));
+
+    /* 適応ブロックサイズ選択ではブロックサイズ、独自レイヤー構造ではプリセットを変えない */
+    analyzed = parameter;
+    analyzed.min_num_samples_per_block = 1024;
+    analyzed.block_size_search_budget = 1;
+    analyzed.num_custom_layers = 2;
+    analyzed.custom_num_params_list[0] = 32;
+    analyzed.custom_num_params_list[1] = 8;
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_PreAnalyzeWhole(encoder, (const int32_t *const *)input, num_samples, 8, &analyzed));
+    EXPECT_EQ(parameter.num_samples_per_block, analyzed.num_samples_per_block);
+    EXPECT_EQ(parameter.preset, analyzed.preset);
+
+    for (ch = 0; ch < 2; ch++) {
+        free(input[ch]);
+    }
+    LINNEEncoder_Destroy(encoder);
+}
+
+/* 実行したタスク数を数えながら逆順に実行するタスク実行コールバック */
+static void LINNEEncoderTest_RunTasksReverse(
+        LINNEEncoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data)
+{
+    uint32_t i;
+    uint32_t *num_executed_tasks = (uint32_t *)user_data;
+
+    for (i = num_tasks; i > 0; i--) {
+        task(task_context, i - 1);
+        (*num_executed_tasks)++;
+    }
+}
+
+/* プリセット競争エンコードテスト */
+TEST(LINNEEncoderTest, EncodeBlockRaceTest)
+{
+    struct LINNEEncoder *encoders[LINNE_NUM_PARAMETER_PRESETS], *single, *mixed[2];
+    struct LINNEEncoderConfig config;
+    struct LINNEEncodeParameter parameter;
+    int32_t *input[2];
+    uint8_t *data, *single_data;
+    uint32_t i, ch, smpl, output_size, single_output_size, min_single_output_size, num_executed_tasks;
+    const uint32_t num_samples = 1000;
+    const uint32_t data_size = LINNEENCODER_CALCULATE_MAX_BLOCK_SIZE(2, 16, num_samples);
+
+    LINNEEncoder_SetValidConfig(&config);
+    for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+        encoders[i] = LINNEEncoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(encoders[i] != NULL);
+    }
+    single = LINNEEncoder_Create(&config, NULL, 0);
+    ASSERT_TRUE(single != NULL);
+
+    data = (uint8_t *)malloc(data_size);
+    single_data = (uint8_t *)malloc(data_size);
+    srand(0);
+    for (ch = 0; ch < 2; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(((rand() % 256) - 128) + 8192.0 * sin(0.02 * (ch + 1) * smpl));
+        }
+    }
+
+    /* パラメータ未設定 */
+    EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, data, data_size, &output_size));
+
+    /* ブロック毎のプリセット番号を記録する設定 */
+    LINNEEncoder_SetValidEncodeParameter(&parameter);
+    parameter.num_channels = 2;
+    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    parameter.enable_block_preset = 1;
+    for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+        parameter.preset = (uint8_t)i;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoders[i], &parameter));
+    }
+
+    /* 不正な引数 */
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(NULL, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, 0,
+                input, num_samples, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNEENCODER_MAX_NUM_RACE_ENCODERS + 1,
+                input, num_samples, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                NULL, num_samples, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, 0, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, NULL, data_size, &output_size));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, data, data_size, NULL));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEEncoder_SetTaskCallback(NULL, NULL, NULL));
+
+    /* ブロックあたりサンプル数を超える */
+    EXPECT_EQ(LINNE_APIRESULT_INSUFFICIENT_BUFFER,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, parameter.num_samples_per_block + 1, data, data_size, &output_size));
+
+    /* プリセット番号を記録しないエンコーダ・前処理が異なるエンコーダは混ぜられない */
+    mixed[0] = encoders[0];
+    mixed[1] = single;
+    parameter.preset = 1;
+    parameter.enable_block_preset = 0;
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(single, &parameter));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+            LINNEEncoder_EncodeBlockRace(mixed, 2, input, num_samples, data, data_size, &output_size));
+    parameter.enable_block_preset = 1;
+    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_NONE;
+    ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(single, &parameter));
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT,
+            LINNEEncoder_EncodeBlockRace(mixed, 2, input, num_samples, data, data_size, &output_size));
+    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+
+    /* 独自レイヤー構造はプリセット番号を記録できない */
+    parameter.num_custom_layers = 1;
+    parameter.custom_num_params_list[0] = 16;
+    EXPECT_EQ(LINNE_APIRESULT_INVALID_FORMAT, LINNEEncoder_SetEncodeParameter(single, &parameter));
+    parameter.num_custom_layers = 0;
+
+    /* 競争の結果は各プリセット単独のエンコード結果のうち最小のものと一致する */
+    num_executed_tasks = 0;
+    EXPECT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_SetTaskCallback(encoders[0], LINNEEncoderTest_RunTasksReverse, &num_executed_tasks));
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, data, data_size, &output_size));
+    EXPECT_EQ(LINNE_NUM_PARAMETER_PRESETS, num_executed_tasks);
+    min_single_output_size = data_size;
+    for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+        parameter.preset = (uint8_t)i;
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(single, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlock(single, input, num_samples, single_data, data_size, &single_output_size));
+        EXPECT_TRUE(output_size <= single_output_size);
+        if (single_output_size < min_single_output_size) {
+            min_single_output_size = single_output_size;
+            EXPECT_EQ(0, memcmp(&data[LINNE_BLOCK_HEADER_SIZE], &single_data[LINNE_BLOCK_HEADER_SIZE],
+                        output_size - LINNE_BLOCK_HEADER_SIZE));
+        }
+    }
+    EXPECT_EQ(min_single_output_size, output_size);
+
+    /* コールバック解除後は使われず、結果も変わらない */
+    num_executed_tasks = 0;
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetTaskCallback(encoders[0], NULL, &num_executed_tasks));
+    ASSERT_EQ(LINNE_APIRESULT_OK,
+            LINNEEncoder_EncodeBlockRace(encoders, LINNE_NUM_PARAMETER_PRESETS,
+                input, num_samples, single_data, data_size, &single_output_size));
+    EXPECT_EQ(0U, num_executed_tasks);
+    EXPECT_EQ(output_size, single_output_size);
+    EXPECT_EQ(0, memcmp(data, single_data, output_size));
+
+    for (ch = 0; ch < 2; ch++) {
+        free(input[ch]);
+    }
+    free(data);
+    free(single_data);
+    for (i = 0; i < LINNE_NUM_PARAMETER_PRESETS; i++) {
+        LINNEEncoder_Destroy(encoders[i]);
+    }
+    LINNEEncoder_Destroy(single);
 }
@@ -1,4 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_encoder/src/linne_lpc_predict.c"
 }
+
+/* 参照用の次数可変なLPC予測 */
+static void LINNELPCPredictTest_PredictReference(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    int32_t predict;
+    uint32_t smpl, ord;
+    const int32_t half = 1 << (coef_rshift - 1);
+
+    memcpy(residual, data, sizeof(int32_t) * num_samples);
+    for (smpl = 1; smpl < coef_order; smpl++) {
+        predict = half;
+        for (ord = 0; ord < smpl; ord++) {
+            predict += (coef[coef_order - smpl + ord] * data[ord]);
+        }
+        residual[smpl] += (predict >> coef_rshift);
+    }
+    for (smpl = coef_order; smpl < num_samples; smpl++) {
+        predict = half;
+        for (ord = 0; ord < coef_order; ord++) {
+            predict += (coef[ord] * data[smpl - coef_order + ord]);
+        }
+        residual[smpl] += (predict >> coef_rshift);
+    }
+}
+
+/* 参照用の64bit積和によるLPC予測 */
+static void LINNELPCPredictTest_PredictInt64Reference(
+    const int32_t *data, uint32_t num_samples,
+    const int32_t *coef, uint32_t coef_order, int32_t *residual, uint32_t coef_rshift)
+{
+    int64_t predict;
+    uint32_t smpl, ord;
+
+    memcpy(residual, data, sizeof(int32_t) * num_samples);
+    for (smpl = 1; smpl < num_samples; smpl++) {
+        const uint32_t order = (smpl < coef_order) ? smpl : coef_order;
+        predict = (int64_t)1 << (coef_rshift - 1);
+        for (ord = 0; ord < order; ord++) {
+            predict += ((int64_t)coef[coef_order - order + ord] * data[smpl - order + ord]);
+        }
+        residual[smpl] += (int32_t)(predict >> coef_rshift);
+    }
+}
+
+/* 固定次数カーネルが次数可変の予測と一致するか */
+TEST(LINNELPCPredictTest, FixedOrderKernelTest)
+{
+    uint32_t i, j, smpl;
+    /* カーネルを持つ次数と持たない次数(5, 7)の両方を確認 */
+    const uint32_t orders[] = { 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 1024 };
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            const uint32_t order = orders[i];
+            const uint32_t num_samples = nums_samples[j];
+            int32_t *data, *residual, *answer;
+            int32_t coef[128];
+
+            if (order > num_samples) {
+                continue;
+            }
+
+            data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            residual = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                data[smpl] = (rand() % 4096) - 2048;
+            }
+            for (smpl = 0; smpl < order; smpl++) {
+                coef[smpl] = (rand() % 64) - 32;
+            }
+
+            LINNELPCPredictTest_PredictReference(data, num_samples, coef, order, answer, 8);
+            LINNELPC_Predict(data, num_samples, coef, order, residual, 8);
+            EXPECT_EQ(0, memcmp(answer, residual, sizeof(int32_t) * num_samples));
+
+            free(data);
+            free(residual);
+            free(answer);
+        }
+    }
+}
+
+/* 16bit積和による予測が参照実装と一致するか */
+TEST(LINNELPCPredictTest, PredictInt16Test)
+{
+    uint32_t i, j, smpl;
+    /* 16bit積和カーネルを持つ次数(8の倍数)と持たない次数の両方を確認 */
+    const uint32_t orders[] = { 1, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 300, 1024 };
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            const uint32_t order = orders[i];
+            const uint32_t num_samples = nums_samples[j];
+            int32_t *data, *residual, *answer;
+            int32_t coef[128];
+
+            if (order > num_samples) {
+                continue;
+            }
+
+            /* 入力と係数は16bitと8bitの全域を使う */
+            data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            residual = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                data[smpl] = (rand() % 65536) - 32768;
+            }
+            data[0] = INT16_MIN;
+            data[num_samples - 1] = INT16_MAX;
+            for (smpl = 0; smpl < order; smpl++) {
+                coef[smpl] = (rand() % 256) - 128;
+            }
+
+            LINNELPCPredictTest_PredictReference(data, num_samples, coef, order, answer, 8);
+            LINNELPC_PredictInt16(data, num_samples, coef, order, residual, 8);
+            EXPECT_EQ(0, memcmp(answer, residual, sizeof(int32_t) * num_samples));
+
+            free(data);
+            free(residual);
+            free(answer);
+        }
+    }
+}
+
+/* 64bit積和による予測が参照実装と一致するか */
+TEST(LINNELPCPredictTest, PredictInt64Test)
+{
+    uint32_t i, j, k, smpl;
+    const uint32_t orders[] = { 1, 2, 3, 8, 15, 16, 32, 64, 96, 128 };
+    const uint32_t nums_samples[] = { 1, 7, 128, 129, 300, 1024 };
+    /* 24bit音源のMS変換・プリエンファシス後の最大振幅 */
+    const int32_t amplitude = (1 << 25) - 1;
+
+    srand(0);
+    for (i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (j = 0; j < sizeof(nums_samples) / sizeof(nums_samples[0]); j++) {
+            /* k == 0: 積の符号を揃えた最悪ケース, k == 1: フルスケールの乱数 */
+            for (k = 0; k < 2; k++) {
+                const uint32_t order = orders[i];
+                const uint32_t num_samples = nums_samples[j];
+                int32_t *data, *residual, *answer;
+                int32_t coef[128];
+
+                if (order > num_samples) {
+                    continue;
+                }
+
+                data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                residual = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                for (smpl = 0; smpl < order; smpl++) {
+                    coef[smpl] = (k == 0) ? -128 : ((rand() % 256) - 128);
+                }
+                for (smpl = 0; smpl < num_samples; smpl++) {
+                    data[smpl] = (k == 0) ? amplitude : ((rand() % (2 * amplitude + 1)) - amplitude);
+                }
+
+                /* 最悪ケースは32bitの積和では桁あふれすると判定される */
+                if (k == 0) {
+                    EXPECT_EQ(1, LINNEUtility_IsLPCAccumulatorOverflowable(coef, order, 8, 24));
+                }
+
+                LINNELPCPredictTest_PredictInt64Reference(data, num_samples, coef, order, answer, 8);
+                LINNELPC_PredictInt64(data, num_samples, coef, order, residual, 8);
+                EXPECT_EQ(0, memcmp(answer, residual, sizeof(int32_t) * num_samples));
+
+                free(data);
+                free(residual);
+                free(answer);
+            }
+        }
+    }
+}
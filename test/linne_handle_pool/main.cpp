@@ -0,0 +1,380 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+/* テスト対象のモジュール */
+extern "C" {
+#include "../../libs/linne_handle_pool/src/linne_handle_pool.c"
+}
+
+/* 有効なエンコードパラメータをセット */
+#define LINNEEncoder_SetValidEncodeParameter(p_parameter)\
+    do {\
+        struct LINNEEncodeParameter *param__p = p_parameter;\
+        param__p->num_channels          = 1;\
+        param__p->bits_per_sample       = 16;\
+        param__p->sampling_rate         = 44100;\
+        param__p->num_samples_per_block = 1024;\
+        param__p->preset                = 0;\
+        param__p->ch_process_method     = LINNE_CH_PROCESS_METHOD_NONE;\
+        param__p->enable_learning       = 0;\
+        param__p->min_num_samples_per_block = 0;\
+        param__p->block_size_search_budget = 0;\
+        param__p->target_realtime_factor = 0;\
+        param__p->num_custom_layers = 0;\
+        param__p->enable_block_preset = 0;\
+        param__p->enable_parameter_reuse = 0;\
+        param__p->num_lookback_samples = 0;\
+        param__p->enable_delta_parameters = 0;\
+        param__p->keyframe_interval = 0;\
+    } while (0);
+
+/* 有効なエンコーダコンフィグをセット */
+#define LINNEEncoder_SetValidConfig(p_config)\
+    do {\
+        struct LINNEEncoderConfig *config__p = p_config;\
+        config__p->max_num_channels             = 2;\
+        config__p->max_num_samples_per_block    = 4096;\
+        config__p->max_num_layers               = 4;\
+        config__p->max_num_parameters_per_layer = 128;\
+        config__p->max_num_lookback_samples     = 0;\
+        config__p->enable_delta_parameters      = 0;\
+    } while (0);
+
+/* 有効なデコーダコンフィグをセット */
+#define LINNEDecoder_SetValidConfig(p_config)\
+    do {\
+        struct LINNEDecoderConfig *config__p = p_config;\
+        config__p->max_num_channels             = 2;\
+        config__p->max_num_layers               = 4;\
+        config__p->max_num_parameters_per_layer = 128;\
+        config__p->check_crc                    = 1;\
+    } while (0);
+
+/* ハンドルプール作成破棄テスト */
+TEST(LINNEHandlePoolTest, CreateDestroyTest)
+{
+    /* ワークサイズ計算テスト */
+    {
+        int32_t work_size;
+        struct LINNEEncoderConfig encoder_config;
+        struct LINNEDecoderConfig decoder_config;
+
+        LINNEEncoder_SetValidConfig(&encoder_config);
+        LINNEDecoder_SetValidConfig(&decoder_config);
+
+        /* 最低限ハンドルの個数分よりは大きいはず */
+        work_size = LINNEEncoderPool_CalculateWorkSize(&encoder_config, 4);
+        EXPECT_TRUE(work_size > 4 * LINNEEncoder_CalculateWorkSize(&encoder_config));
+        work_size = LINNEDecoderPool_CalculateWorkSize(&decoder_config, 4);
+        EXPECT_TRUE(work_size > 4 * LINNEDecoder_CalculateWorkSize(&decoder_config));
+
+        /* 不正な引数 */
+        EXPECT_TRUE(LINNEEncoderPool_CalculateWorkSize(NULL, 4) < 0);
+        EXPECT_TRUE(LINNEEncoderPool_CalculateWorkSize(&encoder_config, 0) < 0);
+        EXPECT_TRUE(LINNEDecoderPool_CalculateWorkSize(NULL, 4) < 0);
+        EXPECT_TRUE(LINNEDecoderPool_CalculateWorkSize(&decoder_config, 0) < 0);
+
+        /* int32_tで表せないサイズになる個数 */
+        EXPECT_TRUE(LINNEEncoderPool_CalculateWorkSize(&encoder_config, 0xFFFFFFFFUL) < 0);
+        EXPECT_TRUE(LINNEDecoderPool_CalculateWorkSize(&decoder_config, 0xFFFFFFFFUL) < 0);
+        EXPECT_TRUE(LINNEEncoderPool_CalculateWorkSize(&encoder_config,
+                    (uint32_t)(INT32_MAX / LINNEEncoder_CalculateWorkSize(&encoder_config)) + 1) < 0);
+
+        /* 不正なコンフィグ */
+        encoder_config.max_num_channels = 0;
+        EXPECT_TRUE(LINNEEncoderPool_CalculateWorkSize(&encoder_config, 4) < 0);
+        decoder_config.max_num_channels = 0;
+        EXPECT_TRUE(LINNEDecoderPool_CalculateWorkSize(&decoder_config, 4) < 0);
+    }
+
+    /* ワーク領域渡しによる作成（成功例） */
+    {
+        void *work;
+        int32_t work_size;
+        struct LINNEEncoderPool *pool;
+        struct LINNEEncoderConfig config;
+
+        LINNEEncoder_SetValidConfig(&config);
+        work_size = LINNEEncoderPool_CalculateWorkSize(&config, 4);
+        ASSERT_TRUE(work_size > 0);
+        work = malloc((size_t)work_size);
+
+        pool = LINNEEncoderPool_Create(&config, 4, work, work_size);
+        ASSERT_TRUE(pool != NULL);
+        EXPECT_EQ(4, pool->pool.num_handles);
+        EXPECT_EQ(4, LINNEEncoderPool_GetNumFreeHandles(pool));
+        EXPECT_EQ(0, pool->pool.alloced_by_own);
+        EXPECT_TRUE(pool->pool.work == work);
+
+        LINNEEncoderPool_Destroy(pool);
+        free(work);
+    }
+
+    /* 自前確保による作成（成功例） */
+    {
+        struct LINNEDecoderPool *pool;
+        struct LINNEDecoderConfig config;
+
+        LINNEDecoder_SetValidConfig(&config);
+
+        pool = LINNEDecoderPool_Create(&config, 3, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+        EXPECT_EQ(3, pool->pool.num_handles);
+        EXPECT_EQ(3, LINNEDecoderPool_GetNumFreeHandles(pool));
+        EXPECT_EQ(1, pool->pool.alloced_by_own);
+        EXPECT_TRUE(pool->pool.work != NULL);
+
+        LINNEDecoderPool_Destroy(pool);
+    }
+
+    /* 作成失敗例 */
+    {
+        void *work;
+        int32_t work_size;
+        struct LINNEEncoderConfig config;
+
+        LINNEEncoder_SetValidConfig(&config);
+        work_size = LINNEEncoderPool_CalculateWorkSize(&config, 4);
+        ASSERT_TRUE(work_size > 0);
+        work = malloc((size_t)work_size);
+
+        /* 引数が不正 */
+        EXPECT_TRUE(LINNEEncoderPool_Create(NULL, 4, work, work_size) == NULL);
+        EXPECT_TRUE(LINNEEncoderPool_Create(&config, 0, work, work_size) == NULL);
+        EXPECT_TRUE(LINNEEncoderPool_Create(&config, 4, NULL, work_size) == NULL);
+        EXPECT_TRUE(LINNEEncoderPool_Create(&config, 4, work, 0) == NULL);
+
+        /* ワークサイズ不足 */
+        EXPECT_TRUE(LINNEEncoderPool_Create(&config, 4, work, work_size - 1) == NULL);
+
+        /* コンフィグが不正 */
+        config.max_num_layers = 0;
+        EXPECT_TRUE(LINNEEncoderPool_Create(&config, 4, work, work_size) == NULL);
+
+        free(work);
+    }
+}
+
+/* ハンドル貸し出し返却テスト */
+TEST(LINNEHandlePoolTest, AcquireReleaseTest)
+{
+    /* 全て貸し出すと空きがなくなり、返却すると再度貸し出せる */
+    {
+        uint32_t i, j;
+        struct LINNEEncoderPool *pool;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncoder *encoders[4];
+
+        LINNEEncoder_SetValidConfig(&config);
+        pool = LINNEEncoderPool_Create(&config, 4, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+
+        for (i = 0; i < 4; i++) {
+            encoders[i] = LINNEEncoderPool_Acquire(pool);
+            ASSERT_TRUE(encoders[i] != NULL);
+            EXPECT_EQ(4 - i - 1, LINNEEncoderPool_GetNumFreeHandles(pool));
+            /* 貸し出したハンドルは全て異なる */
+            for (j = 0; j < i; j++) {
+                EXPECT_TRUE(encoders[i] != encoders[j]);
+            }
+        }
+        EXPECT_TRUE(LINNEEncoderPool_Acquire(pool) == NULL);
+
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoderPool_Release(pool, encoders[2]));
+        EXPECT_EQ(1, LINNEEncoderPool_GetNumFreeHandles(pool));
+        EXPECT_TRUE(LINNEEncoderPool_Acquire(pool) == encoders[2]);
+
+        for (i = 0; i < 4; i++) {
+            EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoderPool_Release(pool, encoders[i]));
+        }
+        EXPECT_EQ(4, LINNEEncoderPool_GetNumFreeHandles(pool));
+
+        LINNEEncoderPool_Destroy(pool);
+    }
+
+    /* 返却失敗例 */
+    {
+        struct LINNEDecoderPool *pool;
+        struct LINNEDecoderConfig config;
+        struct LINNEDecoder *decoder, *other;
+
+        LINNEDecoder_SetValidConfig(&config);
+        pool = LINNEDecoderPool_Create(&config, 2, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+        other = LINNEDecoder_Create(&config, NULL, 0);
+        ASSERT_TRUE(other != NULL);
+
+        decoder = LINNEDecoderPool_Acquire(pool);
+        ASSERT_TRUE(decoder != NULL);
+
+        /* 引数が不正 */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoderPool_Release(NULL, decoder));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoderPool_Release(pool, NULL));
+
+        /* プールのハンドルではない */
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoderPool_Release(pool, other));
+
+        /* 二重返却 */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEDecoderPool_Release(pool, decoder));
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNEDecoderPool_Release(pool, decoder));
+        EXPECT_EQ(2, LINNEDecoderPool_GetNumFreeHandles(pool));
+
+        /* プールがNULL */
+        EXPECT_TRUE(LINNEDecoderPool_Acquire(NULL) == NULL);
+        EXPECT_EQ(0, LINNEDecoderPool_GetNumFreeHandles(NULL));
+
+        LINNEDecoder_Destroy(other);
+        LINNEDecoderPool_Destroy(pool);
+    }
+
+    /* 返却されたハンドルはパラメータ未設定に戻る */
+    {
+        struct LINNEEncoderPool *pool;
+        struct LINNEEncoderConfig config;
+        struct LINNEEncodeParameter parameter;
+        struct LINNEEncoder *encoder;
+        int32_t input_buffer[256];
+        const int32_t *input[1];
+        uint8_t data[4096];
+        uint32_t output_size;
+
+        LINNEEncoder_SetValidConfig(&config);
+        LINNEEncoder_SetValidEncodeParameter(&parameter);
+        memset(input_buffer, 0, sizeof(input_buffer));
+        input[0] = input_buffer;
+
+        pool = LINNEEncoderPool_Create(&config, 1, NULL, 0);
+        ASSERT_TRUE(pool != NULL);
+
+        encoder = LINNEEncoderPool_Acquire(pool);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_EncodeBlock(encoder, input, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        EXPECT_EQ(LINNE_APIRESULT_OK,
+                LINNEEncoder_EncodeBlock(encoder, input, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoderPool_Release(pool, encoder));
+
+        encoder = LINNEEncoderPool_Acquire(pool);
+        ASSERT_TRUE(encoder != NULL);
+        EXPECT_EQ(LINNE_APIRESULT_PARAMETER_NOT_SET,
+                LINNEEncoder_EncodeBlock(encoder, input, 256, data, sizeof(data), &output_size));
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNEEncoderPool_Release(pool, encoder));
+
+        LINNEEncoderPool_Destroy(pool);
+    }
+}
+
+/* 複数スレッドからの貸し出し返却テスト */
+TEST(LINNEHandlePoolTest, MultiThreadTest)
+{
+#define NUM_THREADS 8
+#define NUM_HANDLES 3
+#define NUM_ITERATIONS 50
+#define NUM_SAMPLES 2048
+    uint32_t i, smpl;
+    struct LINNEEncoderPool *encoder_pool;
+    struct LINNEDecoderPool *decoder_pool;
+    struct LINNEEncoderConfig encoder_config;
+    struct LINNEDecoderConfig decoder_config;
+    struct LINNEEncodeParameter parameter;
+    std::vector<int32_t> input_buffer(NUM_SAMPLES);
+    std::vector<uint8_t> reference(NUM_SAMPLES * 4);
+    uint32_t reference_size;
+    std::vector<std::thread> threads;
+    std::vector<int> num_failures(NUM_THREADS, 0);
+
+    LINNEEncoder_SetValidConfig(&encoder_config);
+    LINNEDecoder_SetValidConfig(&decoder_config);
+    LINNEEncoder_SetValidEncodeParameter(&parameter);
+
+    /* 入力信号と基準となるエンコード結果の作成 */
+    for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        input_buffer[smpl] = (int32_t)(8192.0 * sin(0.05 * smpl));
+    }
+    {
+        const int32_t *input[1] = { &input_buffer[0] };
+        struct LINNEEncoder *encoder = LINNEEncoder_Create(&encoder_config, NULL, 0);
+        ASSERT_TRUE(encoder != NULL);
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_SetEncodeParameter(encoder, &parameter));
+        ASSERT_EQ(LINNE_APIRESULT_OK, LINNEEncoder_EncodeWhole(encoder,
+                    input, NUM_SAMPLES, &reference[0], (uint32_t)reference.size(), &reference_size));
+        LINNEEncoder_Destroy(encoder);
+    }
+
+    encoder_pool = LINNEEncoderPool_Create(&encoder_config, NUM_HANDLES, NULL, 0);
+    ASSERT_TRUE(encoder_pool != NULL);
+    decoder_pool = LINNEDecoderPool_Create(&decoder_config, NUM_HANDLES, NULL, 0);
+    ASSERT_TRUE(decoder_pool != NULL);
+
+    /* 各スレッドでハンドルを借りてエンコード・デコードし、返却する */
+    for (i = 0; i < NUM_THREADS; i++) {
+        threads.emplace_back([&, i]() {
+            uint32_t itr, output_size;
+            std::vector<uint8_t> data(NUM_SAMPLES * 4);
+            std::vector<int32_t> output_buffer(NUM_SAMPLES);
+            const int32_t *input[1] = { &input_buffer[0] };
+            int32_t *output[1] = { &output_buffer[0] };
+
+            for (itr = 0; itr < NUM_ITERATIONS; itr++) {
+                struct LINNEEncoder *encoder;
+                struct LINNEDecoder *decoder;
+
+                /* 空きが出るまで待つ */
+                while ((encoder = LINNEEncoderPool_Acquire(encoder_pool)) == NULL) {
+                    std::this_thread::yield();
+                }
+                if ((LINNEEncoder_SetEncodeParameter(encoder, &parameter) != LINNE_APIRESULT_OK)
+                        || (LINNEEncoder_EncodeWhole(encoder, input, NUM_SAMPLES,
+                                &data[0], (uint32_t)data.size(), &output_size) != LINNE_APIRESULT_OK)
+                        || (output_size != reference_size)
+                        || (memcmp(&data[0], &reference[0], output_size) != 0)) {
+                    num_failures[i]++;
+                }
+                if (LINNEEncoderPool_Release(encoder_pool, encoder) != LINNE_APIRESULT_OK) {
+                    num_failures[i]++;
+                }
+
+                while ((decoder = LINNEDecoderPool_Acquire(decoder_pool)) == NULL) {
+                    std::this_thread::yield();
+                }
+                if ((LINNEDecoder_DecodeWhole(decoder, &data[0], output_size,
+                                output, 1, NUM_SAMPLES) != LINNE_APIRESULT_OK)
+                        || (memcmp(&output_buffer[0], &input_buffer[0], sizeof(int32_t) * NUM_SAMPLES) != 0)) {
+                    num_failures[i]++;
+                }
+                if (LINNEDecoderPool_Release(decoder_pool, decoder) != LINNE_APIRESULT_OK) {
+                    num_failures[i]++;
+                }
+            }
+        });
+    }
+    for (i = 0; i < NUM_THREADS; i++) {
+        threads[i].join();
+    }
+
+    for (i = 0; i < NUM_THREADS; i++) {
+        EXPECT_EQ(0, num_failures[i]);
+    }
+    EXPECT_EQ(NUM_HANDLES, LINNEEncoderPool_GetNumFreeHandles(encoder_pool));
+    EXPECT_EQ(NUM_HANDLES, LINNEDecoderPool_GetNumFreeHandles(decoder_pool));
+
+    LINNEEncoderPool_Destroy(encoder_pool);
+    LINNEDecoderPool_Destroy(decoder_pool);
+#undef NUM_THREADS
+#undef NUM_HANDLES
+#undef NUM_ITERATIONS
+#undef NUM_SAMPLES
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -6,6 +6,66 @@
 /* テスト対象のモジュール */
 extern "C" {
 #include "../../libs/linne_internal/src/linne_utility.c"
+#include "../../libs/linne_internal/src/linne_internal.c"
+}
+
+#include "../common/linne_test_allocator.h"
+
+/* アロケータ設定テスト */
+TEST(LINNEInternalTest, AllocatorTest)
+{
+    /* 不正な設定 */
+    {
+        struct LINNEAllocator allocator;
+
+        allocator.allocate = NULL;
+        allocator.deallocate = LINNETestAllocator_Deallocate;
+        allocator.context = NULL;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNE_SetAllocator(&allocator));
+
+        allocator.allocate = LINNETestAllocator_Allocate;
+        allocator.deallocate = NULL;
+        EXPECT_EQ(LINNE_APIRESULT_INVALID_ARGUMENT, LINNE_SetAllocator(&allocator));
+    }
+
+    /* 設定したアロケータで確保・解放される */
+    {
+        void *ptr;
+        struct LINNEAllocator get_allocator;
+        struct LINNETestAllocatorContext ctx;
+
+        LINNETestAllocator_Install(&ctx, 1);
+        LINNE_GetAllocator(&get_allocator);
+        EXPECT_TRUE(get_allocator.allocate == LINNETestAllocator_Allocate);
+        EXPECT_TRUE(get_allocator.deallocate == LINNETestAllocator_Deallocate);
+        EXPECT_TRUE(get_allocator.context == &ctx);
+
+        ptr = LINNE_AllocateMemory(16);
+        ASSERT_TRUE(ptr != NULL);
+        EXPECT_EQ(1, ctx.num_allocate);
+        EXPECT_EQ(LINNE_MEMORY_ALIGNMENT, ctx.last_alignment);
+        LINNE_FreeMemory(ptr);
+        EXPECT_EQ(1, ctx.num_deallocate);
+
+        /* NULLの解放はアロケータに渡さない */
+        LINNE_FreeMemory(NULL);
+        EXPECT_EQ(1, ctx.num_deallocate);
+
+        /* 確保の失敗はそのまま返る */
+        EXPECT_TRUE(LINNE_AllocateMemory(16) == NULL);
+
+        /* 標準に戻す */
+        EXPECT_EQ(LINNE_APIRESULT_OK, LINNE_SetAllocator(NULL));
+        LINNE_GetAllocator(&get_allocator);
+        EXPECT_TRUE(get_allocator.allocate != LINNETestAllocator_Allocate);
+        EXPECT_TRUE(get_allocator.context == NULL);
+
+        ptr = LINNE_AllocateMemory(16);
+        ASSERT_TRUE(ptr != NULL);
+        LINNE_FreeMemory(ptr);
+        EXPECT_EQ(1, ctx.num_allocate);
+        EXPECT_EQ(1, ctx.num_deallocate);
+    }
 }
 
 /* CRC16の計算テスト */
@@ -76,8 +136,278 @@ TEST(LINNEUtilityTest, CalculateCRC16Test)
     }
 }
 
+/* ビット単位で計算するCRC16(IBM)のリファレンス実装 */
+static uint16_t CalculateCRC16Reference(const uint8_t *data, uint32_t data_size)
+{
+    uint32_t i, j;
+    uint16_t crc16 = 0;
+
+    for (i = 0; i < data_size; i++) {
+        crc16 ^= data[i];
+        for (j = 0; j < 8; j++) {
+            crc16 = (crc16 & 1) ? ((crc16 >> 1) ^ 0xA001) : (crc16 >> 1);
+        }
+    }
+
+    return crc16;
+}
+
+/* 乱数データに対するCRC16の計算テスト */
+TEST(LINNEUtilityTest, CalculateCRC16RandomDataTest)
+{
+    uint32_t i, offset, size;
+    uint8_t *data;
+    const uint32_t max_size = 4096 + 64;
+
+    data = (uint8_t *)malloc(max_size);
+    srand(0);
+    for (i = 0; i < max_size; i++) {
+        data[i] = (uint8_t)(rand() & 0xFF);
+    }
+
+    /* 先頭のずれとサイズを色々変えて一致を確認 */
+    for (offset = 0; offset < 16; offset++) {
+        for (size = 0; size <= 300; size++) {
+            const uint16_t answer = CalculateCRC16Reference(&data[offset], size);
+            EXPECT_EQ(answer, LINNEUtility_CalculateCRC16(&data[offset], size));
+            EXPECT_EQ(answer, LINNEUtility_CalculateCRC16Slicing8(0, &data[offset], size));
+#if defined(LINNEUTILITY_USE_CRC16_CLMUL)
+            if ((size >= LINNEUTILITY_CRC16_CLMUL_MIN_SIZE) && LINNEUtility_IsCLMULSupported()) {
+                EXPECT_EQ(answer, LINNEUtility_CalculateCRC16CLMUL(&data[offset], size));
+            }
+#endif
+        }
+    }
+
+    /* 長いデータ */
+    for (i = 0; i < 64; i++) {
+        offset = (uint32_t)(rand() % 64);
+        size = (uint32_t)(rand() % 4096);
+        EXPECT_EQ(CalculateCRC16Reference(&data[offset], size), LINNEUtility_CalculateCRC16(&data[offset], size));
+    }
+
+    /* 全て0xFFのデータ */
+    memset(data, 0xFF, max_size);
+    EXPECT_EQ(CalculateCRC16Reference(data, max_size), LINNEUtility_CalculateCRC16(data, max_size));
+
+    free(data);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+/* 参照用の多段デエンファシス: フィルタ毎に逐次デエンファシス */
+static void LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(
+        struct LINNEPreemphasisFilter *preem, int32_t *buffer, uint32_t num_samples)
+{
+    int32_t l;
+    for (l = LINNE_NUM_PREEMPHASIS_FILTERS - 1; l >= 0; l--) {
+        LINNEPreemphasisFilter_Deemphasis(&preem[l], buffer, num_samples);
+    }
+}
+
+/* 多段デエンファシスのテスト */
+TEST(LINNEPreemphasisFilterTest, MultiStageDeemphasisTest)
+{
+    /* 逐次デエンファシスと一致するか */
+    {
+        uint32_t i, trial, smpl, ch;
+        int32_t l;
+        const uint32_t nums_samples[] = { 1, 10, 255, 256, 257, 1000, 4099, 8192 };
+
+        srand(0);
+        for (i = 0; i < sizeof(nums_samples) / sizeof(nums_samples[0]); i++) {
+            for (trial = 0; trial < 8; trial++) {
+                const uint32_t num_samples = nums_samples[i];
+                struct LINNEPreemphasisFilter preem[2][LINNE_NUM_PREEMPHASIS_FILTERS];
+                struct LINNEPreemphasisFilter answer_preem[2][LINNE_NUM_PREEMPHASIS_FILTERS];
+                struct LINNEPreemphasisFilter *ppreem[2];
+                int32_t *data[2], *answer[2];
+
+                for (ch = 0; ch < 2; ch++) {
+                    data[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                    answer[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                    for (smpl = 0; smpl < num_samples; smpl++) {
+                        data[ch][smpl] = answer[ch][smpl] = (rand() % 65536) - 32768;
+                    }
+                    for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                        preem[ch][l].coef = rand() % (1 << (LINNE_PREEMPHASIS_COEF_SHIFT - 1));
+                        preem[ch][l].prev = (rand() % 65536) - 32768;
+                        answer_preem[ch][l] = preem[ch][l];
+                    }
+                    ppreem[ch] = preem[ch];
+                }
+
+                /* 1チャンネル */
+                LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[0], answer[0], num_samples);
+                LINNEPreemphasisFilter_MultiStageDeemphasis(preem[0], data[0], num_samples);
+                EXPECT_EQ(0, memcmp(answer[0], data[0], sizeof(int32_t) * num_samples));
+                for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                    EXPECT_EQ(answer_preem[0][l].prev, preem[0][l].prev);
+                }
+
+                /* 2チャンネル+LR変換 1チャンネル目は処理済みの結果をさらに処理 */
+                LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[0], answer[0], num_samples);
+                LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[1], answer[1], num_samples);
+                LINNEUtility_LRConversion(answer, num_samples);
+                LINNEPreemphasisFilter_MultiStageDeemphasisLRConversion(ppreem, data, num_samples);
+                for (ch = 0; ch < 2; ch++) {
+                    EXPECT_EQ(0, memcmp(answer[ch], data[ch], sizeof(int32_t) * num_samples));
+                    for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                        EXPECT_EQ(answer_preem[ch][l].prev, preem[ch][l].prev);
+                    }
+                    free(data[ch]);
+                    free(answer[ch]);
+                }
+            }
+        }
+    }
+
+    /* ブロック先頭の状態推定が外れる場合も一致するか */
+    {
+        uint32_t smpl, ch;
+        int32_t l;
+        const uint32_t num_samples = 1024;
+        struct LINNEPreemphasisFilter preem[2][LINNE_NUM_PREEMPHASIS_FILTERS];
+        struct LINNEPreemphasisFilter answer_preem[2][LINNE_NUM_PREEMPHASIS_FILTERS];
+        struct LINNEPreemphasisFilter *ppreem[2];
+        int32_t *data[2], *answer[2];
+
+        /* 係数15で入力2が続くとき、出力2と3がどちらも不動点になる
+        * 出力3から始めると、0から推定した状態（2に収束）とは一致しない */
+        for (ch = 0; ch < 2; ch++) {
+            data[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            answer[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                data[ch][smpl] = answer[ch][smpl] = 2;
+            }
+            for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                preem[ch][l].coef = 0;
+                preem[ch][l].prev = 0;
+            }
+            preem[ch][LINNE_NUM_PREEMPHASIS_FILTERS - 1].coef = 15;
+            preem[ch][LINNE_NUM_PREEMPHASIS_FILTERS - 1].prev = 3;
+            for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                answer_preem[ch][l] = preem[ch][l];
+            }
+            ppreem[ch] = preem[ch];
+        }
+
+        /* 途中から入力を変え、再計算が途中で打ち切られる場合も含める */
+        for (ch = 0; ch < 2; ch++) {
+            for (smpl = 700; smpl < 720; smpl++) {
+                data[ch][smpl] = answer[ch][smpl] = -100;
+            }
+        }
+
+        LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[0], answer[0], num_samples);
+        LINNEPreemphasisFilter_MultiStageDeemphasis(preem[0], data[0], num_samples);
+        EXPECT_EQ(0, memcmp(answer[0], data[0], sizeof(int32_t) * num_samples));
+        EXPECT_EQ(3, data[0][100]);
+
+        for (ch = 0; ch < 2; ch++) {
+            for (smpl = 0; smpl < num_samples; smpl++) {
+                data[ch][smpl] = answer[ch][smpl] = (smpl < 700 || smpl >= 720) ? 2 : -100;
+            }
+            for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                preem[ch][l].prev = answer_preem[ch][l].prev = 0;
+            }
+            preem[ch][LINNE_NUM_PREEMPHASIS_FILTERS - 1].prev = 3;
+            answer_preem[ch][LINNE_NUM_PREEMPHASIS_FILTERS - 1].prev = 3;
+        }
+        LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[0], answer[0], num_samples);
+        LINNEPreemphasisFilterTest_MultiStageDeemphasisReference(answer_preem[1], answer[1], num_samples);
+        LINNEUtility_LRConversion(answer, num_samples);
+        LINNEPreemphasisFilter_MultiStageDeemphasisLRConversion(ppreem, data, num_samples);
+        for (ch = 0; ch < 2; ch++) {
+            EXPECT_EQ(0, memcmp(answer[ch], data[ch], sizeof(int32_t) * num_samples));
+            for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                EXPECT_EQ(answer_preem[ch][l].prev, preem[ch][l].prev);
+            }
+            free(data[ch]);
+            free(answer[ch]);
+        }
+    }
+}
+
+/* 参照用の多段プリエンファシス: 段毎に逐次相関計算・係数計算・プリエンファシス */
+static void LINNEPreemphasisFilterTest_MultiStagePreemphasisReference(
+        struct LINNEPreemphasisFilter *preem, int32_t *initial_prev, int32_t *buffer, uint32_t num_samples)
+{
+    int32_t l;
+    uint32_t smpl;
+
+    for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+        double corr[2] = { 0.0, 0.0 };
+        int32_t prev, tmp;
+        for (smpl = 0; smpl < num_samples - 1; smpl++) {
+            corr[0] += (double)buffer[smpl] * buffer[smpl];
+            corr[1] += (double)buffer[smpl] * buffer[smpl + 1];
+        }
+        preem[l].coef = LINNEPreemphasisFilter_CalculateCoefficientFromCorrelation(corr);
+        prev = preem[l].prev = initial_prev[l] = buffer[0];
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            tmp = buffer[smpl];
+            buffer[smpl] -= (prev * preem[l].coef) >> LINNE_PREEMPHASIS_COEF_SHIFT;
+            prev = tmp;
+        }
+        preem[l].prev = prev;
+    }
+}
+
+/* 多段プリエンファシスのテスト */
+TEST(LINNEPreemphasisFilterTest, MultiStagePreemphasisTest)
+{
+    /* 逐次プリエンファシスと一致するか */
+    {
+        uint32_t i, j, trial, smpl;
+        int32_t l;
+        const uint32_t nums_samples[] = { 1, 2, 10, 1023, 1024, 1025, 4099, 8192 };
+        /* 16bit相当のデータと、倍精度で厳密に相関を計算できない大振幅のデータ */
+        const int32_t amplitudes[] = { 1 << 15, 1 << 26 };
+
+        srand(0);
+        for (i = 0; i < sizeof(nums_samples) / sizeof(nums_samples[0]); i++) {
+            for (j = 0; j < sizeof(amplitudes) / sizeof(amplitudes[0]); j++) {
+                for (trial = 0; trial < 4; trial++) {
+                    const uint32_t num_samples = nums_samples[i];
+                    const int32_t amplitude = amplitudes[j];
+                    struct LINNEPreemphasisFilter preem[LINNE_NUM_PREEMPHASIS_FILTERS];
+                    struct LINNEPreemphasisFilter answer_preem[LINNE_NUM_PREEMPHASIS_FILTERS];
+                    int32_t initial_prev[LINNE_NUM_PREEMPHASIS_FILTERS];
+                    int32_t answer_initial_prev[LINNE_NUM_PREEMPHASIS_FILTERS];
+                    int32_t *data, *answer;
+                    double phase = 0.0;
+
+                    data = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                    answer = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+                    /* 偶数試行は白色雑音、奇数試行は相関の強い信号 */
+                    for (smpl = 0; smpl < num_samples; smpl++) {
+                        if (trial % 2 == 0) {
+                            data[smpl] = (int32_t)((2.0 * rand() / RAND_MAX - 1.0) * (amplitude - 1));
+                        } else {
+                            phase += 0.01 + 0.001 * (rand() % 10);
+                            data[smpl] = (int32_t)(sin(phase) * (amplitude - 1) * 0.9);
+                        }
+                        answer[smpl] = data[smpl];
+                    }
+
+                    LINNEPreemphasisFilterTest_MultiStagePreemphasisReference(answer_preem, answer_initial_prev, answer, num_samples);
+                    LINNEPreemphasisFilter_MultiStagePreemphasis(preem, initial_prev, data, num_samples);
+                    EXPECT_EQ(0, memcmp(answer, data, sizeof(int32_t) * num_samples));
+                    for (l = 0; l < LINNE_NUM_PREEMPHASIS_FILTERS; l++) {
+                        EXPECT_EQ(answer_preem[l].coef, preem[l].coef);
+                        EXPECT_EQ(answer_preem[l].prev, preem[l].prev);
+                        EXPECT_EQ(answer_initial_prev[l], initial_prev[l]);
+                    }
+
+                    free(data);
+                    free(answer);
+                }
+            }
+        }
+    }
+}
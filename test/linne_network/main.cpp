@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <gtest/gtest.h>
 
@@ -145,3 +146,93 @@ int main(int argc, char **argv)
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+/* 整数入力からのパラメータ設定テスト */
+TEST(LINNENetworkTest, SetUnitsAndParametersInt32Test)
+{
+#define NUM_SAMPLES 1024
+#define NUM_LAYERS 2
+    struct LINNENetwork *net;
+    const uint32_t num_params_list[NUM_LAYERS] = { 32, 8 };
+    const double scale = 1.0 / 32768.0;
+    int32_t input_int[NUM_SAMPLES];
+    double input_double[NUM_SAMPLES];
+    double params[NUM_LAYERS * 32], params_int32[NUM_LAYERS * 32];
+    uint32_t num_units[NUM_LAYERS], num_units_int32[NUM_LAYERS];
+    uint32_t smpl;
+    int32_t work_size;
+    void *work;
+
+    work_size = LINNENetwork_CalculateWorkSize(NUM_SAMPLES, NUM_LAYERS, 32);
+    work = malloc(work_size);
+    net = LINNENetwork_Create(NUM_SAMPLES, NUM_LAYERS, 32, work, work_size);
+    ASSERT_TRUE(net != NULL);
+    LINNENetwork_SetLayerStructure(net, NUM_SAMPLES, NUM_LAYERS, num_params_list);
+
+    srand(0);
+    for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        input_int[smpl] = (int32_t)(16000.0 * sin(0.03 * smpl)) + (rand() % 256) - 128;
+        input_double[smpl] = input_int[smpl] * scale;
+    }
+
+    /* double信号で与えた場合と同じユニット数・パラメータになるか */
+    memset(params, 0, sizeof(params));
+    memset(params_int32, 0, sizeof(params_int32));
+    LINNENetwork_SetUnitsAndParameters(net, input_double, NUM_SAMPLES);
+    LINNENetwork_GetLayerNumUnits(net, num_units, NUM_LAYERS);
+    LINNENetwork_GetParameters(net, params, NUM_LAYERS, 32);
+    LINNENetwork_ResetParameters(net);
+    LINNENetwork_SetUnitsAndParametersInt32(net, input_int, scale, NUM_SAMPLES);
+    LINNENetwork_GetLayerNumUnits(net, num_units_int32, NUM_LAYERS);
+    LINNENetwork_GetParameters(net, params_int32, NUM_LAYERS, 32);
+    EXPECT_EQ(0, memcmp(num_units, num_units_int32, sizeof(num_units)));
+    EXPECT_EQ(0, memcmp(params, params_int32, sizeof(double) * 32 * NUM_LAYERS));
+
+    LINNENetwork_Destroy(net);
+    free(work);
+#undef NUM_SAMPLES
+#undef NUM_LAYERS
+}
+
+/* パラメータ数が2の冪でない層のユニット数探索テスト */
+TEST(LINNENetworkTest, SetUnitsAndParametersNonPowerOf2LayerTest)
+{
+#define NUM_SAMPLES 4096
+#define NUM_LAYERS 3
+#define MAX_NUM_PARAMS 96
+    struct LINNENetwork *net;
+    /* プリセット3と同じ構造 */
+    const uint32_t num_params_list[NUM_LAYERS] = { 4, MAX_NUM_PARAMS, 16 };
+    double input[NUM_SAMPLES];
+    uint32_t num_units[NUM_LAYERS];
+    uint32_t smpl, l;
+    int32_t work_size;
+    void *work;
+
+    work_size = LINNENetwork_CalculateWorkSize(NUM_SAMPLES, NUM_LAYERS, MAX_NUM_PARAMS);
+    ASSERT_TRUE(work_size > 0);
+    work = malloc((size_t)work_size);
+    net = LINNENetwork_Create(NUM_SAMPLES, NUM_LAYERS, MAX_NUM_PARAMS, work, work_size);
+    ASSERT_TRUE(net != NULL);
+    LINNENetwork_SetLayerStructure(net, NUM_SAMPLES, NUM_LAYERS, num_params_list);
+
+    srand(0);
+    for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        input[smpl] = 0.5 * sin(0.03 * smpl) + 0.01 * ((rand() % 256) - 128) / 128.0;
+    }
+
+    /* ユニット数は層のパラメータ数を割り切る2の冪 */
+    LINNENetwork_SetUnitsAndParameters(net, input, NUM_SAMPLES);
+    LINNENetwork_GetLayerNumUnits(net, num_units, NUM_LAYERS);
+    for (l = 0; l < NUM_LAYERS; l++) {
+        EXPECT_TRUE(LINNEUTILITY_IS_POWERED_OF_2(num_units[l]));
+        EXPECT_EQ(0U, num_params_list[l] % num_units[l]);
+        EXPECT_TRUE(num_units[l] <= (1U << ((1U << LINNE_LOG2_NUM_UNITS_BITWIDTH) - 1)));
+    }
+
+    LINNENetwork_Destroy(net);
+    free(work);
+#undef NUM_SAMPLES
+#undef NUM_LAYERS
+#undef MAX_NUM_PARAMS
+}
@@ -8,6 +8,8 @@ extern "C" {
 #include "../../libs/lpc/src/lpc.c"
 }
 
+#include "../common/linne_test_allocator.h"
+
 /* ハンドル作成破棄テスト */
 TEST(LPCCalculatorTest, CreateDestroyHandleTest)
 {
@@ -108,6 +110,32 @@ TEST(LPCCalculatorTest, CreateDestroyHandleTest)
     }
 }
 
+/* アロケータ差し替えテスト */
+TEST(LPCCalculatorTest, AllocatorTest)
+{
+    struct LPCCalculator *lpcc;
+    struct LPCCalculatorConfig config;
+    struct LINNETestAllocatorContext ctx;
+
+    /* 自前確保のハンドルは設定したアロケータを通る */
+    LINNETestAllocator_Install(&ctx, UINT32_MAX);
+    config.max_order = 1;
+    config.max_num_samples = 1;
+    lpcc = LPCCalculator_Create(&config, NULL, 0);
+    ASSERT_TRUE(lpcc != NULL);
+    EXPECT_EQ(1, ctx.num_allocate);
+    LPCCalculator_Destroy(lpcc);
+    EXPECT_EQ(1, ctx.num_deallocate);
+
+    /* 作成に失敗しても確保した領域は解放される */
+    config.max_order = 0;
+    lpcc = LPCCalculator_Create(&config, NULL, 0);
+    EXPECT_TRUE(lpcc == NULL);
+    EXPECT_EQ(ctx.num_allocate, ctx.num_deallocate);
+
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNE_SetAllocator(NULL));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
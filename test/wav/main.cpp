@@ -8,6 +8,8 @@ extern "C" {
 #include "../../libs/wav/src/wav.c"
 }
 
+#include "../common/linne_test_allocator.h"
+
 /* WAVファイルフォーマット取得テスト */
 TEST(WAVTest, GetWAVFormatTest)
 {
@@ -100,6 +102,56 @@ TEST(WAVTest, CreateDestroyTest)
     }
 }
 
+/* アロケータ差し替えテスト */
+TEST(WAVTest, AllocatorTest)
+{
+    struct WAVFile *wavfile;
+    struct WAVFileFormat format;
+    struct LINNETestAllocatorContext ctx;
+
+    format.data_format     = WAV_DATA_FORMAT_PCM;
+    format.bits_per_sample = 16;
+    format.num_channels    = 2;
+    format.sampling_rate   = 48000;
+    format.num_samples     = 1024;
+
+    /* ハンドルとチャンネル毎のデータが設定したアロケータを通る */
+    {
+        uint32_t ch, smpl, is_ok;
+
+        LINNETestAllocator_Install(&ctx, UINT32_MAX);
+        wavfile = WAV_Create(&format);
+        ASSERT_TRUE(wavfile != NULL);
+        EXPECT_EQ(2 + format.num_channels, ctx.num_allocate);
+
+        /* 0で初期化されている */
+        is_ok = 1;
+        for (ch = 0; ch < format.num_channels; ch++) {
+            for (smpl = 0; smpl < format.num_samples; smpl++) {
+                if (WAVFile_PCM(wavfile, smpl, ch) != 0) {
+                    is_ok = 0;
+                }
+            }
+        }
+        EXPECT_EQ(1, is_ok);
+
+        WAV_Destroy(wavfile);
+        EXPECT_EQ(ctx.num_allocate, ctx.num_deallocate);
+    }
+
+    /* 途中で確保に失敗しても確保済みの領域は解放される */
+    {
+        uint32_t max_num;
+        for (max_num = 0; max_num < 2 + format.num_channels; max_num++) {
+            LINNETestAllocator_Install(&ctx, max_num);
+            EXPECT_TRUE(WAV_Create(&format) == NULL);
+            EXPECT_EQ(ctx.num_allocate, ctx.num_deallocate);
+        }
+    }
+
+    EXPECT_EQ(LINNE_APIRESULT_OK, LINNE_SetAllocator(NULL));
+}
+
 /* WAVファイルデータ書き込みテスト */
 TEST(WAVTest, WriteTest)
 {
@@ -7,9 +7,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /* a, bのうち小さい方を選択 */
 #define LINNECODEC_MIN(a, b) (((a) < (b)) ? (a) : (b))
+/* a, bのうち大きい方を選択 */
+#define LINNECODEC_MAX(a, b) (((a) > (b)) ? (a) : (b))
 
 /* コマンドライン仕様 */
 static struct CommandLineParserSpecification command_line_spec[] = {
@@ -25,6 +30,33 @@ static struct CommandLineParserSpecification command_line_spec[] = {
     { 'l', "enable-learning", COMMAND_LINE_PARSER_FALSE,
         "Whether to learning at encoding (default:no)",
         NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'a', "adaptive-block", COMMAND_LINE_PARSER_TRUE,
+        "Select block size from 2048 to 16384 adaptively with specified search budget: 1(fast), ..., 3(full search) (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'r', "realtime-factor", COMMAND_LINE_PARSER_TRUE,
+        "Switch compress mode (up to -m) and learning (if -l) block by block to encode at least the specified times faster than real time (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 's', "layer-structure", COMMAND_LINE_PARSER_TRUE,
+        "Use the specified comma-separated numbers of parameters per layer (e.g. 16,8) instead of -m preset (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'p', "preset-race", COMMAND_LINE_PARSER_FALSE,
+        "Encode each block with all compress modes up to -m (with and without learning if -l) in parallel and keep the smallest (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'u', "reuse-parameters", COMMAND_LINE_PARSER_FALSE,
+        "Skip analysis and reuse the previous block's parameters while they still predict well (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'L', "low-latency", COMMAND_LINE_PARSER_TRUE,
+        "Encode with the specified short block size, analyzing over preceding blocks and coding parameters as deltas with a keyframe every 250 ms (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'A', "pre-analysis", COMMAND_LINE_PARSER_TRUE,
+        "Before encoding, analyze the specified number of blocks sampled across the file to choose channel processing, block size and compress mode (up to -m) (default:off)",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 'n', "dry-run", COMMAND_LINE_PARSER_TRUE,
+        "Dry run: encode only the specified number of blocks sampled across the file at each preset (or -s) and report projected size and encode time without output",
+        NULL, COMMAND_LINE_PARSER_FALSE },
+    { 't', "test", COMMAND_LINE_PARSER_FALSE,
+        "Test mode: only verify CRC16 of each block without decoding",
+        NULL, COMMAND_LINE_PARSER_FALSE },
     { 'c', "no-crc-check", COMMAND_LINE_PARSER_FALSE,
         "Whether to NOT check CRC16 at decoding (default:no)",
         NULL, COMMAND_LINE_PARSER_FALSE },
@@ -37,12 +69,87 @@ static struct CommandLineParserSpecification command_line_spec[] = {
     { 0, }
 };
 
-/* エンコード 成功時は0、失敗時は0以外を返す */
-static int do_encode(const char* in_filename, const char* out_filename, uint32_t encode_preset_no, uint8_t enable_learning)
+/* 固定ブロックサイズでのブロックあたりサンプル数 */
+#define LINNECODEC_NUM_SAMPLES_PER_BLOCK (5 * 2048)
+/* 適応ブロックサイズ選択での最大/最小のブロックあたりサンプル数 */
+#define LINNECODEC_ADAPTIVE_MAX_NUM_SAMPLES_PER_BLOCK 16384
+#define LINNECODEC_ADAPTIVE_MIN_NUM_SAMPLES_PER_BLOCK 2048
+/* 低遅延エンコードで分析に含める直前のブロックの最大サンプル数 */
+#define LINNECODEC_LOW_LATENCY_MAX_NUM_LOOKBACK_SAMPLES 4096
+/* 低遅延エンコードで分析に含める直前のブロックのサンプル数とブロックサイズの積
+* 長いブロックでは直前のブロックを含めすぎると局所的な性質に合わなくなるため、ブロックサイズに反比例させる */
+#define LINNECODEC_LOW_LATENCY_LOOKBACK_SIZE_PRODUCT (1UL << 20)
+/* 低遅延エンコードでのキーフレーム間隔[ms] */
+#define LINNECODEC_LOW_LATENCY_KEYFRAME_INTERVAL_MS 250
+
+/* 入力wavとオプションからエンコードパラメータを作成 */
+static void make_encode_parameter(const struct WAVFile *in_wav,
+        uint32_t encode_preset_no, uint8_t enable_learning, uint8_t block_size_search_budget,
+        uint16_t target_realtime_factor, uint8_t num_custom_layers, const uint32_t *custom_num_params_list,
+        struct LINNEEncodeParameter *parameter)
+{
+    parameter->num_channels = (uint16_t)in_wav->format.num_channels;
+    parameter->bits_per_sample = (uint16_t)in_wav->format.bits_per_sample;
+    parameter->sampling_rate = in_wav->format.sampling_rate;
+    /* プリセットの反映 */
+    parameter->num_samples_per_block = LINNECODEC_NUM_SAMPLES_PER_BLOCK;
+    parameter->ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
+    parameter->preset = (uint8_t)encode_preset_no;
+    parameter->enable_learning = (uint8_t)enable_learning;
+    parameter->min_num_samples_per_block = 0;
+    parameter->block_size_search_budget = block_size_search_budget;
+    parameter->target_realtime_factor = target_realtime_factor;
+    parameter->num_custom_layers = num_custom_layers;
+    memcpy(parameter->custom_num_params_list, custom_num_params_list, sizeof(uint32_t) * num_custom_layers);
+    parameter->enable_block_preset = 0;
+    parameter->enable_parameter_reuse = 0;
+    parameter->num_lookback_samples = 0;
+    parameter->enable_delta_parameters = 0;
+    parameter->keyframe_interval = 0;
+    if (block_size_search_budget > 0) {
+        parameter->num_samples_per_block = LINNECODEC_ADAPTIVE_MAX_NUM_SAMPLES_PER_BLOCK;
+        parameter->min_num_samples_per_block = LINNECODEC_ADAPTIVE_MIN_NUM_SAMPLES_PER_BLOCK;
+    }
+    /* 2ch未満の信号にはMS処理できないので無効に */
+    if (in_wav->format.num_channels < 2) {
+        parameter->ch_process_method = LINNE_CH_PROCESS_METHOD_NONE;
+    }
+}
+
+#ifdef _OPENMP
+/* OpenMPによるタスク実行: エンコーダのプリセット競争に使用 */
+static void run_race_tasks_omp(
+        LINNEEncoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data)
+{
+    int i;
+
+    (void)user_data;
+
+    /* プリセット毎に処理量が大きく異なるため動的に割り当てる */
+#pragma omp parallel for schedule(dynamic)
+    for (i = 0; i < (int)num_tasks; i++) {
+        task(task_context, (uint32_t)i);
+    }
+}
+#endif
+
+/* エンコード 成功時は0、失敗時は0以外を返す
+* block_size_search_budgetが0のときは固定ブロックサイズでエンコード
+* target_realtime_factorが0のときはプリセットと学習の有無を固定してエンコード
+* num_custom_layersが0以外のときはプリセットの代わりにcustom_num_params_listのレイヤー構造でエンコード
+* preset_raceが0以外のときはencode_preset_no以下の全プリセット（enable_learningが0以外なら学習の有無も）で
+* ブロック毎に競争させ、最も小さいものを記録する
+* reuse_parametersが0以外のときは直前のブロックのパラメータで十分に予測できるブロックの分析を省く
+* low_latency_block_sizeが0以外のときはそのブロックサイズで、直前のブロックを含めて分析しパラメータを差分で記録する
+* num_pre_analysis_blocksが0以外のときはその数のブロックを事前分析し、チャンネル処理法・ブロックサイズ・プリセットを決め直す */
+static int do_encode(const char* in_filename, const char* out_filename,
+        uint32_t encode_preset_no, uint8_t enable_learning, uint8_t block_size_search_budget,
+        uint16_t target_realtime_factor, uint8_t num_custom_layers, const uint32_t *custom_num_params_list,
+        uint8_t preset_race, uint8_t reuse_parameters, uint32_t low_latency_block_size, uint32_t num_pre_analysis_blocks)
 {
     FILE *out_fp;
     struct WAVFile *in_wav;
-    struct LINNEEncoder *encoder;
+    struct LINNEEncoder *encoder, *encoders[LINNEENCODER_MAX_NUM_RACE_ENCODERS];
     struct LINNEEncoderConfig config;
     struct LINNEEncodeParameter parameter;
     struct stat fstat;
@@ -50,17 +157,7 @@ static int do_encode(const char* in_filename, const char* out_filename, uint32_t
     uint8_t *buffer;
     uint32_t buffer_size, encoded_data_size;
     LINNEApiResult ret;
-    uint32_t ch, smpl, num_channels, num_samples;
-
-    /* エンコーダ作成 */
-    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
-    config.max_num_samples_per_block = 16 * 1024;
-    config.max_num_layers = 5;
-    config.max_num_parameters_per_layer = 128;
-    if ((encoder = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
-        fprintf(stderr, "Failed to create encoder handle. \n");
-        return 1;
-    }
+    uint32_t i, ch, smpl, num_channels, num_samples, num_encoders;
 
     /* WAVファイルオープン */
     if ((in_wav = WAV_CreateFromFile(in_filename)) == NULL) {
@@ -70,41 +167,98 @@ static int do_encode(const char* in_filename, const char* out_filename, uint32_t
     num_channels = in_wav->format.num_channels;
     num_samples = in_wav->format.num_samples;
 
+    /* 入力データ領域を作成し、情報が失われない程度に右シフト */
+    for (ch = 0; ch < num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(WAVFile_PCM(in_wav, smpl, ch) >> (32 - in_wav->format.bits_per_sample));
+        }
+    }
+
     /* エンコードパラメータセット */
-    parameter.num_channels = (uint16_t)num_channels;
-    parameter.bits_per_sample = (uint16_t)in_wav->format.bits_per_sample;
-    parameter.sampling_rate = in_wav->format.sampling_rate;
-    /* プリセットの反映 */
-    parameter.num_samples_per_block = 5 * 2048;
-    parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_MS;
-    parameter.preset = (uint8_t)encode_preset_no;
-    parameter.enable_learning = (uint8_t)enable_learning;
-    /* 2ch未満の信号にはMS処理できないので無効に */
-    if (num_channels < 2) {
-        parameter.ch_process_method = LINNE_CH_PROCESS_METHOD_NONE;
+    make_encode_parameter(in_wav, encode_preset_no, enable_learning, block_size_search_budget,
+            target_realtime_factor, num_custom_layers, custom_num_params_list, &parameter);
+    parameter.enable_block_preset = preset_race;
+    parameter.enable_parameter_reuse = reuse_parameters;
+    if (low_latency_block_size != 0) {
+        /* キーフレームは一定時間毎に置く */
+        const uint32_t keyframe_interval = (parameter.sampling_rate * LINNECODEC_LOW_LATENCY_KEYFRAME_INTERVAL_MS)
+            / (1000 * low_latency_block_size);
+        parameter.num_samples_per_block = (uint16_t)low_latency_block_size;
+        parameter.num_lookback_samples = (uint16_t)LINNECODEC_MIN(LINNECODEC_LOW_LATENCY_MAX_NUM_LOOKBACK_SAMPLES,
+                LINNECODEC_LOW_LATENCY_LOOKBACK_SIZE_PRODUCT / low_latency_block_size);
+        parameter.enable_delta_parameters = 1;
+        parameter.keyframe_interval = (uint16_t)LINNECODEC_MIN(LINNECODEC_MAX(keyframe_interval, 1), UINT16_MAX);
     }
-    if ((ret = LINNEEncoder_SetEncodeParameter(encoder, &parameter)) != LINNE_APIRESULT_OK) {
-        fprintf(stderr, "Failed to set encode parameter: %d \n", ret);
+
+    /* 事前分析でチャンネル処理法・ブロックサイズ・プリセットを決め直す */
+    if (num_pre_analysis_blocks != 0) {
+        struct LINNEEncoder *analyzer;
+        if ((ret = LINNEEncoder_CalculateMinimumConfig(&parameter, &config)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Invalid encode parameter: %d \n", ret);
+            return 1;
+        }
+        if ((analyzer = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
+            fprintf(stderr, "Failed to create encoder handle. \n");
+            return 1;
+        }
+        ret = LINNEEncoder_PreAnalyzeWhole(analyzer,
+                (const int32_t *const *)input, num_samples, num_pre_analysis_blocks, &parameter);
+        LINNEEncoder_Destroy(analyzer);
+        if (ret != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to pre-analyze: %d \n", ret);
+            return 1;
+        }
+        /* 競争させるプリセットも決め直したものまで */
+        encode_preset_no = parameter.preset;
+        printf("pre-analysis: %s, block size %d, mode %d \n",
+                (parameter.ch_process_method == LINNE_CH_PROCESS_METHOD_MS) ? "MS" : "no channel processing",
+                parameter.num_samples_per_block, parameter.preset);
+    }
+
+    /* 競争させるエンコーダ数: プリセット0からencode_preset_noまで x 学習の有無 */
+    num_encoders = 1;
+    if (preset_race) {
+        num_encoders = (encode_preset_no + 1) * (enable_learning ? 2 : 1);
+    }
+
+    /* パラメータに必要な分だけの領域でエンコーダ作成
+    * 競争時も最大のプリセットはencode_preset_noなので同じコンフィグで足りる */
+    if ((ret = LINNEEncoder_CalculateMinimumConfig(&parameter, &config)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Invalid encode parameter: %d \n", ret);
         return 1;
     }
+    for (i = 0; i < num_encoders; i++) {
+        struct LINNEEncodeParameter race_parameter = parameter;
+        if (preset_race) {
+            race_parameter.preset = (uint8_t)(i % (encode_preset_no + 1));
+            race_parameter.enable_learning = (uint8_t)(i / (encode_preset_no + 1));
+        }
+        if ((encoders[i] = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
+            fprintf(stderr, "Failed to create encoder handle. \n");
+            return 1;
+        }
+        if ((ret = LINNEEncoder_SetEncodeParameter(encoders[i], &race_parameter)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to set encode parameter: %d \n", ret);
+            return 1;
+        }
+    }
+    /* ブロック分割は先頭のエンコーダで決める */
+    encoder = encoders[0];
+#ifdef _OPENMP
+    /* 複数のエンコーダの分析を並列実行 */
+    if ((num_encoders > 1) && (omp_get_max_threads() > 1)) {
+        (void)LINNEEncoder_SetTaskCallback(encoder, run_race_tasks_omp, NULL);
+    }
+#endif
 
     /* 入力ファイルのサイズを拾っておく */
     stat(in_filename, &fstat);
     /* 入力wavの2倍よりは大きくならないだろうという想定 */
     buffer_size = (uint32_t)(2 * fstat.st_size);
 
-    /* エンコードデータ/入力データ領域を作成 */
+    /* エンコードデータ領域を作成 */
     buffer = (uint8_t *)malloc(buffer_size);
-    for (ch = 0; ch < num_channels; ch++) {
-        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
-    }
-
-    /* 情報が失われない程度に右シフト */
-    for (ch = 0; ch < num_channels; ch++) {
-        for (smpl = 0; smpl < num_samples; smpl++) {
-            input[ch][smpl] = (int32_t)(WAVFile_PCM(in_wav, smpl, ch) >> (32 - in_wav->format.bits_per_sample));
-        }
-    }
 
     /* エンコード実行 */
     {
@@ -121,41 +275,63 @@ static int do_encode(const char* in_filename, const char* out_filename, uint32_t
         header.bits_per_sample = parameter.bits_per_sample;
         header.num_samples_per_block = parameter.num_samples_per_block;
         header.preset = parameter.preset;
+        header.enable_block_preset
+            = ((parameter.target_realtime_factor != 0) || (parameter.enable_block_preset != 0)) ? 1 : 0;
+        header.num_custom_layers = parameter.num_custom_layers;
+        memcpy(header.custom_num_params_list, parameter.custom_num_params_list, sizeof(uint32_t) * parameter.num_custom_layers);
         header.ch_process_method = parameter.ch_process_method;
         if ((ret = LINNEEncoder_EncodeHeader(&header, data_pos, buffer_size))
                 != LINNE_APIRESULT_OK) {
             fprintf(stderr, "Failed to encode header! ret:%d \n", ret);
             return 1;
         }
-        data_pos += LINNE_HEADER_SIZE;
-        write_offset += LINNE_HEADER_SIZE;
+        data_pos += LINNE_CALCULATE_HEADER_SIZE(&header);
+        write_offset += LINNE_CALCULATE_HEADER_SIZE(&header);
 
         /* ブロックを時系列順にエンコード */
         progress = 0;
         while (progress < num_samples) {
-            uint32_t ch, write_size;
+            uint32_t ch, blk, write_size, num_blocks;
+            uint32_t block_num_samples[LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS];
             const int32_t *input_ptr[LINNE_MAX_NUM_CHANNELS];
-            /* エンコードサンプル数の確定 */
-            const uint32_t num_encode_samples
-                = LINNECODEC_MIN(parameter.num_samples_per_block, num_samples - progress);
 
             /* サンプル参照位置のセット */
             for (ch = 0; ch < (uint32_t)num_channels; ch++) {
                 input_ptr[ch] = &input[ch][progress];
             }
 
-            /* ブロックエンコード */
-            if ((ret = LINNEEncoder_EncodeBlock(encoder,
-                            input_ptr, num_encode_samples,
-                            data_pos, buffer_size - write_offset, &write_size)) != LINNE_APIRESULT_OK) {
-                fprintf(stderr, "Failed to encode! ret:%d \n", ret);
+            /* エンコードサンプル数の確定 */
+            if ((ret = LINNEEncoder_DecideBlockPartition(encoder,
+                            input_ptr, num_samples - progress,
+                            block_num_samples, LINNEENCODER_MAX_NUM_BLOCK_PARTITIONS, &num_blocks)) != LINNE_APIRESULT_OK) {
+                fprintf(stderr, "Failed to decide block size! ret:%d \n", ret);
                 return 1;
             }
 
-            /* 進捗更新 */
-            data_pos += write_size;
-            write_offset += write_size;
-            progress += num_encode_samples;
+            for (blk = 0; blk < num_blocks; blk++) {
+                /* サンプル参照位置のセット */
+                for (ch = 0; ch < (uint32_t)num_channels; ch++) {
+                    input_ptr[ch] = &input[ch][progress];
+                }
+
+                /* ブロックエンコード */
+                if (preset_race) {
+                    ret = LINNEEncoder_EncodeBlockRace(encoders, num_encoders,
+                            input_ptr, block_num_samples[blk], data_pos, buffer_size - write_offset, &write_size);
+                } else {
+                    ret = LINNEEncoder_EncodeBlock(encoder,
+                            input_ptr, block_num_samples[blk], data_pos, buffer_size - write_offset, &write_size);
+                }
+                if (ret != LINNE_APIRESULT_OK) {
+                    fprintf(stderr, "Failed to encode! ret:%d \n", ret);
+                    return 1;
+                }
+
+                /* 進捗更新 */
+                data_pos += write_size;
+                write_offset += write_size;
+                progress += block_num_samples[blk];
+            }
 
             /* 進捗表示 */
             printf("progress... %5.2f%% \r", (progress * 100.0f) / num_samples);
@@ -184,11 +360,115 @@ static int do_encode(const char* in_filename, const char* out_filename, uint32_t
         free(input[ch]);
     }
     WAV_Destroy(in_wav);
-    LINNEEncoder_Destroy(encoder);
+    for (i = 0; i < num_encoders; i++) {
+        LINNEEncoder_Destroy(encoders[i]);
+    }
 
     return 0;
 }
 
+/* 分析のみのドライラン 成功時は0、失敗時は0以外を返す
+* 各プリセット（num_custom_layersが0以外のときは独自レイヤー構造のみ）で
+* ファイル全体に散らばるnum_analyze_blocks個のブロックを分析し、圧縮サイズとエンコード時間の推定を表示する */
+static int do_estimate(const char* in_filename, uint32_t num_analyze_blocks,
+        uint8_t enable_learning, uint8_t num_custom_layers, const uint32_t *custom_num_params_list)
+{
+    struct WAVFile *in_wav;
+    struct LINNEEncoder *encoder;
+    struct LINNEEncoderConfig config;
+    struct LINNEEncodeParameter parameter;
+    struct LINNEEncodeEstimate estimate;
+    struct stat fstat;
+    int32_t *input[LINNE_MAX_NUM_CHANNELS];
+    LINNEApiResult ret;
+    uint32_t ch, smpl, num_channels, num_samples, preset, num_presets;
+    double duration;
+
+    /* WAVファイルオープン */
+    if ((in_wav = WAV_CreateFromFile(in_filename)) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", in_filename);
+        return 1;
+    }
+    num_channels = in_wav->format.num_channels;
+    num_samples = in_wav->format.num_samples;
+    duration = (double)num_samples / in_wav->format.sampling_rate;
+    stat(in_filename, &fstat);
+
+    /* 最も大きいプリセットで全プリセットを扱える領域のエンコーダを作成 */
+    num_presets = (num_custom_layers > 0) ? 1 : LINNE_NUM_PARAMETER_PRESETS;
+    make_encode_parameter(in_wav, num_presets - 1, enable_learning, 0, 0,
+            num_custom_layers, custom_num_params_list, &parameter);
+    if ((ret = LINNEEncoder_CalculateMinimumConfig(&parameter, &config)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Invalid encode parameter: %d \n", ret);
+        WAV_Destroy(in_wav);
+        return 1;
+    }
+    if ((encoder = LINNEEncoder_Create(&config, NULL, 0)) == NULL) {
+        fprintf(stderr, "Failed to create encoder handle. \n");
+        WAV_Destroy(in_wav);
+        return 1;
+    }
+
+    /* 入力データ領域を作成し、情報が失われない程度に右シフト */
+    for (ch = 0; ch < num_channels; ch++) {
+        input[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+            input[ch][smpl] = (int32_t)(WAVFile_PCM(in_wav, smpl, ch) >> (32 - in_wav->format.bits_per_sample));
+        }
+    }
+
+    /* プリセット毎に推定 */
+    for (preset = 0; preset < num_presets; preset++) {
+        make_encode_parameter(in_wav, preset, enable_learning, 0, 0,
+                num_custom_layers, custom_num_params_list, &parameter);
+        if ((ret = LINNEEncoder_SetEncodeParameter(encoder, &parameter)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to set encode parameter: %d \n", ret);
+            break;
+        }
+        if ((ret = LINNEEncoder_EstimateWhole(encoder,
+                        (const int32_t *const *)input, num_samples, num_analyze_blocks, &estimate)) != LINNE_APIRESULT_OK) {
+            fprintf(stderr, "Failed to estimate! ret:%d \n", ret);
+            break;
+        }
+        if (num_custom_layers > 0) {
+            printf("custom: ");
+        } else {
+            printf("mode %u: ", preset);
+        }
+        printf("%.0f (%6.2f %%, 95%% CI %6.2f - %6.2f %%) encode time %.2f sec (x%.1f realtime) [%u / %u blocks] \n",
+                estimate.estimated_size, 100.0 * estimate.estimated_size / fstat.st_size,
+                100.0 * estimate.estimated_size_lower / fstat.st_size, 100.0 * estimate.estimated_size_upper / fstat.st_size,
+                estimate.estimated_encode_time,
+                (estimate.estimated_encode_time > 0.0) ? (duration / estimate.estimated_encode_time) : 0.0,
+                estimate.num_analyzed_blocks, estimate.num_blocks);
+    }
+
+    /* リソース破棄 */
+    for (ch = 0; ch < num_channels; ch++) {
+        free(input[ch]);
+    }
+    WAV_Destroy(in_wav);
+    LINNEEncoder_Destroy(encoder);
+
+    return (ret == LINNE_APIRESULT_OK) ? 0 : 1;
+}
+
+#ifdef _OPENMP
+/* OpenMPによるタスク実行: デコーダのチャンネル並列合成に使用 */
+static void run_tasks_omp(
+        LINNEDecoderTaskFunction task, void *task_context, uint32_t num_tasks, void *user_data)
+{
+    int i;
+
+    (void)user_data;
+
+#pragma omp parallel for schedule(static)
+    for (i = 0; i < (int)num_tasks; i++) {
+        task(task_context, (uint32_t)i);
+    }
+}
+#endif
+
 /* デコード 成功時は0、失敗時は0以外を返す */
 static int do_decode(const char* in_filename, const char* out_filename, uint8_t check_crc)
 {
@@ -203,16 +483,6 @@ static int do_decode(const char* in_filename, const char* out_filename, uint8_t
     uint32_t ch, smpl, buffer_size;
     LINNEApiResult ret;
 
-    /* デコーダハンドルの作成 */
-    config.max_num_channels = LINNE_MAX_NUM_CHANNELS;
-    config.max_num_layers = 5;
-    config.max_num_parameters_per_layer = 128;
-    config.check_crc = check_crc;
-    if ((decoder = LINNEDecoder_Create(&config, NULL, 0)) == NULL) {
-        fprintf(stderr, "Failed to create decoder handle. \n");
-        return 1;
-    }
-
     /* 入力ファイルオープン */
     in_fp = fopen(in_filename, "rb");
     /* 入力ファイルのサイズ取得 / バッファ領域割り当て */
@@ -230,6 +500,23 @@ static int do_decode(const char* in_filename, const char* out_filename, uint8_t
         return 1;
     }
 
+    /* ヘッダに必要な分だけの領域でデコーダハンドルの作成 */
+    if ((ret = LINNEDecoder_CalculateMinimumConfig(&header, &config)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Invalid header: %d \n", ret);
+        return 1;
+    }
+    config.check_crc = check_crc;
+    if ((decoder = LINNEDecoder_Create(&config, NULL, 0)) == NULL) {
+        fprintf(stderr, "Failed to create decoder handle. \n");
+        return 1;
+    }
+#ifdef _OPENMP
+    /* 多チャンネルのときはチャンネル毎の合成を並列実行 */
+    if ((header.num_channels > 2) && (omp_get_max_threads() > 1)) {
+        (void)LINNEDecoder_SetTaskCallback(decoder, run_tasks_omp, NULL);
+    }
+#endif
+
     /* 出力wavハンドルの生成 */
     wav_format.data_format     = WAV_DATA_FORMAT_PCM;
     wav_format.num_channels    = header.num_channels;
@@ -270,6 +557,96 @@ static int do_decode(const char* in_filename, const char* out_filename, uint8_t
     return 0;
 }
 
+/* CRC16のみの検査 成功時（破損なし）は0、失敗時は0以外を返す */
+static int do_test(const char* in_filename)
+{
+    FILE* in_fp;
+    struct stat fstat;
+    struct LINNEHeader header;
+    struct LINNEBlockInfo *block_info;
+    uint8_t* buffer;
+    uint32_t buffer_size, num_blocks, blk, num_corrupted;
+    int i, num_threads;
+    LINNEApiResult ret;
+
+    /* 入力ファイルオープン */
+    if ((in_fp = fopen(in_filename, "rb")) == NULL) {
+        fprintf(stderr, "Failed to open %s. \n", in_filename);
+        return 1;
+    }
+    /* 入力ファイルのサイズ取得 / バッファ領域割り当て */
+    stat(in_filename, &fstat);
+    buffer_size = (uint32_t)fstat.st_size;
+    if ((buffer = (uint8_t *)malloc(buffer_size)) == NULL) {
+        fprintf(stderr, "Failed to allocate buffer. \n");
+        fclose(in_fp);
+        return 1;
+    }
+    /* バッファ領域にデータをロード */
+    fread(buffer, sizeof(uint8_t), buffer_size, in_fp);
+    fclose(in_fp);
+
+    /* ヘッダデコード */
+    if ((ret = LINNEDecoder_DecodeHeader(buffer, buffer_size, &header))
+            != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to get header information: %d \n", ret);
+        free(buffer);
+        return 1;
+    }
+
+    /* ブロック情報の取得 */
+    if ((ret = LINNEDecoder_GetBlockInfo(buffer, buffer_size, NULL, 0, &num_blocks))
+            != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to parse block headers: %d \n", ret);
+        free(buffer);
+        return 1;
+    }
+    if ((block_info = (struct LINNEBlockInfo *)malloc(sizeof(struct LINNEBlockInfo) * LINNECODEC_MAX(num_blocks, 1))) == NULL) {
+        fprintf(stderr, "Failed to allocate block information. \n");
+        free(buffer);
+        return 1;
+    }
+    if ((ret = LINNEDecoder_GetBlockInfo(buffer, buffer_size, block_info, num_blocks, &num_blocks))
+            != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Failed to parse block headers: %d \n", ret);
+        free(block_info);
+        free(buffer);
+        return 1;
+    }
+
+    /* ブロック範囲をスレッド毎に分割して検査 */
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#else
+    num_threads = 1;
+#endif
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i = 0; i < num_threads; i++) {
+        const uint32_t begin = (uint32_t)(((uint64_t)num_blocks * (uint32_t)i) / (uint32_t)num_threads);
+        const uint32_t end = (uint32_t)(((uint64_t)num_blocks * ((uint32_t)i + 1)) / (uint32_t)num_threads);
+        /* 破損は結果として記録されるので戻り値は見ない */
+        (void)LINNEDecoder_CheckBlocks(buffer, buffer_size, &block_info[begin], end - begin);
+    }
+
+    /* 結果表示 */
+    num_corrupted = 0;
+    for (blk = 0; blk < num_blocks; blk++) {
+        if (block_info[blk].corrupted) {
+            printf("block %u: corrupted (samples %u - %u) \n", blk,
+                    block_info[blk].sample_offset, block_info[blk].sample_offset + block_info[blk].num_samples - 1);
+            num_corrupted++;
+        }
+    }
+    printf("%u / %u blocks corrupted. \n", num_corrupted, num_blocks);
+
+    free(block_info);
+    free(buffer);
+
+    return (num_corrupted > 0) ? 1 : 0;
+}
+
 /* 使用法の表示 */
 static void print_usage(char** argv)
 {
@@ -321,8 +698,18 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    /* 出力ファイル名の取得 */
-    if ((output_file = filename_ptr[1]) == NULL) {
+    /* 検査モードは出力ファイル不要 */
+    if (CommandLineParser_GetOptionAcquired(command_line_spec, "test") == COMMAND_LINE_PARSER_TRUE) {
+        if (do_test(input_file) != 0) {
+            fprintf(stderr, "%s: integrity check failed for %s. \n", argv[0], input_file);
+            return 1;
+        }
+        return 0;
+    }
+
+    /* 出力ファイル名の取得: ドライランは出力ファイル不要 */
+    if (((output_file = filename_ptr[1]) == NULL)
+            && (CommandLineParser_GetOptionAcquired(command_line_spec, "dry-run") != COMMAND_LINE_PARSER_TRUE)) {
         fprintf(stderr, "%s: output file must be specified. \n", argv[0]);
         return 1;
     }
@@ -350,6 +737,14 @@ int main(int argc, char** argv)
         /* エンコード */
         uint32_t encode_preset_no = 0;
         uint8_t enable_learning = 0;
+        uint8_t block_size_search_budget = 0;
+        uint16_t target_realtime_factor = 0;
+        uint8_t num_custom_layers = 0;
+        uint8_t preset_race = 0;
+        uint8_t reuse_parameters = 0;
+        uint32_t low_latency_block_size = 0;
+        uint32_t num_pre_analysis_blocks = 0;
+        uint32_t custom_num_params_list[LINNE_MAX_NUM_CUSTOM_LAYERS];
         /* エンコードプリセット番号取得 */
         if (CommandLineParser_GetOptionAcquired(command_line_spec, "mode") == COMMAND_LINE_PARSER_TRUE) {
             encode_preset_no = (uint32_t)strtol(CommandLineParser_GetArgumentString(command_line_spec, "mode"), NULL, 10);
@@ -362,8 +757,105 @@ int main(int argc, char** argv)
         if (CommandLineParser_GetOptionAcquired(command_line_spec, "enable-learning") == COMMAND_LINE_PARSER_TRUE) {
             enable_learning = 1;
         }
+        /* ブロックサイズ探索の計算量上限を取得 */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "adaptive-block") == COMMAND_LINE_PARSER_TRUE) {
+            const long budget = strtol(CommandLineParser_GetArgumentString(command_line_spec, "adaptive-block"), NULL, 10);
+            if ((budget <= 0) || (budget > UINT8_MAX)) {
+                fprintf(stderr, "%s: block size search budget is out of range. \n", argv[0]);
+                return 1;
+            }
+            block_size_search_budget = (uint8_t)budget;
+        }
+        /* 目標の実時間倍率を取得 */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "realtime-factor") == COMMAND_LINE_PARSER_TRUE) {
+            const long factor = strtol(CommandLineParser_GetArgumentString(command_line_spec, "realtime-factor"), NULL, 10);
+            if ((factor <= 0) || (factor > UINT16_MAX)) {
+                fprintf(stderr, "%s: realtime factor is out of range. \n", argv[0]);
+                return 1;
+            }
+            target_realtime_factor = (uint16_t)factor;
+        }
+        /* 独自レイヤー構造を取得 */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "layer-structure") == COMMAND_LINE_PARSER_TRUE) {
+            const char *str = CommandLineParser_GetArgumentString(command_line_spec, "layer-structure");
+            char *end;
+            while (1) {
+                const long num_params = strtol(str, &end, 10);
+                if ((end == str) || (num_params <= 0) || (num_custom_layers >= LINNE_MAX_NUM_CUSTOM_LAYERS)) {
+                    fprintf(stderr, "%s: invalid layer structure. \n", argv[0]);
+                    return 1;
+                }
+                custom_num_params_list[num_custom_layers++] = (uint32_t)num_params;
+                if (*end != ',') {
+                    break;
+                }
+                str = end + 1;
+            }
+            if (*end != '\0') {
+                fprintf(stderr, "%s: invalid layer structure. \n", argv[0]);
+                return 1;
+            }
+        }
+        /* プリセット競争フラグを取得 速度目標・独自レイヤー構造とは併用できない */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "preset-race") == COMMAND_LINE_PARSER_TRUE) {
+            if ((target_realtime_factor != 0) || (num_custom_layers > 0)) {
+                fprintf(stderr, "%s: preset race cannot be combined with realtime factor or layer structure. \n", argv[0]);
+                return 1;
+            }
+            preset_race = 1;
+        }
+        /* パラメータ再利用フラグを取得 プリセット競争では再利用しない */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "reuse-parameters") == COMMAND_LINE_PARSER_TRUE) {
+            if (preset_race) {
+                fprintf(stderr, "%s: parameter reuse cannot be combined with preset race. \n", argv[0]);
+                return 1;
+            }
+            reuse_parameters = 1;
+        }
+        /* 低遅延エンコードのブロックサイズを取得 適応ブロックサイズ・プリセット競争とは併用できない */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "low-latency") == COMMAND_LINE_PARSER_TRUE) {
+            const long block_size = strtol(CommandLineParser_GetArgumentString(command_line_spec, "low-latency"), NULL, 10);
+            if ((block_size <= 0) || (block_size > LINNECODEC_NUM_SAMPLES_PER_BLOCK)) {
+                fprintf(stderr, "%s: low latency block size is out of range. \n", argv[0]);
+                return 1;
+            }
+            if ((block_size_search_budget != 0) || preset_race) {
+                fprintf(stderr, "%s: low latency cannot be combined with adaptive block or preset race. \n", argv[0]);
+                return 1;
+            }
+            low_latency_block_size = (uint32_t)block_size;
+        }
+        /* 事前分析するブロック数を取得 低遅延エンコードはブロックサイズを指定するので併用できない */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "pre-analysis") == COMMAND_LINE_PARSER_TRUE) {
+            const long num_blocks = strtol(CommandLineParser_GetArgumentString(command_line_spec, "pre-analysis"), NULL, 10);
+            if (num_blocks <= 0) {
+                fprintf(stderr, "%s: number of blocks to pre-analyze is out of range. \n", argv[0]);
+                return 1;
+            }
+            if (low_latency_block_size != 0) {
+                fprintf(stderr, "%s: pre-analysis cannot be combined with low latency. \n", argv[0]);
+                return 1;
+            }
+            num_pre_analysis_blocks = (uint32_t)num_blocks;
+        }
+        /* ドライラン: 分析のみ行い推定結果を表示 */
+        if (CommandLineParser_GetOptionAcquired(command_line_spec, "dry-run") == COMMAND_LINE_PARSER_TRUE) {
+            const long num_analyze_blocks = strtol(CommandLineParser_GetArgumentString(command_line_spec, "dry-run"), NULL, 10);
+            if (num_analyze_blocks <= 0) {
+                fprintf(stderr, "%s: number of blocks to analyze is out of range. \n", argv[0]);
+                return 1;
+            }
+            if (do_estimate(input_file, (uint32_t)num_analyze_blocks, enable_learning,
+                        num_custom_layers, custom_num_params_list) != 0) {
+                fprintf(stderr, "%s: failed to analyze %s. \n", argv[0], input_file);
+                return 1;
+            }
+            return 0;
+        }
         /* 一括エンコード実行 */
-        if (do_encode(input_file, output_file, encode_preset_no, enable_learning) != 0) {
+        if (do_encode(input_file, output_file, encode_preset_no, enable_learning,
+                    block_size_search_budget, target_realtime_factor,
+                    num_custom_layers, custom_num_params_list, preset_race, reuse_parameters, low_latency_block_size, num_pre_analysis_blocks) != 0) {
             fprintf(stderr, "%s: failed to encode %s. \n", argv[0], input_file);
             return 1;
         }
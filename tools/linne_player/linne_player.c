@@ -8,6 +8,10 @@
 
 /* 出力要求コールバック */
 static void LINNEPlayer_SampleRequestCallback(int32_t **buffer, uint32_t num_channels, uint32_t num_samples);
+/* 次のブロックをデコード 失敗時は再同期し無音を出力 */
+static void LINNEPlayer_DecodeNextBlock(void);
+/* 再同期で読み飛ばした区間のサンプル数を数える */
+static uint32_t LINNEPlayer_CountSkippedSamples(uint32_t begin_offset, uint32_t end_offset);
 /* 終了処理 */
 static void exit_linne_player(void);
 
@@ -20,6 +24,8 @@ static uint32_t buffer_pos = 0;
 static uint32_t data_size = 0;
 static uint8_t *data = NULL;
 static uint32_t decode_offset = 0;
+static uint32_t stream_samples = 0;
+static uint32_t num_pending_silent_samples = 0;
 static struct LINNEDecoder* decoder = NULL;
 
 /* メインエントリ */
@@ -68,11 +74,11 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    /* デコーダハンドルの作成 */
-    decoder_config.max_num_channels = header.num_channels;
-    decoder_config.max_num_layers   = 10;
-    decoder_config.max_num_parameters_per_layer = 128;
-    decoder_config.check_crc        = 1;
+    /* ヘッダに必要な分だけの領域でデコーダハンドルの作成 */
+    if ((ret = LINNEDecoder_CalculateMinimumConfig(&header, &decoder_config)) != LINNE_APIRESULT_OK) {
+        fprintf(stderr, "Invalid header: %d \n", ret);
+        return 1;
+    }
     if ((decoder = LINNEDecoder_Create(&decoder_config, NULL, 0)) == NULL) {
         fprintf(stderr, "Failed to create decoder handle. \n");
         return 1;
@@ -90,8 +96,8 @@ int main(int argc, char **argv)
         memset(decode_buffer[i], 0, sizeof(int32_t) * header.num_samples_per_block);
     }
 
-    /* デコード位置をヘッダ分進める */
-    decode_offset = LINNE_HEADER_SIZE;
+    /* デコード位置をヘッダ（拡張を含む）分進める */
+    decode_offset = LINNE_CALCULATE_HEADER_SIZE(&header);
 
     /* プレイヤー初期化 */
     player_config.sampling_rate = header.sampling_rate;
@@ -114,16 +120,7 @@ static void LINNEPlayer_SampleRequestCallback(int32_t **buffer, uint32_t num_cha
     for (smpl = 0; smpl < num_samples; smpl++) {
         /* バッファを使い切ったら即時にデコード */
         if (buffer_pos >= num_buffered_samples) {
-            uint32_t decode_size;
-            if (LINNEDecoder_DecodeBlock(decoder,
-                        &data[decode_offset], data_size - decode_offset,
-                        decode_buffer, header.num_channels, header.num_samples_per_block,
-                        &decode_size, &num_buffered_samples) != LINNE_APIRESULT_OK) {
-                fprintf(stderr, "decoding error! \n");
-                exit(1);
-            }
-            buffer_pos = 0;
-            decode_offset += decode_size;
+            LINNEPlayer_DecodeNextBlock();
         }
 
         /* 出力用バッファ領域にコピー */
@@ -145,6 +142,89 @@ static void LINNEPlayer_SampleRequestCallback(int32_t **buffer, uint32_t num_cha
     fflush(stdout);
 }
 
+/* 再同期で読み飛ばした区間のサンプル数を数える */
+static uint32_t LINNEPlayer_CountSkippedSamples(uint32_t begin_offset, uint32_t end_offset)
+{
+    uint32_t offset, num_samples;
+    struct LINNEBlockInfo block_info;
+
+    /* 区間内に収まるブロックヘッダを辿れる限り、ヘッダのサンプル数を積算 */
+    num_samples = 0;
+    offset = begin_offset;
+    while (offset < end_offset) {
+        if (LINNEDecoder_PeekBlockInfo(decoder,
+                    &data[offset], end_offset - offset, &block_info) != LINNE_APIRESULT_OK) {
+            /* ヘッダが壊れて辿れない残りは1ブロック分とみなす */
+            num_samples += header.num_samples_per_block;
+            break;
+        }
+        num_samples += block_info.num_samples;
+        offset += block_info.data_size;
+    }
+
+    return num_samples;
+}
+
+/* 次のブロックをデコード 失敗時は再同期し無音を出力 */
+static void LINNEPlayer_DecodeNextBlock(void)
+{
+    uint32_t ch, decode_size, next_offset;
+
+    buffer_pos = 0;
+
+    /* 無音で埋める途中でなければデコード */
+    if (num_pending_silent_samples == 0) {
+        if (decode_offset < data_size) {
+            LINNEApiResult ret;
+            struct LINNEBlockInfo block_info;
+            if ((ret = LINNEDecoder_DecodeBlock(decoder,
+                            &data[decode_offset], data_size - decode_offset,
+                            decode_buffer, header.num_channels, header.num_samples_per_block,
+                            &decode_size, &num_buffered_samples)) == LINNE_APIRESULT_OK) {
+                decode_offset += decode_size;
+                stream_samples += num_buffered_samples;
+                return;
+            }
+            if ((ret == LINNE_APIRESULT_INSUFFICIENT_DATA)
+                    && (LINNEDecoder_PeekBlockInfo(decoder,
+                            &data[decode_offset], data_size - decode_offset, &block_info) == LINNE_APIRESULT_OK)
+                    && (block_info.corrupted == 0)) {
+                /* 正常なブロックだが失ったブロックのパラメータに依存している
+                * 誤った信号を再生しないよう、パラメータを持つブロックが来るまでブロック単位で無音にする */
+                decode_offset += block_info.data_size;
+                num_pending_silent_samples = block_info.num_samples;
+            } else {
+                fprintf(stderr, "decoding error at offset %u. resynchronizing... \n", decode_offset);
+                /* 破損ブロックの次のバイトから正常なブロックを探し、読み飛ばすブロックのサンプル数を数える */
+                if (LINNEDecoder_FindNextBlock(decoder,
+                            &data[decode_offset + 1], data_size - decode_offset - 1, &next_offset) == LINNE_APIRESULT_OK) {
+                    num_pending_silent_samples = LINNEPlayer_CountSkippedSamples(decode_offset, decode_offset + 1 + next_offset);
+                    decode_offset += 1 + next_offset;
+                } else {
+                    decode_offset = data_size;
+                }
+            }
+        }
+        /* 以降にブロックがなければ残り全てを無音で埋める */
+        if (decode_offset >= data_size) {
+            num_pending_silent_samples = header.num_samples - stream_samples;
+        }
+        /* 総サンプル数を超えて埋めない */
+        if (num_pending_silent_samples > (header.num_samples - stream_samples)) {
+            num_pending_silent_samples = header.num_samples - stream_samples;
+        }
+        stream_samples += num_pending_silent_samples;
+    }
+
+    /* 失ったサンプル分は無音で埋める */
+    num_buffered_samples = (num_pending_silent_samples < header.num_samples_per_block)
+        ? num_pending_silent_samples : header.num_samples_per_block;
+    for (ch = 0; ch < header.num_channels; ch++) {
+        memset(decode_buffer[ch], 0, sizeof(int32_t) * num_buffered_samples);
+    }
+    num_pending_silent_samples -= num_buffered_samples;
+}
+
 /* 終了処理 */
 static void exit_linne_player(void)
 {